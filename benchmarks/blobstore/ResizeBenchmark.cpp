@@ -0,0 +1,64 @@
+#include <blobstore/implementations/onblocks/BlobStoreOnBlocks.h>
+#include <blockstore/implementations/compressing/CompressingBlockStore.h>
+#include <blockstore/implementations/compressing/compressors/RunLengthEncoding.h>
+#include <blockstore/implementations/inmemory/InMemoryBlockStore.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+
+// Measures how long it takes to grow an empty blob to a given size and to shrink it back to zero,
+// like `truncate -s` on a new file and deleting its content again.
+// The blocks are stored in memory and compressed, so large sizes fit into memory because the new blocks are all zero.
+//
+// Usage: blobstore-benchmark-ResizeBenchmark [block size in bytes] [blob size in MiB]...
+
+using blobstore::onblocks::BlobStoreOnBlocks;
+using blockstore::compressing::CompressingBlockStore;
+using blockstore::compressing::RunLengthEncoding;
+using blockstore::inmemory::InMemoryBlockStore;
+using cpputils::make_unique_ref;
+using std::vector;
+
+namespace {
+
+template<class Func>
+double measureSeconds(Func func) {
+  auto start = std::chrono::steady_clock::now();
+  func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  uint64_t blockSize = 32 * 1024;
+  vector<uint64_t> sizesInMiB = {1024, 10 * 1024};
+  if (argc > 1) {
+    blockSize = std::strtoull(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    sizesInMiB.clear();
+    for (int i = 2; i < argc; ++i) {
+      sizesInMiB.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+  }
+
+  std::cout << "Block size " << blockSize << " bytes" << std::endl;
+  std::cout << std::setw(12) << "size (MiB)" << std::setw(12) << "grow (s)" << std::setw(12) << "shrink (s)" << std::endl;
+  for (uint64_t sizeInMiB : sizesInMiB) {
+    BlobStoreOnBlocks blobStore(make_unique_ref<CompressingBlockStore<RunLengthEncoding>>(make_unique_ref<InMemoryBlockStore>()), blockSize);
+    auto blob = blobStore.create();
+    double grow = measureSeconds([&blob, sizeInMiB] {
+      blob->resize(sizeInMiB * 1024 * 1024);
+    });
+    double shrink = measureSeconds([&blob] {
+      blob->resize(0);
+    });
+    std::cout << std::setw(12) << sizeInMiB << std::setw(12) << std::fixed << std::setprecision(2) << grow
+              << std::setw(12) << shrink << std::endl;
+  }
+  return 0;
+}
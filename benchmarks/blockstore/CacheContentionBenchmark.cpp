@@ -0,0 +1,68 @@
+#include <blockstore/implementations/caching/cache/Cache.h>
+#include <blockstore/implementations/caching/cache/ShardedCache.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+// Measures the throughput of the pop()/push() cycle that CachingBlockStore runs for each block access,
+// for Cache (one mutex) and ShardedCache (one mutex per shard) with an increasing number of threads.
+//
+// Usage: blockstore-benchmark-CacheContentionBenchmark [operations per thread]
+
+using blockstore::caching::Cache;
+using blockstore::caching::ShardedCache;
+using std::vector;
+
+namespace {
+
+constexpr uint32_t MAX_ENTRIES = 1000;
+// Each thread works on its own keys, so pushing a popped key back never collides with another thread.
+constexpr int KEYS_PER_THREAD = 8;
+
+template<class CacheType>
+double measureOpsPerSecond(unsigned int numThreads, unsigned int opsPerThread) {
+  CacheType cache(MAX_ENTRIES);
+  vector<std::thread> threads;
+  threads.reserve(numThreads);
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&cache, t, opsPerThread] {
+      int firstKey = t * KEYS_PER_THREAD;
+      for (unsigned int i = 0; i < opsPerThread; ++i) {
+        int key = firstKey + (i % KEYS_PER_THREAD);
+        auto value = cache.pop(key);
+        cache.push(key, value.value_or(key));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+  return static_cast<double>(numThreads) * opsPerThread / seconds;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  unsigned int opsPerThread = 200000;
+  if (argc > 1) {
+    opsPerThread = std::strtoul(argv[1], nullptr, 10);
+  }
+
+  std::cout << "pop()+push() operations per second, " << opsPerThread << " operations per thread" << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(16) << "Cache" << std::setw(16) << "ShardedCache" << std::setw(10) << "speedup" << std::endl;
+  for (unsigned int numThreads = 1; numThreads <= 64; numThreads *= 2) {
+    double single = measureOpsPerSecond<Cache<int, int>>(numThreads, opsPerThread);
+    double sharded = measureOpsPerSecond<ShardedCache<int, int>>(numThreads, opsPerThread);
+    std::cout << std::setw(8) << numThreads
+              << std::setw(16) << std::fixed << std::setprecision(0) << single
+              << std::setw(16) << sharded
+              << std::setw(10) << std::setprecision(2) << (sharded / single) << std::endl;
+  }
+  return 0;
+}
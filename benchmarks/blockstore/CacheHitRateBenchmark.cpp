@@ -0,0 +1,170 @@
+#include <blockstore/implementations/caching/cache/LRUEvictionPolicy.h>
+#include <blockstore/implementations/caching/cache/TwoQueueEvictionPolicy.h>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <cstdlib>
+
+// Replays block access traces against each eviction policy and reports the cache hit rate.
+// The replay simulates the pop()/push() cycle CachingBlockStore runs for each block access, but without a real cache,
+// so the results don't depend on timing (i.e. on entries being purged because they got too old).
+//
+// Usage: blockstore-benchmark-CacheHitRateBenchmark [cache size in entries] [trace file]
+// Without a trace file, a set of synthetic traces is replayed. A trace file contains one block number per line.
+
+using blockstore::caching::EvictionPolicyFactory;
+using blockstore::caching::LRUEvictionPolicy;
+using blockstore::caching::TwoQueueEvictionPolicy;
+using std::vector;
+using std::string;
+using std::pair;
+
+namespace {
+
+using Trace = vector<uint64_t>;
+
+double hitRate(const Trace &trace, uint64_t cacheSize, const EvictionPolicyFactory<uint64_t> &createEvictionPolicy) {
+  auto policy = createEvictionPolicy(cacheSize);
+  std::unordered_set<uint64_t> cached;
+  uint64_t hits = 0;
+  for (uint64_t key : trace) {
+    if (cached.count(key) > 0) {
+      ++hits;
+      policy->onPop(key);
+    } else {
+      cached.insert(key);
+    }
+    policy->onPush(key, 1);
+    while (cached.size() > cacheSize) {
+      auto victim = policy->victim();
+      policy->onEvict(*victim);
+      cached.erase(*victim);
+    }
+  }
+  return trace.empty() ? 0 : static_cast<double>(hits) / trace.size();
+}
+
+// Block numbers used by the synthetic traces
+constexpr uint64_t DIR_BLOCKS_BEGIN = 0;
+constexpr uint64_t NUM_DIR_BLOCKS = 200;
+constexpr uint64_t INNER_NODES_BEGIN = 1000;
+constexpr uint64_t LEAVES_BEGIN = 1000000;
+// Number of children of an inner node of a blob tree with 32KB blocks
+constexpr uint64_t CHILDREN_PER_INNER_NODE = 2048;
+
+// Reads a file sequentially, like `cat` does. Each read loads the root node, the inner node and a leaf of the file's tree.
+// From time to time, other processes look up directory entries, which loads a directory block twice (e.g. for lookup and stat).
+Trace sequentialReadWithDirectoryLookups(uint64_t numLeaves) {
+  std::mt19937 random(1);
+  Trace trace;
+  for (uint64_t leaf = 0; leaf < numLeaves; ++leaf) {
+    trace.push_back(INNER_NODES_BEGIN);
+    trace.push_back(INNER_NODES_BEGIN + 1 + leaf / CHILDREN_PER_INNER_NODE);
+    trace.push_back(LEAVES_BEGIN + leaf);
+    if (leaf % 64 == 0) {
+      uint64_t dirBlock = DIR_BLOCKS_BEGIN + random() % NUM_DIR_BLOCKS;
+      trace.push_back(dirBlock);
+      trace.push_back(dirBlock);
+    }
+  }
+  return trace;
+}
+
+// Random accesses to a small set of hot blocks, interrupted by large sequential scans.
+Trace hotSetWithScans(uint64_t hotSetSize, uint64_t scanLength) {
+  std::mt19937 random(2);
+  Trace trace;
+  uint64_t nextScanBlock = LEAVES_BEGIN;
+  for (int round = 0; round < 10; ++round) {
+    for (uint64_t i = 0; i < 10 * hotSetSize; ++i) {
+      trace.push_back(random() % hotSetSize);
+    }
+    for (uint64_t i = 0; i < scanLength; ++i) {
+      trace.push_back(nextScanBlock++);
+    }
+  }
+  return trace;
+}
+
+// Random accesses where some blocks are accessed much more often than others
+Trace skewed(uint64_t numBlocks, uint64_t length) {
+  std::mt19937 random(3);
+  // 80% of the accesses go to 20% of the blocks
+  std::uniform_int_distribution<uint64_t> hot(0, numBlocks / 5 - 1);
+  std::uniform_int_distribution<uint64_t> all(0, numBlocks - 1);
+  std::bernoulli_distribution isHot(0.8);
+  Trace trace;
+  for (uint64_t i = 0; i < length; ++i) {
+    trace.push_back(isHot(random) ? hot(random) : all(random));
+  }
+  return trace;
+}
+
+// Loops over a working set that is slightly larger than the cache. This is the worst case for LRU.
+Trace loop(uint64_t numBlocks, uint64_t numLoops) {
+  Trace trace;
+  for (uint64_t i = 0; i < numLoops; ++i) {
+    for (uint64_t block = 0; block < numBlocks; ++block) {
+      trace.push_back(block);
+    }
+  }
+  return trace;
+}
+
+Trace loadTrace(const string &path) {
+  std::ifstream file(path);
+  if (!file.good()) {
+    std::cerr << "Couldn't open trace file " << path << std::endl;
+    exit(1);
+  }
+  Trace trace;
+  uint64_t key;
+  while (file >> key) {
+    trace.push_back(key);
+  }
+  return trace;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  uint64_t cacheSize = 1024;
+  if (argc > 1) {
+    cacheSize = std::strtoull(argv[1], nullptr, 10);
+  }
+
+  vector<pair<string, Trace>> traces;
+  if (argc > 2) {
+    traces.emplace_back(argv[2], loadTrace(argv[2]));
+  } else {
+    traces.emplace_back("sequential read + dir lookups", sequentialReadWithDirectoryLookups(20 * cacheSize));
+    traces.emplace_back("hot set + scans", hotSetWithScans(cacheSize / 2, 4 * cacheSize));
+    traces.emplace_back("80/20 skewed", skewed(4 * cacheSize, 50 * cacheSize));
+    traces.emplace_back("loop over 1.1x cache size", loop(cacheSize + cacheSize / 10, 20));
+  }
+
+  vector<pair<string, EvictionPolicyFactory<uint64_t>>> policies = {
+    {"LRU", LRUEvictionPolicy<uint64_t>::Factory()},
+    {"2Q", TwoQueueEvictionPolicy<uint64_t>::Factory()},
+  };
+
+  std::cout << "Hit rates with a cache size of " << cacheSize << " entries" << std::endl;
+  std::cout << std::setw(32) << std::left << "trace" << std::right << std::setw(10) << "accesses";
+  for (const auto &policy : policies) {
+    std::cout << std::setw(10) << policy.first;
+  }
+  std::cout << std::endl;
+  for (const auto &trace : traces) {
+    std::cout << std::setw(32) << std::left << trace.first << std::right << std::setw(10) << trace.second.size();
+    for (const auto &policy : policies) {
+      std::cout << std::setw(9) << std::fixed << std::setprecision(1) << 100 * hitRate(trace.second, cacheSize, policy.second) << "%";
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
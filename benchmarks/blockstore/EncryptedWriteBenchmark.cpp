@@ -0,0 +1,86 @@
+#include <blockstore/implementations/encrypted/EncryptedBlockStore.h>
+#include <blockstore/implementations/inmemory/InMemoryBlockStore.h>
+#include <cpp-utils/crypto/symmetric/ciphers.h>
+#include <cpp-utils/data/DataFixture.h>
+#include <cpp-utils/random/Random.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+// Measures how fast a single thread can write blocks through an EncryptedBlockStore. The blocks are encrypted
+// by the store's pipeline, so this should scale with the number of cores. For comparison, the writing thread
+// also waits for each block to be written before it goes on, which is how fast the store was without the pipeline.
+//
+// Usage: blockstore-benchmark-EncryptedWriteBenchmark [number of blocks] [block size in bytes]
+
+using blockstore::Key;
+using blockstore::encrypted::EncryptedBlockStore;
+using blockstore::inmemory::InMemoryBlockStore;
+using cpputils::AES256_GCM;
+using cpputils::Data;
+using cpputils::DataFixture;
+using cpputils::Random;
+using cpputils::make_unique_ref;
+using std::vector;
+using std::function;
+
+namespace {
+
+double measureMBPerSecond(const vector<Key> &keys, size_t blockSize, function<void (const Key &)> write, function<void ()> finish) {
+  auto start = std::chrono::steady_clock::now();
+  for (const Key &key : keys) {
+    write(key);
+  }
+  finish();
+  auto end = std::chrono::steady_clock::now();
+  return keys.size() * blockSize / 1024.0 / 1024.0 / std::chrono::duration<double>(end - start).count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  unsigned int numBlocks = 20000;
+  size_t blockSize = 32 * 1024;
+  if (argc > 1) {
+    numBlocks = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    blockSize = std::strtoul(argv[2], nullptr, 10);
+  }
+
+  auto encKey = AES256_GCM::CreateKey(Random::PseudoRandom());
+  Data data = DataFixture::generate(blockSize);
+
+  auto encryptedStore = make_unique_ref<EncryptedBlockStore<AES256_GCM>>(make_unique_ref<InMemoryBlockStore>(), encKey);
+  vector<Key> keys;
+  keys.reserve(numBlocks);
+  for (unsigned int i = 0; i < numBlocks; ++i) {
+    keys.push_back(encryptedStore->create(Data(blockSize))->key());
+  }
+  encryptedStore->waitForPendingWrites();
+
+  auto writeBlock = [&encryptedStore, &data] (const Key &key) {
+    auto block = encryptedStore->load(key).value();
+    block->write(data.data(), 0, data.size());
+  };
+  auto waitForPendingWrites = [&encryptedStore] {
+    encryptedStore->waitForPendingWrites();
+  };
+
+  double serialized = measureMBPerSecond(keys, blockSize, [&writeBlock, &waitForPendingWrites] (const Key &key) {
+    writeBlock(key);
+    waitForPendingWrites();
+  }, waitForPendingWrites);
+
+  double pipelined = measureMBPerSecond(keys, blockSize, writeBlock, waitForPendingWrites);
+
+  std::cout << numBlocks << " blocks of " << blockSize << " bytes, " << std::thread::hardware_concurrency() << " cores" << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(30) << "wait for each block: " << serialized << " MB/s" << std::endl;
+  std::cout << std::setw(30) << "encryption pipeline: " << pipelined << " MB/s" << std::endl;
+  return 0;
+}
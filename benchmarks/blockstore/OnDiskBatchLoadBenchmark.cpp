@@ -0,0 +1,77 @@
+#include <blockstore/implementations/ondisk/OnDiskBlockStore.h>
+#include <cpp-utils/data/DataFixture.h>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+
+// Measures how many blocks per second OnDiskBlockStore loads with one load() per block compared to loadMany()
+// batches of increasing size, i.e. the gain from having more reads in flight at the same time.
+// Blocks are read with O_DIRECT so that they come from the device and not from the page cache.
+//
+// Usage: blockstore-benchmark-OnDiskBatchLoadBenchmark [number of blocks] [block size in bytes] [directory]
+
+using blockstore::Key;
+using blockstore::ondisk::OnDiskBlockStore;
+using cpputils::Data;
+using cpputils::DataFixture;
+using std::vector;
+
+namespace bf = boost::filesystem;
+
+namespace {
+
+template<class LoadFunc>
+double measureBlocksPerSecond(const vector<Key> &keys, size_t batchSize, LoadFunc load) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t begin = 0; begin < keys.size(); begin += batchSize) {
+    size_t end = std::min(keys.size(), begin + batchSize);
+    load(vector<Key>(keys.begin() + begin, keys.begin() + end));
+  }
+  auto end = std::chrono::steady_clock::now();
+  return keys.size() / std::chrono::duration<double>(end - start).count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  unsigned int numBlocks = 4096;
+  size_t blockSize = 32 * 1024;
+  if (argc > 1) {
+    numBlocks = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    blockSize = std::strtoul(argv[2], nullptr, 10);
+  }
+  // The system temp directory is often a tmpfs, which doesn't support O_DIRECT. Pass a directory on the device to measure.
+  bf::path rootdir = (argc > 3 ? bf::path(argv[3]) : bf::temp_directory_path()) / bf::unique_path();
+  bf::create_directory(rootdir);
+
+  {
+    OnDiskBlockStore blockStore(rootdir, true);
+    vector<Key> keys;
+    keys.reserve(numBlocks);
+    for (unsigned int i = 0; i < numBlocks; ++i) {
+      keys.push_back(blockStore.create(DataFixture::generate(blockSize, i))->key());
+    }
+
+    std::cout << numBlocks << " blocks of " << blockSize << " bytes in " << rootdir.native() << std::endl;
+    std::cout << std::setw(12) << "batch size" << std::setw(14) << "blocks/s" << std::endl;
+    double single = measureBlocksPerSecond(keys, 1, [&blockStore] (const vector<Key> &batch) {
+      blockStore.load(batch[0]).value();
+    });
+    std::cout << std::setw(12) << "load()" << std::setw(14) << std::fixed << std::setprecision(0) << single << std::endl;
+    for (size_t batchSize = 2; batchSize <= 128; batchSize *= 2) {
+      double batched = measureBlocksPerSecond(keys, batchSize, [&blockStore] (const vector<Key> &batch) {
+        blockStore.loadMany(batch);
+      });
+      std::cout << std::setw(12) << batchSize << std::setw(14) << batched
+                << "  (" << std::setprecision(2) << (batched / single) << "x)" << std::setprecision(0) << std::endl;
+    }
+  }
+
+  bf::remove_all(rootdir);
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include <blockstore/implementations/ondisk/OnDiskBlock.h>
+#include <cpp-utils/data/DataFixture.h>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <vector>
+#include <cstdlib>
+
+// Measures how many blocks per second OnDiskBlock can store and load, with buffered I/O and with O_DIRECT,
+// compared to the std::ifstream/std::ofstream based implementation it had before.
+// Loads are served from the page cache for the buffered variants, i.e. this measures the per-block overhead.
+// Overwrites with the file descriptor variants go through a temporary file and rename() to be crash-safe.
+//
+// Usage: blockstore-benchmark-OnDiskBlockBenchmark [number of blocks] [block size in bytes] [directory]
+
+using blockstore::Key;
+using blockstore::ondisk::OnDiskBlock;
+using cpputils::Data;
+using cpputils::DataFixture;
+using std::vector;
+using std::function;
+
+namespace bf = boost::filesystem;
+
+namespace {
+
+bf::path blockPath(const bf::path &rootdir, const Key &key) {
+  std::string keyStr = key.ToString();
+  return rootdir / keyStr.substr(0,3) / keyStr.substr(3);
+}
+
+// The implementation OnDiskBlock used before it switched to file descriptors
+void streamStore(const bf::path &rootdir, const Key &key, const Data &data) {
+  auto filepath = blockPath(rootdir, key);
+  bf::create_directory(filepath.parent_path());
+  std::ofstream file(filepath.c_str(), std::ios::binary | std::ios::trunc);
+  file.write(OnDiskBlock::FORMAT_VERSION_HEADER.c_str(), OnDiskBlock::formatVersionHeaderSize());
+  data.StoreToStream(file);
+  if (!file.good()) {
+    throw std::runtime_error("Error writing block");
+  }
+}
+
+size_t streamLoad(const bf::path &rootdir, const Key &key) {
+  auto filepath = blockPath(rootdir, key);
+  if (!bf::is_regular_file(filepath)) {
+    throw std::runtime_error("Block not found");
+  }
+  std::ifstream file(filepath.c_str(), std::ios::binary);
+  Data header(OnDiskBlock::formatVersionHeaderSize());
+  file.read(static_cast<char*>(header.data()), header.size());
+  return Data::LoadFromStream(file).size();
+}
+
+void fdCreate(const bf::path &rootdir, const Key &key, const Data &data, bool directIO) {
+  OnDiskBlock::CreateOnDisk(rootdir, key, data.copy(), directIO).value();
+}
+
+void fdOverwrite(const bf::path &rootdir, const Key &key, const Data &data, bool directIO) {
+  // Store the block the way flush() does when a loaded block was modified
+  OnDiskBlock block(key, blockPath(rootdir, key), data.copy(), directIO);
+  block.write(data.data(), 0, data.size());
+}
+
+size_t fdLoad(const bf::path &rootdir, const Key &key, bool directIO) {
+  return OnDiskBlock::LoadFromDisk(rootdir, key, directIO).value()->size();
+}
+
+double measureOpsPerSecond(const vector<Key> &keys, function<void (const Key &)> op) {
+  auto start = std::chrono::steady_clock::now();
+  for (const Key &key : keys) {
+    op(key);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return keys.size() / std::chrono::duration<double>(end - start).count();
+}
+
+struct Variant {
+  const char *name;
+  function<void (const bf::path &, const Key &, const Data &)> create;
+  function<void (const bf::path &, const Key &, const Data &)> overwrite;
+  function<size_t (const bf::path &, const Key &)> load;
+};
+
+}
+
+int main(int argc, char *argv[]) {
+  unsigned int numBlocks = 2000;
+  size_t blockSize = 32 * 1024;
+  if (argc > 1) {
+    numBlocks = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    blockSize = std::strtoul(argv[2], nullptr, 10);
+  }
+  // The system temp directory is often a tmpfs, which doesn't support O_DIRECT. Pass a directory on a real disk to measure that.
+  bf::path baseDir = argc > 3 ? bf::path(argv[3]) : bf::temp_directory_path();
+
+  vector<Key> keys;
+  keys.reserve(numBlocks);
+  for (unsigned int i = 0; i < numBlocks; ++i) {
+    keys.push_back(Key::FromBinary(DataFixture::generate(Key::BINARY_LENGTH, i).data()));
+  }
+  Data data = DataFixture::generate(blockSize);
+
+  vector<Variant> variants = {
+      {"std::fstream", streamStore, streamStore, streamLoad},
+      {"fd", [] (const bf::path &root, const Key &key, const Data &d) {fdCreate(root, key, d, false);},
+             [] (const bf::path &root, const Key &key, const Data &d) {fdOverwrite(root, key, d, false);},
+             [] (const bf::path &root, const Key &key) {return fdLoad(root, key, false);}},
+      {"fd+O_DIRECT", [] (const bf::path &root, const Key &key, const Data &d) {fdCreate(root, key, d, true);},
+                      [] (const bf::path &root, const Key &key, const Data &d) {fdOverwrite(root, key, d, true);},
+                      [] (const bf::path &root, const Key &key) {return fdLoad(root, key, true);}},
+  };
+
+  std::cout << numBlocks << " blocks of " << blockSize << " bytes in " << baseDir.native() << std::endl;
+  std::cout << std::setw(14) << "variant" << std::setw(14) << "create/s" << std::setw(14) << "overwrite/s" << std::setw(14) << "load/s" << std::endl;
+  for (const Variant &variant : variants) {
+    bf::path rootdir = baseDir / bf::unique_path();
+    bf::create_directory(rootdir);
+    double create = measureOpsPerSecond(keys, [&] (const Key &key) {variant.create(rootdir, key, data);});
+    double overwrite = measureOpsPerSecond(keys, [&] (const Key &key) {variant.overwrite(rootdir, key, data);});
+    double load = measureOpsPerSecond(keys, [&] (const Key &key) {
+      if (variant.load(rootdir, key) != blockSize) {
+        throw std::runtime_error("Loaded wrong block size");
+      }
+    });
+    bf::remove_all(rootdir);
+    std::cout << std::setw(14) << variant.name << std::fixed << std::setprecision(0)
+              << std::setw(14) << create << std::setw(14) << overwrite << std::setw(14) << load << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+#include <cpp-utils/crypto/symmetric/ciphers.h>
+#include <cpp-utils/random/Random.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+
+// Measures how fast each cipher CryFS offers encrypts and decrypts blocks of different sizes on one thread.
+// The blocks are encrypted into and decrypted from preallocated buffers, like the block store does it.
+// AES uses the AES instructions of the CPU if it has them, the first line of the output tells whether it does.
+//
+// Usage: cpp-utils-benchmark-CipherBenchmark [MiB per measurement]
+
+using cpputils::Data;
+using cpputils::Random;
+using std::vector;
+
+namespace {
+
+const vector<uint64_t> BLOCK_SIZES = {4 * 1024, 32 * 1024, 1024 * 1024};
+
+template<class Func>
+double measureSeconds(Func func) {
+  auto start = std::chrono::steady_clock::now();
+  func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+template<class Cipher>
+void benchmark(uint64_t bytesPerMeasurement) {
+  auto encKey = Cipher::CreateKey(Random::PseudoRandom());
+  for (uint64_t blockSize : BLOCK_SIZES) {
+    Data plaintext(blockSize);
+    plaintext.FillWithZeroes();
+    Data ciphertext(Cipher::ciphertextSize(blockSize));
+    uint64_t numBlocks = std::max(UINT64_C(1), bytesPerMeasurement / blockSize);
+    // The first call sets up the cipher for the key on this thread
+    Cipher::encrypt((byte*)plaintext.data(), blockSize, (byte*)ciphertext.data(), encKey);
+    double encryption = measureSeconds([&] {
+      for (uint64_t i = 0; i < numBlocks; ++i) {
+        Cipher::encrypt((byte*)plaintext.data(), blockSize, (byte*)ciphertext.data(), encKey);
+      }
+    });
+    double decryption = measureSeconds([&] {
+      for (uint64_t i = 0; i < numBlocks; ++i) {
+        if (!Cipher::decrypt((byte*)ciphertext.data(), ciphertext.size(), (byte*)plaintext.data(), encKey)) {
+          std::cerr << "Decryption failed" << std::endl;
+          std::exit(1);
+        }
+      }
+    });
+    double megabytes = static_cast<double>(numBlocks * blockSize) / (1024 * 1024);
+    std::cout << std::setw(18) << Cipher::NAME << std::setw(12) << blockSize / 1024
+              << std::setw(16) << std::fixed << std::setprecision(1) << megabytes / encryption
+              << std::setw(16) << megabytes / decryption << std::endl;
+  }
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  uint64_t mibPerMeasurement = 256;
+  if (argc > 1) {
+    mibPerMeasurement = std::strtoull(argv[1], nullptr, 10);
+  }
+  uint64_t bytesPerMeasurement = mibPerMeasurement * 1024 * 1024;
+
+  if (cpputils::HardwareAesGcm::usesVaes()) {
+    std::cout << "AES-GCM: VAES and VPCLMULQDQ (AVX-512)" << std::endl;
+  } else if (cpputils::HardwareAesGcm::isSupported()) {
+    std::cout << "AES-GCM: AES-NI and PCLMULQDQ" << std::endl;
+  } else {
+    std::cout << "AES-GCM: Crypto++" << std::endl;
+  }
+  std::cout << std::setw(18) << "cipher" << std::setw(12) << "block (KiB)"
+            << std::setw(16) << "encrypt (MiB/s)" << std::setw(16) << "decrypt (MiB/s)" << std::endl;
+  benchmark<cpputils::AES256_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::AES256_CFB>(bytesPerMeasurement);
+  benchmark<cpputils::AES128_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::AES128_CFB>(bytesPerMeasurement);
+  benchmark<cpputils::XChaCha20Poly1305>(bytesPerMeasurement);
+  benchmark<cpputils::Twofish256_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::Twofish256_CFB>(bytesPerMeasurement);
+  benchmark<cpputils::Twofish128_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::Twofish128_CFB>(bytesPerMeasurement);
+  benchmark<cpputils::Serpent256_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::Serpent256_CFB>(bytesPerMeasurement);
+  benchmark<cpputils::Serpent128_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::Serpent128_CFB>(bytesPerMeasurement);
+  benchmark<cpputils::Cast256_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::Cast256_CFB>(bytesPerMeasurement);
+#if CRYPTOPP_VERSION != 564
+  benchmark<cpputils::Mars448_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::Mars448_CFB>(bytesPerMeasurement);
+#endif
+  benchmark<cpputils::Mars256_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::Mars256_CFB>(bytesPerMeasurement);
+  benchmark<cpputils::Mars128_GCM>(bytesPerMeasurement);
+  benchmark<cpputils::Mars128_CFB>(bytesPerMeasurement);
+  return 0;
+}
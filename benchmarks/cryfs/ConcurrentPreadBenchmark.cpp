@@ -0,0 +1,120 @@
+#include <cpp-utils/data/DataFixture.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Measures the read throughput of several threads calling pread() at random offsets of the same file,
+// like several processes reading one large database file. Run it on a file in a mounted CryFS
+// to see how well reads to one file scale with the number of readers.
+// If the file doesn't exist or is smaller than the given size, it is written first.
+// The page cache for the file is dropped before each run, so the reads reach the file system.
+//
+// Usage: cryfs-benchmark-ConcurrentPreadBenchmark [file] [file size in MiB] [read size in bytes] [seconds per run]
+
+using cpputils::Data;
+using cpputils::DataFixture;
+using std::vector;
+using std::string;
+
+namespace {
+
+void prepareFile(const string &path, uint64_t fileSize) {
+  struct stat st;
+  if (0 == ::stat(path.c_str(), &st) && static_cast<uint64_t>(st.st_size) >= fileSize) {
+    return;
+  }
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    throw std::runtime_error("Couldn't create " + path + ": " + std::strerror(errno));
+  }
+  constexpr uint64_t CHUNK_SIZE = 1024 * 1024;
+  for (uint64_t offset = 0; offset < fileSize; offset += CHUNK_SIZE) {
+    Data chunk = DataFixture::generate(std::min(CHUNK_SIZE, fileSize - offset), offset / CHUNK_SIZE);
+    if (static_cast<ssize_t>(chunk.size()) != ::pwrite(fd, chunk.data(), chunk.size(), offset)) {
+      ::close(fd);
+      throw std::runtime_error("Couldn't write " + path + ": " + std::strerror(errno));
+    }
+  }
+  ::fsync(fd);
+  ::close(fd);
+}
+
+double measureBytesPerSecond(const string &path, uint64_t fileSize, size_t readSize, unsigned int numThreads, double seconds) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Couldn't open " + path + ": " + std::strerror(errno));
+  }
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> bytesRead(0);
+  vector<std::thread> threads;
+  threads.reserve(numThreads);
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int t = 0; t < numThreads; ++t) {
+    threads.emplace_back([fd, fileSize, readSize, t, &stop, &bytesRead] {
+      std::mt19937_64 random(t);
+      std::uniform_int_distribution<uint64_t> chunkIndex(0, fileSize / readSize - 1);
+      Data buffer(readSize);
+      uint64_t read = 0;
+      while (!stop) {
+        ssize_t result = ::pread(fd, buffer.data(), readSize, chunkIndex(random) * readSize);
+        if (result < 0) {
+          std::cerr << "pread failed: " << std::strerror(errno) << std::endl;
+          std::exit(1);
+        }
+        read += result;
+      }
+      bytesRead += read;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  ::close(fd);
+  return bytesRead / std::chrono::duration<double>(end - start).count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  string path = (argc > 1) ? argv[1] : "concurrent-pread-benchmark.bin";
+  uint64_t fileSize = ((argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 256) * 1024 * 1024;
+  size_t readSize = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 128 * 1024;
+  double seconds = (argc > 4) ? std::strtod(argv[4], nullptr) : 5;
+  if (readSize == 0 || fileSize < readSize) {
+    std::cerr << "The file has to be at least as large as one read" << std::endl;
+    return 1;
+  }
+
+  prepareFile(path, fileSize);
+
+  std::cout << "pread() of " << readSize << " bytes at random offsets of " << path << " (" << (fileSize / 1024 / 1024) << " MiB)" << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(12) << "MiB/s" << std::setw(10) << "speedup" << std::endl;
+  double single = 0;
+  for (unsigned int numThreads = 1; numThreads <= 16; numThreads *= 2) {
+    double bytesPerSecond = measureBytesPerSecond(path, fileSize, readSize, numThreads, seconds);
+    if (numThreads == 1) {
+      single = bytesPerSecond;
+    }
+    std::cout << std::setw(8) << numThreads
+              << std::setw(12) << std::fixed << std::setprecision(1) << (bytesPerSecond / 1024 / 1024)
+              << std::setw(10) << std::setprecision(2) << (bytesPerSecond / single) << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include <cryfs/filesystem/CryDevice.h>
+#include <fspp/fs_interface/Dir.h>
+#include <fspp/fs_interface/OpenFile.h>
+#include <blockstore/implementations/inmemory/InMemoryBlockStore.h>
+#include <cpp-utils/crypto/kdf/Scrypt.h>
+#include <cpp-utils/crypto/symmetric/ciphers.h>
+#include <cpp-utils/random/Random.h>
+#include <cpp-utils/tempfile/TempFile.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <sys/stat.h>
+
+// Measures how fast files can be created in a single huge directory, like a mail spool or a build cache.
+// Creating a file has to check that the name doesn't exist yet, so the create rate is printed for each batch of files.
+// Without an index over the names, it drops with the number of files that are already in the directory.
+// The blocks are kept in memory, so this measures the directory handling and not the disk.
+//
+// Usage: cryfs-benchmark-CreateFilesBenchmark [number of files] [files per batch]
+
+using blockstore::inmemory::InMemoryBlockStore;
+using cpputils::make_unique_ref;
+using cryfs::CryConfig;
+using cryfs::CryConfigFile;
+using cryfs::CryDevice;
+using std::string;
+
+int main(int argc, char *argv[]) {
+  unsigned int numFiles = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  unsigned int batchSize = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 10000;
+
+  cpputils::TempFile configFile(false);
+  CryConfig config;
+  config.SetCipher("aes-256-gcm");
+  config.SetEncryptionKey(cpputils::AES256_GCM::CreateKey(cpputils::Random::PseudoRandom()).ToString());
+  config.SetBlocksizeBytes(32 * 1024);
+  CryDevice device(CryConfigFile::create(configFile.path(), std::move(config), "password", cpputils::SCrypt::TestSettings),
+                   make_unique_ref<InMemoryBlockStore>());
+  auto dir = device.LoadDir("/").value();
+
+  std::cout << "Creating " << numFiles << " files in one directory" << std::endl;
+  std::cout << std::fixed << std::setprecision(0);
+  auto start = std::chrono::steady_clock::now();
+  auto batchStart = start;
+  for (unsigned int i = 0; i < numFiles; ++i) {
+    dir->createAndOpenFile("message" + std::to_string(i) + ".eml", S_IFREG | S_IRUSR | S_IWUSR, 0, 0);
+    if ((i + 1) % batchSize == 0 || i + 1 == numFiles) {
+      auto now = std::chrono::steady_clock::now();
+      unsigned int filesInBatch = (i % batchSize) + 1;
+      std::cout << std::setw(10) << (i + 1) << " files: " << filesInBatch / std::chrono::duration<double>(now - batchStart).count() << " creates/s" << std::endl;
+      batchStart = now;
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::cout << "Total: " << numFiles / std::chrono::duration<double>(end - start).count() << " creates/s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include <cryfs/filesystem/ReadAhead.h>
+#include <blobstore/implementations/onblocks/BlobStoreOnBlocks.h>
+#include <blockstore/implementations/caching/CachingBlockStore.h>
+#include <blockstore/implementations/encrypted/EncryptedBlockStore.h>
+#include <blockstore/implementations/ondisk/OnDiskBlockStore.h>
+#include <cpp-utils/crypto/symmetric/ciphers.h>
+#include <cpp-utils/data/DataFixture.h>
+#include <cpp-utils/random/Random.h>
+#include <cpp-utils/thread/WorkerPool.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+// Measures the throughput of reading a blob sequentially with different read-ahead windows, i.e. how much it helps
+// that the following blocks are loaded and decrypted in the background while the reader processes the current ones.
+// The blocks are encrypted and read with O_DIRECT, and each run starts with an empty block cache,
+// so all blocks come from the device. A window of zero disables read-ahead.
+//
+// Usage: cryfs-benchmark-SequentialReadBenchmark [blob size in MiB] [read size in bytes] [directory]
+
+using blobstore::Blob;
+using blobstore::onblocks::BlobStoreOnBlocks;
+using blockstore::Key;
+using blockstore::caching::CachingBlockStore;
+using blockstore::encrypted::EncryptedBlockStore;
+using blockstore::ondisk::OnDiskBlockStore;
+using cpputils::AES256_GCM;
+using cpputils::Data;
+using cpputils::DataFixture;
+using cpputils::WorkerPool;
+using cpputils::make_unique_ref;
+using cpputils::unique_ref;
+using cryfs::ReadAhead;
+using std::vector;
+
+namespace bf = boost::filesystem;
+
+namespace {
+
+constexpr uint64_t BLOCKSIZE_BYTES = 32 * 1024;
+
+unique_ref<BlobStoreOnBlocks> createBlobStore(const bf::path &rootdir, const AES256_GCM::EncryptionKey &encKey) {
+  return make_unique_ref<BlobStoreOnBlocks>(
+    make_unique_ref<CachingBlockStore>(
+      make_unique_ref<EncryptedBlockStore<AES256_GCM>>(
+        make_unique_ref<OnDiskBlockStore>(rootdir, true), encKey)),
+    BLOCKSIZE_BYTES);
+}
+
+Key createBlob(const bf::path &rootdir, const AES256_GCM::EncryptionKey &encKey, uint64_t blobSize) {
+  auto blobStore = createBlobStore(rootdir, encKey);
+  auto blob = blobStore->create();
+  constexpr uint64_t CHUNK_SIZE = 1024 * 1024;
+  for (uint64_t offset = 0; offset < blobSize; offset += CHUNK_SIZE) {
+    Data chunk = DataFixture::generate(std::min(CHUNK_SIZE, blobSize - offset), offset / CHUNK_SIZE);
+    blob->write(chunk.data(), offset, chunk.size());
+  }
+  blob->flush();
+  return blob->key();
+}
+
+double measureBytesPerSecond(const bf::path &rootdir, const AES256_GCM::EncryptionKey &encKey, const Key &blobKey, uint64_t readSize, uint64_t windowSize, WorkerPool *workers) {
+  auto blobStore = createBlobStore(rootdir, encKey);
+  auto blob = blobStore->load(blobKey).value();
+  uint64_t blobSize = blob->size();
+  const Blob *prefetchedBlob = blob.get();
+  ReadAhead readAhead(workers, [prefetchedBlob] (uint64_t offset, uint64_t count) {
+    prefetchedBlob->prefetch(offset, count);
+  }, windowSize);
+  Data buffer(readSize);
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t offset = 0; offset < blobSize; offset += readSize) {
+    uint64_t count = std::min(readSize, blobSize - offset);
+    readAhead.onRead(offset, count);
+    blob->read(buffer.data(), offset, count);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return blobSize / std::chrono::duration<double>(end - start).count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  uint64_t blobSize = ((argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 256) * 1024 * 1024;
+  uint64_t readSize = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 128 * 1024;
+  if (readSize == 0) {
+    std::cerr << "The read size has to be positive" << std::endl;
+    return 1;
+  }
+  // The system temp directory is often a tmpfs, which doesn't support O_DIRECT. Pass a directory on the device to measure.
+  bf::path rootdir = (argc > 3 ? bf::path(argv[3]) : bf::temp_directory_path()) / bf::unique_path();
+  bf::create_directory(rootdir);
+
+  {
+    auto encKey = AES256_GCM::CreateKey(cpputils::Random::PseudoRandom());
+    Key blobKey = createBlob(rootdir, encKey, blobSize);
+    uint32_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    WorkerPool workers(numThreads, 4 * numThreads);
+
+    std::cout << "Sequential reads of " << readSize << " bytes from a blob of " << (blobSize / 1024 / 1024) << " MiB in " << rootdir.native() << std::endl;
+    std::cout << std::setw(14) << "window (KiB)" << std::setw(12) << "MiB/s" << std::setw(10) << "speedup" << std::endl;
+    double withoutReadAhead = 0;
+    for (uint64_t windowSize : vector<uint64_t>{0, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024}) {
+      double bytesPerSecond = measureBytesPerSecond(rootdir, encKey, blobKey, readSize, windowSize, &workers);
+      if (windowSize == 0) {
+        withoutReadAhead = bytesPerSecond;
+      }
+      std::cout << std::setw(14) << (windowSize / 1024)
+                << std::setw(12) << std::fixed << std::setprecision(1) << (bytesPerSecond / 1024 / 1024)
+                << std::setw(10) << std::setprecision(2) << (bytesPerSecond / withoutReadAhead) << std::endl;
+    }
+  }
+
+  bf::remove_all(rootdir);
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include <cryfs/filesystem/CryDevice.h>
+#include <fspp/fs_interface/Dir.h>
+#include <fspp/fs_interface/Node.h>
+#include <fspp/fs_interface/OpenFile.h>
+#include <blockstore/implementations/inmemory/InMemoryBlockStore.h>
+#include <cpp-utils/crypto/kdf/Scrypt.h>
+#include <cpp-utils/crypto/symmetric/ciphers.h>
+#include <cpp-utils/random/Random.h>
+#include <cpp-utils/tempfile/TempFile.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <sys/stat.h>
+
+// Measures how many stat() calls per second CryDevice answers for the files of a deep directory tree, like `find` or
+// `make` do on a large source checkout. All files are stat'ed in several rounds, first with the DentryCache disabled,
+// so each stat() loads and searches all directories along the path, and then with it enabled.
+// The blocks are kept in memory and fit into the block cache, so this measures the path resolution and not the disk.
+// Pass a larger tree, e.g. depth 8 with 5 subdirectories, to get close to a checkout with a million files.
+//
+// Usage: cryfs-benchmark-StatBenchmark [depth] [subdirectories per directory] [files per directory] [rounds]
+
+using blockstore::inmemory::InMemoryBlockStore;
+using cpputils::make_unique_ref;
+using cryfs::CryConfig;
+using cryfs::CryConfigFile;
+using cryfs::CryDevice;
+using std::string;
+using std::vector;
+
+namespace bf = boost::filesystem;
+
+namespace {
+
+constexpr mode_t MODE = S_IFREG | S_IRUSR | S_IWUSR;
+
+void createTree(CryDevice *device, const bf::path &dir, unsigned int depth, unsigned int numSubdirs, unsigned int numFiles, vector<bf::path> *files) {
+  auto dirNode = device->LoadDir(dir).value();
+  for (unsigned int i = 0; i < numFiles; ++i) {
+    string name = "file" + std::to_string(i) + ".cpp";
+    dirNode->createAndOpenFile(name, MODE, 0, 0);
+    files->push_back(dir / name);
+  }
+  if (depth == 0) {
+    return;
+  }
+  for (unsigned int i = 0; i < numSubdirs; ++i) {
+    string name = "dir" + std::to_string(i);
+    dirNode->createDir(name, S_IFDIR | S_IRWXU, 0, 0);
+    createTree(device, dir / name, depth - 1, numSubdirs, numFiles, files);
+  }
+}
+
+double measureStatsPerSecond(uint32_t maxCachedPaths, unsigned int depth, unsigned int numSubdirs, unsigned int numFiles, unsigned int numRounds, size_t *numFilesOut) {
+  cpputils::TempFile configFile(false);
+  CryConfig config;
+  config.SetCipher("aes-256-gcm");
+  config.SetEncryptionKey(cpputils::AES256_GCM::CreateKey(cpputils::Random::PseudoRandom()).ToString());
+  config.SetBlocksizeBytes(32 * 1024);
+  CryDevice device(CryConfigFile::create(configFile.path(), std::move(config), "password", cpputils::SCrypt::TestSettings),
+                   make_unique_ref<InMemoryBlockStore>(), CryDevice::DEFAULT_CACHE_SIZE_BYTES, maxCachedPaths);
+  vector<bf::path> files;
+  createTree(&device, "/", depth, numSubdirs, numFiles, &files);
+  *numFilesOut = files.size();
+
+  struct ::stat st;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int round = 0; round < numRounds; ++round) {
+    for (const bf::path &file : files) {
+      device.Load(file).value()->stat(&st);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return numRounds * files.size() / std::chrono::duration<double>(end - start).count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  unsigned int depth = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 6;
+  unsigned int numSubdirs = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 3;
+  unsigned int numFiles = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 10;
+  unsigned int numRounds = (argc > 4) ? std::strtoul(argv[4], nullptr, 10) : 3;
+
+  size_t numFilesInTree = 0;
+  double uncached = measureStatsPerSecond(0, depth, numSubdirs, numFiles, numRounds, &numFilesInTree);
+  double cached = measureStatsPerSecond(CryDevice::DEFAULT_MAX_CACHED_PATHS, depth, numSubdirs, numFiles, numRounds, &numFilesInTree);
+
+  std::cout << numRounds << " rounds of stat() on " << numFilesInTree << " files in a tree of depth " << depth << std::endl;
+  std::cout << std::fixed << std::setprecision(0);
+  std::cout << std::setw(24) << "without DentryCache: " << uncached << " stat/s" << std::endl;
+  std::cout << std::setw(24) << "with DentryCache: " << cached << " stat/s" << std::endl;
+  return 0;
+}
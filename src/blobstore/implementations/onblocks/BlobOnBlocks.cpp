@@ -4,6 +4,7 @@
 #include "datanodestore/DataLeafNode.h"
 #include "utils/Math.h"
 #include <cmath>
+#include <cstring>
 #include <cpp-utils/assert/assert.h>
 
 using std::function;
@@ -41,21 +42,30 @@ void BlobOnBlocks::traverseLeaves(uint64_t beginByte, uint64_t sizeBytes, functi
   uint64_t endByte = beginByte + sizeBytes;
   uint32_t firstLeaf = beginByte / _datatree->maxBytesPerLeaf();
   uint32_t endLeaf = utils::ceilDivision(endByte, _datatree->maxBytesPerLeaf());
-  bool writingOutside = size() < endByte; // TODO Calling size() is slow because it has to traverse the tree
-  _datatree->traverseLeaves(firstLeaf, endLeaf, [&func, beginByte, endByte, endLeaf, writingOutside](DataLeafNode *leaf, uint32_t leafIndex) {
+  ASSERT(endByte <= size(), "Traversing outside of the blob. Grow it first.");
+  // The callbacks only touch their own leaf and their own part of the source/target buffer, so they can run in parallel.
+  _datatree->traverseLeavesInParallel(firstLeaf, endLeaf, [&func, beginByte, endByte](DataLeafNode *leaf, uint32_t leafIndex) {
     uint64_t indexOfFirstLeafByte = leafIndex * leaf->maxStoreableBytes();
     uint32_t dataBegin = utils::maxZeroSubtraction(beginByte, indexOfFirstLeafByte);
     uint32_t dataEnd = std::min(leaf->maxStoreableBytes(), endByte - indexOfFirstLeafByte);
-    if (leafIndex == endLeaf-1 && writingOutside) {
-      // If we are traversing an area that didn't exist before, then the last leaf was just created with a wrong size. We have to fix it.
-      leaf->resize(dataEnd);
-    }
     func(indexOfFirstLeafByte, leaf, dataBegin, dataEnd-dataBegin);
   });
-  if (writingOutside) {
-    ASSERT(_datatree->numStoredBytes() == endByte, "Writing didn't grow by the correct number of bytes");
-    _sizeCache = endByte;
-  }
+}
+
+void BlobOnBlocks::readLeaves(uint64_t beginByte, uint64_t sizeBytes, function<void (uint64_t, const DataLeafNode *leaf, uint32_t, uint32_t)> func, function<void (uint64_t, uint64_t)> onHoles) const {
+  uint64_t endByte = beginByte + sizeBytes;
+  uint64_t maxBytesPerLeaf = _datatree->maxBytesPerLeaf();
+  uint32_t firstLeaf = beginByte / maxBytesPerLeaf;
+  uint32_t endLeaf = utils::ceilDivision(endByte, maxBytesPerLeaf);
+  ASSERT(endByte <= size(), "Reading outside of the blob.");
+  _datatree->readLeavesInParallel(firstLeaf, endLeaf, [&func, beginByte, endByte](const DataLeafNode *leaf, uint32_t leafIndex) {
+    uint64_t indexOfFirstLeafByte = leafIndex * leaf->maxStoreableBytes();
+    uint32_t dataBegin = utils::maxZeroSubtraction(beginByte, indexOfFirstLeafByte);
+    uint32_t dataEnd = std::min(leaf->maxStoreableBytes(), endByte - indexOfFirstLeafByte);
+    func(indexOfFirstLeafByte, leaf, dataBegin, dataEnd-dataBegin);
+  }, [&onHoles, beginByte, endByte, maxBytesPerLeaf] (uint32_t beginLeaf, uint32_t endLeaf) {
+    onHoles(std::max(beginByte, beginLeaf * maxBytesPerLeaf), std::min(endByte, endLeaf * maxBytesPerLeaf));
+  });
 }
 
 Data BlobOnBlocks::readAll() const {
@@ -74,25 +84,92 @@ void BlobOnBlocks::read(void *target, uint64_t offset, uint64_t count) const {
 
 uint64_t BlobOnBlocks::tryRead(void *target, uint64_t offset, uint64_t count) const {
   //TODO Quite inefficient to call size() here, because that has to traverse the tree
-  uint64_t realCount = std::max(UINT64_C(0), std::min(count, size()-offset));
+  uint64_t blobSize = size();
+  if (offset >= blobSize) {
+    // Reading outside of the blob must not grow it
+    return 0;
+  }
+  uint64_t realCount = std::min(count, blobSize - offset);
   _read(target, offset, realCount);
   return realCount;
 }
 
 void BlobOnBlocks::_read(void *target, uint64_t offset, uint64_t count) const {
-  traverseLeaves(offset, count, [target, offset] (uint64_t indexOfFirstLeafByte, const DataLeafNode *leaf, uint32_t leafDataOffset, uint32_t leafDataSize) {
+  readLeaves(offset, count, [target, offset] (uint64_t indexOfFirstLeafByte, const DataLeafNode *leaf, uint32_t leafDataOffset, uint32_t leafDataSize) {
       //TODO Simplify formula, make it easier to understand
       leaf->read((uint8_t*)target + indexOfFirstLeafByte - offset + leafDataOffset, leafDataOffset, leafDataSize);
+  }, [target, offset] (uint64_t holeBegin, uint64_t holeEnd) {
+      std::memset((uint8_t*)target + holeBegin - offset, 0, holeEnd - holeBegin);
   });
 }
 
 void BlobOnBlocks::write(const void *source, uint64_t offset, uint64_t count) {
+  if (size() < offset + count) {
+    // Growing first makes all written leaves exist, so overwriteFullLeaves() below doesn't skip the ones after the old end
+    resize(offset + count);
+  }
+  // Leaves that the write covers entirely are replaced without loading and decrypting their old content.
+  // Only the partially written leaves at the begin and end of the range are loaded and modified.
+  uint64_t maxBytesPerLeaf = _datatree->maxBytesPerLeaf();
+  uint64_t beginFullLeaves = utils::ceilDivision(offset, maxBytesPerLeaf);
+  uint64_t endFullLeaves = (offset + count) / maxBytesPerLeaf;
+  if (beginFullLeaves >= endFullLeaves) {
+    return _writeToLeaves(source, offset, count);
+  }
+  uint64_t fullBegin = beginFullLeaves * maxBytesPerLeaf;
+  uint64_t fullEnd = endFullLeaves * maxBytesPerLeaf;
+  if (offset < fullBegin) {
+    _writeToLeaves(source, offset, fullBegin - offset);
+  }
+  _datatree->overwriteFullLeaves(beginFullLeaves, endFullLeaves, [source, offset, maxBytesPerLeaf] (uint32_t leafIndex, void *target) {
+    std::memcpy(target, (uint8_t*)source + leafIndex * maxBytesPerLeaf - offset, maxBytesPerLeaf);
+  });
+  if (fullEnd < offset + count) {
+    _writeToLeaves((uint8_t*)source + fullEnd - offset, fullEnd, offset + count - fullEnd);
+  }
+}
+
+void BlobOnBlocks::_writeToLeaves(const void *source, uint64_t offset, uint64_t count) {
   traverseLeaves(offset, count, [source, offset] (uint64_t indexOfFirstLeafByte, DataLeafNode *leaf, uint32_t leafDataOffset, uint32_t leafDataSize) {
     //TODO Simplify formula, make it easier to understand
     leaf->write((uint8_t*)source + indexOfFirstLeafByte - offset + leafDataOffset, leafDataOffset, leafDataSize);
   });
 }
 
+void BlobOnBlocks::prefetch(uint64_t offset, uint64_t count) const {
+  // This usually runs in a background thread, so it asks the tree for the size instead of using _sizeCache
+  uint64_t blobSize = _datatree->numStoredBytes();
+  if (offset >= blobSize) {
+    return;
+  }
+  uint64_t endByte = offset + std::min(count, blobSize - offset);
+  uint64_t maxBytesPerLeaf = _datatree->maxBytesPerLeaf();
+  _datatree->prefetchLeaves(offset / maxBytesPerLeaf, utils::ceilDivision(endByte, maxBytesPerLeaf));
+}
+
+boost::optional<uint64_t> BlobOnBlocks::seekData(uint64_t offset) const {
+  if (offset >= size()) {
+    return boost::none;
+  }
+  uint64_t maxBytesPerLeaf = _datatree->maxBytesPerLeaf();
+  auto leaf = _datatree->firstLeafWithData(offset / maxBytesPerLeaf);
+  ASSERT(leaf != boost::none, "The last leaf always has data");
+  return std::max(offset, *leaf * maxBytesPerLeaf);
+}
+
+boost::optional<uint64_t> BlobOnBlocks::seekHole(uint64_t offset) const {
+  uint64_t blobSize = size();
+  if (offset >= blobSize) {
+    return boost::none;
+  }
+  uint64_t maxBytesPerLeaf = _datatree->maxBytesPerLeaf();
+  auto leaf = _datatree->firstLeafInHole(offset / maxBytesPerLeaf);
+  if (leaf == boost::none) {
+    return blobSize;
+  }
+  return std::max(offset, *leaf * maxBytesPerLeaf);
+}
+
 void BlobOnBlocks::flush() {
   _datatree->flush();
 }
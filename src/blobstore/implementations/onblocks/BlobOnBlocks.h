@@ -30,6 +30,10 @@ public:
   void read(void *target, uint64_t offset, uint64_t size) const override;
   uint64_t tryRead(void *target, uint64_t offset, uint64_t size) const override;
   void write(const void *source, uint64_t offset, uint64_t size) override;
+  void prefetch(uint64_t offset, uint64_t size) const override;
+
+  boost::optional<uint64_t> seekData(uint64_t offset) const override;
+  boost::optional<uint64_t> seekHole(uint64_t offset) const override;
 
   void flush() override;
 
@@ -38,7 +42,11 @@ public:
 private:
 
   void _read(void *target, uint64_t offset, uint64_t count) const;
+  void _writeToLeaves(const void *source, uint64_t offset, uint64_t count);
+  // The holes in the range are filled (see DataTree::traverseLeaves).
   void traverseLeaves(uint64_t offsetBytes, uint64_t sizeBytes, std::function<void (uint64_t, datanodestore::DataLeafNode *, uint32_t, uint32_t)>) const;
+  // Like traverseLeaves(), but only reads the leaves, see DataTree::readLeavesInParallel(). onHoles gets the range [begin, end) of bytes that are in holes.
+  void readLeaves(uint64_t offsetBytes, uint64_t sizeBytes, std::function<void (uint64_t, const datanodestore::DataLeafNode *, uint32_t, uint32_t)>, std::function<void (uint64_t, uint64_t)> onHoles) const;
 
   cpputils::unique_ref<parallelaccessdatatreestore::DataTreeRef> _datatree;
   mutable boost::optional<uint64_t> _sizeCache;
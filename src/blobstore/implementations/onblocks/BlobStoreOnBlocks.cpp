@@ -64,6 +64,10 @@ uint64_t BlobStoreOnBlocks::estimateSpaceForNumBlocksLeft() const {
     return _dataTreeStore->estimateSpaceForNumNodesLeft();
 }
 
+void BlobStoreOnBlocks::waitForPendingWrites() {
+    _dataTreeStore->waitForPendingWrites();
+}
+
 
 }
 }
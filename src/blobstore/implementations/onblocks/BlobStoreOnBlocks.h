@@ -30,6 +30,8 @@ public:
   uint64_t numBlocks() const override;
   uint64_t estimateSpaceForNumBlocksLeft() const override;
 
+  void waitForPendingWrites() override;
+
 private:
   cpputils::unique_ref<parallelaccessdatatreestore::ParallelAccessDataTreeStore> _dataTreeStore;
 
@@ -12,10 +12,12 @@ namespace blobstore {
 namespace onblocks {
 namespace datanodestore {
 
+constexpr uint16_t DataInnerNode::FORMAT_VERSION_HEADER_WITH_HOLES;
+
 DataInnerNode::DataInnerNode(DataNodeView view)
 : DataNode(std::move(view)) {
   ASSERT(depth() > 0, "Inner node can't have depth 0. Is this a leaf maybe?");
-  if (node().FormatVersion() != FORMAT_VERSION_HEADER) {
+  if (node().FormatVersion() != FORMAT_VERSION_HEADER && node().FormatVersion() != FORMAT_VERSION_HEADER_WITH_HOLES) {
     throw std::runtime_error("This node format is not supported. Was it created with a newer version of CryFS?");
   }
 }
@@ -33,6 +35,21 @@ unique_ref<DataInnerNode> DataInnerNode::InitializeNewNode(unique_ref<Block> blo
   return result;
 }
 
+unique_ref<DataInnerNode> DataInnerNode::InitializeNewNodeOfHoles(unique_ref<Block> block, uint8_t depth, uint32_t numHoles) {
+  ASSERT(depth > 0, "Inner node can't have depth 0");
+  ASSERT(numHoles > 0, "Inner node must have at least one child");
+  DataNodeView node(std::move(block));
+  node.setFormatVersion(FORMAT_VERSION_HEADER_WITH_HOLES);
+  node.setDepth(depth);
+  node.setSize(numHoles);
+  auto result = make_unique_ref<DataInnerNode>(std::move(node));
+  ASSERT(numHoles <= result->maxStoreableChildren(), "Adding more children than we can store");
+  for (uint32_t i = 0; i < numHoles; ++i) {
+    result->getChild(i)->setHole();
+  }
+  return result;
+}
+
 uint32_t DataInnerNode::numChildren() const {
   return node().Size();
 }
@@ -77,6 +94,22 @@ void DataInnerNode::addChild(const DataNode &child) {
   LastChild()->setKey(child.key());
 }
 
+void DataInnerNode::addHole() {
+  ASSERT(numChildren() < maxStoreableChildren(), "Adding more children than we can store");
+  node().setFormatVersion(FORMAT_VERSION_HEADER_WITH_HOLES);
+  node().setSize(node().Size()+1);
+  LastChild()->setHole();
+}
+
+void DataInnerNode::fillHole(unsigned int index, const DataNode &child) {
+  ASSERT(getChild(index)->isHole(), "Child isn't a hole");
+  ASSERT(child.depth() == depth()-1, "The child that should be added has wrong depth");
+  // Goes through the block instead of writing the entry in place, so that the block knows it was modified
+  uint8_t keydata[blockstore::Key::BINARY_LENGTH];
+  child.key().ToBinary(keydata);
+  node().write(keydata, index * sizeof(ChildEntry), sizeof(keydata));
+}
+
 void DataInnerNode::removeLastChild() {
   ASSERT(node().Size() > 1, "There is no child to remove");
   node().setSize(node().Size()-1);
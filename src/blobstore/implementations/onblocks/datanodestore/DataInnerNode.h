@@ -12,6 +12,7 @@ namespace datanodestore {
 class DataInnerNode final: public DataNode {
 public:
   static cpputils::unique_ref<DataInnerNode> InitializeNewNode(cpputils::unique_ref<blockstore::Block> block, const DataNode &first_child_key);
+  static cpputils::unique_ref<DataInnerNode> InitializeNewNodeOfHoles(cpputils::unique_ref<blockstore::Block> block, uint8_t depth, uint32_t numHoles);
 
   DataInnerNode(DataNodeView block);
   ~DataInnerNode();
@@ -27,12 +28,18 @@ public:
 
   void addChild(const DataNode &child_key);
 
+  void addHole();
+
+  void fillHole(unsigned int index, const DataNode &child);
+
   void removeLastChild();
 
   ChildEntry *LastChild();
   const ChildEntry *LastChild() const;
 
 private:
+  // Older versions don't know about holes. Nodes that can have holes get a new format version, so they refuse to load them.
+  static constexpr uint16_t FORMAT_VERSION_HEADER_WITH_HOLES = 1;
 
   ChildEntry *ChildrenBegin();
   ChildEntry *ChildrenEnd();
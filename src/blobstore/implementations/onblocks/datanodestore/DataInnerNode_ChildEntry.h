@@ -3,6 +3,9 @@
 #define MESSMER_BLOBSTORE_IMPLEMENTATIONS_ONBLOCKS_DATANODESTORE_DATAINNERNODE_CHILDENTRY_H_
 
 #include <cpp-utils/macros.h>
+#include <cpp-utils/assert/assert.h>
+#include <algorithm>
+#include <cstring>
 
 namespace blobstore{
 namespace onblocks{
@@ -11,12 +14,21 @@ namespace datanodestore{
 struct DataInnerNode_ChildEntry final {
 public:
   blockstore::Key key() const {
+    ASSERT(!isHole(), "A hole doesn't have a key");
     return blockstore::Key::FromBinary(_keydata);
   }
+  // A hole is a child that doesn't exist in the block store. It stands for a full subtree that only contains zeroes.
+  // It is stored as a key with all bits zero.
+  bool isHole() const {
+    return std::all_of(_keydata, _keydata + blockstore::Key::BINARY_LENGTH, [] (uint8_t byte) {return byte == 0;});
+  }
 private:
   void setKey(const blockstore::Key &key) {
     key.ToBinary(_keydata);
   }
+  void setHole() {
+    std::memset(_keydata, 0, blockstore::Key::BINARY_LENGTH);
+  }
   friend class DataInnerNode;
   uint8_t _keydata[blockstore::Key::BINARY_LENGTH];
 
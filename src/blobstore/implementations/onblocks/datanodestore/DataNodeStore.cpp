@@ -5,6 +5,9 @@
 #include <blockstore/interface/Block.h>
 #include <blockstore/utils/BlockStoreUtils.h>
 #include <cpp-utils/assert/assert.h>
+#include <algorithm>
+#include <thread>
+#include <cstring>
 
 using blockstore::BlockStore;
 using blockstore::Block;
@@ -15,13 +18,18 @@ using cpputils::make_unique_ref;
 using std::runtime_error;
 using boost::optional;
 using boost::none;
+using std::vector;
+using std::function;
+using cpputils::WorkerPool;
 
 namespace blobstore {
 namespace onblocks {
 namespace datanodestore {
 
 DataNodeStore::DataNodeStore(unique_ref<BlockStore> blockstore, uint64_t physicalBlocksizeBytes)
-: _blockstore(std::move(blockstore)), _layout(_blockstore->blockSizeFromPhysicalBlockSize(physicalBlocksizeBytes)) {
+: _blockstore(std::move(blockstore)), _layout(_blockstore->blockSizeFromPhysicalBlockSize(physicalBlocksizeBytes)),
+  _blockHeadroomBytes(physicalBlocksizeBytes - _layout.blocksizeBytes()),
+  _traversalWorkersStarted(), _traversalWorkers(nullptr) {
 }
 
 DataNodeStore::~DataNodeStore() {
@@ -43,16 +51,25 @@ unique_ref<DataNode> DataNodeStore::load(unique_ref<Block> block) {
 unique_ref<DataInnerNode> DataNodeStore::createNewInnerNode(const DataNode &first_child) {
   ASSERT(first_child.node().layout().blocksizeBytes() == _layout.blocksizeBytes(), "Source node has wrong layout. Is it from the same DataNodeStore?");
   //TODO Initialize block and then create it in the blockstore - this is more efficient than creating it and then writing to it
-  auto block = _blockstore->create(Data(_layout.blocksizeBytes()).FillWithZeroes());
+  auto block = _blockstore->create(_newBlockData().FillWithZeroes());
   return DataInnerNode::InitializeNewNode(std::move(block), first_child);
 }
 
+unique_ref<DataInnerNode> DataNodeStore::createNewInnerNodeOfHoles(uint8_t depth, uint32_t numHoles) {
+  auto block = _blockstore->create(_newBlockData().FillWithZeroes());
+  return DataInnerNode::InitializeNewNodeOfHoles(std::move(block), depth, numHoles);
+}
+
 unique_ref<DataLeafNode> DataNodeStore::createNewLeafNode() {
   //TODO Initialize block and then create it in the blockstore - this is more efficient than creating it and then writing to it
-  auto block = _blockstore->create(Data(_layout.blocksizeBytes()).FillWithZeroes());
+  auto block = _blockstore->create(_newBlockData().FillWithZeroes());
   return DataLeafNode::InitializeNewNode(std::move(block));
 }
 
+Data DataNodeStore::_newBlockData() const {
+  return Data(_layout.blocksizeBytes(), _blockHeadroomBytes);
+}
+
 optional<unique_ref<DataNode>> DataNodeStore::load(const Key &key) {
   auto block = _blockstore->load(key);
   if (block == none) {
@@ -62,6 +79,44 @@ optional<unique_ref<DataNode>> DataNodeStore::load(const Key &key) {
   }
 }
 
+vector<optional<unique_ref<DataNode>>> DataNodeStore::loadMany(const vector<Key> &keys) {
+  auto blocks = _blockstore->loadMany(keys);
+  // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+  vector<optional<unique_ref<DataNode>>> result(blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (blocks[i] != none) {
+      result[i] = load(std::move(*blocks[i]));
+    }
+  }
+  return result;
+}
+
+void DataNodeStore::prefetchMany(const vector<Key> &keys) {
+  _blockstore->prefetchMany(keys);
+}
+
+void DataNodeStore::overwriteWithFullLeaves(const vector<Key> &keys, const function<void (size_t, void*)> &fill) {
+  // Stored in batches of the size of an inner node, so large writes don't hold all their blocks in memory at once
+  const size_t batchSize = _layout.maxChildrenPerInnerNode();
+  const uint32_t leafSize = _layout.maxBytesPerLeaf();
+  for (size_t batchBegin = 0; batchBegin < keys.size(); batchBegin += batchSize) {
+    size_t batchEnd = std::min(keys.size(), batchBegin + batchSize);
+    vector<std::pair<Key, Data>> blocks;
+    blocks.reserve(batchEnd - batchBegin);
+    for (size_t i = batchBegin; i < batchEnd; ++i) {
+      // Same header as DataLeafNode::InitializeNewNode() writes, followed by the content
+      Data block = _newBlockData();
+      std::memset(block.data(), 0, DataNodeLayout::HEADERSIZE_BYTES);
+      uint16_t formatVersion = DataNode::FORMAT_VERSION_HEADER;
+      std::memcpy((uint8_t*)block.data() + DataNodeLayout::FORMAT_VERSION_OFFSET_BYTES, &formatVersion, sizeof(formatVersion));
+      std::memcpy((uint8_t*)block.data() + DataNodeLayout::SIZE_OFFSET_BYTES, &leafSize, sizeof(leafSize));
+      fill(i, (uint8_t*)block.data() + DataNodeLayout::HEADERSIZE_BYTES);
+      blocks.emplace_back(keys[i], std::move(block));
+    }
+    _blockstore->storeMany(std::move(blocks));
+  }
+}
+
 unique_ref<DataNode> DataNodeStore::createNewNodeAsCopyFrom(const DataNode &source) {
   ASSERT(source.node().layout().blocksizeBytes() == _layout.blocksizeBytes(), "Source node has wrong layout. Is it from the same DataNodeStore?");
   auto newBlock = blockstore::utils::copyToNewBlock(_blockstore.get(), source.node().block());
@@ -88,6 +143,10 @@ void DataNodeStore::remove(unique_ref<DataNode> node) {
   _blockstore->remove(std::move(block));
 }
 
+void DataNodeStore::waitForPendingWrites() {
+  _blockstore->waitForPendingWrites();
+}
+
 uint64_t DataNodeStore::numNodes() const {
   return _blockstore->numBlocks();
 }
@@ -101,18 +160,56 @@ uint64_t DataNodeStore::virtualBlocksizeBytes() const {
 }
 
 void DataNodeStore::removeSubtree(unique_ref<DataNode> node) {
-  //TODO Make this faster by not loading the leaves but just deleting them. Can be recognized, because of the depth of their parents.
   DataInnerNode *inner = dynamic_cast<DataInnerNode*>(node.get());
   if (inner != nullptr) {
-    for (uint32_t i = 0; i < inner->numChildren(); ++i) {
-      auto child = load(inner->getChild(i)->key());
-      ASSERT(child != none, "Couldn't load child node");
-      removeSubtree(std::move(*child));
-    }
+    vector<Key> childKeys;
+    _appendChildKeys(*inner, &childKeys);
+    removeSubtrees(inner->depth()-1, childKeys);
   }
   remove(std::move(node));
 }
 
+void DataNodeStore::removeSubtrees(uint8_t depth, const vector<Key> &keys) {
+  // The subtrees are removed level by level. The depth tells us when we reached the leaves,
+  // so they can be removed by key without loading and decrypting them.
+  if (depth > 0) {
+    vector<Key> childKeys;
+    {
+      auto nodes = loadMany(keys);
+      for (auto &node : nodes) {
+        ASSERT(node != none, "Couldn't load node of the subtree");
+        DataInnerNode *inner = dynamic_cast<DataInnerNode*>(node->get());
+        ASSERT(inner != nullptr && inner->depth() == depth, "Node of the subtree has wrong depth");
+        _appendChildKeys(*inner, &childKeys);
+      }
+    } // The nodes must not be loaded anymore when they are removed
+    removeSubtrees(depth-1, childKeys);
+  }
+  // Removed in batches of the size of an inner node, so removing a large file doesn't hand all its blocks to the block store at once
+  const size_t batchSize = _layout.maxChildrenPerInnerNode();
+  for (size_t batchBegin = 0; batchBegin < keys.size(); batchBegin += batchSize) {
+    size_t batchEnd = std::min(keys.size(), batchBegin + batchSize);
+    _blockstore->removeMany(vector<Key>(keys.begin() + batchBegin, keys.begin() + batchEnd));
+  }
+}
+
+void DataNodeStore::_appendChildKeys(const DataInnerNode &node, vector<Key> *keys) {
+  for (uint32_t i = 0; i < node.numChildren(); ++i) {
+    // Holes don't have a node
+    if (!node.getChild(i)->isHole()) {
+      keys->push_back(node.getChild(i)->key());
+    }
+  }
+}
+
+WorkerPool *DataNodeStore::traversalWorkers() {
+  std::call_once(_traversalWorkersStarted, [this] {
+    uint32_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    _traversalWorkers = std::make_unique<WorkerPool>(numThreads, numThreads);
+  });
+  return _traversalWorkers.get();
+}
+
 DataNodeLayout DataNodeStore::layout() const {
   return _layout;
 }
@@ -6,6 +6,10 @@
 #include <cpp-utils/macros.h>
 #include "DataNodeView.h"
 #include <blockstore/utils/Key.h>
+#include <cpp-utils/thread/WorkerPool.h>
+#include <mutex>
+#include <functional>
+#include <vector>
 
 namespace blockstore{
 class Block;
@@ -29,9 +33,17 @@ public:
   DataNodeLayout layout() const;
 
   boost::optional<cpputils::unique_ref<DataNode>> load(const blockstore::Key &key);
+  // Loads the nodes in one batch from the block store. Returns one entry per key, in the order of the keys.
+  std::vector<boost::optional<cpputils::unique_ref<DataNode>>> loadMany(const std::vector<blockstore::Key> &keys);
+  // Loads the nodes into the cache of the block store in the background, see BlockStore::prefetchMany().
+  void prefetchMany(const std::vector<blockstore::Key> &keys);
+  // Replaces the existing leaves with the given keys by full leaves, without loading and decrypting their old content.
+  // fill(i, target) has to write the layout().maxBytesPerLeaf() bytes of new content of the leaf keys[i] to target.
+  void overwriteWithFullLeaves(const std::vector<blockstore::Key> &keys, const std::function<void (size_t, void*)> &fill);
 
   cpputils::unique_ref<DataLeafNode> createNewLeafNode();
   cpputils::unique_ref<DataInnerNode> createNewInnerNode(const DataNode &first_child);
+  cpputils::unique_ref<DataInnerNode> createNewInnerNodeOfHoles(uint8_t depth, uint32_t numHoles);
 
   cpputils::unique_ref<DataNode> createNewNodeAsCopyFrom(const DataNode &source);
 
@@ -39,19 +51,35 @@ public:
 
   void remove(cpputils::unique_ref<DataNode> node);
 
+  // Only the inner nodes of the subtree are loaded. The leaves are removed by their key, without loading them.
   void removeSubtree(cpputils::unique_ref<DataNode> node);
+  // Removes the subtrees with the given root nodes, which all have the given depth.
+  void removeSubtrees(uint8_t depth, const std::vector<blockstore::Key> &keys);
 
   //TODO Test blocksizeBytes/numBlocks/estimateSpaceForNumBlocksLeft
   uint64_t virtualBlocksizeBytes() const;
   uint64_t numNodes() const;
   uint64_t estimateSpaceForNumNodesLeft() const;
+  // See BlockStore::waitForPendingWrites()
+  void waitForPendingWrites();
   //TODO Test overwriteNodeWith(), createNodeAsCopyFrom(), removeSubtree()
 
+  // Worker threads shared by all trees of this store to process the leaves of large traversals in parallel.
+  cpputils::WorkerPool *traversalWorkers();
+
 private:
   cpputils::unique_ref<DataNode> load(cpputils::unique_ref<blockstore::Block> block);
+  static void _appendChildKeys(const DataInnerNode &node, std::vector<blockstore::Key> *keys);
+  cpputils::Data _newBlockData() const;
 
   cpputils::unique_ref<blockstore::BlockStore> _blockstore;
   const DataNodeLayout _layout;
+  // The block store layers prepend their headers to the data of new blocks. Reserving their overhead
+  // in front of the data lets them do that without copying the block.
+  const uint64_t _blockHeadroomBytes;
+  // The threads are only started when the first large traversal runs.
+  std::once_flag _traversalWorkersStarted;
+  std::unique_ptr<cpputils::WorkerPool> _traversalWorkers;
 
   DISALLOW_COPY_AND_ASSIGN(DataNodeStore);
 };
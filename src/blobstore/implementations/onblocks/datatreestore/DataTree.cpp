@@ -5,8 +5,6 @@
 #include "../datanodestore/DataLeafNode.h"
 #include "../utils/Math.h"
 
-#include "impl/algorithms.h"
-
 #include <cpp-utils/pointer/cast.h>
 #include <cpp-utils/pointer/optional_ownership_ptr.h>
 #include <cmath>
@@ -32,27 +30,21 @@ using cpputils::optional_ownership_ptr;
 using cpputils::WithOwnership;
 using cpputils::WithoutOwnership;
 using cpputils::unique_ref;
+using cpputils::Data;
 
 namespace blobstore {
 namespace onblocks {
 namespace datatreestore {
 
+constexpr uint32_t DataTree::MIN_LEAVES_FOR_PARALLEL_TRAVERSAL;
+
 DataTree::DataTree(DataNodeStore *nodeStore, unique_ref<DataNode> rootNode)
-  : _mutex(), _nodeStore(nodeStore), _rootNode(std::move(rootNode)) {
+  : _mutex(), _nodeStore(nodeStore), _rootNode(std::move(rootNode)), _sizeCacheMutex(), _sizeCache(none) {
 }
 
 DataTree::~DataTree() {
 }
 
-void DataTree::removeLastDataLeaf() {
-  auto deletePosOrNull = algorithms::GetLowestRightBorderNodeWithMoreThanOneChildOrNull(_nodeStore, _rootNode.get());
-  ASSERT(deletePosOrNull.get() != nullptr, "Tree has only one leaf, can't shrink it.");
-
-  deleteLastChildSubtree(deletePosOrNull.get());
-
-  ifRootHasOnlyOneChildReplaceRootWithItsChild();
-}
-
 void DataTree::ifRootHasOnlyOneChildReplaceRootWithItsChild() {
   DataInnerNode *rootNode = dynamic_cast<DataInnerNode*>(_rootNode.get());
   ASSERT(rootNode != nullptr, "RootNode is not an inner node");
@@ -64,29 +56,6 @@ void DataTree::ifRootHasOnlyOneChildReplaceRootWithItsChild() {
   }
 }
 
-void DataTree::deleteLastChildSubtree(DataInnerNode *node) {
-  auto lastChild = _nodeStore->load(node->LastChild()->key());
-  ASSERT(lastChild != none, "Couldn't load last child");
-  _nodeStore->removeSubtree(std::move(*lastChild));
-  node->removeLastChild();
-}
-
-unique_ref<DataLeafNode> DataTree::addDataLeaf() {
-  auto insertPosOrNull = algorithms::GetLowestInnerRightBorderNodeWithLessThanKChildrenOrNull(_nodeStore, _rootNode.get());
-  if (insertPosOrNull) {
-    return addDataLeafAt(insertPosOrNull.get());
-  } else {
-    return addDataLeafToFullTree();
-  }
-}
-
-unique_ref<DataLeafNode> DataTree::addDataLeafAt(DataInnerNode *insertPos) {
-  auto new_leaf = _nodeStore->createNewLeafNode();
-  auto chain = createChainOfInnerNodes(insertPos->depth()-1, new_leaf.get());
-  insertPos->addChild(*chain);
-  return new_leaf;
-}
-
 optional_ownership_ptr<DataNode> DataTree::createChainOfInnerNodes(unsigned int num, DataNode *child) {
   //TODO This function is implemented twice, once with optional_ownership_ptr, once with unique_ref. Redundancy!
   optional_ownership_ptr<DataNode> chain = cpputils::WithoutOwnership<DataNode>(child);
@@ -115,12 +84,6 @@ DataInnerNode* DataTree::increaseTreeDepth(unsigned int levels) {
   return result;
 }
 
-unique_ref<DataLeafNode> DataTree::addDataLeafToFullTree() {
-  DataInnerNode *rootNode = increaseTreeDepth(1);
-  auto newLeaf = addDataLeafAt(rootNode);
-  return newLeaf;
-}
-
 const Key &DataTree::key() const {
   return _rootNode->key();
 }
@@ -139,67 +102,119 @@ unique_ref<DataNode> DataTree::releaseRootNode() {
 //TODO Test numLeaves(), for example also two configurations with same number of bytes but different number of leaves (last leaf has 0 bytes)
 uint32_t DataTree::numLeaves() const {
   shared_lock<shared_mutex> lock(_mutex);
-  return _numLeaves(*_rootNode);
+  return _sizes().numLeaves;
 }
 
-uint32_t DataTree::_numLeaves(const DataNode &node) const {
-  const DataLeafNode *leaf = dynamic_cast<const DataLeafNode*>(&node);
-  if (leaf != nullptr) {
-    return 1;
+DataTree::Sizes DataTree::_sizes() const {
+  std::lock_guard<std::mutex> lock(_sizeCacheMutex);
+  if (_sizeCache == none) {
+    _sizeCache = _computeSizes();
   }
+  return *_sizeCache;
+}
 
-  const DataInnerNode &inner = dynamic_cast<const DataInnerNode&>(node);
-  uint64_t numLeavesInLeftChildren = (uint64_t)(inner.numChildren()-1) * leavesPerFullChild(inner);
-  auto lastChild = _nodeStore->load(inner.LastChild()->key());
-  ASSERT(lastChild != none, "Couldn't load last child");
-  uint64_t numLeavesInRightChild = _numLeaves(**lastChild);
+void DataTree::_setSizes(const Sizes &sizes) {
+  std::lock_guard<std::mutex> lock(_sizeCacheMutex);
+  _sizeCache = sizes;
+}
+
+void DataTree::_invalidateSizes() {
+  std::lock_guard<std::mutex> lock(_sizeCacheMutex);
+  _sizeCache = none;
+}
 
-  return numLeavesInLeftChildren + numLeavesInRightChild;
+DataTree::Sizes DataTree::_computeSizes() const {
+  // All children left of the right border are full, so we only have to walk down the right border to the last leaf.
+  uint64_t numLeavesLeftOfBorder = 0;
+  const DataNode *node = _rootNode.get();
+  boost::optional<unique_ref<DataNode>> loadedNode = none;
+  while (const DataInnerNode *inner = dynamic_cast<const DataInnerNode*>(node)) {
+    numLeavesLeftOfBorder += (uint64_t)(inner->numChildren()-1) * leavesPerFullChild(*inner);
+    auto lastChild = _nodeStore->load(inner->LastChild()->key());
+    ASSERT(lastChild != none, "Couldn't load last child");
+    loadedNode = std::move(*lastChild);
+    node = loadedNode->get();
+  }
+  const DataLeafNode *lastLeaf = dynamic_cast<const DataLeafNode*>(node);
+  ASSERT(lastLeaf != nullptr, "Node is neither a leaf nor an inner node");
+  return Sizes{static_cast<uint32_t>(numLeavesLeftOfBorder + 1), numLeavesLeftOfBorder * _nodeStore->layout().maxBytesPerLeaf() + lastLeaf->numBytes()};
+}
+
+void DataTree::traverseLeaves(uint32_t beginIndex, uint32_t endIndex, function<void (DataLeafNode*, uint32_t)> func, function<void (uint32_t, uint32_t)> onHoles) {
+  _traverseLeaves(beginIndex, endIndex, false, std::move(func), std::move(onHoles));
+}
+
+void DataTree::traverseLeavesInParallel(uint32_t beginIndex, uint32_t endIndex, function<void (DataLeafNode*, uint32_t)> func, function<void (uint32_t, uint32_t)> onHoles) {
+  _traverseLeaves(beginIndex, endIndex, true, std::move(func), std::move(onHoles));
+}
+
+void DataTree::readLeavesInParallel(uint32_t beginIndex, uint32_t endIndex, function<void (const DataLeafNode*, uint32_t)> func, function<void (uint32_t, uint32_t)> onHoles) {
+  ASSERT(beginIndex <= endIndex, "Invalid parameters");
+  // Reading doesn't change the leaves or the tree structure, so several reads (e.g. of different processes) can run at the same time.
+  shared_lock<shared_mutex> lock(_mutex);
+  uint32_t numLeaves = _sizes().numLeaves;
+  if (numLeaves < endIndex) {
+    // The tree was shrunk by another user since the caller got its size. The missing leaves read as zeroes.
+    onHoles(std::max(beginIndex, numLeaves), endIndex);
+    endIndex = std::max(beginIndex, numLeaves);
+  }
+  if (beginIndex == endIndex) {
+    return;
+  }
+  _traverseLeaves(_rootNode.get(), 0, beginIndex, endIndex, true, [&func] (DataLeafNode *leaf, uint32_t leafIndex) {
+    func(leaf, leafIndex);
+  }, &onHoles);
 }
 
-void DataTree::traverseLeaves(uint32_t beginIndex, uint32_t endIndex, function<void (DataLeafNode*, uint32_t)> func) {
-  //TODO Can we traverse in parallel?
-  unique_lock<shared_mutex> lock(_mutex); //TODO Only lock when resizing. Otherwise parallel read/write to a blob is not possible!
+void DataTree::_traverseLeaves(uint32_t beginIndex, uint32_t endIndex, bool parallel, function<void (DataLeafNode*, uint32_t)> func, function<void (uint32_t, uint32_t)> onHoles) {
   ASSERT(beginIndex <= endIndex, "Invalid parameters");
   if (0 == endIndex) {
     // In this case the utils::ceilLog(_, endIndex) below would fail
     return;
   }
 
+  // func can change the leaves, e.g. write to them, and filling holes or growing changes the tree structure.
+  // Both must not happen while another traversal reads or writes the same leaves.
+  unique_lock<shared_mutex> lock(_mutex);
+  uint32_t numLeaves = _sizes().numLeaves;
+  if (endIndex <= numLeaves) {
+    return _traverseLeaves(_rootNode.get(), 0, beginIndex, endIndex, parallel, func, onHoles ? &onHoles : nullptr);
+  }
+
+  // The traversal grows the tree.
   uint8_t neededTreeDepth = utils::ceilLog(_nodeStore->layout().maxChildrenPerInnerNode(), (uint64_t)endIndex);
-  uint32_t numLeaves = this->_numLeaves(*_rootNode); // TODO Querying the size causes a tree traversal down to the leaves. Possible without querying the size?
+  // The callbacks of a growing traversal may resize leaves, so we can't tell the new size. It is computed again when queried.
+  _invalidateSizes();
   if (_rootNode->depth() < neededTreeDepth) {
     //TODO Test cases that actually increase it here by 0 level / 1 level / more than 1 level
     increaseTreeDepth(neededTreeDepth - _rootNode->depth());
   }
 
-  if (numLeaves <= beginIndex) {
-    //TODO Test cases with numLeaves < / >= beginIndex
-    // There is a gap between the current size and the begin of the traversal
-    return _traverseLeaves(_rootNode.get(), 0, numLeaves-1, endIndex, [beginIndex, numLeaves, &func, this](DataLeafNode* node, uint32_t index) {
-      if (index >= beginIndex) {
-        func(node, index);
-      } else if (index == numLeaves - 1) {
-        // It is the old last leaf - resize it to maximum
-        node->resize(_nodeStore->layout().maxBytesPerLeaf());
-      }
-    });
-  } else if (numLeaves < endIndex) {
-    // We are starting traversal in the valid region, but traverse until after it (we grow new leaves)
-    return _traverseLeaves(_rootNode.get(), 0, beginIndex, endIndex, [numLeaves, &func, this] (DataLeafNode *node, uint32_t index) {
+  if (numLeaves < beginIndex) {
+    // There is a gap between the current size and the begin of the traversal. It is filled with holes.
+    _growTo(numLeaves, beginIndex);
+    numLeaves = beginIndex;
+  } else if (numLeaves == beginIndex) {
+    // The old last leaf isn't traversed, but isn't the last one anymore afterwards
+    LastLeaf(_rootNode.get())->resize(_nodeStore->layout().maxBytesPerLeaf());
+  }
+
+  if (numLeaves < endIndex) {
+    // We traverse until after the end of the tree (we grow new leaves)
+    return _traverseLeaves(_rootNode.get(), 0, beginIndex, endIndex, parallel, [numLeaves, &func, this] (DataLeafNode *node, uint32_t index) {
       if (index == numLeaves - 1) {
         // It is the old last leaf  - resize it to maximum
         node->resize(_nodeStore->layout().maxBytesPerLeaf());
       }
       func(node, index);
-    });
+    }, nullptr);
   } else {
     //We are traversing entirely inside the valid region
-    _traverseLeaves(_rootNode.get(), 0, beginIndex, endIndex, func);
+    _traverseLeaves(_rootNode.get(), 0, beginIndex, endIndex, parallel, func, nullptr);
   }
 }
 
-void DataTree::_traverseLeaves(DataNode *root, uint32_t leafOffset, uint32_t beginIndex, uint32_t endIndex, function<void (DataLeafNode*, uint32_t)> func) {
+void DataTree::_traverseLeaves(DataNode *root, uint32_t leafOffset, uint32_t beginIndex, uint32_t endIndex, bool parallel, const function<void (DataLeafNode*, uint32_t)> &func, const function<void (uint32_t, uint32_t)> *onHoles) {
   DataLeafNode *leaf = dynamic_cast<DataLeafNode*>(root);
   if (leaf != nullptr) {
     ASSERT(beginIndex <= 1 && endIndex <= 1, "If root node is a leaf, the (sub)tree has only one leaf - access indices must be 0 or 1.");
@@ -213,34 +228,87 @@ void DataTree::_traverseLeaves(DataNode *root, uint32_t leafOffset, uint32_t beg
   uint32_t leavesPerChild = leavesPerFullChild(*inner);
   uint32_t beginChild = beginIndex/leavesPerChild;
   uint32_t endChild = utils::ceilDivision(endIndex, leavesPerChild);
-  vector<unique_ref<DataNode>> children = getOrCreateChildren(inner, beginChild, endChild);
+  vector<boost::optional<unique_ref<DataNode>>> children = getOrCreateChildren(inner, beginChild, endChild, onHoles == nullptr);
+
+  if (parallel && inner->depth() == 1 && children.size() >= MIN_LEAVES_FOR_PARALLEL_TRAVERSAL) {
+    // The children are leaves and each of them is in the range. Growing the tree happened in getOrCreateChildren() above,
+    // so the callbacks only touch their own leaf and can run concurrently.
+    _nodeStore->traversalWorkers()->parallelFor(children.size(), [&children, &func, onHoles, leafOffset, beginChild] (size_t index) {
+      uint32_t leafIndex = leafOffset + beginChild + index;
+      if (children[index] == none) {
+        (*onHoles)(leafIndex, leafIndex + 1);
+        return;
+      }
+      DataLeafNode *leaf = dynamic_cast<DataLeafNode*>(children[index]->get());
+      ASSERT(leaf != nullptr, "Child of an inner node with depth 1 is not a leaf");
+      func(leaf, leafIndex);
+    });
+    return;
+  }
 
   for (uint32_t childIndex = beginChild; childIndex < endChild; ++childIndex) {
     uint32_t childOffset = childIndex * leavesPerChild;
     uint32_t localBeginIndex = utils::maxZeroSubtraction(beginIndex, childOffset);
     uint32_t localEndIndex = std::min(leavesPerChild, endIndex - childOffset);
-    auto child = std::move(children[childIndex-beginChild]);
-    _traverseLeaves(child.get(), leafOffset + childOffset, localBeginIndex, localEndIndex, func);
+    auto &child = children[childIndex-beginChild];
+    if (child == none) {
+      (*onHoles)(leafOffset + childOffset + localBeginIndex, leafOffset + childOffset + localEndIndex);
+    } else {
+      _traverseLeaves(child->get(), leafOffset + childOffset, localBeginIndex, localEndIndex, parallel, func, onHoles);
+    }
   }
 }
 
-vector<unique_ref<DataNode>> DataTree::getOrCreateChildren(DataInnerNode *node, uint32_t begin, uint32_t end) {
-  vector<unique_ref<DataNode>> children;
-  children.reserve(end-begin);
-  for (uint32_t childIndex = begin; childIndex < std::min(node->numChildren(), end); ++childIndex) {
-    auto child = _nodeStore->load(node->getChild(childIndex)->key());
-    ASSERT(child != none, "Couldn't load child node");
-    children.emplace_back(std::move(*child));
+vector<boost::optional<unique_ref<DataNode>>> DataTree::getOrCreateChildren(DataInnerNode *node, uint32_t begin, uint32_t end, bool fillHoles) {
+  // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+  vector<boost::optional<unique_ref<DataNode>>> children(end-begin);
+  uint32_t endOfExistingChildren = std::min(node->numChildren(), end);
+  vector<Key> existingChildKeys;
+  for (uint32_t childIndex = begin; childIndex < endOfExistingChildren; ++childIndex) {
+    if (!node->getChild(childIndex)->isHole()) {
+      existingChildKeys.push_back(node->getChild(childIndex)->key());
+    }
+  }
+  // Loading them in one batch allows the block store to decrypt them in parallel and have their disk reads in flight together
+  auto existingChildren = _nodeStore->loadMany(existingChildKeys);
+  auto nextLoadedChild = existingChildren.begin();
+  for (uint32_t childIndex = begin; childIndex < endOfExistingChildren; ++childIndex) {
+    if (node->getChild(childIndex)->isHole()) {
+      if (fillHoles) {
+        children[childIndex-begin] = _fillHole(node, childIndex);
+      }
+    } else {
+      ASSERT(*nextLoadedChild != none, "Couldn't load child node");
+      children[childIndex-begin] = std::move(**nextLoadedChild);
+      ++nextLoadedChild;
+    }
   }
   for (uint32_t childIndex = node->numChildren(); childIndex < end; ++childIndex) {
     //TODO This creates each child with one chain to one leaf only, and then on the next lower level it
     //     has to create the children for the child. Would be faster to directly create full trees if necessary.
-    children.emplace_back(addChildTo(node));
+    children[childIndex-begin] = addChildTo(node);
   }
-  ASSERT(children.size() == end-begin, "Number of children in the result is wrong");
   return children;
 }
 
+unique_ref<DataNode> DataTree::_loadLastChild(DataInnerNode *node) {
+  auto lastChild = _nodeStore->load(node->LastChild()->key());
+  ASSERT(lastChild != none, "Couldn't load last child");
+  return std::move(*lastChild);
+}
+
+unique_ref<DataNode> DataTree::_fillHole(DataInnerNode *node, uint32_t childIndex) {
+  // Only the nodes on the path to the leaves that are accessed are created. Their siblings stay holes.
+  if (node->depth() == 1) {
+    auto leaf = _createSubtree(0, 1);
+    node->fillHole(childIndex, *leaf);
+    return leaf;
+  }
+  auto child = _nodeStore->createNewInnerNodeOfHoles(node->depth()-1, _nodeStore->layout().maxChildrenPerInnerNode());
+  node->fillHole(childIndex, *child);
+  return std::move(child);
+}
+
 unique_ref<DataNode> DataTree::addChildTo(DataInnerNode *node) {
   auto new_leaf = _nodeStore->createNewLeafNode();
   new_leaf->resize(_nodeStore->layout().maxBytesPerLeaf());
@@ -255,50 +323,259 @@ uint32_t DataTree::leavesPerFullChild(const DataInnerNode &root) const {
 
 uint64_t DataTree::numStoredBytes() const {
   shared_lock<shared_mutex> lock(_mutex);
-  return _numStoredBytes();
+  return _sizes().numStoredBytes;
+}
+
+boost::optional<uint32_t> DataTree::firstLeafInHole(uint32_t beginIndex) const {
+  shared_lock<shared_mutex> lock(_mutex);
+  return _firstLeaf(*_rootNode, 0, beginIndex, true);
 }
 
-uint64_t DataTree::_numStoredBytes() const {
-  return _numStoredBytes(*_rootNode);
+boost::optional<uint32_t> DataTree::firstLeafWithData(uint32_t beginIndex) const {
+  shared_lock<shared_mutex> lock(_mutex);
+  return _firstLeaf(*_rootNode, 0, beginIndex, false);
 }
 
-uint64_t DataTree::_numStoredBytes(const DataNode &root) const {
-  const DataLeafNode *leaf = dynamic_cast<const DataLeafNode*>(&root);
-  if (leaf != nullptr) {
-    return leaf->numBytes();
+boost::optional<uint32_t> DataTree::_firstLeaf(const DataNode &root, uint32_t leafOffset, uint32_t beginIndex, bool inHole) const {
+  const DataInnerNode *inner = dynamic_cast<const DataInnerNode*>(&root);
+  if (inner == nullptr) {
+    if (inHole || beginIndex > 0) {
+      return none;
+    }
+    return leafOffset;
+  }
+  uint32_t leavesPerChild = leavesPerFullChild(*inner);
+  for (uint32_t childIndex = beginIndex/leavesPerChild; childIndex < inner->numChildren(); ++childIndex) {
+    uint32_t childOffset = childIndex * leavesPerChild;
+    uint32_t localBeginIndex = utils::maxZeroSubtraction(beginIndex, childOffset);
+    if (inner->getChild(childIndex)->isHole()) {
+      if (inHole) {
+        return leafOffset + childOffset + localBeginIndex;
+      }
+    } else if (inner->depth() == 1) {
+      // We don't have to load leaves, they never contain holes
+      if (!inHole) {
+        return leafOffset + childOffset;
+      }
+    } else {
+      auto child = _nodeStore->load(inner->getChild(childIndex)->key());
+      ASSERT(child != none, "Couldn't load child node");
+      auto found = _firstLeaf(**child, leafOffset + childOffset, localBeginIndex, inHole);
+      if (found != none) {
+        return found;
+      }
+    }
   }
+  return none;
+}
 
-  const DataInnerNode &inner = dynamic_cast<const DataInnerNode&>(root);
-  uint64_t numBytesInLeftChildren = (inner.numChildren()-1) * leavesPerFullChild(inner) * _nodeStore->layout().maxBytesPerLeaf();
-  auto lastChild = _nodeStore->load(inner.LastChild()->key());
-  ASSERT(lastChild != none, "Couldn't load last child");
-  uint64_t numBytesInRightChild = _numStoredBytes(**lastChild);
+void DataTree::prefetchLeaves(uint32_t beginIndex, uint32_t endIndex) const {
+  // The shared lock makes sure that the leaves aren't removed while they are prefetched
+  shared_lock<shared_mutex> lock(_mutex);
+  endIndex = std::min(endIndex, _sizes().numLeaves);
+  if (beginIndex >= endIndex) {
+    return;
+  }
+  vector<Key> leafKeys;
+  vector<uint32_t> leafIndices;
+  _collectLeaves(*_rootNode, 0, beginIndex, endIndex, &leafKeys, &leafIndices, nullptr);
+  _nodeStore->prefetchMany(leafKeys);
+}
+
+void DataTree::overwriteFullLeaves(uint32_t beginIndex, uint32_t endIndex, function<void (uint32_t, void*)> fill) {
+  const uint64_t maxBytesPerLeaf = _nodeStore->layout().maxBytesPerLeaf();
+  // Storing the new leaves replaces the data of their blocks, which must not happen while another traversal of this
+  // tree reads or writes one of them. Creating the leaves in holes changes the inner nodes. Both need the exclusive lock.
+  unique_lock<shared_mutex> lock(_mutex);
+  uint32_t numFullLeaves = _sizes().numStoredBytes / maxBytesPerLeaf;
+  uint32_t end = std::min(endIndex, numFullLeaves);
+  if (beginIndex >= end) {
+    return;
+  }
+  DataLeafNode *rootLeaf = dynamic_cast<DataLeafNode*>(_rootNode.get());
+  if (rootLeaf != nullptr) {
+    // The root is loaded already anyway, so it is written directly
+    Data content(maxBytesPerLeaf);
+    fill(0, content.data());
+    rootLeaf->write(content.data(), 0, maxBytesPerLeaf);
+    return;
+  }
+  vector<Key> leafKeys;
+  vector<uint32_t> leafIndices;
+  vector<std::pair<uint32_t, uint32_t>> holes;
+  _collectLeaves(*_rootNode, 0, beginIndex, end, &leafKeys, &leafIndices, &holes);
+  _nodeStore->overwriteWithFullLeaves(leafKeys, [&fill, &leafIndices] (size_t i, void *target) {
+    fill(leafIndices[i], target);
+  });
+  for (const auto &hole : holes) {
+    _traverseLeaves(_rootNode.get(), 0, hole.first, hole.second, true, [&fill, maxBytesPerLeaf] (DataLeafNode *leaf, uint32_t leafIndex) {
+      Data content(maxBytesPerLeaf);
+      fill(leafIndex, content.data());
+      leaf->write(content.data(), 0, maxBytesPerLeaf);
+    }, nullptr);
+  }
+}
 
-  return numBytesInLeftChildren + numBytesInRightChild;
+void DataTree::_collectLeaves(const DataNode &root, uint32_t leafOffset, uint32_t beginIndex, uint32_t endIndex, vector<Key> *leafKeys, vector<uint32_t> *leafIndices, vector<std::pair<uint32_t, uint32_t>> *holes) const {
+  const DataInnerNode *inner = dynamic_cast<const DataInnerNode*>(&root);
+  if (inner == nullptr) {
+    // The root is the only leaf and it is loaded already
+    return;
+  }
+  uint32_t leavesPerChild = leavesPerFullChild(*inner);
+  uint32_t beginChild = beginIndex/leavesPerChild;
+  uint32_t endChild = std::min<uint32_t>(inner->numChildren(), utils::ceilDivision(endIndex, leavesPerChild));
+  vector<Key> childKeys;
+  vector<uint32_t> childIndices;
+  for (uint32_t childIndex = beginChild; childIndex < endChild; ++childIndex) {
+    uint32_t childOffset = childIndex * leavesPerChild;
+    if (inner->getChild(childIndex)->isHole()) {
+      // Holes only contain zeroes and don't have nodes to load
+      if (holes != nullptr) {
+        uint32_t holeBegin = leafOffset + std::max(beginIndex, childOffset);
+        uint32_t holeEnd = leafOffset + std::min(endIndex, childOffset + leavesPerChild);
+        if (!holes->empty() && holes->back().second == holeBegin) {
+          holes->back().second = holeEnd;
+        } else {
+          holes->push_back(std::make_pair(holeBegin, holeEnd));
+        }
+      }
+    } else {
+      childKeys.push_back(inner->getChild(childIndex)->key());
+      childIndices.push_back(childIndex);
+    }
+  }
+  if (inner->depth() == 1) {
+    leafKeys->insert(leafKeys->end(), childKeys.begin(), childKeys.end());
+    for (uint32_t childIndex : childIndices) {
+      leafIndices->push_back(leafOffset + childIndex);
+    }
+    return;
+  }
+  auto children = _nodeStore->loadMany(childKeys);
+  for (size_t i = 0; i < children.size(); ++i) {
+    ASSERT(children[i] != none, "Couldn't load child node");
+    uint32_t childOffset = childIndices[i] * leavesPerChild;
+    uint32_t localBeginIndex = utils::maxZeroSubtraction(beginIndex, childOffset);
+    uint32_t localEndIndex = std::min(leavesPerChild, endIndex - childOffset);
+    _collectLeaves(**children[i], leafOffset + childOffset, localBeginIndex, localEndIndex, leafKeys, leafIndices, holes);
+  }
 }
 
 void DataTree::resizeNumBytes(uint64_t newNumBytes) {
-  //TODO Can we resize in parallel? Especially creating new blocks (i.e. encrypting them) is expensive and should be done in parallel.
   boost::upgrade_lock<shared_mutex> lock(_mutex);
   {
     boost::upgrade_to_unique_lock<shared_mutex> exclusiveLock(lock);
-    //TODO Faster implementation possible (no addDataLeaf()/removeLastDataLeaf() in a loop, but directly resizing)
-    LastLeaf(_rootNode.get())->resize(_nodeStore->layout().maxBytesPerLeaf());
-    uint64_t currentNumBytes = _numStoredBytes();
-    ASSERT(currentNumBytes % _nodeStore->layout().maxBytesPerLeaf() == 0, "The last leaf is not a max data leaf, although we just resized it to be one.");
-    uint32_t currentNumLeaves = currentNumBytes / _nodeStore->layout().maxBytesPerLeaf();
+    uint32_t currentNumLeaves = _sizes().numLeaves;
+    // If resizing fails in the middle, the size is computed again when queried
+    _invalidateSizes();
     uint32_t newNumLeaves = std::max(UINT64_C(1), utils::ceilDivision(newNumBytes, _nodeStore->layout().maxBytesPerLeaf()));
-
-    for(uint32_t i = currentNumLeaves; i < newNumLeaves; ++i) {
-      addDataLeaf()->resize(_nodeStore->layout().maxBytesPerLeaf());
-    }
-    for(uint32_t i = currentNumLeaves; i > newNumLeaves; --i) {
-      removeLastDataLeaf();
+    if (currentNumLeaves < newNumLeaves) {
+      _growTo(currentNumLeaves, newNumLeaves);
+    } else if (currentNumLeaves > newNumLeaves) {
+      _shrinkTo(currentNumLeaves, newNumLeaves);
     }
     uint32_t newLastLeafSize = newNumBytes - (newNumLeaves-1)*_nodeStore->layout().maxBytesPerLeaf();
     LastLeaf(_rootNode.get())->resize(newLastLeafSize);
+    _setSizes(Sizes{newNumLeaves, newNumBytes});
+  }
+}
+
+void DataTree::_growTo(uint32_t currentNumLeaves, uint32_t newNumLeaves) {
+  // The old last leaf isn't the last one anymore, so it has to be full
+  LastLeaf(_rootNode.get())->resize(_nodeStore->layout().maxBytesPerLeaf());
+  uint8_t neededTreeDepth = utils::ceilLog(_nodeStore->layout().maxChildrenPerInnerNode(), (uint64_t)newNumLeaves);
+  if (_rootNode->depth() < neededTreeDepth) {
+    increaseTreeDepth(neededTreeDepth - _rootNode->depth());
+  }
+  DataInnerNode *root = dynamic_cast<DataInnerNode*>(_rootNode.get());
+  ASSERT(root != nullptr, "A tree with more than one leaf must have an inner node as root");
+  _growSubtree(root, currentNumLeaves, newNumLeaves, true);
+}
+
+void DataTree::_growSubtree(DataInnerNode *node, uint32_t currentNumLeaves, uint32_t newNumLeaves, bool onRightBorder) {
+  uint32_t leavesPerChild = leavesPerFullChild(*node);
+  uint32_t numChildren = node->numChildren();
+  uint32_t newNumChildren = utils::ceilDivision(newNumLeaves, leavesPerChild);
+  uint32_t lastChildOffset = (numChildren-1) * leavesPerChild;
+  if (currentNumLeaves - lastChildOffset < leavesPerChild) {
+    // The last child isn't full yet, so it gets the first new leaves
+    auto lastChild = _nodeStore->load(node->LastChild()->key());
+    ASSERT(lastChild != none, "Couldn't load last child");
+    DataInnerNode *lastInnerChild = dynamic_cast<DataInnerNode*>(lastChild->get());
+    ASSERT(lastInnerChild != nullptr, "Child with more than one leaf is not an inner node");
+    _growSubtree(lastInnerChild, currentNumLeaves - lastChildOffset, std::min(leavesPerChild, newNumLeaves - lastChildOffset), onRightBorder && numChildren == newNumChildren);
+  }
+
+  if (numChildren < newNumChildren) {
+    // The new leaves are zero. Only the new right border of the tree is created, the full subtrees left of it are holes.
+    uint32_t numHoles = onRightBorder ? newNumChildren-1-numChildren : newNumChildren-numChildren;
+    for (uint32_t i = 0; i < numHoles; ++i) {
+      node->addHole();
+    }
+    if (onRightBorder) {
+      auto lastChild = _createSubtree(node->depth()-1, newNumLeaves - (newNumChildren-1)*leavesPerChild);
+      node->addChild(*lastChild);
+    }
+  }
+}
+
+unique_ref<DataNode> DataTree::_createSubtree(uint8_t depth, uint32_t numLeaves) {
+  if (depth == 0) {
+    ASSERT(numLeaves == 1, "A leaf can't have more than one leaf");
+    auto leaf = _nodeStore->createNewLeafNode();
+    leaf->resize(_nodeStore->layout().maxBytesPerLeaf());
+    return std::move(leaf);
+  }
+  uint64_t leavesPerChild = utils::intPow((uint64_t)_nodeStore->layout().maxChildrenPerInnerNode(), (uint64_t)depth-1);
+  uint32_t numChildren = utils::ceilDivision((uint64_t)numLeaves, leavesPerChild);
+  auto lastChild = _createSubtree(depth-1, numLeaves - (numChildren-1)*leavesPerChild);
+  if (numChildren == 1) {
+    return _nodeStore->createNewInnerNode(*lastChild);
+  }
+  auto node = _nodeStore->createNewInnerNodeOfHoles(depth, numChildren-1);
+  node->addChild(*lastChild);
+  return std::move(node);
+}
+
+void DataTree::_shrinkTo(uint32_t currentNumLeaves, uint32_t newNumLeaves) {
+  DataInnerNode *root = dynamic_cast<DataInnerNode*>(_rootNode.get());
+  ASSERT(root != nullptr, "A tree with more than one leaf must have an inner node as root");
+  _shrinkSubtree(root, currentNumLeaves, newNumLeaves);
+  // The tree can now be deeper than needed for its number of leaves
+  while ((root = dynamic_cast<DataInnerNode*>(_rootNode.get())) != nullptr && root->numChildren() == 1) {
+    ifRootHasOnlyOneChildReplaceRootWithItsChild();
+  }
+}
+
+void DataTree::_shrinkSubtree(DataInnerNode *node, uint32_t currentNumLeaves, uint32_t newNumLeaves) {
+  uint32_t leavesPerChild = leavesPerFullChild(*node);
+  uint32_t newNumChildren = utils::ceilDivision(newNumLeaves, leavesPerChild);
+  // The children right of the new last child are removed in one batch
+  vector<Key> removedChildKeys;
+  for (uint32_t i = newNumChildren; i < node->numChildren(); ++i) {
+    if (!node->getChild(i)->isHole()) {
+      removedChildKeys.push_back(node->getChild(i)->key());
+    }
+  }
+  _nodeStore->removeSubtrees(node->depth()-1, removedChildKeys);
+  while (node->numChildren() > newNumChildren) {
+    node->removeLastChild();
+  }
+
+  uint32_t lastChildIndex = newNumChildren-1;
+  uint32_t lastChildOffset = lastChildIndex * leavesPerChild;
+  uint32_t currentLeavesInLastChild = std::min(leavesPerChild, currentNumLeaves - lastChildOffset);
+  bool lastChildIsHole = node->LastChild()->isHole();
+  if (lastChildIsHole || newNumLeaves - lastChildOffset < currentLeavesInLastChild) {
+    // The new last child keeps only some of its leaves, or it was a hole and is now on the right border of the tree,
+    // which must exist so that the size of the tree can be computed.
+    auto lastChild = lastChildIsHole ? _fillHole(node, lastChildIndex) : _loadLastChild(node);
+    DataInnerNode *lastInnerChild = dynamic_cast<DataInnerNode*>(lastChild.get());
+    if (lastInnerChild != nullptr) {
+      _shrinkSubtree(lastInnerChild, currentLeavesInLastChild, newNumLeaves - lastChildOffset);
+    }
   }
-  ASSERT(newNumBytes == _numStoredBytes(), "We resized to the wrong number of bytes ("+std::to_string(numStoredBytes())+" instead of "+std::to_string(newNumBytes)+")");
 }
 
 optional_ownership_ptr<DataLeafNode> DataTree::LastLeaf(DataNode *root) {
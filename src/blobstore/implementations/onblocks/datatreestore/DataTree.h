@@ -9,6 +9,8 @@
 //TODO Replace with C++14 once std::shared_mutex is supported
 #include <boost/thread/shared_mutex.hpp>
 #include <blockstore/utils/Key.h>
+#include <boost/optional.hpp>
+#include <mutex>
 
 namespace blobstore {
 namespace onblocks {
@@ -30,12 +32,38 @@ public:
   //Returning uint64_t, because calculations handling this probably need to be done in 64bit to support >4GB blobs.
   uint64_t maxBytesPerLeaf() const;
 
-  void traverseLeaves(uint32_t beginIndex, uint32_t endIndex, std::function<void (datanodestore::DataLeafNode*, uint32_t)> func);
+  // Traversals take the exclusive lock of the tree, because func can change the leaves. Reads that don't change them
+  // use readLeavesInParallel(), which can run concurrently with other reads.
+  // Leaves in holes (see DataInnerNode_ChildEntry) only contain zeroes and don't exist in the block store.
+  // If onHoles is given, it is called with the range [begin, end) of leaf indices of each hole instead of creating these leaves.
+  // Otherwise, the leaves are created and passed to func.
+  void traverseLeaves(uint32_t beginIndex, uint32_t endIndex, std::function<void (datanodestore::DataLeafNode*, uint32_t)> func, std::function<void (uint32_t, uint32_t)> onHoles = nullptr);
+  // Like traverseLeaves(), but if a range covers many leaves of one inner node, func is called for them concurrently
+  // on the worker pool of the node store. So func must be safe to call concurrently for different leaves and can't
+  // rely on the order of the calls. It still gets the index of each leaf, so results can be placed in order.
+  // The same holds for onHoles.
+  void traverseLeavesInParallel(uint32_t beginIndex, uint32_t endIndex, std::function<void (datanodestore::DataLeafNode*, uint32_t)> func, std::function<void (uint32_t, uint32_t)> onHoles = nullptr);
+  // Like traverseLeavesInParallel() with onHoles, but func only reads the leaves. This only takes the shared lock of the tree,
+  // so reads of different processes can run at the same time. Leaves after the end of the tree are passed to onHoles.
+  void readLeavesInParallel(uint32_t beginIndex, uint32_t endIndex, std::function<void (const datanodestore::DataLeafNode*, uint32_t)> func, std::function<void (uint32_t, uint32_t)> onHoles);
+  // Loads the inner nodes leading to the leaves in [beginIndex, endIndex) and prefetches the leaves into the cache
+  // of the block store, so a later traversal doesn't have to wait for them. Leaves outside of the tree are ignored.
+  void prefetchLeaves(uint32_t beginIndex, uint32_t endIndex) const;
+  // Replaces the full leaves in [beginIndex, endIndex) without loading their old content. fill(leafIndex, target) has to
+  // write the maxBytesPerLeaf() bytes of new content of the leaf to target and, like func of traverseLeavesInParallel(),
+  // must be safe to call concurrently. Leaves in holes are created. Leaves that aren't full because the tree
+  // was shrunk in the meantime are left out, as if the shrinking happened afterwards.
+  void overwriteFullLeaves(uint32_t beginIndex, uint32_t endIndex, std::function<void (uint32_t, void*)> fill);
   void resizeNumBytes(uint64_t newNumBytes);
 
   uint32_t numLeaves() const;
   uint64_t numStoredBytes() const;
 
+  // Index of the first leaf at or after beginIndex that is in a hole, or that exists. Returns none if there is none.
+  // The last leaf is never in a hole.
+  boost::optional<uint32_t> firstLeafInHole(uint32_t beginIndex) const;
+  boost::optional<uint32_t> firstLeafWithData(uint32_t beginIndex) const;
+
   void flush() const;
 
 private:
@@ -43,30 +71,55 @@ private:
   datanodestore::DataNodeStore *_nodeStore;
   cpputils::unique_ref<datanodestore::DataNode> _rootNode;
 
-  cpputils::unique_ref<datanodestore::DataLeafNode> addDataLeaf();
-  void removeLastDataLeaf();
+  struct Sizes final {
+    uint32_t numLeaves;
+    uint64_t numStoredBytes;
+  };
+  // Computing the sizes loads all nodes on the right border of the tree. So they are only computed when first queried,
+  // and the functions that change the tree keep them up to date (or reset them if they can't tell the new sizes).
+  // This has its own mutex, because readers only hold _mutex shared.
+  mutable std::mutex _sizeCacheMutex;
+  mutable boost::optional<Sizes> _sizeCache;
 
   cpputils::unique_ref<datanodestore::DataNode> releaseRootNode();
   friend class DataTreeStore;
 
-  cpputils::unique_ref<datanodestore::DataLeafNode> addDataLeafAt(datanodestore::DataInnerNode *insertPos);
   cpputils::optional_ownership_ptr<datanodestore::DataNode> createChainOfInnerNodes(unsigned int num, datanodestore::DataNode *child);
   cpputils::unique_ref<datanodestore::DataNode> createChainOfInnerNodes(unsigned int num, cpputils::unique_ref<datanodestore::DataNode> child);
-  cpputils::unique_ref<datanodestore::DataLeafNode> addDataLeafToFullTree();
 
-  void deleteLastChildSubtree(datanodestore::DataInnerNode *node);
   void ifRootHasOnlyOneChildReplaceRootWithItsChild();
 
+  // Resizing works on whole subtrees instead of adding or removing one leaf at a time,
+  // so it only walks down the right border of the tree once. New leaves are holes, only the right border is created.
+  void _growTo(uint32_t currentNumLeaves, uint32_t newNumLeaves);
+  // If the subtree isn't on the right border of the tree after growing, it is full and its new children are all holes.
+  void _growSubtree(datanodestore::DataInnerNode *node, uint32_t currentNumLeaves, uint32_t newNumLeaves, bool onRightBorder);
+  cpputils::unique_ref<datanodestore::DataNode> _createSubtree(uint8_t depth, uint32_t numLeaves);
+  cpputils::unique_ref<datanodestore::DataNode> _fillHole(datanodestore::DataInnerNode *node, uint32_t childIndex);
+  cpputils::unique_ref<datanodestore::DataNode> _loadLastChild(datanodestore::DataInnerNode *node);
+  void _shrinkTo(uint32_t currentNumLeaves, uint32_t newNumLeaves);
+  void _shrinkSubtree(datanodestore::DataInnerNode *node, uint32_t currentNumLeaves, uint32_t newNumLeaves);
+
+  // Below this number of leaves, handing them to the worker pool costs more than processing them in parallel gains
+  static constexpr uint32_t MIN_LEAVES_FOR_PARALLEL_TRAVERSAL = 4;
+
   //TODO Use underscore for private methods
-  void _traverseLeaves(datanodestore::DataNode *root, uint32_t leafOffset, uint32_t beginIndex, uint32_t endIndex, std::function<void (datanodestore::DataLeafNode*, uint32_t)> func);
+  void _traverseLeaves(uint32_t beginIndex, uint32_t endIndex, bool parallel, std::function<void (datanodestore::DataLeafNode*, uint32_t)> func, std::function<void (uint32_t, uint32_t)> onHoles);
+  // If onHoles is nullptr, holes are filled
+  void _traverseLeaves(datanodestore::DataNode *root, uint32_t leafOffset, uint32_t beginIndex, uint32_t endIndex, bool parallel, const std::function<void (datanodestore::DataLeafNode*, uint32_t)> &func, const std::function<void (uint32_t, uint32_t)> *onHoles);
+  boost::optional<uint32_t> _firstLeaf(const datanodestore::DataNode &root, uint32_t leafOffset, uint32_t beginIndex, bool inHole) const;
+  // Collects the keys and indices of the existing leaves in [beginIndex, endIndex), and the holes if holes isn't nullptr
+  void _collectLeaves(const datanodestore::DataNode &root, uint32_t leafOffset, uint32_t beginIndex, uint32_t endIndex, std::vector<blockstore::Key> *leafKeys, std::vector<uint32_t> *leafIndices, std::vector<std::pair<uint32_t, uint32_t>> *holes) const;
   uint32_t leavesPerFullChild(const datanodestore::DataInnerNode &root) const;
-  uint64_t _numStoredBytes() const;
-  uint64_t _numStoredBytes(const datanodestore::DataNode &root) const;
-  uint32_t _numLeaves(const datanodestore::DataNode &node) const;
+  Sizes _sizes() const;
+  Sizes _computeSizes() const;
+  void _setSizes(const Sizes &sizes);
+  void _invalidateSizes();
   cpputils::optional_ownership_ptr<datanodestore::DataLeafNode> LastLeaf(datanodestore::DataNode *root);
   cpputils::unique_ref<datanodestore::DataLeafNode> LastLeaf(cpputils::unique_ref<datanodestore::DataNode> root);
   datanodestore::DataInnerNode* increaseTreeDepth(unsigned int levels);
-  std::vector<cpputils::unique_ref<datanodestore::DataNode>> getOrCreateChildren(datanodestore::DataInnerNode *node, uint32_t begin, uint32_t end);
+  // Holes are none in the result, unless fillHoles is set
+  std::vector<boost::optional<cpputils::unique_ref<datanodestore::DataNode>>> getOrCreateChildren(datanodestore::DataInnerNode *node, uint32_t begin, uint32_t end, bool fillHoles);
   cpputils::unique_ref<datanodestore::DataNode> addChildTo(datanodestore::DataInnerNode *node);
 
   DISALLOW_COPY_AND_ASSIGN(DataTree);
@@ -30,12 +30,18 @@ public:
   uint64_t numNodes() const;
   uint64_t estimateSpaceForNumNodesLeft() const;
 
+  void waitForPendingWrites();
+
 private:
   cpputils::unique_ref<datanodestore::DataNodeStore> _nodeStore;
 
   DISALLOW_COPY_AND_ASSIGN(DataTreeStore);
 };
 
+inline void DataTreeStore::waitForPendingWrites() {
+    _nodeStore->waitForPendingWrites();
+}
+
 inline uint64_t DataTreeStore::numNodes() const {
     return _nodeStore->numNodes();
 }
@@ -21,8 +21,24 @@ public:
     return _baseTree->maxBytesPerLeaf();
   }
 
-  void traverseLeaves(uint32_t beginIndex, uint32_t endIndex, std::function<void (datanodestore::DataLeafNode*, uint32_t)> func) {
-    return _baseTree->traverseLeaves(beginIndex, endIndex, func);
+  void traverseLeaves(uint32_t beginIndex, uint32_t endIndex, std::function<void (datanodestore::DataLeafNode*, uint32_t)> func, std::function<void (uint32_t, uint32_t)> onHoles = nullptr) {
+    return _baseTree->traverseLeaves(beginIndex, endIndex, func, onHoles);
+  }
+
+  void traverseLeavesInParallel(uint32_t beginIndex, uint32_t endIndex, std::function<void (datanodestore::DataLeafNode*, uint32_t)> func, std::function<void (uint32_t, uint32_t)> onHoles = nullptr) {
+    return _baseTree->traverseLeavesInParallel(beginIndex, endIndex, func, onHoles);
+  }
+
+  void readLeavesInParallel(uint32_t beginIndex, uint32_t endIndex, std::function<void (const datanodestore::DataLeafNode*, uint32_t)> func, std::function<void (uint32_t, uint32_t)> onHoles) {
+    return _baseTree->readLeavesInParallel(beginIndex, endIndex, func, onHoles);
+  }
+
+  void prefetchLeaves(uint32_t beginIndex, uint32_t endIndex) const {
+    return _baseTree->prefetchLeaves(beginIndex, endIndex);
+  }
+
+  void overwriteFullLeaves(uint32_t beginIndex, uint32_t endIndex, std::function<void (uint32_t, void*)> fill) {
+    return _baseTree->overwriteFullLeaves(beginIndex, endIndex, std::move(fill));
   }
 
   uint32_t numLeaves() const {
@@ -37,6 +53,14 @@ public:
     return _baseTree->numStoredBytes();
   }
 
+  boost::optional<uint32_t> firstLeafInHole(uint32_t beginIndex) const {
+    return _baseTree->firstLeafInHole(beginIndex);
+  }
+
+  boost::optional<uint32_t> firstLeafWithData(uint32_t beginIndex) const {
+    return _baseTree->firstLeafWithData(beginIndex);
+  }
+
   void flush() {
     return _baseTree->flush();
   }
@@ -31,6 +31,8 @@ public:
   uint64_t numNodes() const;
   uint64_t estimateSpaceForNumNodesLeft() const;
 
+  void waitForPendingWrites();
+
 private:
   cpputils::unique_ref<datatreestore::DataTreeStore> _dataTreeStore;
   parallelaccessstore::ParallelAccessStore<datatreestore::DataTree, DataTreeRef, blockstore::Key> _parallelAccessStore;
@@ -42,6 +44,10 @@ inline uint64_t ParallelAccessDataTreeStore::virtualBlocksizeBytes() const {
     return _dataTreeStore->virtualBlocksizeBytes();
 }
 
+inline void ParallelAccessDataTreeStore::waitForPendingWrites() {
+    _dataTreeStore->waitForPendingWrites();
+}
+
 inline uint64_t ParallelAccessDataTreeStore::numNodes() const {
     return _dataTreeStore->numNodes();
 }
@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <blockstore/utils/Key.h>
 #include <cpp-utils/data/Data.h>
+#include <boost/optional.hpp>
 
 namespace blobstore {
 
@@ -23,6 +24,15 @@ public:
   virtual void read(void *target, uint64_t offset, uint64_t size) const = 0;
   virtual uint64_t tryRead(void *target, uint64_t offset, uint64_t size) const = 0;
   virtual void write(const void *source, uint64_t offset, uint64_t size) = 0;
+  // Loads the blocks of the given range, so a later read of it doesn't have to wait for them, if they are still cached by then.
+  // The part of the range that is outside of the blob is ignored.
+  virtual void prefetch(uint64_t offset, uint64_t size) const = 0;
+
+  // Like lseek() with SEEK_DATA and SEEK_HOLE: The first offset at or after the given one that is data or that is in a hole.
+  // Holes are regions of zeroes that aren't stored. The end of the blob counts as hole.
+  // Returns none if the offset is at or after the end of the blob.
+  virtual boost::optional<uint64_t> seekData(uint64_t offset) const = 0;
+  virtual boost::optional<uint64_t> seekHole(uint64_t offset) const = 0;
 
   virtual void flush() = 0;
 
@@ -24,6 +24,9 @@ public:
   virtual uint64_t estimateSpaceForNumBlocksLeft() const = 0;
   //virtual means "space we can use" as opposed to "space it takes on the disk" (i.e. virtual is without headers, checksums, ...)
   virtual uint64_t virtualBlocksizeBytes() const = 0;
+
+  // Waits until blocks that are written in the background reached the disk. Throws if writing one of them failed.
+  virtual void waitForPendingWrites() = 0;
 };
 
 }
@@ -2,19 +2,29 @@
 #include "CachingBlockStore.h"
 
 using cpputils::unique_ref;
+using boost::optional;
+using boost::none;
+using boost::posix_time::ptime;
 
 namespace blockstore {
 namespace caching {
 
-CachedBlock::CachedBlock(unique_ref<Block> baseBlock, CachingBlockStore *blockStore)
+CachedBlock::CachedBlock(unique_ref<Block> baseBlock, CachingBlockStore *blockStore, optional<ptime> dirtySince)
     :Block(baseBlock->key()),
      _blockStore(blockStore),
-     _baseBlock(std::move(baseBlock)) {
+     _baseBlock(std::move(baseBlock)),
+     _dirtySince(dirtySince) {
 }
 
 CachedBlock::~CachedBlock() {
   if (_baseBlock.get() != nullptr) {
-    _blockStore->release(std::move(_baseBlock));
+    _blockStore->release(std::move(_baseBlock), _dirtySince);
+  }
+}
+
+void CachedBlock::_markDirty() {
+  if (_dirtySince == none) {
+    _dirtySince = boost::posix_time::microsec_clock::local_time();
   }
 }
 
@@ -23,11 +33,13 @@ const void *CachedBlock::data() const {
 }
 
 void CachedBlock::write(const void *source, uint64_t offset, uint64_t size) {
+  _markDirty();
   return _baseBlock->write(source, offset, size);
 }
 
 void CachedBlock::flush() {
-  return _baseBlock->flush();
+  _baseBlock->flush();
+  _dirtySince = none;
 }
 
 size_t CachedBlock::size() const {
@@ -35,6 +47,7 @@ size_t CachedBlock::size() const {
 }
 
 void CachedBlock::resize(size_t newSize) {
+    _markDirty();
     return _baseBlock->resize(newSize);
 }
 
@@ -5,6 +5,8 @@
 #include "../../interface/Block.h"
 
 #include <cpp-utils/pointer/unique_ref.h>
+#include <boost/optional.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 namespace blockstore {
 namespace caching {
@@ -13,7 +15,8 @@ class CachingBlockStore;
 class CachedBlock final: public Block {
 public:
   //TODO Storing key twice (in parent class and in object pointed to). Once would be enough.
-  CachedBlock(cpputils::unique_ref<Block> baseBlock, CachingBlockStore *blockStore);
+  // dirtySince is the time the base block was first modified after it was written back the last time, or none if it is clean.
+  CachedBlock(cpputils::unique_ref<Block> baseBlock, CachingBlockStore *blockStore, boost::optional<boost::posix_time::ptime> dirtySince);
   ~CachedBlock();
 
   const void *data() const override;
@@ -27,8 +30,11 @@ public:
   cpputils::unique_ref<Block> releaseBlock();
 
 private:
+  void _markDirty();
+
   CachingBlockStore *_blockStore;
   cpputils::unique_ref<Block> _baseBlock;
+  boost::optional<boost::posix_time::ptime> _dirtySince;
 
   DISALLOW_COPY_AND_ASSIGN(CachedBlock);
 };
@@ -13,12 +13,23 @@ using boost::optional;
 using cpputils::unique_ref;
 using cpputils::make_unique_ref;
 using boost::none;
+using boost::posix_time::ptime;
+using std::vector;
+using std::pair;
 
 namespace blockstore {
 namespace caching {
 
-CachingBlockStore::CachingBlockStore(cpputils::unique_ref<BlockStore> baseBlockStore)
-  :_baseBlockStore(std::move(baseBlockStore)), _cache(), _numNewBlocks(0) {
+constexpr uint64_t CachingBlockStore::DEFAULT_MAX_CACHE_SIZE_BYTES;
+constexpr double CachingBlockStore::DEFAULT_MAX_DIRTY_AGE_SEC;
+constexpr uint64_t CachingBlockStore::DEFAULT_MAX_DIRTY_BYTES;
+
+CachingBlockStore::CachingBlockStore(cpputils::unique_ref<BlockStore> baseBlockStore, uint64_t maxCacheSizeBytes, double maxDirtyAgeSec, uint64_t maxDirtyBytes)
+  :_baseBlockStore(std::move(baseBlockStore)), _cache(maxCacheSizeBytes, [] (const unique_ref<Block> &block) {
+    return block->size();
+  }, TwoQueueEvictionPolicy<Key>::Factory(), WriteBackOptions<unique_ref<Block>>{[] (unique_ref<Block> &block) {
+    block->flush();
+  }, maxDirtyAgeSec, maxDirtyBytes}), _numNewBlocks(0), _prefetchMutex(), _keysBeingPrefetched() {
 }
 
 Key CachingBlockStore::createKey() {
@@ -30,36 +41,198 @@ optional<unique_ref<Block>> CachingBlockStore::tryCreate(const Key &key, Data da
   //TODO Shouldn't we return boost::none if the key already exists?
   //TODO Key can also already exist but not be in the cache right now.
   ++_numNewBlocks;
-  return unique_ref<Block>(make_unique_ref<CachedBlock>(make_unique_ref<NewBlock>(key, std::move(data), this), this));
+  // The new block only exists in the cache, so it is dirty
+  return unique_ref<Block>(make_unique_ref<CachedBlock>(make_unique_ref<NewBlock>(key, std::move(data), this), this, boost::posix_time::microsec_clock::local_time()));
 }
 
 optional<unique_ref<Block>> CachingBlockStore::load(const Key &key) {
-  optional<unique_ref<Block>> optBlock = _cache.pop(key);
+  optional<ptime> dirtySince;
+  optional<unique_ref<Block>> optBlock = _cache.pop(key, &dirtySince);
   //TODO an optional<> class with .getOrElse() would make this code simpler. boost::optional<>::value_or_eval didn't seem to work with unique_ptr members.
   if (optBlock != none) {
-    return optional<unique_ref<Block>>(make_unique_ref<CachedBlock>(std::move(*optBlock), this));
+    return optional<unique_ref<Block>>(make_unique_ref<CachedBlock>(std::move(*optBlock), this, dirtySince));
   } else {
     auto block = _baseBlockStore->load(key);
     if (block == none) {
       return none;
     } else {
-      return optional<unique_ref<Block>>(make_unique_ref<CachedBlock>(std::move(*block), this));
+      return optional<unique_ref<Block>>(make_unique_ref<CachedBlock>(std::move(*block), this, none));
     }
   }
 }
 
 void CachingBlockStore::remove(cpputils::unique_ref<Block> block) {
+  auto baseBlock = _releaseForRemoval(std::move(block));
+  if (baseBlock != none) {
+    _baseBlockStore->remove(std::move(*baseBlock));
+  }
+}
+
+optional<unique_ref<Block>> CachingBlockStore::_releaseForRemoval(unique_ref<Block> block) {
+  Key key = block->key();
+  _invalidatePrefetch(key);
+  // The cache can hold a prefetched copy of a block while it is loaded, see CacheShard::push()
+  _cache.pop(key);
   auto cached_block = dynamic_pointer_move<CachedBlock>(block);
   ASSERT(cached_block != none, "Passed block is not a CachedBlock");
-  auto baseBlock = (*cached_block)->releaseBlock();
+  return _releaseBaseBlockForRemoval((*cached_block)->releaseBlock());
+}
+
+optional<unique_ref<Block>> CachingBlockStore::_releaseBaseBlockForRemoval(unique_ref<Block> baseBlock) {
   auto baseNewBlock = dynamic_pointer_move<NewBlock>(baseBlock);
   if (baseNewBlock != none) {
 	if(!(*baseNewBlock)->alreadyExistsInBaseStore()) {
 	  --_numNewBlocks;
 	}
     (*baseNewBlock)->remove();
+    return none;
   } else {
-    _baseBlockStore->remove(std::move(baseBlock));
+    return std::move(baseBlock);
+  }
+}
+
+vector<optional<unique_ref<Block>>> CachingBlockStore::loadMany(const vector<Key> &keys) {
+  // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+  vector<optional<unique_ref<Block>>> result(keys.size());
+  vector<Key> missingKeys;
+  vector<size_t> missingIndices;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    optional<ptime> dirtySince;
+    auto cached = _cache.pop(keys[i], &dirtySince);
+    if (cached != none) {
+      result[i] = unique_ref<Block>(make_unique_ref<CachedBlock>(std::move(*cached), this, dirtySince));
+    } else {
+      missingKeys.push_back(keys[i]);
+      missingIndices.push_back(i);
+    }
+  }
+  if (!missingKeys.empty()) {
+    auto loaded = _baseBlockStore->loadMany(missingKeys);
+    for (size_t i = 0; i < missingKeys.size(); ++i) {
+      if (loaded[i] != none) {
+        result[missingIndices[i]] = unique_ref<Block>(make_unique_ref<CachedBlock>(std::move(*loaded[i]), this, none));
+      }
+    }
+  }
+  return result;
+}
+
+void CachingBlockStore::storeMany(vector<pair<Key, Data>> blocks) {
+  // Cached blocks (including new blocks that only exist in the cache) are overwritten in the cache and written back later.
+  // The other blocks are passed to the base store in one batch.
+  vector<pair<Key, Data>> uncachedBlocks;
+  for (auto &block : blocks) {
+    // Invalidated before looking into the cache, so a prefetch that finishes in between either is in the cache
+    // and gets overwritten, or doesn't add its old version of the block to the cache anymore.
+    _invalidatePrefetch(block.first);
+    optional<ptime> dirtySince;
+    auto cached = _cache.pop(block.first, &dirtySince);
+    if (cached != none) {
+      CachedBlock cachedBlock(std::move(*cached), this, dirtySince);
+      cachedBlock.resize(block.second.size());
+      cachedBlock.write(block.second.data(), 0, block.second.size());
+    } else {
+      uncachedBlocks.push_back(std::move(block));
+    }
+  }
+  if (!uncachedBlocks.empty()) {
+    vector<Key> uncachedKeys;
+    uncachedKeys.reserve(uncachedBlocks.size());
+    for (const auto &block : uncachedBlocks) {
+      uncachedKeys.push_back(block.first);
+    }
+    _baseBlockStore->storeMany(std::move(uncachedBlocks));
+    // Prefetches that started while storing could have loaded the old version
+    for (const Key &key : uncachedKeys) {
+      _invalidatePrefetch(key);
+    }
+  }
+}
+
+void CachingBlockStore::removeMany(vector<unique_ref<Block>> blocks) {
+  vector<unique_ref<Block>> baseBlocks;
+  baseBlocks.reserve(blocks.size());
+  for (auto &block : blocks) {
+    auto baseBlock = _releaseForRemoval(std::move(block));
+    if (baseBlock != none) {
+      baseBlocks.push_back(std::move(*baseBlock));
+    }
+  }
+  if (!baseBlocks.empty()) {
+    _baseBlockStore->removeMany(std::move(baseBlocks));
+  }
+}
+
+void CachingBlockStore::remove(const Key &key) {
+  removeMany(vector<Key>{key});
+}
+
+void CachingBlockStore::removeMany(const vector<Key> &keys) {
+  // Cached blocks are taken out of the cache and removed without writing them back first.
+  // The other blocks are removed by key, so the base store doesn't load them.
+  vector<unique_ref<Block>> cachedBaseBlocks;
+  vector<Key> uncachedKeys;
+  for (const Key &key : keys) {
+    auto cached = _cache.pop(key);
+    if (cached == none) {
+      _invalidatePrefetch(key);
+      uncachedKeys.push_back(key);
+    } else {
+      auto baseBlock = _releaseBaseBlockForRemoval(std::move(*cached));
+      if (baseBlock != none) {
+        cachedBaseBlocks.push_back(std::move(*baseBlock));
+      }
+    }
+  }
+  if (!cachedBaseBlocks.empty()) {
+    _baseBlockStore->removeMany(std::move(cachedBaseBlocks));
+  }
+  if (!uncachedKeys.empty()) {
+    _baseBlockStore->removeMany(uncachedKeys);
+  }
+}
+
+void CachingBlockStore::prefetchMany(const vector<Key> &keys) {
+  vector<Key> keysToLoad;
+  {
+    std::lock_guard<std::mutex> lock(_prefetchMutex);
+    for (const Key &key : keys) {
+      if (!_cache.contains(key) && _keysBeingPrefetched.emplace(key, false).second) {
+        keysToLoad.push_back(key);
+      }
+    }
+  }
+  if (keysToLoad.empty()) {
+    return;
+  }
+  vector<optional<unique_ref<Block>>> loaded;
+  try {
+    loaded = _baseBlockStore->loadMany(keysToLoad);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(_prefetchMutex);
+    for (const Key &key : keysToLoad) {
+      _keysBeingPrefetched.erase(key);
+    }
+    throw;
+  }
+  // Pushing under the lock makes sure that a block released after the check below replaces the prefetched version
+  std::lock_guard<std::mutex> lock(_prefetchMutex);
+  for (size_t i = 0; i < keysToLoad.size(); ++i) {
+    auto found = _keysBeingPrefetched.find(keysToLoad[i]);
+    ASSERT(found != _keysBeingPrefetched.end(), "Prefetched key wasn't registered");
+    bool outdated = found->second;
+    _keysBeingPrefetched.erase(found);
+    if (!outdated && loaded[i] != none) {
+      _cache.pushPrefetched(keysToLoad[i], std::move(*loaded[i]));
+    }
+  }
+}
+
+void CachingBlockStore::_invalidatePrefetch(const Key &key) {
+  std::lock_guard<std::mutex> lock(_prefetchMutex);
+  auto found = _keysBeingPrefetched.find(key);
+  if (found != _keysBeingPrefetched.end()) {
+    found->second = true;
   }
 }
 
@@ -71,9 +244,10 @@ uint64_t CachingBlockStore::estimateNumFreeBytes() const {
   return _baseBlockStore->estimateNumFreeBytes();
 }
 
-void CachingBlockStore::release(unique_ref<Block> block) {
+void CachingBlockStore::release(unique_ref<Block> block, optional<ptime> dirtySince) {
   Key key = block->key();
-  _cache.push(key, std::move(block));
+  _invalidatePrefetch(key);
+  _cache.push(key, std::move(block), dirtySince);
 }
 
 optional<unique_ref<Block>> CachingBlockStore::tryCreateInBaseStore(const Key &key, Data data) {
@@ -92,6 +266,10 @@ void CachingBlockStore::flush() {
   _cache.flush();
 }
 
+void CachingBlockStore::waitForPendingWrites() {
+  _baseBlockStore->waitForPendingWrites();
+}
+
 uint64_t CachingBlockStore::blockSizeFromPhysicalBlockSize(uint64_t blockSize) const {
   return _baseBlockStore->blockSizeFromPhysicalBlockSize(blockSize);
 }
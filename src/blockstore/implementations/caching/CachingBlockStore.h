@@ -2,8 +2,11 @@
 #ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHINGBLOCKSTORE_H_
 #define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHINGBLOCKSTORE_H_
 
-#include "cache/Cache.h"
+#include "cache/ShardedCache.h"
+#include "cache/TwoQueueEvictionPolicy.h"
 #include "../../interface/BlockStore.h"
+#include <mutex>
+#include <unordered_map>
 
 namespace blockstore {
 namespace caching {
@@ -11,17 +14,37 @@ namespace caching {
 //TODO Check that this blockstore allows parallel destructing of blocks (otherwise we won't encrypt blocks in parallel)
 class CachingBlockStore final: public BlockStore {
 public:
-  explicit CachingBlockStore(cpputils::unique_ref<BlockStore> baseBlockStore);
+  // The cache holds at most maxCacheSizeBytes bytes of block data (measured as the sum of Block::size() of the cached blocks)
+  // It uses 2Q eviction, so sequentially reading a large file doesn't evict blocks that are used repeatedly,
+  // like the inner nodes of the file's tree or directory blocks.
+  static constexpr uint64_t DEFAULT_MAX_CACHE_SIZE_BYTES = 32 * 1024 * 1024;
+  // Blocks stay in the cache after they are written back. Modified blocks are written back once they have been modified
+  // for longer than maxDirtyAgeSec, so repeated modifications in that time are written back only once.
+  // If the modified blocks in the cache are larger than maxDirtyBytes, blocks are written back earlier.
+  static constexpr double DEFAULT_MAX_DIRTY_AGE_SEC = 0.5;
+  static constexpr uint64_t DEFAULT_MAX_DIRTY_BYTES = 8 * 1024 * 1024;
+
+  explicit CachingBlockStore(cpputils::unique_ref<BlockStore> baseBlockStore, uint64_t maxCacheSizeBytes = DEFAULT_MAX_CACHE_SIZE_BYTES,
+                             double maxDirtyAgeSec = DEFAULT_MAX_DIRTY_AGE_SEC, uint64_t maxDirtyBytes = DEFAULT_MAX_DIRTY_BYTES);
 
   Key createKey() override;
   boost::optional<cpputils::unique_ref<Block>> tryCreate(const Key &key, cpputils::Data data) override;
   boost::optional<cpputils::unique_ref<Block>> load(const Key &key) override;
   void remove(cpputils::unique_ref<Block> block) override;
+  // Cached modifications of the block are dropped instead of being written back.
+  void remove(const Key &key) override;
+  std::vector<boost::optional<cpputils::unique_ref<Block>>> loadMany(const std::vector<Key> &keys) override;
+  void storeMany(std::vector<std::pair<Key, cpputils::Data>> blocks) override;
+  void removeMany(std::vector<cpputils::unique_ref<Block>> blocks) override;
+  void removeMany(const std::vector<Key> &keys) override;
+  // The prefetched blocks are decrypted and put into the cache, but don't count as used by the eviction policy yet.
+  void prefetchMany(const std::vector<Key> &keys) override;
+  void waitForPendingWrites() override;
   uint64_t numBlocks() const override;
   uint64_t estimateNumFreeBytes() const override;
   uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize) const override;
 
-  void release(cpputils::unique_ref<Block> block);
+  void release(cpputils::unique_ref<Block> block, boost::optional<boost::posix_time::ptime> dirtySince);
 
   boost::optional<cpputils::unique_ref<Block>> tryCreateInBaseStore(const Key &key, cpputils::Data data);
   void removeFromBaseStore(cpputils::unique_ref<Block> block);
@@ -29,9 +52,20 @@ public:
   void flush();
 
 private:
+  // Returns the base block if the block exists in the base store, or none if it is a NewBlock that got removed.
+  boost::optional<cpputils::unique_ref<Block>> _releaseForRemoval(cpputils::unique_ref<Block> block);
+  // Like _releaseForRemoval(), but for a block that was taken out of the cache.
+  boost::optional<cpputils::unique_ref<Block>> _releaseBaseBlockForRemoval(cpputils::unique_ref<Block> baseBlock);
+  // Called when a block is released or removed. If the block is being prefetched at the moment,
+  // the prefetched version could be outdated and isn't put into the cache.
+  void _invalidatePrefetch(const Key &key);
+
   cpputils::unique_ref<BlockStore> _baseBlockStore;
-  Cache<Key, cpputils::unique_ref<Block>, 1000> _cache;
+  ShardedCache<Key, cpputils::unique_ref<Block>> _cache;
   uint32_t _numNewBlocks;
+  std::mutex _prefetchMutex;
+  // Maps the keys that are being prefetched at the moment to whether their prefetched version got outdated
+  std::unordered_map<Key, bool> _keysBeingPrefetched;
 
   DISALLOW_COPY_AND_ASSIGN(CachingBlockStore);
 };
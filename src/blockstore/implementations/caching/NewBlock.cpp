@@ -22,10 +22,16 @@ NewBlock::~NewBlock() {
 }
 
 const void *NewBlock::data() const {
+  if (_baseBlock != none) {
+    return (*_baseBlock)->data();
+  }
   return _data.data();
 }
 
 void NewBlock::write(const void *source, uint64_t offset, uint64_t size) {
+  if (_baseBlock != none) {
+    return (*_baseBlock)->write(source, offset, size);
+  }
   ASSERT(offset <= _data.size() && offset + size <= _data.size(), "Write outside of valid area");
   std::memcpy((uint8_t*)_data.data()+offset, source, size);
   _dataChanged = true;
@@ -33,14 +39,12 @@ void NewBlock::write(const void *source, uint64_t offset, uint64_t size) {
 
 void NewBlock::writeToBaseBlockIfChanged() {
   if (_dataChanged) {
-    if (_baseBlock == none) {
-      //TODO _data.copy() necessary?
-      auto newBase = _blockStore->tryCreateInBaseStore(key(), _data.copy());
-      ASSERT(newBase != boost::none, "Couldn't create base block"); //TODO What if tryCreate fails due to a duplicate key? We should ensure we don't use duplicate keys.
-      _baseBlock = std::move(*newBase);
-    } else {
-        (*_baseBlock)->write(_data.data(), 0, _data.size());
-    }
+    ASSERT(_baseBlock == none, "Once the base block exists, changes are written to it directly");
+    // The data is moved into the base block instead of copying it. Afterwards, the base block holds the data.
+    auto newBase = _blockStore->tryCreateInBaseStore(key(), std::move(_data));
+    ASSERT(newBase != boost::none, "Couldn't create base block"); //TODO What if tryCreate fails due to a duplicate key? We should ensure we don't use duplicate keys.
+    _baseBlock = std::move(*newBase);
+    _data = Data(0);
 	_dataChanged = false;
   }
 }
@@ -59,12 +63,18 @@ void NewBlock::flush() {
 }
 
 size_t NewBlock::size() const {
+  if (_baseBlock != none) {
+    return (*_baseBlock)->size();
+  }
   return _data.size();
 }
 
 void NewBlock::resize(size_t newSize) {
-    _data = cpputils::DataUtils::resize(std::move(_data), newSize);
-    _dataChanged = true;
+  if (_baseBlock != none) {
+    return (*_baseBlock)->resize(newSize);
+  }
+  _data = cpputils::DataUtils::resize(std::move(_data), newSize);
+  _dataChanged = true;
 }
 
 bool NewBlock::alreadyExistsInBaseStore() const {
@@ -17,7 +17,8 @@ class CachingBlockStore;
 //     Maybe a second abstract class for BlockRefBackedBlock?
 
 // This is a block that was created in CachingBlockStore, but doesn't exist in the base block store yet.
-// It only exists in the cache and it is created in the base block store when destructed.
+// It only exists in the cache and it is created in the base block store when destructed or flushed.
+// Its data is moved into the base block then, and afterwards all operations are forwarded to the base block.
 class NewBlock final: public Block {
 public:
   NewBlock(const Key &key, cpputils::Data data, CachingBlockStore *blockStore);
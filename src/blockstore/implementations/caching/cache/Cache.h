@@ -3,19 +3,21 @@
 #define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_CACHE_H_
 
 #include "CacheEntry.h"
-#include "QueueMap.h"
+#include "CacheShard.h"
+#include "LRUEvictionPolicy.h"
+#include "WriteBackOptions.h"
 #include "PeriodicTask.h"
 #include <memory>
+#include <thread>
 #include <boost/optional.hpp>
-#include <future>
+#include <cpp-utils/thread/WorkerPool.h>
 #include <cpp-utils/assert/assert.h>
-#include <cpp-utils/lock/MutexPoolLock.h>
 #include <cpp-utils/pointer/gcc_4_8_compatibility.h>
 
 namespace blockstore {
 namespace caching {
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
+template<class Key, class Value>
 class Cache final {
 public:
   //TODO Current MAX_LIFETIME_SEC only considers time since the element was last pushed to the Cache. Also insert a real MAX_LIFETIME_SEC that forces resync of entries that have been pushed/popped often (e.g. the root blob)
@@ -24,153 +26,187 @@ public:
   static constexpr double PURGE_INTERVAL = 0.5; // With this interval, we check for entries to purge
   static constexpr double MAX_LIFETIME_SEC = PURGE_LIFETIME_SEC + PURGE_INTERVAL; // This is the oldest age an entry can reach (given purging works in an ideal world, i.e. with the ideal interval and in zero time)
 
-  Cache();
+  // The cache evicts entries when the sum of sizeOf() over all entries exceeds maxSize.
+  // With the default sizeOf, every entry has size 1, i.e. maxSize is the maximal number of entries.
+  // The eviction policy decides which entries are evicted. By default, the least recently used one.
+  // Without write back options, entries are purged once they are older than PURGE_LIFETIME_SEC.
+  // With write back options, entries stay in the cache and dirty entries are written back as configured (see WriteBackOptions).
+  explicit Cache(uint64_t maxSize, std::function<uint64_t (const Value &)> sizeOf = CountAsOneEntry, EvictionPolicyFactory<Key> createEvictionPolicy = LRUEvictionPolicy<Key>::Factory(), boost::optional<WriteBackOptions<Value>> writeBack = boost::none);
   ~Cache();
 
+  // Number of entries
   uint32_t size() const;
-
-  void push(const Key &key, Value value);
+  // Sum of sizeOf() over all entries
+  uint64_t totalSize() const;
+  uint64_t maxSize() const;
+  // Sum of sizeOf() over all dirty entries
+  uint64_t dirtySize() const;
+  // Queue depth and latency of the workers that purge, flush and delete entries
+  cpputils::WorkerPool::Statistics workerStatistics() const;
+
+  // dirtySince is the time the value was first modified after it was written back the last time, or none if it is clean.
+  void push(const Key &key, Value value, boost::optional<boost::posix_time::ptime> dirtySince = boost::none);
   boost::optional<Value> pop(const Key &key);
+  // Like pop(), but also returns the time the entry got dirty. Pass it to push() again so that the entry is written
+  // back at the time it was meant to, even if it is popped and pushed in the meantime.
+  boost::optional<Value> pop(const Key &key, boost::optional<boost::posix_time::ptime> *dirtySince);
 
   void flush();
 
+  static uint64_t CountAsOneEntry(const Value &) {
+    return 1;
+  }
+
+  static uint32_t NumWorkerThreads() {
+    // Twice the number of cores, so we use full CPU even if half the threads are doing I/O
+    return 2 * std::max(1u, std::thread::hardware_concurrency());
+  }
+
 private:
-  void _makeSpaceForEntry(std::unique_lock<std::mutex> *lock);
-  void _deleteEntry(std::unique_lock<std::mutex> *lock);
+  void _deleteEntriesWhileOverBudget();
+  void _flushEntriesWhileOverDirtyBudget();
+  void _purgeOrFlushOldEntriesParallel();
   void _deleteOldEntriesParallel();
+  void _flushOldDirtyEntriesParallel();
   void _deleteAllEntriesParallel();
   void _deleteMatchingEntriesAtBeginningParallel(std::function<bool (const CacheEntry<Key, Value> &)> matches);
   void _deleteMatchingEntriesAtBeginning(std::function<bool (const CacheEntry<Key, Value> &)> matches);
-  bool _deleteMatchingEntryAtBeginning(std::function<bool (const CacheEntry<Key, Value> &)> matches);
 
-  mutable std::mutex _mutex;
-  cpputils::LockPool<Key> _currentlyFlushingEntries;
-  QueueMap<Key, CacheEntry<Key, Value>> _cachedBlocks;
+  const uint64_t _maxSize;
+  const boost::optional<WriteBackOptions<Value>> _writeBack;
+  CacheShard<Key, Value> _cachedBlocks;
+  cpputils::WorkerPool _workers;
   std::unique_ptr<PeriodicTask> _timeoutFlusher;
 
   DISALLOW_COPY_AND_ASSIGN(Cache);
 };
 
-template<class Key, class Value, uint32_t MAX_ENTRIES> constexpr double Cache<Key, Value, MAX_ENTRIES>::PURGE_LIFETIME_SEC;
-template<class Key, class Value, uint32_t MAX_ENTRIES> constexpr double Cache<Key, Value, MAX_ENTRIES>::PURGE_INTERVAL;
-template<class Key, class Value, uint32_t MAX_ENTRIES> constexpr double Cache<Key, Value, MAX_ENTRIES>::MAX_LIFETIME_SEC;
+template<class Key, class Value> constexpr double Cache<Key, Value>::PURGE_LIFETIME_SEC;
+template<class Key, class Value> constexpr double Cache<Key, Value>::PURGE_INTERVAL;
+template<class Key, class Value> constexpr double Cache<Key, Value>::MAX_LIFETIME_SEC;
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-Cache<Key, Value, MAX_ENTRIES>::Cache(): _mutex(), _currentlyFlushingEntries(), _cachedBlocks(), _timeoutFlusher(nullptr) {
+template<class Key, class Value>
+Cache<Key, Value>::Cache(uint64_t maxSize, std::function<uint64_t (const Value &)> sizeOf, EvictionPolicyFactory<Key> createEvictionPolicy, boost::optional<WriteBackOptions<Value>> writeBack)
+  : _maxSize(maxSize), _writeBack(std::move(writeBack)), _cachedBlocks(std::move(sizeOf), createEvictionPolicy(maxSize)), _workers(NumWorkerThreads(), 2 * NumWorkerThreads()), _timeoutFlusher(nullptr) {
   //Don't initialize timeoutFlusher in the initializer list,
   //because it then might already call Cache::popOldEntries() before Cache is done constructing.
-  _timeoutFlusher = std::make_unique<PeriodicTask>(std::bind(&Cache::_deleteOldEntriesParallel, this), PURGE_INTERVAL);
+  _timeoutFlusher = std::make_unique<PeriodicTask>(std::bind(&Cache::_purgeOrFlushOldEntriesParallel, this), PURGE_INTERVAL);
 }
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-Cache<Key, Value, MAX_ENTRIES>::~Cache() {
+template<class Key, class Value>
+Cache<Key, Value>::~Cache() {
   _deleteAllEntriesParallel();
   ASSERT(_cachedBlocks.size() == 0, "Error in _deleteAllEntriesParallel()");
 }
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-boost::optional<Value> Cache<Key, Value, MAX_ENTRIES>::pop(const Key &key) {
-  std::unique_lock<std::mutex> lock(_mutex);
-  cpputils::MutexPoolLock<Key> lockEntryFromBeingPopped(&_currentlyFlushingEntries, key, &lock);
+template<class Key, class Value>
+boost::optional<Value> Cache<Key, Value>::pop(const Key &key) {
+  return _cachedBlocks.pop(key, nullptr);
+}
 
-  auto found = _cachedBlocks.pop(key);
-  if (!found) {
-    return boost::none;
-  }
-  return found->releaseValue();
+template<class Key, class Value>
+boost::optional<Value> Cache<Key, Value>::pop(const Key &key, boost::optional<boost::posix_time::ptime> *dirtySince) {
+  return _cachedBlocks.pop(key, dirtySince);
 }
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-void Cache<Key, Value, MAX_ENTRIES>::push(const Key &key, Value value) {
-  std::unique_lock<std::mutex> lock(_mutex);
-  ASSERT(_cachedBlocks.size() <= MAX_ENTRIES, "Cache too full");
-  _makeSpaceForEntry(&lock);
-  _cachedBlocks.push(key, CacheEntry<Key, Value>(std::move(value)));
+template<class Key, class Value>
+void Cache<Key, Value>::push(const Key &key, Value value, boost::optional<boost::posix_time::ptime> dirtySince) {
+  _cachedBlocks.push(key, std::move(value), dirtySince);
+  _deleteEntriesWhileOverBudget();
+  _flushEntriesWhileOverDirtyBudget();
 }
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-void Cache<Key, Value, MAX_ENTRIES>::_makeSpaceForEntry(std::unique_lock<std::mutex> *lock) {
-  // _deleteEntry releases the lock while the Value destructor is running.
+template<class Key, class Value>
+void Cache<Key, Value>::_deleteEntriesWhileOverBudget() {
+  // deleteVictim() releases the lock while the Value destructor is running.
   // So we can destruct multiple entries in parallel and also call pop() or push() while doing so.
-  // However, if another thread calls push() before we get the lock back, the cache is full again.
-  // That's why we need the while() loop here.
-  while (_cachedBlocks.size() == MAX_ENTRIES) {
-    _deleteEntry(lock);
+  // If the entry that was just pushed alone is larger than the budget, it is deleted as well.
+  while (_cachedBlocks.totalSize() > _maxSize && _cachedBlocks.deleteVictim()) {}
+}
+
+template<class Key, class Value>
+void Cache<Key, Value>::_flushEntriesWhileOverDirtyBudget() {
+  if (_writeBack == boost::none) {
+    return;
   }
-  ASSERT(_cachedBlocks.size() < MAX_ENTRIES, "Removing entry from cache didn't work");
-};
+  while (_cachedBlocks.dirtySize() > _writeBack->maxDirtySize && _cachedBlocks.flushDirtyEntryAtBeginning([] (const CacheEntry<Key, Value> &) {
+    return true;
+  }, _writeBack->flush)) {}
+}
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-void Cache<Key, Value, MAX_ENTRIES>::_deleteEntry(std::unique_lock<std::mutex> *lock) {
-  ASSERT(lock->owns_lock(), "The operations in this function require a locked mutex");
-  auto key = _cachedBlocks.peekKey();
-  ASSERT(key != boost::none, "There was no entry to delete");
-  cpputils::MutexPoolLock<Key> lockEntryFromBeingPopped(&_currentlyFlushingEntries, *key);
-  auto value = _cachedBlocks.pop();
-  // Call destructor outside of the unique_lock,
-  // i.e. pop() and push() can be called here, except for pop() on the element in _currentlyFlushingEntries
-  lock->unlock();
-  value = boost::none; // Call destructor
-  lockEntryFromBeingPopped.unlock();  // unlock this one first to keep same locking oder (preventing potential deadlock)
-  lock->lock();
-};
+template<class Key, class Value>
+void Cache<Key, Value>::_purgeOrFlushOldEntriesParallel() {
+  if (_writeBack == boost::none) {
+    _deleteOldEntriesParallel();
+  } else {
+    _flushOldDirtyEntriesParallel();
+  }
+}
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-void Cache<Key, Value, MAX_ENTRIES>::_deleteAllEntriesParallel() {
+template<class Key, class Value>
+void Cache<Key, Value>::_deleteAllEntriesParallel() {
   return _deleteMatchingEntriesAtBeginningParallel([] (const CacheEntry<Key, Value> &) {
       return true;
   });
 }
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-void Cache<Key, Value, MAX_ENTRIES>::_deleteOldEntriesParallel() {
+template<class Key, class Value>
+void Cache<Key, Value>::_deleteOldEntriesParallel() {
   return _deleteMatchingEntriesAtBeginningParallel([] (const CacheEntry<Key, Value> &entry) {
       return entry.ageSeconds() > PURGE_LIFETIME_SEC;
   });
 }
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-void Cache<Key, Value, MAX_ENTRIES>::_deleteMatchingEntriesAtBeginningParallel(std::function<bool (const CacheEntry<Key, Value> &)> matches) {
-  // Twice the number of cores, so we use full CPU even if half the threads are doing I/O
-  unsigned int numThreads = 2 * std::max(1u, std::thread::hardware_concurrency());
-  std::vector<std::future<void>> waitHandles;
-  for (unsigned int i = 0; i < numThreads; ++i) {
-    waitHandles.push_back(std::async(std::launch::async, [this, matches] {
-        _deleteMatchingEntriesAtBeginning(matches);
-    }));
-  }
-  for (auto & waitHandle : waitHandles) {
-    waitHandle.wait();
-  }
+template<class Key, class Value>
+void Cache<Key, Value>::_flushOldDirtyEntriesParallel() {
+  double maxDirtyAgeSec = _writeBack->maxDirtyAgeSec;
+  return _workers.runOnAllWorkers([this, maxDirtyAgeSec] (uint32_t) {
+    auto isOld = [maxDirtyAgeSec] (const CacheEntry<Key, Value> &entry) {
+      return entry.dirtyAgeSeconds() > maxDirtyAgeSec;
+    };
+    while (_cachedBlocks.flushDirtyEntryAtBeginning(isOld, _writeBack->flush)) {}
+  });
+}
+
+template<class Key, class Value>
+void Cache<Key, Value>::_deleteMatchingEntriesAtBeginningParallel(std::function<bool (const CacheEntry<Key, Value> &)> matches) {
+  return _workers.runOnAllWorkers([this, matches] (uint32_t) {
+    _deleteMatchingEntriesAtBeginning(matches);
+  });
 };
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-void Cache<Key, Value, MAX_ENTRIES>::_deleteMatchingEntriesAtBeginning(std::function<bool (const CacheEntry<Key, Value> &)> matches) {
-  while (_deleteMatchingEntryAtBeginning(matches)) {}
+template<class Key, class Value>
+void Cache<Key, Value>::_deleteMatchingEntriesAtBeginning(std::function<bool (const CacheEntry<Key, Value> &)> matches) {
+  while (_cachedBlocks.deleteMatchingEntryAtBeginning(matches)) {}
 }
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-bool Cache<Key, Value, MAX_ENTRIES>::_deleteMatchingEntryAtBeginning(std::function<bool (const CacheEntry<Key, Value> &)> matches) {
-  // This function can be called in parallel by multiple threads and will then cause the Value destructors
-  // to be called in parallel. The call to _deleteEntry() releases the lock while the Value destructor is running.
-  std::unique_lock<std::mutex> lock(_mutex);
-  if (_cachedBlocks.size() > 0 && matches(*_cachedBlocks.peek())) {
-    _deleteEntry(&lock);
-    ASSERT(lock.owns_lock(), "Something strange happened with the lock. It should be locked again when we come back.");
-    return true;
-  } else {
-    return false;
-  }
+template<class Key, class Value>
+uint32_t Cache<Key, Value>::size() const {
+  return _cachedBlocks.size();
 };
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-uint32_t Cache<Key, Value, MAX_ENTRIES>::size() const {
-  std::unique_lock<std::mutex> lock(_mutex);
-  return _cachedBlocks.size();
+template<class Key, class Value>
+uint64_t Cache<Key, Value>::totalSize() const {
+  return _cachedBlocks.totalSize();
+};
+
+template<class Key, class Value>
+uint64_t Cache<Key, Value>::maxSize() const {
+  return _maxSize;
+};
+
+template<class Key, class Value>
+uint64_t Cache<Key, Value>::dirtySize() const {
+  return _cachedBlocks.dirtySize();
+};
+
+template<class Key, class Value>
+cpputils::WorkerPool::Statistics Cache<Key, Value>::workerStatistics() const {
+  return _workers.statistics();
 };
 
-template<class Key, class Value, uint32_t MAX_ENTRIES>
-void Cache<Key, Value, MAX_ENTRIES>::flush() {
+template<class Key, class Value>
+void Cache<Key, Value>::flush() {
   //TODO Test flush()
   return _deleteAllEntriesParallel();
 };
@@ -6,6 +6,7 @@
 #include <memory>
 #include <cpp-utils/macros.h>
 #include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/optional.hpp>
 
 namespace blockstore {
 namespace caching {
@@ -13,7 +14,8 @@ namespace caching {
 template<class Key, class Value>
 class CacheEntry final {
 public:
-  explicit CacheEntry(Value value): _lastAccess(currentTime()), _value(std::move(value)) {
+  CacheEntry(Value value, uint64_t size, boost::optional<boost::posix_time::ptime> dirtySince = boost::none)
+    : _lastAccess(currentTime()), _size(size), _dirtySince(dirtySince), _value(std::move(value)) {
   }
 
   CacheEntry(CacheEntry &&) = default;
@@ -22,12 +24,39 @@ public:
     return ((double)(currentTime() - _lastAccess).total_nanoseconds()) / ((double)1000000000);
   }
 
+  // The size this entry is accounted with in the cache budget
+  uint64_t size() const {
+    return _size;
+  }
+
+  // The time the value was first modified after it was written back the last time, or none if it is clean
+  const boost::optional<boost::posix_time::ptime> &dirtySince() const {
+    return _dirtySince;
+  }
+
+  double dirtyAgeSeconds() const {
+    if (_dirtySince == boost::none) {
+      return 0;
+    }
+    return ((double)(currentTime() - *_dirtySince).total_nanoseconds()) / ((double)1000000000);
+  }
+
+  void markClean() {
+    _dirtySince = boost::none;
+  }
+
+  Value &value() {
+    return _value;
+  }
+
   Value releaseValue() {
     return std::move(_value);
   }
 
 private:
   boost::posix_time::ptime _lastAccess;
+  uint64_t _size;
+  boost::optional<boost::posix_time::ptime> _dirtySince;
   Value _value;
 
   static boost::posix_time::ptime currentTime() {
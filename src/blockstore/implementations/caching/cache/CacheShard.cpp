@@ -0,0 +1 @@
+#include "CacheShard.h"
@@ -0,0 +1,253 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_CACHESHARD_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_CACHESHARD_H_
+
+#include "CacheEntry.h"
+#include "QueueMap.h"
+#include "EvictionPolicy.h"
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <boost/optional.hpp>
+#include <cpp-utils/assert/assert.h>
+#include <cpp-utils/lock/MutexPoolLock.h>
+
+namespace blockstore {
+namespace caching {
+
+// A queue of cache entries (ordered by the time they were pushed) protected by its own mutex.
+// Cache uses one of these, ShardedCache uses several of them so that operations on different keys don't contend on the same mutex.
+// A shard doesn't enforce a size limit itself. It keeps track of the total size of its entries and the owning cache
+// evicts entries by calling deleteVictim() until it is within its budget again. Which entry is evicted is decided by the
+// shard's EvictionPolicy. Entries that are too old are purged in push order with deleteMatchingEntryAtBeginning().
+// Additionally, the shard keeps the dirty entries in a second queue (ordered by the time they were pushed as dirty),
+// from which the owning cache writes them back with flushDirtyEntryAtBeginning().
+template<class Key, class Value>
+class CacheShard final {
+public:
+  CacheShard(std::function<uint64_t (const Value &)> sizeOf, cpputils::unique_ref<EvictionPolicy<Key>> evictionPolicy);
+
+  // Number of entries in this shard
+  uint32_t size() const;
+  // Sum of the sizes of all entries in this shard. This doesn't lock the shard.
+  uint64_t totalSize() const;
+  // Sum of the sizes of all dirty entries in this shard. This doesn't lock the shard.
+  uint64_t dirtySize() const;
+
+  // If dirtySince is set, the entry is dirty. See CacheEntry::dirtySince().
+  // A prefetched entry with the same key is replaced, because it could have been loaded before the pushed value was modified.
+  void push(const Key &key, Value value, boost::optional<boost::posix_time::ptime> dirtySince);
+  // Pushes a clean entry that wasn't used yet, see EvictionPolicy::onPrefetch(). If there already is an entry with this key,
+  // the value is dropped instead.
+  void pushPrefetched(const Key &key, Value value);
+  bool contains(const Key &key) const;
+  // If the entry was found and dirtySince isn't nullptr, it is set to the time the entry got dirty.
+  boost::optional<Value> pop(const Key &key, boost::optional<boost::posix_time::ptime> *dirtySince);
+
+  // Deletes the oldest entry if it matches. Returns true if an entry was deleted.
+  // This can be called by multiple threads in parallel and will then call the Value destructors in parallel.
+  bool deleteMatchingEntryAtBeginning(std::function<bool (const CacheEntry<Key, Value> &)> matches);
+
+  // Deletes the entry chosen by the eviction policy. Returns true if an entry was deleted.
+  // Like deleteMatchingEntryAtBeginning(), this calls the Value destructor without holding the shard lock.
+  bool deleteVictim();
+
+  // Calls flush() on the dirty entry that was pushed first if it matches and marks it clean. The entry stays in the cache.
+  // Returns true if an entry was flushed. Like the delete functions, this calls flush() without holding the shard lock.
+  bool flushDirtyEntryAtBeginning(std::function<bool (const CacheEntry<Key, Value> &)> matches, const std::function<void (Value &)> &flush);
+
+private:
+  void _deleteEntry(const Key &key, std::unique_lock<std::mutex> *lock);
+  void _removeFromDirtyEntries(const Key &key);
+
+  std::function<uint64_t (const Value &)> _sizeOf;
+  std::atomic<uint64_t> _totalSize;
+  std::atomic<uint64_t> _dirtySize;
+  mutable std::mutex _mutex;
+  cpputils::LockPool<Key> _currentlyFlushingEntries;
+  QueueMap<Key, CacheEntry<Key, Value>> _cachedBlocks;
+  // Maps the keys of the dirty entries to their sizes
+  QueueMap<Key, uint64_t> _dirtyEntries;
+  cpputils::unique_ref<EvictionPolicy<Key>> _evictionPolicy;
+
+  DISALLOW_COPY_AND_ASSIGN(CacheShard);
+};
+
+template<class Key, class Value>
+CacheShard<Key, Value>::CacheShard(std::function<uint64_t (const Value &)> sizeOf, cpputils::unique_ref<EvictionPolicy<Key>> evictionPolicy)
+  : _sizeOf(std::move(sizeOf)), _totalSize(0), _dirtySize(0), _mutex(), _currentlyFlushingEntries(), _cachedBlocks(), _dirtyEntries(), _evictionPolicy(std::move(evictionPolicy)) {
+}
+
+template<class Key, class Value>
+boost::optional<Value> CacheShard<Key, Value>::pop(const Key &key, boost::optional<boost::posix_time::ptime> *dirtySince) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  cpputils::MutexPoolLock<Key> lockEntryFromBeingPopped(&_currentlyFlushingEntries, key, &lock);
+
+  auto found = _cachedBlocks.pop(key);
+  if (!found) {
+    return boost::none;
+  }
+  _evictionPolicy->onPop(key);
+  _totalSize -= found->size();
+  if (found->dirtySince() != boost::none) {
+    _removeFromDirtyEntries(key);
+  }
+  if (dirtySince != nullptr) {
+    *dirtySince = found->dirtySince();
+  }
+  return found->releaseValue();
+}
+
+template<class Key, class Value>
+void CacheShard<Key, Value>::push(const Key &key, Value value, boost::optional<boost::posix_time::ptime> dirtySince) {
+  uint64_t entrySize = _sizeOf(value);
+  std::unique_lock<std::mutex> lock(_mutex);
+  auto replaced = _cachedBlocks.pop(key);
+  if (replaced != boost::none) {
+    ASSERT(replaced->dirtySince() == boost::none, "Only prefetched entries can be replaced and they are clean");
+    _evictionPolicy->onEvict(key);
+    _totalSize -= replaced->size();
+  }
+  _cachedBlocks.push(key, CacheEntry<Key, Value>(std::move(value), entrySize, dirtySince));
+  _evictionPolicy->onPush(key, entrySize);
+  _totalSize += entrySize;
+  if (dirtySince != boost::none) {
+    _dirtyEntries.push(key, entrySize);
+    _dirtySize += entrySize;
+  }
+  // The destructor of a replaced entry runs without holding the lock
+  lock.unlock();
+}
+
+template<class Key, class Value>
+void CacheShard<Key, Value>::pushPrefetched(const Key &key, Value value) {
+  uint64_t entrySize = _sizeOf(value);
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_cachedBlocks.contains(key)) {
+    // value is destructed after the lock is released, because parameters are destructed after locals
+    return;
+  }
+  _cachedBlocks.push(key, CacheEntry<Key, Value>(std::move(value), entrySize, boost::none));
+  _evictionPolicy->onPrefetch(key, entrySize);
+  _totalSize += entrySize;
+}
+
+template<class Key, class Value>
+bool CacheShard<Key, Value>::contains(const Key &key) const {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return _cachedBlocks.contains(key);
+}
+
+template<class Key, class Value>
+void CacheShard<Key, Value>::_removeFromDirtyEntries(const Key &key) {
+  auto size = _dirtyEntries.pop(key);
+  ASSERT(size != boost::none, "Dirty entry wasn't in the list of dirty entries");
+  _dirtySize -= *size;
+}
+
+template<class Key, class Value>
+void CacheShard<Key, Value>::_deleteEntry(const Key &key, std::unique_lock<std::mutex> *lock) {
+  ASSERT(lock->owns_lock(), "The operations in this function require a locked mutex");
+  // The entry might currently be flushed by flushDirtyEntryAtBeginning(). Don't block the shard while waiting for that.
+  cpputils::MutexPoolLock<Key> lockEntryFromBeingPopped(&_currentlyFlushingEntries, key, lock);
+  auto value = _cachedBlocks.pop(key);
+  if (value == boost::none) {
+    // Another thread popped or deleted the entry while we were waiting
+    return;
+  }
+  _evictionPolicy->onEvict(key);
+  _totalSize -= value->size();
+  if (value->dirtySince() != boost::none) {
+    // The Value destructor writes the modifications back
+    _removeFromDirtyEntries(key);
+  }
+  // Call destructor outside of the unique_lock,
+  // i.e. pop() and push() can be called here, except for pop() on the element in _currentlyFlushingEntries
+  lock->unlock();
+  value = boost::none; // Call destructor
+  lockEntryFromBeingPopped.unlock();  // unlock this one first to keep same locking oder (preventing potential deadlock)
+  lock->lock();
+};
+
+template<class Key, class Value>
+bool CacheShard<Key, Value>::deleteMatchingEntryAtBeginning(std::function<bool (const CacheEntry<Key, Value> &)> matches) {
+  // The call to _deleteEntry() releases the lock while the Value destructor is running.
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_cachedBlocks.size() > 0 && matches(*_cachedBlocks.peek())) {
+    Key key = *_cachedBlocks.peekKey(); // copy, because the entry the key reference points to is deleted
+    _deleteEntry(key, &lock);
+    ASSERT(lock.owns_lock(), "Something strange happened with the lock. It should be locked again when we come back.");
+    return true;
+  } else {
+    return false;
+  }
+};
+
+template<class Key, class Value>
+bool CacheShard<Key, Value>::deleteVictim() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  auto victim = _evictionPolicy->victim();
+  if (victim == boost::none) {
+    return false;
+  }
+  _deleteEntry(*victim, &lock);
+  ASSERT(lock.owns_lock(), "Something strange happened with the lock. It should be locked again when we come back.");
+  return true;
+};
+
+template<class Key, class Value>
+bool CacheShard<Key, Value>::flushDirtyEntryAtBeginning(std::function<bool (const CacheEntry<Key, Value> &)> matches, const std::function<void (Value &)> &flush) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  auto dirtyKey = _dirtyEntries.peekKey();
+  if (dirtyKey == boost::none) {
+    return false;
+  }
+  Key key = *dirtyKey; // copy, because the entry the key reference points to is deleted
+  auto entry = _cachedBlocks.get(key);
+  ASSERT(entry != boost::none, "Dirty entry isn't in the cache");
+  if (!matches(*entry)) {
+    return false;
+  }
+  // Removing it from the dirty entries keeps other threads from flushing it at the same time
+  _removeFromDirtyEntries(key);
+  // Nobody else holds this lock, because pop() only holds it while it has the shard locked and the entry is still in
+  // the cache, i.e. it isn't being deleted. While we hold it, the entry can't be popped or deleted, so we can flush it
+  // outside of the shard lock.
+  cpputils::MutexPoolLock<Key> lockEntryFromBeingPopped(&_currentlyFlushingEntries, key);
+  lock.unlock();
+  try {
+    flush(entry->value());
+  } catch (...) {
+    // The entry wasn't written back, so it stays dirty since the time it was before and is flushed again later
+    lock.lock();
+    _dirtyEntries.push(key, entry->size());
+    _dirtySize += entry->size();
+    throw;
+  }
+  lock.lock();
+  entry->markClean();
+  lock.unlock();
+  lockEntryFromBeingPopped.unlock();
+  return true;
+}
+
+template<class Key, class Value>
+uint32_t CacheShard<Key, Value>::size() const {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return _cachedBlocks.size();
+};
+
+template<class Key, class Value>
+uint64_t CacheShard<Key, Value>::totalSize() const {
+  return _totalSize;
+};
+
+template<class Key, class Value>
+uint64_t CacheShard<Key, Value>::dirtySize() const {
+  return _dirtySize;
+};
+
+}
+}
+
+#endif
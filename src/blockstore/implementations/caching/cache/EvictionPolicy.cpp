@@ -0,0 +1 @@
+#include "EvictionPolicy.h"
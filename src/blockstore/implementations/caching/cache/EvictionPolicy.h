@@ -0,0 +1,44 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_EVICTIONPOLICY_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_EVICTIONPOLICY_H_
+
+#include <functional>
+#include <boost/optional.hpp>
+#include <cpp-utils/pointer/unique_ref.h>
+
+namespace blockstore {
+namespace caching {
+
+// Decides which entry a CacheShard evicts when the cache is over its size budget.
+// The shard notifies the policy about every entry that enters or leaves it. All calls happen while the shard is locked,
+// so implementations don't need to be thread safe.
+// Note that the cache works by checking entries out: A cache hit pops the entry and the user pushes it back when done.
+// So a push following a pop of the same key is a re-reference of that entry, not a new entry.
+template<class Key>
+class EvictionPolicy {
+public:
+  virtual ~EvictionPolicy() {}
+
+  // An entry with the given size was pushed to the cache
+  virtual void onPush(const Key &key, uint64_t size) = 0;
+  // An entry with the given size was pushed to the cache because it is likely to be needed soon, not because it was used.
+  // So this isn't a reference to the entry. By default, it is handled like a push.
+  virtual void onPrefetch(const Key &key, uint64_t size) {
+    onPush(key, size);
+  }
+  // An entry was popped from the cache by the user, i.e. there was a cache hit
+  virtual void onPop(const Key &key) = 0;
+  // An entry was removed from the cache, either because victim() chose it or because it got too old
+  virtual void onEvict(const Key &key) = 0;
+  // The entry to evict next, or none if the policy doesn't know any entries
+  virtual boost::optional<Key> victim() = 0;
+};
+
+// Creates the eviction policy for a cache shard that can hold entries with a total size of up to maxSize
+template<class Key>
+using EvictionPolicyFactory = std::function<cpputils::unique_ref<EvictionPolicy<Key>> (uint64_t maxSize)>;
+
+}
+}
+
+#endif
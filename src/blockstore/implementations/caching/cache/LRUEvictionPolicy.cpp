@@ -0,0 +1 @@
+#include "LRUEvictionPolicy.h"
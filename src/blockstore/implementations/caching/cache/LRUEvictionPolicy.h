@@ -0,0 +1,54 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_LRUEVICTIONPOLICY_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_LRUEVICTIONPOLICY_H_
+
+#include "EvictionPolicy.h"
+#include "QueueMap.h"
+
+namespace blockstore {
+namespace caching {
+
+// Evicts the entry that was pushed least recently.
+// Since a cache hit pops the entry and the user pushes it back afterwards, this is least-recently-used eviction.
+// A single sequential scan over more data than fits into the cache evicts everything else from the cache.
+template<class Key>
+class LRUEvictionPolicy final: public EvictionPolicy<Key> {
+public:
+  LRUEvictionPolicy(): _queue() {}
+
+  void onPush(const Key &key, uint64_t /*size*/) override {
+    _queue.push(key, true);
+  }
+
+  void onPop(const Key &key) override {
+    _queue.pop(key);
+  }
+
+  void onEvict(const Key &key) override {
+    _queue.pop(key);
+  }
+
+  boost::optional<Key> victim() override {
+    auto key = _queue.peekKey();
+    if (key == boost::none) {
+      return boost::none;
+    }
+    return *key;
+  }
+
+  static EvictionPolicyFactory<Key> Factory() {
+    return [] (uint64_t /*maxSize*/) {
+      return cpputils::unique_ref<EvictionPolicy<Key>>(cpputils::make_unique_ref<LRUEvictionPolicy<Key>>());
+    };
+  }
+
+private:
+  QueueMap<Key, bool> _queue;
+
+  DISALLOW_COPY_AND_ASSIGN(LRUEvictionPolicy);
+};
+
+}
+}
+
+#endif
@@ -19,7 +19,12 @@ bool PeriodicTask::_loopIteration() {
   //Has to be boost::this_thread::sleep_for and not std::this_thread::sleep_for, because it has to be interruptible.
   //LoopThread will interrupt this method if it has to be restarted.
   boost::this_thread::sleep_for(_interval);
-  _task();
+  try {
+    _task();
+  } catch (const std::exception &e) {
+    // An exception would end the thread, so the task would never run again. Try again in the next iteration instead.
+    LOG(ERROR, "Periodic task failed: {}", e.what());
+  }
   return true; // Run another iteration (don't terminate thread)
 }
 
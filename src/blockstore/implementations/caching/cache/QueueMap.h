@@ -72,6 +72,18 @@ public:
     return _sentinel.next->value();
   }
 
+  boost::optional<Value &> get(const Key &key) {
+    auto found = _entries.find(key);
+    if (found == _entries.end()) {
+      return boost::none;
+    }
+    return found->second.value();
+  }
+
+  bool contains(const Key &key) const {
+    return _entries.find(key) != _entries.end();
+  }
+
   uint32_t size() const {
     return _entries.size();
   }
@@ -90,7 +102,7 @@ private:
       _value()->~Value();
       return value;
     }
-    const Value &value() {
+    Value &value() {
       return *_value();
     }
     Entry *prev;
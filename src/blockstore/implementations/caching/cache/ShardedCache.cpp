@@ -0,0 +1 @@
+#include "ShardedCache.h"
@@ -0,0 +1,285 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_SHARDEDCACHE_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_SHARDEDCACHE_H_
+
+#include "CacheEntry.h"
+#include "CacheShard.h"
+#include "PeriodicTask.h"
+#include "Cache.h"
+#include <memory>
+#include <vector>
+#include <boost/optional.hpp>
+#include <cpp-utils/thread/WorkerPool.h>
+#include <cpp-utils/assert/assert.h>
+#include <cpp-utils/pointer/unique_ref.h>
+#include <cpp-utils/pointer/gcc_4_8_compatibility.h>
+
+namespace blockstore {
+namespace caching {
+
+// A lock-striped variant of Cache. Entries are distributed over NUM_SHARDS shards by the hash of their key and each shard
+// has its own mutex, its own set of currently flushing entries and its own LRU queue, so threads accessing different
+// keys don't contend on a single cache mutex.
+// The size budget is shared by all shards. When it is exceeded, the shard using the largest part of the budget evicts
+// the entry its eviction policy chooses, so the eviction policy works per shard, not globally.
+// Each shard's policy is created for an equal share of the budget. The same holds for the dirty budget with write back:
+// When it is exceeded, the shard with the most dirty data writes back its entry that got dirty first.
+template<class Key, class Value, uint32_t NUM_SHARDS = 16>
+class ShardedCache final {
+public:
+  static_assert(NUM_SHARDS > 0, "ShardedCache needs at least one shard");
+
+  // Use the same purging behavior as Cache
+  static constexpr double PURGE_LIFETIME_SEC = Cache<Key, Value>::PURGE_LIFETIME_SEC;
+  static constexpr double PURGE_INTERVAL = Cache<Key, Value>::PURGE_INTERVAL;
+  static constexpr double MAX_LIFETIME_SEC = Cache<Key, Value>::MAX_LIFETIME_SEC;
+
+  // See Cache for the meaning of the parameters
+  explicit ShardedCache(uint64_t maxSize, std::function<uint64_t (const Value &)> sizeOf = Cache<Key, Value>::CountAsOneEntry, EvictionPolicyFactory<Key> createEvictionPolicy = LRUEvictionPolicy<Key>::Factory(), boost::optional<WriteBackOptions<Value>> writeBack = boost::none);
+  ~ShardedCache();
+
+  // Number of entries
+  uint32_t size() const;
+  // Sum of sizeOf() over all entries
+  uint64_t totalSize() const;
+  uint64_t maxSize() const;
+  // Sum of sizeOf() over all dirty entries
+  uint64_t dirtySize() const;
+  // Queue depth and latency of the workers that purge, flush and delete entries
+  cpputils::WorkerPool::Statistics workerStatistics() const;
+
+  // See Cache for the meaning of dirtySince
+  void push(const Key &key, Value value, boost::optional<boost::posix_time::ptime> dirtySince = boost::none);
+  boost::optional<Value> pop(const Key &key);
+  boost::optional<Value> pop(const Key &key, boost::optional<boost::posix_time::ptime> *dirtySince);
+  // Pushes an entry that is likely to be popped soon. It doesn't count as used, see EvictionPolicy::onPrefetch().
+  // If the key is already in the cache, the value is dropped.
+  void pushPrefetched(const Key &key, Value value);
+  bool contains(const Key &key) const;
+
+  void flush();
+
+private:
+  uint32_t _shardIndexFor(const Key &key) const;
+  void _deleteEntriesWhileOverBudget();
+  void _flushEntriesWhileOverDirtyBudget();
+  uint32_t _largestShardIndex() const;
+  uint32_t _dirtiestShardIndex() const;
+  void _purgeOrFlushOldEntriesParallel();
+  void _deleteOldEntriesParallel();
+  void _flushOldDirtyEntriesParallel();
+  void _deleteAllEntriesParallel();
+  void _deleteMatchingEntriesAtBeginningParallel(std::function<bool (const CacheEntry<Key, Value> &)> matches);
+  void _deleteMatchingEntriesAtBeginning(uint32_t firstShard, std::function<bool (const CacheEntry<Key, Value> &)> matches);
+  void _runOnAllWorkers(std::function<void (uint32_t firstShard)> task);
+
+  const uint64_t _maxSize;
+  const boost::optional<WriteBackOptions<Value>> _writeBack;
+  std::vector<cpputils::unique_ref<CacheShard<Key, Value>>> _shards;
+  cpputils::WorkerPool _workers;
+  std::unique_ptr<PeriodicTask> _timeoutFlusher;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedCache);
+};
+
+template<class Key, class Value, uint32_t NUM_SHARDS> constexpr double ShardedCache<Key, Value, NUM_SHARDS>::PURGE_LIFETIME_SEC;
+template<class Key, class Value, uint32_t NUM_SHARDS> constexpr double ShardedCache<Key, Value, NUM_SHARDS>::PURGE_INTERVAL;
+template<class Key, class Value, uint32_t NUM_SHARDS> constexpr double ShardedCache<Key, Value, NUM_SHARDS>::MAX_LIFETIME_SEC;
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+ShardedCache<Key, Value, NUM_SHARDS>::ShardedCache(uint64_t maxSize, std::function<uint64_t (const Value &)> sizeOf, EvictionPolicyFactory<Key> createEvictionPolicy, boost::optional<WriteBackOptions<Value>> writeBack)
+  : _maxSize(maxSize), _writeBack(std::move(writeBack)), _shards(), _workers(Cache<Key, Value>::NumWorkerThreads(), 2 * Cache<Key, Value>::NumWorkerThreads()), _timeoutFlusher(nullptr) {
+  _shards.reserve(NUM_SHARDS);
+  for (uint32_t i = 0; i < NUM_SHARDS; ++i) {
+    _shards.push_back(cpputils::make_unique_ref<CacheShard<Key, Value>>(sizeOf, createEvictionPolicy(maxSize / NUM_SHARDS)));
+  }
+  //Don't initialize timeoutFlusher in the initializer list,
+  //because it then might already call ShardedCache::popOldEntries() before ShardedCache is done constructing.
+  _timeoutFlusher = std::make_unique<PeriodicTask>(std::bind(&ShardedCache::_purgeOrFlushOldEntriesParallel, this), PURGE_INTERVAL);
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+ShardedCache<Key, Value, NUM_SHARDS>::~ShardedCache() {
+  _deleteAllEntriesParallel();
+  ASSERT(size() == 0, "Error in _deleteAllEntriesParallel()");
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+uint32_t ShardedCache<Key, Value, NUM_SHARDS>::_shardIndexFor(const Key &key) const {
+  return std::hash<Key>()(key) % NUM_SHARDS;
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+boost::optional<Value> ShardedCache<Key, Value, NUM_SHARDS>::pop(const Key &key) {
+  return _shards[_shardIndexFor(key)]->pop(key, nullptr);
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+boost::optional<Value> ShardedCache<Key, Value, NUM_SHARDS>::pop(const Key &key, boost::optional<boost::posix_time::ptime> *dirtySince) {
+  return _shards[_shardIndexFor(key)]->pop(key, dirtySince);
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::push(const Key &key, Value value, boost::optional<boost::posix_time::ptime> dirtySince) {
+  _shards[_shardIndexFor(key)]->push(key, std::move(value), dirtySince);
+  _deleteEntriesWhileOverBudget();
+  _flushEntriesWhileOverDirtyBudget();
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::pushPrefetched(const Key &key, Value value) {
+  _shards[_shardIndexFor(key)]->pushPrefetched(key, std::move(value));
+  _deleteEntriesWhileOverBudget();
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+bool ShardedCache<Key, Value, NUM_SHARDS>::contains(const Key &key) const {
+  return _shards[_shardIndexFor(key)]->contains(key);
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::_deleteEntriesWhileOverBudget() {
+  // Only one shard is locked at a time, so this can't deadlock with other threads evicting entries.
+  // If the entry that was just pushed alone is larger than the budget, it is deleted as well.
+  // deleteVictim() finds nothing to evict if other threads popped or deleted the entries of the shard in the meantime.
+  while (totalSize() > _maxSize && _shards[_largestShardIndex()]->deleteVictim()) {}
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::_flushEntriesWhileOverDirtyBudget() {
+  if (_writeBack == boost::none) {
+    return;
+  }
+  while (dirtySize() > _writeBack->maxDirtySize && _shards[_dirtiestShardIndex()]->flushDirtyEntryAtBeginning([] (const CacheEntry<Key, Value> &) {
+    return true;
+  }, _writeBack->flush)) {}
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+uint32_t ShardedCache<Key, Value, NUM_SHARDS>::_dirtiestShardIndex() const {
+  uint32_t result = 0;
+  for (uint32_t i = 1; i < NUM_SHARDS; ++i) {
+    if (_shards[i]->dirtySize() > _shards[result]->dirtySize()) {
+      result = i;
+    }
+  }
+  return result;
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+uint32_t ShardedCache<Key, Value, NUM_SHARDS>::_largestShardIndex() const {
+  uint32_t result = 0;
+  for (uint32_t i = 1; i < NUM_SHARDS; ++i) {
+    if (_shards[i]->totalSize() > _shards[result]->totalSize()) {
+      result = i;
+    }
+  }
+  return result;
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::_purgeOrFlushOldEntriesParallel() {
+  if (_writeBack == boost::none) {
+    _deleteOldEntriesParallel();
+  } else {
+    _flushOldDirtyEntriesParallel();
+  }
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::_deleteAllEntriesParallel() {
+  return _deleteMatchingEntriesAtBeginningParallel([] (const CacheEntry<Key, Value> &) {
+      return true;
+  });
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::_deleteOldEntriesParallel() {
+  return _deleteMatchingEntriesAtBeginningParallel([] (const CacheEntry<Key, Value> &entry) {
+      return entry.ageSeconds() > PURGE_LIFETIME_SEC;
+  });
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::_flushOldDirtyEntriesParallel() {
+  double maxDirtyAgeSec = _writeBack->maxDirtyAgeSec;
+  return _runOnAllWorkers([this, maxDirtyAgeSec] (uint32_t firstShard) {
+    auto isOld = [maxDirtyAgeSec] (const CacheEntry<Key, Value> &entry) {
+      return entry.dirtyAgeSeconds() > maxDirtyAgeSec;
+    };
+    for (uint32_t i = 0; i < NUM_SHARDS; ++i) {
+      auto &shard = *_shards[(firstShard + i) % NUM_SHARDS];
+      while (shard.flushDirtyEntryAtBeginning(isOld, _writeBack->flush)) {}
+    }
+  });
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::_deleteMatchingEntriesAtBeginningParallel(std::function<bool (const CacheEntry<Key, Value> &)> matches) {
+  return _runOnAllWorkers([this, matches] (uint32_t firstShard) {
+    _deleteMatchingEntriesAtBeginning(firstShard, matches);
+  });
+};
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::_runOnAllWorkers(std::function<void (uint32_t firstShard)> task) {
+  // Let each worker start at a different shard so they don't all queue up on the mutex of the first shard
+  _workers.runOnAllWorkers([&task] (uint32_t workerIndex) {
+    task(workerIndex % NUM_SHARDS);
+  });
+};
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::_deleteMatchingEntriesAtBeginning(uint32_t firstShard, std::function<bool (const CacheEntry<Key, Value> &)> matches) {
+  for (uint32_t i = 0; i < NUM_SHARDS; ++i) {
+    auto &shard = *_shards[(firstShard + i) % NUM_SHARDS];
+    while (shard.deleteMatchingEntryAtBeginning(matches)) {}
+  }
+}
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+uint32_t ShardedCache<Key, Value, NUM_SHARDS>::size() const {
+  uint32_t result = 0;
+  for (const auto &shard : _shards) {
+    result += shard->size();
+  }
+  return result;
+};
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+uint64_t ShardedCache<Key, Value, NUM_SHARDS>::totalSize() const {
+  uint64_t result = 0;
+  for (const auto &shard : _shards) {
+    result += shard->totalSize();
+  }
+  return result;
+};
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+uint64_t ShardedCache<Key, Value, NUM_SHARDS>::maxSize() const {
+  return _maxSize;
+};
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+cpputils::WorkerPool::Statistics ShardedCache<Key, Value, NUM_SHARDS>::workerStatistics() const {
+  return _workers.statistics();
+};
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+uint64_t ShardedCache<Key, Value, NUM_SHARDS>::dirtySize() const {
+  uint64_t result = 0;
+  for (const auto &shard : _shards) {
+    result += shard->dirtySize();
+  }
+  return result;
+};
+
+template<class Key, class Value, uint32_t NUM_SHARDS>
+void ShardedCache<Key, Value, NUM_SHARDS>::flush() {
+  return _deleteAllEntriesParallel();
+};
+
+}
+}
+
+#endif
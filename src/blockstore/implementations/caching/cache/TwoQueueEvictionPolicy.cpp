@@ -0,0 +1 @@
+#include "TwoQueueEvictionPolicy.h"
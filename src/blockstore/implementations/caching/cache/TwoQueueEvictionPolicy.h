@@ -0,0 +1,123 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_TWOQUEUEEVICTIONPOLICY_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_TWOQUEUEEVICTIONPOLICY_H_
+
+#include "EvictionPolicy.h"
+#include "QueueMap.h"
+#include <unordered_set>
+
+namespace blockstore {
+namespace caching {
+
+// A scan resistant eviction policy following the 2Q algorithm (Johnson, Shasha: "2Q: A Low Overhead High Performance
+// Buffer Management Replacement Algorithm", 1994), with sizes measured in the cache's size unit instead of in pages.
+// - Entries seen for the first time go to the FIFO queue _in.
+// - Entries that are referenced again go to the LRU queue _main. An entry counts as referenced again if it is pushed
+//   after a cache hit on it or if it is pushed while its key is remembered in _out.
+// - _out remembers the keys (but not the values) of entries that left _in, either by eviction or by a cache hit.
+// - As long as _in holds more than a quarter of the budget, entries are evicted from _in. Otherwise from _main.
+// So a sequential read of a large file only cycles through _in, while entries that are used repeatedly
+// (e.g. inner nodes of the file's tree or directory blocks) stay in _main.
+// Prefetched entries go to _in as well, but the first cache hit on them is their first use, not a re-reference.
+// So they aren't remembered in _out when they leave _in before they are used or by their first use.
+template<class Key>
+class TwoQueueEvictionPolicy final: public EvictionPolicy<Key> {
+public:
+  explicit TwoQueueEvictionPolicy(uint64_t maxSize)
+    : _maxInSize(maxSize / 4), _maxOutSize(maxSize / 2), _inSize(0), _outSize(0), _in(), _out(), _main(), _prefetched() {}
+
+  void onPush(const Key &key, uint64_t size) override {
+    auto remembered = _out.pop(key);
+    if (remembered != boost::none) {
+      _outSize -= *remembered;
+      _main.push(key, size);
+    } else {
+      _in.push(key, size);
+      _inSize += size;
+    }
+  }
+
+  void onPrefetch(const Key &key, uint64_t size) override {
+    // The key might be remembered in _out. It stays there, because it still counts as referenced before.
+    _in.push(key, size);
+    _inSize += size;
+    _prefetched.insert(key);
+  }
+
+  void onPop(const Key &key) override {
+    auto size = _removeFromQueues(key);
+    ASSERT(size != boost::none, "Popped entry wasn't known to the eviction policy");
+    if (_prefetched.erase(key) == 0) {
+      _remember(key, *size);
+    }
+  }
+
+  void onEvict(const Key &key) override {
+    auto sizeInIn = _in.pop(key);
+    if (sizeInIn != boost::none) {
+      _inSize -= *sizeInIn;
+      if (_prefetched.erase(key) == 0) {
+        _remember(key, *sizeInIn);
+      }
+      return;
+    }
+    // Entries evicted from _main aren't remembered. If they come back, they have to prove themselves in _in again.
+    auto sizeInMain = _main.pop(key);
+    ASSERT(sizeInMain != boost::none, "Evicted entry wasn't known to the eviction policy");
+  }
+
+  boost::optional<Key> victim() override {
+    auto key = (_inSize > _maxInSize || _main.size() == 0) ? _in.peekKey() : _main.peekKey();
+    if (key == boost::none) {
+      key = _main.peekKey();
+      if (key == boost::none) {
+        return boost::none;
+      }
+    }
+    return *key;
+  }
+
+  static EvictionPolicyFactory<Key> Factory() {
+    return [] (uint64_t maxSize) {
+      return cpputils::unique_ref<EvictionPolicy<Key>>(cpputils::make_unique_ref<TwoQueueEvictionPolicy<Key>>(maxSize));
+    };
+  }
+
+private:
+  boost::optional<uint64_t> _removeFromQueues(const Key &key) {
+    auto size = _in.pop(key);
+    if (size != boost::none) {
+      _inSize -= *size;
+      return size;
+    }
+    return _main.pop(key);
+  }
+
+  void _remember(const Key &key, uint64_t size) {
+    _out.push(key, size);
+    _outSize += size;
+    while (_outSize > _maxOutSize) {
+      auto forgotten = _out.pop();
+      ASSERT(forgotten != boost::none, "_outSize is positive, so there must be remembered entries");
+      _outSize -= *forgotten;
+    }
+  }
+
+  const uint64_t _maxInSize;
+  const uint64_t _maxOutSize;
+  uint64_t _inSize;
+  uint64_t _outSize;
+  // The values in these queues are the entry sizes
+  QueueMap<Key, uint64_t> _in;
+  QueueMap<Key, uint64_t> _out;
+  QueueMap<Key, uint64_t> _main;
+  // Keys of the entries in _in that were prefetched and not used yet
+  std::unordered_set<Key> _prefetched;
+
+  DISALLOW_COPY_AND_ASSIGN(TwoQueueEvictionPolicy);
+};
+
+}
+}
+
+#endif
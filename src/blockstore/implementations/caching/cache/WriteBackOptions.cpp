@@ -0,0 +1 @@
+#include "WriteBackOptions.h"
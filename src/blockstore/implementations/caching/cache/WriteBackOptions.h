@@ -0,0 +1,27 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_WRITEBACKOPTIONS_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_CACHING_CACHE_WRITEBACKOPTIONS_H_
+
+#include <functional>
+#include <cstdint>
+
+namespace blockstore {
+namespace caching {
+
+// A cache with write back options keeps entries until the size budget forces it to evict them.
+// Instead of purging old entries, it writes back entries that were pushed as dirty, but leaves them in the cache.
+// Modifications made to an entry while it is dirty are written back together.
+template<class Value>
+struct WriteBackOptions final {
+  // Writes back the modifications of a dirty value
+  std::function<void (Value &)> flush;
+  // Dirty entries are written back once they have been dirty for longer than this
+  double maxDirtyAgeSec;
+  // If the sum of the sizes of the dirty entries exceeds this, the ones that got dirty first are written back when pushing
+  uint64_t maxDirtySize;
+};
+
+}
+}
+
+#endif
@@ -30,6 +30,7 @@ public:
   size_t size() const override;
   void resize(size_t newSize) override;
 
+  // Returns the base block to remove it. Modifications that weren't compressed yet are discarded.
   cpputils::unique_ref<Block> releaseBaseBlock();
 
 private:
@@ -107,7 +108,7 @@ void CompressedBlock<Compressor>::resize(size_t newSize) {
 template<class Compressor>
 cpputils::unique_ref<Block> CompressedBlock<Compressor>::releaseBaseBlock() {
   std::unique_lock<std::mutex> lock(_mutex);
-  _compressToBaseBlock();
+  _dataChanged = false;
   return std::move(_baseBlock);
 }
 
@@ -18,6 +18,8 @@ public:
     boost::optional<cpputils::unique_ref<Block>> tryCreate(const Key &key, cpputils::Data data) override;
     boost::optional<cpputils::unique_ref<Block>> load(const Key &key) override;
     void remove(cpputils::unique_ref<Block> block) override;
+    void remove(const Key &key) override;
+    void waitForPendingWrites() override;
     uint64_t numBlocks() const override;
     uint64_t estimateNumFreeBytes() const override;
     uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize) const override;
@@ -68,6 +70,16 @@ void CompressingBlockStore<Compressor>::remove(cpputils::unique_ref<Block> block
     return _baseBlockStore->remove(std::move(baseBlock));
 }
 
+template<class Compressor>
+void CompressingBlockStore<Compressor>::remove(const Key &key) {
+    return _baseBlockStore->remove(key);
+}
+
+template<class Compressor>
+void CompressingBlockStore<Compressor>::waitForPendingWrites() {
+    _baseBlockStore->waitForPendingWrites();
+}
+
 template<class Compressor>
 uint64_t CompressingBlockStore<Compressor>::numBlocks() const {
     return _baseBlockStore->numBlocks();
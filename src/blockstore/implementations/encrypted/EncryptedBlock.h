@@ -15,6 +15,7 @@
 #include <cpp-utils/data/DataUtils.h>
 #include <mutex>
 #include <cpp-utils/logging/logging.h>
+#include "EncryptionPipeline.h"
 
 namespace blockstore {
 namespace encrypted {
@@ -28,36 +29,47 @@ template<class Cipher>
 class EncryptedBlock final: public Block {
 public:
   BOOST_CONCEPT_ASSERT((cpputils::CipherConcept<Cipher>));
-  static boost::optional<cpputils::unique_ref<EncryptedBlock>> TryCreateNew(BlockStore *baseBlockStore, const Key &key, cpputils::Data data, const typename Cipher::EncryptionKey &encKey);
-  static boost::optional<cpputils::unique_ref<EncryptedBlock>> TryDecrypt(cpputils::unique_ref<Block> baseBlock, const typename Cipher::EncryptionKey &key);
+  static boost::optional<cpputils::unique_ref<EncryptedBlock>> TryCreateNew(BlockStore *baseBlockStore, EncryptionPipeline *pipeline, const Key &key, cpputils::Data data, const typename Cipher::EncryptionKey &encKey);
+  static boost::optional<cpputils::unique_ref<EncryptedBlock>> TryDecrypt(cpputils::unique_ref<Block> baseBlock, EncryptionPipeline *pipeline, const typename Cipher::EncryptionKey &key);
+  // Returns the data the base block of a block with this key and content has. TryDecrypt() accepts it.
+  static cpputils::Data Encrypt(const Key &key, cpputils::Data data, const typename Cipher::EncryptionKey &encKey);
 
   static uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize);
 
   //TODO Storing key twice (in parent class and in object pointed to). Once would be enough.
-  EncryptedBlock(cpputils::unique_ref<Block> baseBlock, const typename Cipher::EncryptionKey &key, cpputils::Data plaintextWithHeader);
+  EncryptedBlock(cpputils::unique_ref<Block> baseBlock, EncryptionPipeline *pipeline, const typename Cipher::EncryptionKey &key, cpputils::Data plaintextWithHeader);
+  // If the block was modified, it is encrypted and written to the base block by the pipeline after the destructor returned.
   ~EncryptedBlock();
 
   const void *data() const override;
   void write(const void *source, uint64_t offset, uint64_t count) override;
+  // Encrypts the block and writes and flushes the base block before returning, so errors reach the caller.
+  // Flushes of the same block can run concurrently and finish in any order, but only the newest content ends up in the base block.
   void flush() override;
 
   size_t size() const override;
   void resize(size_t newSize) override;
 
+  // Returns the base block to remove it. Modifications that weren't encrypted yet are discarded.
   cpputils::unique_ref<Block> releaseBlock();
 
 private:
   cpputils::unique_ref<Block> _baseBlock; // TODO Do I need the ciphertext block in memory or is the key enough?
+  EncryptionPipeline *_pipeline;
   cpputils::Data _plaintextWithHeader;
   typename Cipher::EncryptionKey _encKey;
   bool _dataChanged;
+  // Each flush() gets the next version. A write only changes the base block if no newer version was written before.
+  uint64_t _version;
+  uint64_t _writtenVersion;
 
   static constexpr unsigned int HEADER_LENGTH = Key::BINARY_LENGTH;
 
-  void _encryptToBaseBlock();
+  void _writeToBaseBlock(const cpputils::Data &plaintextWithHeader, uint64_t version);
+  static void _writeEncrypted(Block *baseBlock, const cpputils::Data &encryptedWithFormatHeader);
+  static cpputils::Data _encrypt(const cpputils::Data &plaintextWithHeader, const typename Cipher::EncryptionKey &encKey);
   static cpputils::Data _prependKeyHeaderToData(const Key &key, cpputils::Data data);
   static bool _keyHeaderIsCorrect(const Key &key, const cpputils::Data &data);
-  static cpputils::Data _prependFormatHeader(const cpputils::Data &data);
   static void _checkFormatHeader(const void *data);
 
   // This header is prepended to blocks to allow future versions to have compatibility.
@@ -76,31 +88,34 @@ constexpr uint16_t EncryptedBlock<Cipher>::FORMAT_VERSION_HEADER;
 
 
 template<class Cipher>
-boost::optional<cpputils::unique_ref<EncryptedBlock<Cipher>>> EncryptedBlock<Cipher>::TryCreateNew(BlockStore *baseBlockStore, const Key &key, cpputils::Data data, const typename Cipher::EncryptionKey &encKey) {
-  //TODO Is it possible to avoid copying the whole plaintext data into plaintextWithHeader? Maybe an encrypt() object that has an .addData() function and concatenates all data for encryption? Maybe Crypto++ offers this functionality already.
+boost::optional<cpputils::unique_ref<EncryptedBlock<Cipher>>> EncryptedBlock<Cipher>::TryCreateNew(BlockStore *baseBlockStore, EncryptionPipeline *pipeline, const Key &key, cpputils::Data data, const typename Cipher::EncryptionKey &encKey) {
   cpputils::Data plaintextWithHeader = _prependKeyHeaderToData(key, std::move(data));
-  cpputils::Data encrypted = Cipher::encrypt((byte*)plaintextWithHeader.data(), plaintextWithHeader.size(), encKey);
-  //TODO Avoid copying the whole encrypted block into a encryptedWithFormatHeader by creating a Data object with full size and then giving it as an encryption target to Cipher::encrypt()
-  cpputils::Data encryptedWithFormatHeader = _prependFormatHeader(std::move(encrypted));
+  cpputils::Data encryptedWithFormatHeader = _encrypt(plaintextWithHeader, encKey);
   auto baseBlock = baseBlockStore->tryCreate(key, std::move(encryptedWithFormatHeader));
   if (baseBlock == boost::none) {
     //TODO Test this code branch
     return boost::none;
   }
 
-  return cpputils::make_unique_ref<EncryptedBlock>(std::move(*baseBlock), encKey, std::move(plaintextWithHeader));
+  return cpputils::make_unique_ref<EncryptedBlock>(std::move(*baseBlock), pipeline, encKey, std::move(plaintextWithHeader));
 }
 
 template<class Cipher>
-cpputils::Data EncryptedBlock<Cipher>::_prependFormatHeader(const cpputils::Data &data) {
-  cpputils::Data dataWithHeader(sizeof(FORMAT_VERSION_HEADER) + data.size());
-  std::memcpy(dataWithHeader.dataOffset(0), &FORMAT_VERSION_HEADER, sizeof(FORMAT_VERSION_HEADER));
-  std::memcpy(dataWithHeader.dataOffset(sizeof(FORMAT_VERSION_HEADER)), data.data(), data.size());
-  return dataWithHeader;
+cpputils::Data EncryptedBlock<Cipher>::Encrypt(const Key &key, cpputils::Data data, const typename Cipher::EncryptionKey &encKey) {
+  return _encrypt(_prependKeyHeaderToData(key, std::move(data)), encKey);
 }
 
 template<class Cipher>
-boost::optional<cpputils::unique_ref<EncryptedBlock<Cipher>>> EncryptedBlock<Cipher>::TryDecrypt(cpputils::unique_ref<Block> baseBlock, const typename Cipher::EncryptionKey &encKey) {
+cpputils::Data EncryptedBlock<Cipher>::_encrypt(const cpputils::Data &plaintextWithHeader, const typename Cipher::EncryptionKey &encKey) {
+  // The cipher writes the ciphertext behind the format header, so it doesn't have to be copied to prepend the header
+  cpputils::Data encryptedWithFormatHeader(sizeof(FORMAT_VERSION_HEADER) + Cipher::ciphertextSize(plaintextWithHeader.size()));
+  std::memcpy(encryptedWithFormatHeader.data(), &FORMAT_VERSION_HEADER, sizeof(FORMAT_VERSION_HEADER));
+  Cipher::encrypt((byte*)plaintextWithHeader.data(), plaintextWithHeader.size(), (byte*)encryptedWithFormatHeader.dataOffset(sizeof(FORMAT_VERSION_HEADER)), encKey);
+  return encryptedWithFormatHeader;
+}
+
+template<class Cipher>
+boost::optional<cpputils::unique_ref<EncryptedBlock<Cipher>>> EncryptedBlock<Cipher>::TryDecrypt(cpputils::unique_ref<Block> baseBlock, EncryptionPipeline *pipeline, const typename Cipher::EncryptionKey &encKey) {
   _checkFormatHeader(baseBlock->data());
   boost::optional<cpputils::Data> plaintextWithHeader = Cipher::decrypt((byte*)baseBlock->data() + sizeof(FORMAT_VERSION_HEADER), baseBlock->size() - sizeof(FORMAT_VERSION_HEADER), encKey);
   if(plaintextWithHeader == boost::none) {
@@ -113,7 +128,7 @@ boost::optional<cpputils::unique_ref<EncryptedBlock<Cipher>>> EncryptedBlock<Cip
     cpputils::logging::LOG(cpputils::logging::WARN, "Decrypting block {} failed due to invalid block key. Was the block modified by an attacker?", baseBlock->key().ToString());
     return boost::none;
   }
-  return cpputils::make_unique_ref<EncryptedBlock<Cipher>>(std::move(baseBlock), encKey, std::move(*plaintextWithHeader));
+  return cpputils::make_unique_ref<EncryptedBlock<Cipher>>(std::move(baseBlock), pipeline, encKey, std::move(*plaintextWithHeader));
 }
 
 template<class Cipher>
@@ -126,10 +141,10 @@ void EncryptedBlock<Cipher>::_checkFormatHeader(const void *data) {
 template<class Cipher>
 cpputils::Data EncryptedBlock<Cipher>::_prependKeyHeaderToData(const Key &key, cpputils::Data data) {
   static_assert(HEADER_LENGTH >= Key::BINARY_LENGTH, "Key doesn't fit into the header");
-  cpputils::Data result(data.size() + HEADER_LENGTH);
-  std::memcpy(result.data(), key.data(), Key::BINARY_LENGTH);
-  std::memcpy((uint8_t*)result.data() + Key::BINARY_LENGTH, data.data(), data.size());
-  return result;
+  // If the block was created with enough headroom, the plaintext isn't copied
+  data.growFront(HEADER_LENGTH);
+  std::memcpy(data.data(), key.data(), Key::BINARY_LENGTH);
+  return data;
 }
 
 template<class Cipher>
@@ -138,19 +153,32 @@ bool EncryptedBlock<Cipher>::_keyHeaderIsCorrect(const Key &key, const cpputils:
 }
 
 template<class Cipher>
-EncryptedBlock<Cipher>::EncryptedBlock(cpputils::unique_ref<Block> baseBlock, const typename Cipher::EncryptionKey &encKey, cpputils::Data plaintextWithHeader)
+EncryptedBlock<Cipher>::EncryptedBlock(cpputils::unique_ref<Block> baseBlock, EncryptionPipeline *pipeline, const typename Cipher::EncryptionKey &encKey, cpputils::Data plaintextWithHeader)
     :Block(baseBlock->key()),
    _baseBlock(std::move(baseBlock)),
+   _pipeline(pipeline),
    _plaintextWithHeader(std::move(plaintextWithHeader)),
    _encKey(encKey),
    _dataChanged(false),
+   _version(0),
+   _writtenVersion(0),
    _mutex() {
 }
 
 template<class Cipher>
 EncryptedBlock<Cipher>::~EncryptedBlock() {
   std::unique_lock<std::mutex> lock(_mutex);
-  _encryptToBaseBlock();
+  if (_dataChanged) {
+    // The write owns the base block from now on, so it doesn't access this object anymore.
+    // std::function needs a copyable function object, that's why the members are moved into a shared_ptr.
+    auto released = std::make_shared<std::pair<cpputils::unique_ref<Block>, cpputils::Data>>(std::move(_baseBlock), std::move(_plaintextWithHeader));
+    typename Cipher::EncryptionKey encKey = _encKey;
+    _pipeline->schedule(key(), [released, encKey] {
+      _writeEncrypted(released->first.get(), _encrypt(released->second, encKey));
+      // Destructing the base block writes it, and that has to happen before the pipeline considers the key written
+      cpputils::destruct(std::move(released->first));
+    });
+  }
 }
 
 template<class Cipher>
@@ -167,9 +195,25 @@ void EncryptedBlock<Cipher>::write(const void *source, uint64_t offset, uint64_t
 
 template<class Cipher>
 void EncryptedBlock<Cipher>::flush() {
+  // Report a failed write of an earlier instance of this block
+  _pipeline->waitUntilWritten(key());
   std::unique_lock<std::mutex> lock(_mutex);
-  _encryptToBaseBlock();
-  return _baseBlock->flush();
+  if (!_dataChanged) {
+    _baseBlock->flush();
+    return;
+  }
+  cpputils::Data plaintextWithHeader = _plaintextWithHeader.copy();
+  uint64_t version = ++_version;
+  _dataChanged = false;
+  lock.unlock();
+  try {
+    _writeToBaseBlock(plaintextWithHeader, version);
+  } catch (...) {
+    // Keep the block dirty, so the content is written by the next flush or by the destructor
+    lock.lock();
+    _dataChanged = true;
+    throw;
+  }
 }
 
 template<class Cipher>
@@ -184,22 +228,29 @@ void EncryptedBlock<Cipher>::resize(size_t newSize) {
 }
 
 template<class Cipher>
-void EncryptedBlock<Cipher>::_encryptToBaseBlock() {
-  if (_dataChanged) {
-    cpputils::Data encrypted = Cipher::encrypt((byte*)_plaintextWithHeader.data(), _plaintextWithHeader.size(), _encKey);
-    if (_baseBlock->size() != sizeof(FORMAT_VERSION_HEADER) + encrypted.size()) {
-      _baseBlock->resize(sizeof(FORMAT_VERSION_HEADER) + encrypted.size());
-    }
-    _baseBlock->write(&FORMAT_VERSION_HEADER, 0, sizeof(FORMAT_VERSION_HEADER));
-    _baseBlock->write(encrypted.data(), sizeof(FORMAT_VERSION_HEADER), encrypted.size());
-    _dataChanged = false;
+void EncryptedBlock<Cipher>::_writeToBaseBlock(const cpputils::Data &plaintextWithHeader, uint64_t version) {
+  // Encrypting doesn't need the lock, so writes of the same block are encrypted in parallel
+  cpputils::Data encryptedWithFormatHeader = _encrypt(plaintextWithHeader, _encKey);
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (version > _writtenVersion) {
+    _writeEncrypted(_baseBlock.get(), encryptedWithFormatHeader);
+    _writtenVersion = version;
+    _baseBlock->flush();
+  }
+}
+
+template<class Cipher>
+void EncryptedBlock<Cipher>::_writeEncrypted(Block *baseBlock, const cpputils::Data &encryptedWithFormatHeader) {
+  if (baseBlock->size() != encryptedWithFormatHeader.size()) {
+    baseBlock->resize(encryptedWithFormatHeader.size());
   }
+  baseBlock->write(encryptedWithFormatHeader.data(), 0, encryptedWithFormatHeader.size());
 }
 
 template<class Cipher>
 cpputils::unique_ref<Block> EncryptedBlock<Cipher>::releaseBlock() {
   std::unique_lock<std::mutex> lock(_mutex);
-  _encryptToBaseBlock();
+  _dataChanged = false;
   return std::move(_baseBlock);
 }
 
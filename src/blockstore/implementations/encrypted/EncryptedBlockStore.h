@@ -5,8 +5,14 @@
 #include "../../interface/BlockStore.h"
 #include <cpp-utils/macros.h>
 #include <cpp-utils/pointer/cast.h>
+#include <cpp-utils/thread/WorkerPool.h>
 #include "EncryptedBlock.h"
+#include "EncryptionPipeline.h"
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <algorithm>
 
 namespace blockstore {
 namespace encrypted {
@@ -21,25 +27,49 @@ public:
   boost::optional<cpputils::unique_ref<Block>> tryCreate(const Key &key, cpputils::Data data) override;
   boost::optional<cpputils::unique_ref<Block>> load(const Key &key) override;
   void remove(cpputils::unique_ref<Block> block) override;
+  void remove(const Key &key) override;
+  std::vector<boost::optional<cpputils::unique_ref<Block>>> loadMany(const std::vector<Key> &keys) override;
+  void storeMany(std::vector<std::pair<Key, cpputils::Data>> blocks) override;
+  void removeMany(std::vector<cpputils::unique_ref<Block>> blocks) override;
+  void removeMany(const std::vector<Key> &keys) override;
   uint64_t numBlocks() const override;
   uint64_t estimateNumFreeBytes() const override;
   uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize) const override;
 
+  // Modified blocks are written to the base store asynchronously when they're destructed.
+  // This waits until all of these writes reached the base store.
+  void waitForPendingWrites() override;
+
   //This function should only be used by test cases
   void __setKey(const typename Cipher::EncryptionKey &encKey);
 
 private:
+  // Number of blocks per encryption thread that can wait to be encrypted before flushing a block blocks
+  static constexpr uint32_t MAX_QUEUED_WRITES_PER_THREAD = 4;
+
+  cpputils::WorkerPool *_workers();
+  static uint32_t _numThreads();
+
   cpputils::unique_ref<BlockStore> _baseBlockStore;
   typename Cipher::EncryptionKey _encKey;
+  // The threads are only started when the first batch is encrypted or decrypted, because most stores never get one.
+  std::once_flag _workersStarted;
+  std::unique_ptr<cpputils::WorkerPool> _workerPool;
+  // Declared after _baseBlockStore, so it finishes writing before the base store is destructed
+  EncryptionPipeline _pipeline;
 
   DISALLOW_COPY_AND_ASSIGN(EncryptedBlockStore);
 };
 
 
 
+template<class Cipher>
+constexpr uint32_t EncryptedBlockStore<Cipher>::MAX_QUEUED_WRITES_PER_THREAD;
+
 template<class Cipher>
 EncryptedBlockStore<Cipher>::EncryptedBlockStore(cpputils::unique_ref<BlockStore> baseBlockStore, const typename Cipher::EncryptionKey &encKey)
- : _baseBlockStore(std::move(baseBlockStore)), _encKey(encKey) {
+ : _baseBlockStore(std::move(baseBlockStore)), _encKey(encKey), _workersStarted(), _workerPool(nullptr),
+   _pipeline(_numThreads(), _numThreads() * MAX_QUEUED_WRITES_PER_THREAD) {
 }
 
 template<class Cipher>
@@ -51,7 +81,7 @@ template<class Cipher>
 boost::optional<cpputils::unique_ref<Block>> EncryptedBlockStore<Cipher>::tryCreate(const Key &key, cpputils::Data data) {
   //TODO Test that this returns boost::none when base blockstore returns nullptr  (for all pass-through-blockstores)
   //TODO Easier implementation? This is only so complicated because of the cast EncryptedBlock -> Block
-  auto result = EncryptedBlock<Cipher>::TryCreateNew(_baseBlockStore.get(), key, std::move(data), _encKey);
+  auto result = EncryptedBlock<Cipher>::TryCreateNew(_baseBlockStore.get(), &_pipeline, key, std::move(data), _encKey);
   if (result == boost::none) {
     return boost::none;
   }
@@ -60,12 +90,13 @@ boost::optional<cpputils::unique_ref<Block>> EncryptedBlockStore<Cipher>::tryCre
 
 template<class Cipher>
 boost::optional<cpputils::unique_ref<Block>> EncryptedBlockStore<Cipher>::load(const Key &key) {
+  _pipeline.waitUntilWritten(key);
   auto block = _baseBlockStore->load(key);
   if (block == boost::none) {
     //TODO Test this path (for all pass-through-blockstores)
     return boost::none;
   }
-  return boost::optional<cpputils::unique_ref<Block>>(EncryptedBlock<Cipher>::TryDecrypt(std::move(*block), _encKey));
+  return boost::optional<cpputils::unique_ref<Block>>(EncryptedBlock<Cipher>::TryDecrypt(std::move(*block), &_pipeline, _encKey));
 }
 
 template<class Cipher>
@@ -76,6 +107,79 @@ void EncryptedBlockStore<Cipher>::remove(cpputils::unique_ref<Block> block) {
   return _baseBlockStore->remove(std::move(baseBlock));
 }
 
+template<class Cipher>
+void EncryptedBlockStore<Cipher>::remove(const Key &key) {
+  _pipeline.waitUntilWritten(key);
+  return _baseBlockStore->remove(key);
+}
+
+template<class Cipher>
+std::vector<boost::optional<cpputils::unique_ref<Block>>> EncryptedBlockStore<Cipher>::loadMany(const std::vector<Key> &keys) {
+  for (const Key &key : keys) {
+    _pipeline.waitUntilWritten(key);
+  }
+  auto baseBlocks = _baseBlockStore->loadMany(keys);
+  // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+  std::vector<boost::optional<cpputils::unique_ref<Block>>> result(baseBlocks.size());
+  _workers()->parallelFor(baseBlocks.size(), [this, &baseBlocks, &result] (size_t index) {
+    if (baseBlocks[index] != boost::none) {
+      result[index] = boost::optional<cpputils::unique_ref<Block>>(EncryptedBlock<Cipher>::TryDecrypt(std::move(*baseBlocks[index]), &_pipeline, _encKey));
+    }
+  });
+  return result;
+}
+
+template<class Cipher>
+void EncryptedBlockStore<Cipher>::storeMany(std::vector<std::pair<Key, cpputils::Data>> blocks) {
+  // Otherwise a queued write of an older version could overwrite the stored blocks
+  for (const auto &block : blocks) {
+    _pipeline.waitUntilWritten(block.first);
+  }
+  _workers()->parallelFor(blocks.size(), [this, &blocks] (size_t index) {
+    blocks[index].second = EncryptedBlock<Cipher>::Encrypt(blocks[index].first, std::move(blocks[index].second), _encKey);
+  });
+  _baseBlockStore->storeMany(std::move(blocks));
+}
+
+template<class Cipher>
+void EncryptedBlockStore<Cipher>::removeMany(std::vector<cpputils::unique_ref<Block>> blocks) {
+  std::vector<cpputils::unique_ref<Block>> baseBlocks;
+  baseBlocks.reserve(blocks.size());
+  for (auto &block : blocks) {
+    auto encryptedBlock = cpputils::dynamic_pointer_move<EncryptedBlock<Cipher>>(block);
+    ASSERT(encryptedBlock != boost::none, "Block is not an EncryptedBlock");
+    baseBlocks.push_back((*encryptedBlock)->releaseBlock());
+  }
+  _baseBlockStore->removeMany(std::move(baseBlocks));
+}
+
+template<class Cipher>
+void EncryptedBlockStore<Cipher>::removeMany(const std::vector<Key> &keys) {
+  for (const Key &key : keys) {
+    _pipeline.waitUntilWritten(key);
+  }
+  _baseBlockStore->removeMany(keys);
+}
+
+template<class Cipher>
+cpputils::WorkerPool *EncryptedBlockStore<Cipher>::_workers() {
+  std::call_once(_workersStarted, [this] {
+    _workerPool = std::make_unique<cpputils::WorkerPool>(_numThreads(), _numThreads());
+  });
+  return _workerPool.get();
+}
+
+template<class Cipher>
+uint32_t EncryptedBlockStore<Cipher>::_numThreads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+template<class Cipher>
+void EncryptedBlockStore<Cipher>::waitForPendingWrites() {
+  _pipeline.waitUntilAllWritten();
+  _baseBlockStore->waitForPendingWrites();
+}
+
 template<class Cipher>
 uint64_t EncryptedBlockStore<Cipher>::numBlocks() const {
   return _baseBlockStore->numBlocks();
@@ -0,0 +1,115 @@
+#include "EncryptionPipeline.h"
+#include <cpp-utils/assert/assert.h>
+#include <cpp-utils/logging/logging.h>
+
+using std::function;
+using std::unique_lock;
+using std::mutex;
+using std::exception_ptr;
+using cpputils::WorkerPool;
+
+using namespace cpputils::logging;
+
+namespace blockstore {
+namespace encrypted {
+
+EncryptionPipeline::EncryptionPipeline(uint32_t numThreads, uint32_t maxQueuedWrites)
+  : _numThreads(numThreads), _maxQueuedWrites(maxQueuedWrites), _mutex(), _writeFinished(), _pendingWrites(), _numPendingWrites(0),
+    _failedWrites(), _workersStarted(), _workerPool(nullptr) {
+  ASSERT(numThreads > 0, "EncryptionPipeline needs at least one thread");
+  ASSERT(maxQueuedWrites > 0, "EncryptionPipeline needs a queue that can hold at least one write");
+}
+
+EncryptionPipeline::~EncryptionPipeline() {
+  // The worker pool drops tasks that didn't start yet, so wait for them before it is destructed
+  unique_lock<mutex> lock(_mutex);
+  _waitUntilAllFinished(&lock);
+  if (!_failedWrites.empty()) {
+    LOG(ERROR, "{} encrypted blocks couldn't be written", _failedWrites.size());
+  }
+}
+
+void EncryptionPipeline::schedule(const Key &key, function<void ()> write) {
+  {
+    unique_lock<mutex> lock(_mutex);
+    ++_pendingWrites[key];
+    ++_numPendingWrites;
+  }
+  try {
+    // Blocks while the queue is full, so a writer that is faster than the workers can't queue up unbounded memory
+    _workers()->schedule([this, key, write] {
+      exception_ptr error = nullptr;
+      try {
+        write();
+      } catch (const std::exception &e) {
+        LOG(ERROR, "Writing encrypted block {} failed: {}", key.ToString(), e.what());
+        error = std::current_exception();
+      } catch (...) {
+        LOG(ERROR, "Writing encrypted block {} failed", key.ToString());
+        error = std::current_exception();
+      }
+      _finishWrite(key, error);
+    });
+  } catch (...) {
+    _finishWrite(key, nullptr);
+    throw;
+  }
+}
+
+void EncryptionPipeline::_finishWrite(const Key &key, exception_ptr error) {
+  unique_lock<mutex> lock(_mutex);
+  if (error != nullptr) {
+    _failedWrites[key] = error;
+  }
+  auto found = _pendingWrites.find(key);
+  ASSERT(found != _pendingWrites.end(), "Finished a write that wasn't scheduled");
+  if (--found->second == 0) {
+    _pendingWrites.erase(found);
+  }
+  --_numPendingWrites;
+  _writeFinished.notify_all();
+}
+
+void EncryptionPipeline::waitUntilWritten(const Key &key) {
+  unique_lock<mutex> lock(_mutex);
+  _writeFinished.wait(lock, [this, &key] {
+    return _pendingWrites.find(key) == _pendingWrites.end();
+  });
+  auto failed = _failedWrites.find(key);
+  if (failed != _failedWrites.end()) {
+    exception_ptr error = failed->second;
+    _failedWrites.erase(failed);
+    std::rethrow_exception(error);
+  }
+}
+
+void EncryptionPipeline::waitUntilAllWritten() {
+  unique_lock<mutex> lock(_mutex);
+  _waitUntilAllFinished(&lock);
+  if (!_failedWrites.empty()) {
+    exception_ptr error = _failedWrites.begin()->second;
+    _failedWrites.erase(_failedWrites.begin());
+    std::rethrow_exception(error);
+  }
+}
+
+void EncryptionPipeline::_waitUntilAllFinished(unique_lock<mutex> *lock) {
+  _writeFinished.wait(*lock, [this] {
+    return _numPendingWrites == 0;
+  });
+}
+
+uint32_t EncryptionPipeline::numPendingWrites() const {
+  unique_lock<mutex> lock(_mutex);
+  return _numPendingWrites;
+}
+
+WorkerPool *EncryptionPipeline::_workers() {
+  std::call_once(_workersStarted, [this] {
+    _workerPool = std::make_unique<WorkerPool>(_numThreads, _maxQueuedWrites);
+  });
+  return _workerPool.get();
+}
+
+}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_ENCRYPTED_ENCRYPTIONPIPELINE_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_ENCRYPTED_ENCRYPTIONPIPELINE_H_
+
+#include "../../utils/Key.h"
+#include <cpp-utils/macros.h>
+#include <cpp-utils/thread/WorkerPool.h>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace blockstore {
+namespace encrypted {
+
+// Encrypts blocks and writes them to the base store on worker threads, so the thread that destructs a
+// block can go on while the block is encrypted. The store waits for the writes of a key before the key is
+// loaded or removed, so nobody sees the old content of a block whose write is still queued.
+// Nobody waits for the result of a write when it runs, so if it fails, the error is kept and rethrown by the
+// next call that waits for the key (or for all keys).
+class EncryptionPipeline final {
+public:
+  // At most maxQueuedWrites writes wait for a worker. If more are scheduled, schedule() blocks.
+  EncryptionPipeline(uint32_t numThreads, uint32_t maxQueuedWrites);
+  // Waits until all scheduled writes are finished. Errors that weren't rethrown yet are only logged.
+  ~EncryptionPipeline();
+
+  // Runs the write on a worker. If the write throws, the error is kept for waitUntilWritten()/waitUntilAllWritten().
+  void schedule(const Key &key, std::function<void ()> write);
+
+  // Rethrow the error of a failed write, if there is one. Each error is rethrown only once.
+  void waitUntilWritten(const Key &key);
+  void waitUntilAllWritten();
+
+  uint32_t numPendingWrites() const;
+
+private:
+  cpputils::WorkerPool *_workers();
+  void _finishWrite(const Key &key, std::exception_ptr error);
+  void _waitUntilAllFinished(std::unique_lock<std::mutex> *lock);
+
+  const uint32_t _numThreads;
+  const uint32_t _maxQueuedWrites;
+  mutable std::mutex _mutex;
+  std::condition_variable _writeFinished;
+  std::unordered_map<Key, uint32_t> _pendingWrites;
+  uint32_t _numPendingWrites;
+  std::unordered_map<Key, std::exception_ptr> _failedWrites;
+  // The threads are only started when the first block is written, because many stores never write a block.
+  std::once_flag _workersStarted;
+  std::unique_ptr<cpputils::WorkerPool> _workerPool;
+
+  DISALLOW_COPY_AND_ASSIGN(EncryptionPipeline);
+};
+
+}
+}
+
+#endif
@@ -20,9 +20,10 @@ namespace blockstore {
 namespace inmemory {
 
 InMemoryBlockStore::InMemoryBlockStore()
- : _blocks() {}
+ : _blocks(), _mutex() {}
 
 optional<unique_ref<Block>> InMemoryBlockStore::tryCreate(const Key &key, Data data) {
+  lock_guard<mutex> lock(_mutex);
   auto insert_result = _blocks.emplace(piecewise_construct, make_tuple(key), make_tuple(key, std::move(data)));
 
   if (!insert_result.second) {
@@ -34,6 +35,7 @@ optional<unique_ref<Block>> InMemoryBlockStore::tryCreate(const Key &key, Data d
 }
 
 optional<unique_ref<Block>> InMemoryBlockStore::load(const Key &key) {
+  lock_guard<mutex> lock(_mutex);
   //Return a pointer to the stored InMemoryBlock
   try {
     return optional<unique_ref<Block>>(make_unique_ref<InMemoryBlock>(_blocks.at(key)));
@@ -45,11 +47,17 @@ optional<unique_ref<Block>> InMemoryBlockStore::load(const Key &key) {
 void InMemoryBlockStore::remove(unique_ref<Block> block) {
   Key key = block->key();
   cpputils::destruct(std::move(block));
+  remove(key);
+}
+
+void InMemoryBlockStore::remove(const Key &key) {
+  lock_guard<mutex> lock(_mutex);
   int numRemoved = _blocks.erase(key);
   ASSERT(1==numRemoved, "Didn't find block to remove");
 }
 
 uint64_t InMemoryBlockStore::numBlocks() const {
+  lock_guard<mutex> lock(_mutex);
   return _blocks.size();
 }
 
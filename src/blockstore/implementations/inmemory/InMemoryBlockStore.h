@@ -19,12 +19,14 @@ public:
   boost::optional<cpputils::unique_ref<Block>> tryCreate(const Key &key, cpputils::Data data) override;
   boost::optional<cpputils::unique_ref<Block>> load(const Key &key) override;
   void remove(cpputils::unique_ref<Block> block) override;
+  void remove(const Key &key) override;
   uint64_t numBlocks() const override;
   uint64_t estimateNumFreeBytes() const override;
   uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize) const override;
 
 private:
   std::unordered_map<Key, InMemoryBlock> _blocks;
+  mutable std::mutex _mutex;
 
   DISALLOW_COPY_AND_ASSIGN(InMemoryBlockStore);
 };
@@ -0,0 +1,72 @@
+#include "AsyncFileIO.h"
+#include "IoUringFileIO.h"
+#include "ThreadPoolFileIO.h"
+#include <cerrno>
+#include <cpp-utils/logging/logging.h>
+
+using cpputils::unique_ref;
+using cpputils::make_unique_ref;
+using std::vector;
+using namespace cpputils::logging;
+
+namespace blockstore {
+namespace ondisk {
+
+unique_ref<AsyncFileIO> AsyncFileIO::Create() {
+  auto ioUring = IoUringFileIO::Create();
+  if (ioUring != boost::none) {
+    return std::move(*ioUring);
+  }
+  LOG(DEBUG, "io_uring isn't available. Using a thread pool for block I/O.");
+  return make_unique_ref<ThreadPoolFileIO>();
+}
+
+void AsyncFileIO::RunSynchronously(Request *request) {
+  _finishSynchronously(request, 0);
+}
+
+void AsyncFileIO::_finishSynchronously(Request *request, size_t alreadyTransferred) {
+  vector<struct iovec> iov(request->iov, request->iov + request->iovcnt);
+  size_t transferred = alreadyTransferred;
+  size_t toSkip = alreadyTransferred;
+  auto current = iov.begin();
+  while (true) {
+    // Skip the buffers that are already transferred and cut the one that is partly transferred
+    while (current != iov.end() && toSkip >= current->iov_len) {
+      toSkip -= current->iov_len;
+      ++current;
+    }
+    if (current == iov.end()) {
+      break;
+    }
+    current->iov_base = static_cast<uint8_t*>(current->iov_base) + toSkip;
+    current->iov_len -= toSkip;
+
+    off_t offset = request->offset + transferred;
+    int iovcnt = iov.end() - current;
+    ssize_t result;
+    if (request->type == Request::Type::READ) {
+      result = ::preadv(request->fd, &*current, iovcnt, offset);
+    } else {
+      result = ::pwritev(request->fd, &*current, iovcnt, offset);
+    }
+    if (result < 0 && errno == EINTR) {
+      toSkip = 0;
+      continue;
+    }
+    if (result < 0) {
+      request->result = -errno;
+      return;
+    }
+    if (result == 0) {
+      // End of file
+      break;
+    }
+    transferred += result;
+    toSkip = result;
+  }
+  request->result = transferred;
+}
+
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_ONDISK_ASYNCFILEIO_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_ONDISK_ASYNCFILEIO_H_
+
+#include <cpp-utils/pointer/unique_ref.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace blockstore {
+namespace ondisk {
+
+// Runs batches of positional reads and writes on open files. All requests of a batch are in flight at the same time
+// and complete in any order, so a device that handles many requests in parallel (e.g. an NVMe SSD) finishes a batch
+// of n requests in about the time of one, instead of n times that.
+class AsyncFileIO {
+public:
+  struct Request final {
+    enum class Type {READ, WRITE};
+
+    Type type;
+    int fd;
+    // The buffers stay owned by the caller and must stay valid until run() returns.
+    const struct iovec *iov;
+    int iovcnt;
+    off_t offset;
+    // Set by run(). The number of bytes transferred, or -errno if the request failed.
+    // All buffers are transferred, except if a read reaches the end of the file.
+    ssize_t result;
+  };
+
+  virtual ~AsyncFileIO() {}
+
+  // Runs all requests and returns when all of them have completed. This can be called by multiple threads in parallel.
+  virtual void run(std::vector<Request> *requests) = 0;
+
+  // Uses io_uring if the kernel supports it and falls back to a thread pool otherwise
+  static cpputils::unique_ref<AsyncFileIO> Create();
+
+  // Runs the request in the calling thread
+  static void RunSynchronously(Request *request);
+
+protected:
+  // Transfers the part of the request after the first alreadyTransferred bytes in the calling thread.
+  // Backends use this to finish requests for which the kernel transferred less than requested.
+  static void _finishSynchronously(Request *request, size_t alreadyTransferred);
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,271 @@
+#include "IoUringFileIO.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <cpp-utils/assert/assert.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define BLOCKSTORE_HAVE_IO_URING
+#endif
+#endif
+
+#ifdef BLOCKSTORE_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using cpputils::unique_ref;
+using cpputils::nullcheck;
+using boost::optional;
+using boost::none;
+using std::vector;
+
+namespace blockstore {
+namespace ondisk {
+
+constexpr uint32_t IoUringFileIO::QUEUE_DEPTH;
+
+#ifdef BLOCKSTORE_HAVE_IO_URING
+
+// The submission and completion queues shared with the kernel, see io_uring(7)
+class IoUringFileIO::Ring final {
+public:
+  static optional<unique_ref<Ring>> Create(uint32_t numEntries) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = ::syscall(__NR_io_uring_setup, numEntries, &params);
+    if (fd < 0) {
+      return none;
+    }
+    auto ring = nullcheck(std::unique_ptr<Ring>(new Ring(fd, params)));
+    if (!ring.value()->_mapQueues(params)) {
+      return none;
+    }
+    return std::move(*ring);
+  }
+
+  ~Ring() {
+    if (_sqes != MAP_FAILED) {
+      ::munmap(_sqes, _sqesSize);
+    }
+    if (_cqRing != MAP_FAILED && _cqRing != _sqRing) {
+      ::munmap(_cqRing, _cqRingSize);
+    }
+    if (_sqRing != MAP_FAILED) {
+      ::munmap(_sqRing, _sqRingSize);
+    }
+    ::close(_fd);
+  }
+
+  uint32_t numEntries() const {
+    return _numEntries;
+  }
+
+  // Submits the requests and waits until all of them completed
+  void submitAndWait(Request *requests, uint32_t count) {
+    ASSERT(count <= _numEntries, "Too many requests for the ring");
+    // We're the only one adding submissions, so we don't need to synchronize reading the tail
+    unsigned tail = *_sqTail;
+    for (uint32_t i = 0; i < count; ++i) {
+      unsigned index = tail & *_sqMask;
+      struct io_uring_sqe *sqe = &_sqes[index];
+      std::memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = (requests[i].type == Request::Type::READ) ? IORING_OP_READV : IORING_OP_WRITEV;
+      sqe->fd = requests[i].fd;
+      sqe->addr = reinterpret_cast<uintptr_t>(requests[i].iov);
+      sqe->len = requests[i].iovcnt;
+      sqe->off = requests[i].offset;
+      sqe->user_data = i;
+      _sqArray[index] = index;
+      ++tail;
+    }
+    // The kernel must see the entries before it sees the new tail
+    __atomic_store_n(_sqTail, tail, __ATOMIC_RELEASE);
+
+    uint32_t numToSubmit = count;
+    uint32_t numCompleted = 0;
+    while (numCompleted < count) {
+      int submitted = ::syscall(__NR_io_uring_enter, _fd, numToSubmit, count - numCompleted, IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (submitted < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+      }
+      numToSubmit -= submitted;
+      numCompleted += _reapCompletions(requests);
+    }
+  }
+
+private:
+  Ring(int fd, const struct io_uring_params &params)
+    : _fd(fd), _numEntries(params.sq_entries), _sqRing(MAP_FAILED), _sqRingSize(0), _cqRing(MAP_FAILED), _cqRingSize(0),
+      _sqes(static_cast<struct io_uring_sqe*>(MAP_FAILED)), _sqesSize(0), _sqTail(nullptr), _sqMask(nullptr), _sqArray(nullptr),
+      _cqHead(nullptr), _cqTail(nullptr), _cqMask(nullptr), _cqes(nullptr) {
+  }
+
+  bool _mapQueues(const struct io_uring_params &params) {
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+      _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+    }
+    _sqRing = ::mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sqRing == MAP_FAILED) {
+      return false;
+    }
+    if (singleMmap) {
+      _cqRing = _sqRing;
+    } else {
+      _cqRing = ::mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+      if (_cqRing == MAP_FAILED) {
+        return false;
+      }
+    }
+    _sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    _sqes = static_cast<struct io_uring_sqe*>(::mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES));
+    if (_sqes == MAP_FAILED) {
+      return false;
+    }
+
+    uint8_t *sqRing = static_cast<uint8_t*>(_sqRing);
+    _sqTail = reinterpret_cast<unsigned*>(sqRing + params.sq_off.tail);
+    _sqMask = reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_mask);
+    _sqArray = reinterpret_cast<unsigned*>(sqRing + params.sq_off.array);
+    uint8_t *cqRing = static_cast<uint8_t*>(_cqRing);
+    _cqHead = reinterpret_cast<unsigned*>(cqRing + params.cq_off.head);
+    _cqTail = reinterpret_cast<unsigned*>(cqRing + params.cq_off.tail);
+    _cqMask = reinterpret_cast<unsigned*>(cqRing + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<struct io_uring_cqe*>(cqRing + params.cq_off.cqes);
+    return true;
+  }
+
+  // Stores the results of all available completions in their requests and returns how many there were
+  uint32_t _reapCompletions(Request *requests) {
+    uint32_t numReaped = 0;
+    // We're the only one consuming completions, so we don't need to synchronize reading the head
+    unsigned head = *_cqHead;
+    unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+      const struct io_uring_cqe &cqe = _cqes[head & *_cqMask];
+      requests[cqe.user_data].result = cqe.res;
+      ++head;
+      ++numReaped;
+    }
+    // The kernel may only reuse the entries after we read them
+    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+    return numReaped;
+  }
+
+  int _fd;
+  uint32_t _numEntries;
+  void *_sqRing;
+  size_t _sqRingSize;
+  void *_cqRing;
+  size_t _cqRingSize;
+  struct io_uring_sqe *_sqes;
+  size_t _sqesSize;
+  unsigned *_sqTail;
+  unsigned *_sqMask;
+  unsigned *_sqArray;
+  unsigned *_cqHead;
+  unsigned *_cqTail;
+  unsigned *_cqMask;
+  struct io_uring_cqe *_cqes;
+
+  DISALLOW_COPY_AND_ASSIGN(Ring);
+};
+
+#else
+
+class IoUringFileIO::Ring final {
+public:
+  static optional<unique_ref<Ring>> Create(uint32_t /*numEntries*/) {
+    return none;
+  }
+
+  uint32_t numEntries() const {
+    ASSERT(false, "io_uring isn't supported on this platform");
+    return 0;
+  }
+
+  void submitAndWait(Request * /*requests*/, uint32_t /*count*/) {
+    ASSERT(false, "io_uring isn't supported on this platform");
+  }
+};
+
+#endif
+
+optional<unique_ref<IoUringFileIO>> IoUringFileIO::Create() {
+  auto ring = Ring::Create(QUEUE_DEPTH);
+  if (ring == none) {
+    return none;
+  }
+  return nullcheck(std::unique_ptr<IoUringFileIO>(new IoUringFileIO(std::move(*ring))));
+}
+
+IoUringFileIO::IoUringFileIO(unique_ref<Ring> firstRing): _mutex(), _freeRings() {
+  _freeRings.push_back(std::move(firstRing));
+}
+
+IoUringFileIO::~IoUringFileIO() {
+}
+
+unique_ref<IoUringFileIO::Ring> IoUringFileIO::_acquireRing() {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_freeRings.empty()) {
+      auto ring = std::move(_freeRings.back());
+      _freeRings.pop_back();
+      return ring;
+    }
+  }
+  auto ring = Ring::Create(QUEUE_DEPTH);
+  if (ring == none) {
+    throw std::runtime_error("Could not create another io_uring");
+  }
+  return std::move(*ring);
+}
+
+void IoUringFileIO::_releaseRing(unique_ref<Ring> ring) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _freeRings.push_back(std::move(ring));
+}
+
+void IoUringFileIO::run(vector<Request> *requests) {
+  if (requests->size() == 1) {
+    // A single request doesn't benefit from the ring, and the system call is cheaper
+    RunSynchronously(&(*requests)[0]);
+    return;
+  }
+  // If submitting fails, the ring is dropped instead of being reused, because it might still have requests in flight.
+  auto ring = _acquireRing();
+  for (size_t begin = 0; begin < requests->size(); begin += ring->numEntries()) {
+    uint32_t count = std::min<size_t>(ring->numEntries(), requests->size() - begin);
+    ring->submitAndWait(requests->data() + begin, count);
+  }
+  _releaseRing(std::move(ring));
+
+  for (Request &request : *requests) {
+    if (request.result <= 0) {
+      continue;
+    }
+    size_t requested = 0;
+    for (int i = 0; i < request.iovcnt; ++i) {
+      requested += request.iov[i].iov_len;
+    }
+    if (static_cast<size_t>(request.result) < requested) {
+      // The kernel can transfer less than requested, e.g. when interrupted. Finishing it here is rare enough.
+      // This also ends up here when a read reaches the end of the file.
+      _finishSynchronously(&request, request.result);
+    }
+  }
+}
+
+}
+}
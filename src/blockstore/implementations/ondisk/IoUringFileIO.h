@@ -0,0 +1,45 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_ONDISK_IOURINGFILEIO_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_ONDISK_IOURINGFILEIO_H_
+
+#include "AsyncFileIO.h"
+#include <cpp-utils/macros.h>
+#include <boost/optional.hpp>
+#include <mutex>
+
+namespace blockstore {
+namespace ondisk {
+
+// Submits all requests of a batch to the kernel with one io_uring_enter() system call and waits for their completions.
+// This uses the system calls directly instead of liburing, so it doesn't add a dependency.
+class IoUringFileIO final: public AsyncFileIO {
+public:
+  // Number of requests submitted at once. Larger batches are submitted in several rounds.
+  static constexpr uint32_t QUEUE_DEPTH = 64;
+
+  // Returns boost::none if the kernel doesn't support io_uring (it needs Linux 5.1) or it is disabled.
+  static boost::optional<cpputils::unique_ref<IoUringFileIO>> Create();
+
+  ~IoUringFileIO();
+
+  void run(std::vector<Request> *requests) override;
+
+private:
+  class Ring;
+
+  explicit IoUringFileIO(cpputils::unique_ref<Ring> firstRing);
+
+  cpputils::unique_ref<Ring> _acquireRing();
+  void _releaseRing(cpputils::unique_ref<Ring> ring);
+
+  // A ring can only be used by one thread at a time. Threads running batches in parallel each get their own.
+  std::mutex _mutex;
+  std::vector<cpputils::unique_ref<Ring>> _freeRings;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUringFileIO);
+};
+
+}
+}
+
+#endif
@@ -1,19 +1,20 @@
 #include <cstring>
-#include <fstream>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unordered_set>
 #include <boost/filesystem.hpp>
 #include "OnDiskBlock.h"
 #include "OnDiskBlockStore.h"
-#include "../../utils/FileDoesntExistException.h"
 #include <cpp-utils/data/DataUtils.h>
 #include <cpp-utils/assert/assert.h>
 #include <cpp-utils/logging/logging.h>
 
-using std::istream;
-using std::ostream;
-using std::ifstream;
-using std::ofstream;
-using std::ios;
 using std::string;
+using std::vector;
 using cpputils::Data;
 using cpputils::make_unique_ref;
 using cpputils::unique_ref;
@@ -26,11 +27,262 @@ using namespace cpputils::logging;
 namespace blockstore {
 namespace ondisk {
 
+namespace {
+// O_DIRECT needs file offsets, buffer addresses and transfer sizes to be multiples of the logical block size of the
+// underlying device. 4096 is a multiple of the logical block size of all common devices.
+constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+size_t roundUpToAlignment(size_t size) {
+  return (size + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+}
+
+string errorMessage(const string &message, const bf::path &path, int errorCode) {
+  return message + " " + path.native() + ": " + std::strerror(errorCode);
+}
+
+// Owns a file descriptor and closes it on destruction
+class FileDescriptor final {
+public:
+  explicit FileDescriptor(int fd): _fd(fd) {}
+  ~FileDescriptor() {
+    if (_fd >= 0) {
+      ::close(_fd);
+    }
+  }
+  int get() const {
+    return _fd;
+  }
+  // Gives up ownership of the file descriptor
+  int release() {
+    int fd = _fd;
+    _fd = -1;
+    return fd;
+  }
+  // Closes the file descriptor and returns false if that failed, which can indicate a failed write.
+  bool close() {
+    int fd = _fd;
+    _fd = -1;
+    return 0 == ::close(fd);
+  }
+private:
+  int _fd;
+  DISALLOW_COPY_AND_ASSIGN(FileDescriptor);
+};
+
+// Memory region aligned for O_DIRECT
+class AlignedBuffer final {
+public:
+  explicit AlignedBuffer(size_t size): _data(nullptr) {
+    if (0 != posix_memalign(&_data, DIRECT_IO_ALIGNMENT, size)) {
+      throw std::bad_alloc();
+    }
+  }
+  ~AlignedBuffer() {
+    std::free(_data);
+  }
+  uint8_t *data() {
+    return static_cast<uint8_t*>(_data);
+  }
+private:
+  void *_data;
+  DISALLOW_COPY_AND_ASSIGN(AlignedBuffer);
+};
+
+// Opens the file with O_DIRECT if directIO is set and the file system supports it, otherwise with buffered I/O.
+int openFile(const bf::path &path, int flags, bool directIO) {
+#ifdef O_DIRECT
+  if (directIO) {
+    int fd = ::open(path.c_str(), flags | O_DIRECT, 0666);
+    if (fd >= 0 || errno != EINVAL) {
+      return fd;
+    }
+    // The file system doesn't support O_DIRECT (e.g. tmpfs). The aligned buffers work with buffered I/O too.
+  }
+#else
+  UNUSED(directIO);
+#endif
+  return ::open(path.c_str(), flags, 0666);
+}
+
+size_t requestSize(const AsyncFileIO::Request &request) {
+  size_t size = 0;
+  for (int i = 0; i < request.iovcnt; ++i) {
+    size += request.iov[i].iov_len;
+  }
+  return size;
+}
+}
+
+// A block file opened for reading, together with the buffers the read goes to.
+// Loading a block is split into opening it, running the read request (possibly in a batch with others) and finishing it.
+class OnDiskBlock::PendingRead final {
+public:
+  // Returns boost::none if the block file doesn't exist
+  static optional<unique_ref<PendingRead>> Open(const bf::path &filepath, bool directIO) {
+    FileDescriptor file(openFile(filepath, O_RDONLY | O_CLOEXEC, directIO));
+    if (file.get() < 0) {
+      if (errno == ENOENT || errno == ENOTDIR) {
+        return none;
+      }
+      throw std::runtime_error(errorMessage("Could not open file for reading", filepath, errno));
+    }
+    struct stat stat;
+    if (0 != ::fstat(file.get(), &stat)) {
+      throw std::runtime_error(errorMessage("Could not stat block file", filepath, errno));
+    }
+    if (!S_ISREG(stat.st_mode)) {
+      return none;
+    }
+    size_t fileSize = stat.st_size;
+    if (fileSize < formatVersionHeaderSize()) {
+      throw std::runtime_error("This is not a valid block.");
+    }
+    return make_unique_ref<PendingRead>(filepath, file.release(), fileSize, directIO);
+  }
+
+  PendingRead(const bf::path &filepath, int fd, size_t fileSize, bool directIO)
+    : _filepath(filepath), _file(fd), _fileSize(fileSize), _header(formatVersionHeaderSize()), _data(fileSize - formatVersionHeaderSize()),
+      _alignedBuffer(nullptr), _iov(), _iovcnt(0) {
+    if (directIO) {
+      // O_DIRECT can only read whole aligned chunks, so read into an aligned buffer and copy the data out of it.
+      size_t alignedSize = roundUpToAlignment(fileSize);
+      _alignedBuffer = std::make_unique<AlignedBuffer>(alignedSize);
+      _iov[0] = {_alignedBuffer->data(), alignedSize};
+      _iovcnt = 1;
+    } else {
+      _iov[0] = {_header.data(), _header.size()};
+      _iov[1] = {_data.data(), _data.size()};
+      _iovcnt = 2;
+    }
+  }
+
+  AsyncFileIO::Request request() const {
+    return AsyncFileIO::Request{AsyncFileIO::Request::Type::READ, _file.get(), _iov, _iovcnt, 0, 0};
+  }
+
+  // Takes the completed request and returns the block data
+  Data finish(const AsyncFileIO::Request &request) {
+    if (request.result < 0) {
+      throw std::runtime_error(errorMessage("Error reading block file", _filepath, -request.result));
+    }
+    if (static_cast<size_t>(request.result) < _fileSize) {
+      // The file can only be shorter than fstat() said if it was truncated while we were reading it.
+      throw std::runtime_error("Block file " + _filepath.native() + " got shorter while reading it");
+    }
+    if (_alignedBuffer != nullptr) {
+      std::memcpy(_header.data(), _alignedBuffer->data(), _header.size());
+      std::memcpy(_data.data(), _alignedBuffer->data() + _header.size(), _data.size());
+    }
+    _checkHeader(_header);
+    return std::move(_data);
+  }
+
+private:
+  bf::path _filepath;
+  FileDescriptor _file;
+  size_t _fileSize;
+  Data _header;
+  Data _data;
+  std::unique_ptr<AlignedBuffer> _alignedBuffer;
+  struct iovec _iov[2];
+  int _iovcnt;
+
+  DISALLOW_COPY_AND_ASSIGN(PendingRead);
+};
+
+// A block file opened for writing, together with the buffers the write comes from. Like PendingRead, storing a block
+// is split into opening the file, running the write request and finishing it.
+// If the block file already exists, this writes a temporary file and finish() renames it over the block file,
+// so that the block file always contains either the old or the new version of the block, even if CryFS crashes while
+// writing. The files aren't synced to the disk, because that would wait for the disk on each block. So after a power
+// loss or an operating system crash, it depends on the underlying file system whether the block was written.
+// If the PendingWrite is destructed without being finished, it deletes the file it wrote to.
+class OnDiskBlock::PendingWrite final {
+public:
+  // If createNew is set, this creates the block file and returns boost::none if it already exists.
+  // A new block doesn't need the detour over a temporary file, because there is no old version to keep intact.
+  static optional<unique_ref<PendingWrite>> Open(const bf::path &filepath, const Data &data, bool directIO, bool createNew) {
+    bf::path writepath = createNew ? filepath : bf::path(filepath.native() + TEMPFILE_SUFFIX);
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (createNew ? O_EXCL : O_TRUNC);
+    int fd = openFile(writepath, flags, directIO);
+    if (fd < 0) {
+      if (createNew && errno == EEXIST) {
+        return none;
+      }
+      throw std::runtime_error(errorMessage("Could not open file for writing", writepath, errno));
+    }
+    return make_unique_ref<PendingWrite>(filepath, writepath, fd, data, directIO);
+  }
+
+  PendingWrite(const bf::path &filepath, const bf::path &writepath, int fd, const Data &data, bool directIO)
+    : _filepath(filepath), _writepath(writepath), _file(fd), _fileSize(formatVersionHeaderSize() + data.size()),
+      _alignedBuffer(nullptr), _iov(), _iovcnt(0), _finished(false) {
+    if (directIO) {
+      // O_DIRECT can only write whole aligned chunks. Write the padded buffer and cut the file to the real size in finish().
+      size_t alignedSize = roundUpToAlignment(_fileSize);
+      _alignedBuffer = std::make_unique<AlignedBuffer>(alignedSize);
+      std::memcpy(_alignedBuffer->data(), FORMAT_VERSION_HEADER.c_str(), formatVersionHeaderSize());
+      std::memcpy(_alignedBuffer->data() + formatVersionHeaderSize(), data.data(), data.size());
+      std::memset(_alignedBuffer->data() + _fileSize, 0, alignedSize - _fileSize);
+      _iov[0] = {_alignedBuffer->data(), alignedSize};
+      _iovcnt = 1;
+    } else {
+      _iov[0] = {const_cast<char*>(FORMAT_VERSION_HEADER.c_str()), formatVersionHeaderSize()};
+      _iov[1] = {const_cast<void*>(data.data()), data.size()};
+      _iovcnt = 2;
+    }
+  }
+
+  ~PendingWrite() {
+    if (!_finished) {
+      ::unlink(_writepath.c_str());
+    }
+  }
+
+  AsyncFileIO::Request request() const {
+    return AsyncFileIO::Request{AsyncFileIO::Request::Type::WRITE, _file.get(), _iov, _iovcnt, 0, 0};
+  }
+
+  // Takes the completed request and makes the written file the block file
+  void finish(const AsyncFileIO::Request &request) {
+    if (request.result < 0) {
+      throw std::runtime_error(errorMessage("Error writing block file", _writepath, -request.result));
+    }
+    if (static_cast<size_t>(request.result) < requestSize(request)) {
+      throw std::runtime_error("Block file " + _writepath.native() + " wasn't completely written");
+    }
+    if (_alignedBuffer != nullptr && 0 != ::ftruncate(_file.get(), _fileSize)) {
+      throw std::runtime_error(errorMessage("Error writing block file", _writepath, errno));
+    }
+    // Errors from close() can be deferred write errors, so they must not be ignored
+    if (!_file.close()) {
+      throw std::runtime_error(errorMessage("Error writing block file", _writepath, errno));
+    }
+    if (_writepath != _filepath && 0 != ::rename(_writepath.c_str(), _filepath.c_str())) {
+      throw std::runtime_error(errorMessage("Could not rename block file", _writepath, errno));
+    }
+    _finished = true;
+  }
+
+private:
+  bf::path _filepath;
+  bf::path _writepath;
+  FileDescriptor _file;
+  size_t _fileSize;
+  std::unique_ptr<AlignedBuffer> _alignedBuffer;
+  struct iovec _iov[2];
+  int _iovcnt;
+  bool _finished;
+
+  DISALLOW_COPY_AND_ASSIGN(PendingWrite);
+};
+
 const string OnDiskBlock::FORMAT_VERSION_HEADER_PREFIX = "cryfs;block;";
 const string OnDiskBlock::FORMAT_VERSION_HEADER = OnDiskBlock::FORMAT_VERSION_HEADER_PREFIX + "0";
+const string OnDiskBlock::TEMPFILE_SUFFIX = ".tmp";
 
-OnDiskBlock::OnDiskBlock(const Key &key, const bf::path &filepath, Data data)
- : Block(key), _filepath(filepath), _data(std::move(data)), _dataChanged(false), _mutex() {
+OnDiskBlock::OnDiskBlock(const Key &key, const bf::path &filepath, Data data, bool directIO)
+ : Block(key), _filepath(filepath), _data(std::move(data)), _dataChanged(false), _directIO(directIO), _mutex() {
 }
 
 OnDiskBlock::~OnDiskBlock() {
@@ -61,31 +313,77 @@ bf::path OnDiskBlock::_getFilepath(const bf::path &rootdir, const Key &key) {
   return rootdir / keyStr.substr(0,3) / keyStr.substr(3);
 }
 
-optional<unique_ref<OnDiskBlock>> OnDiskBlock::LoadFromDisk(const bf::path &rootdir, const Key &key) {
+optional<unique_ref<OnDiskBlock>> OnDiskBlock::LoadFromDisk(const bf::path &rootdir, const Key &key, bool directIO) {
   auto filepath = _getFilepath(rootdir, key);
-  try {
-    boost::optional<Data> data = _loadFromDisk(filepath);
-    if (data == none) {
-      return none;
-    }
-    return make_unique_ref<OnDiskBlock>(key, filepath, std::move(*data));
-  } catch (const FileDoesntExistException &e) {
+  auto pendingRead = PendingRead::Open(filepath, directIO);
+  if (pendingRead == none) {
     return none;
   }
+  auto request = (*pendingRead)->request();
+  AsyncFileIO::RunSynchronously(&request);
+  return make_unique_ref<OnDiskBlock>(key, filepath, (*pendingRead)->finish(request), directIO);
 }
 
-optional<unique_ref<OnDiskBlock>> OnDiskBlock::CreateOnDisk(const bf::path &rootdir, const Key &key, Data data) {
+vector<optional<unique_ref<OnDiskBlock>>> OnDiskBlock::LoadManyFromDisk(const bf::path &rootdir, const vector<Key> &keys, bool directIO, AsyncFileIO *fileIO) {
+  // The vectors of boost::optional<unique_ref> are sized upfront, because vector can't move them when growing
+  vector<optional<unique_ref<PendingRead>>> pendingReads(keys.size());
+  vector<AsyncFileIO::Request> requests;
+  requests.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    pendingReads[i] = PendingRead::Open(_getFilepath(rootdir, keys[i]), directIO);
+    if (pendingReads[i] != none) {
+      requests.push_back((*pendingReads[i])->request());
+    }
+  }
+
+  fileIO->run(&requests);
+
+  vector<optional<unique_ref<OnDiskBlock>>> result(keys.size());
+  auto request = requests.begin();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (pendingReads[i] != none) {
+      Data data = (*pendingReads[i])->finish(*request++);
+      result[i] = make_unique_ref<OnDiskBlock>(keys[i], _getFilepath(rootdir, keys[i]), std::move(data), directIO);
+    }
+  }
+  return result;
+}
+
+optional<unique_ref<OnDiskBlock>> OnDiskBlock::CreateOnDisk(const bf::path &rootdir, const Key &key, Data data, bool directIO) {
   auto filepath = _getFilepath(rootdir, key);
   bf::create_directory(filepath.parent_path());
-  if (bf::exists(filepath)) {
+
+  auto block = make_unique_ref<OnDiskBlock>(key, filepath, std::move(data), directIO);
+  if (!block->_createOnDisk()) {
     return none;
   }
-
-  auto block = make_unique_ref<OnDiskBlock>(key, filepath, std::move(data));
-  block->_storeToDisk();
   return std::move(block);
 }
 
+void OnDiskBlock::StoreManyToDisk(const bf::path &rootdir, const vector<std::pair<Key, Data>> &blocks, bool directIO, AsyncFileIO *fileIO) {
+  vector<unique_ref<PendingWrite>> pendingWrites;
+  pendingWrites.reserve(blocks.size());
+  vector<AsyncFileIO::Request> requests;
+  requests.reserve(blocks.size());
+  // Blocks with the same key would share their temporary file, so only the last entry of each key is written
+  std::unordered_set<Key> seenKeys;
+  for (auto block = blocks.rbegin(); block != blocks.rend(); ++block) {
+    if (!seenKeys.insert(block->first).second) {
+      continue;
+    }
+    auto filepath = _getFilepath(rootdir, block->first);
+    bf::create_directory(filepath.parent_path());
+    pendingWrites.push_back(PendingWrite::Open(filepath, block->second, directIO, false).value());
+    requests.push_back(pendingWrites.back()->request());
+  }
+
+  fileIO->run(&requests);
+
+  for (size_t i = 0; i < pendingWrites.size(); ++i) {
+    pendingWrites[i]->finish(requests[i]);
+  }
+}
+
 void OnDiskBlock::RemoveFromDisk(const bf::path &rootdir, const Key &key) {
   auto filepath = _getFilepath(rootdir, key);
   ASSERT(bf::is_regular_file(filepath), "Block not found on disk");
@@ -99,40 +397,24 @@ void OnDiskBlock::RemoveFromDisk(const bf::path &rootdir, const Key &key) {
 }
 
 void OnDiskBlock::_storeToDisk() const {
-  std::ofstream file(_filepath.c_str(), std::ios::binary | std::ios::trunc);
-  if (!file.good()) {
-    throw std::runtime_error("Could not open file for writing");
-  }
-  file.write(FORMAT_VERSION_HEADER.c_str(), formatVersionHeaderSize());
-  if (!file.good()) {
-    throw std::runtime_error("Error writing block header");
-  }
-  _data.StoreToStream(file);
-  if (!file.good()) {
-    throw std::runtime_error("Error writing block data");
-  }
+  auto pendingWrite = PendingWrite::Open(_filepath, _data, _directIO, false).value();
+  auto request = pendingWrite->request();
+  AsyncFileIO::RunSynchronously(&request);
+  pendingWrite->finish(request);
 }
 
-optional<Data> OnDiskBlock::_loadFromDisk(const bf::path &filepath) {
-  //If it isn't a file, ifstream::good() would return false. We still need this extra check
-  //upfront, because ifstream::good() doesn't crash if we give it the path of a directory
-  //instead the path of a file.
-  if(!bf::is_regular_file(filepath)) {
-    return none;
-  }
-  ifstream file(filepath.c_str(), ios::binary);
-  if (!file.good()) {
-    return none;
+bool OnDiskBlock::_createOnDisk() const {
+  auto pendingWrite = PendingWrite::Open(_filepath, _data, _directIO, true);
+  if (pendingWrite == none) {
+    return false;
   }
-  _checkHeader(&file);
-  Data result = Data::LoadFromStream(file);
-  //TODO With newer compilers, "return result;" would be enough
-  return boost::optional<Data>(std::move(result));
+  auto request = (*pendingWrite)->request();
+  AsyncFileIO::RunSynchronously(&request);
+  (*pendingWrite)->finish(request);
+  return true;
 }
 
-void OnDiskBlock::_checkHeader(istream *str) {
-  Data header(formatVersionHeaderSize());
-  str->read(reinterpret_cast<char*>(header.data()), formatVersionHeaderSize());
+void OnDiskBlock::_checkHeader(const Data &header) {
   if (!_isAcceptedCryfsHeader(header)) {
     if (_isOtherCryfsHeader(header)) {
       throw std::runtime_error("This block is not supported yet. Maybe it was created with a newer version of CryFS?");
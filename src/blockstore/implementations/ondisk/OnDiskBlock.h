@@ -4,11 +4,13 @@
 
 #include <boost/filesystem/path.hpp>
 #include "../../interface/Block.h"
+#include "AsyncFileIO.h"
 #include <cpp-utils/data/Data.h>
-#include <iostream>
 
 #include <cpp-utils/pointer/unique_ref.h>
 #include <mutex>
+#include <vector>
+#include <utility>
 
 namespace blockstore {
 namespace ondisk {
@@ -16,7 +18,8 @@ class OnDiskBlockStore;
 
 class OnDiskBlock final: public Block {
 public:
-  OnDiskBlock(const Key &key, const boost::filesystem::path &filepath, cpputils::Data data);
+  // With directIO, the block file is read and written with O_DIRECT, i.e. bypassing the page cache of the kernel.
+  OnDiskBlock(const Key &key, const boost::filesystem::path &filepath, cpputils::Data data, bool directIO = false);
   ~OnDiskBlock();
 
   static const std::string FORMAT_VERSION_HEADER_PREFIX;
@@ -24,8 +27,17 @@ public:
   static unsigned int formatVersionHeaderSize();
   static uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize);
 
-  static boost::optional<cpputils::unique_ref<OnDiskBlock>> LoadFromDisk(const boost::filesystem::path &rootdir, const Key &key);
-  static boost::optional<cpputils::unique_ref<OnDiskBlock>> CreateOnDisk(const boost::filesystem::path &rootdir, const Key &key, cpputils::Data data);
+  // Block files are written to a temporary file first that is then renamed to the block file, so if CryFS crashes while
+  // writing a block, it doesn't leave a partly written block behind. Temporary files have this suffix.
+  static const std::string TEMPFILE_SUFFIX;
+
+  static boost::optional<cpputils::unique_ref<OnDiskBlock>> LoadFromDisk(const boost::filesystem::path &rootdir, const Key &key, bool directIO = false);
+  static boost::optional<cpputils::unique_ref<OnDiskBlock>> CreateOnDisk(const boost::filesystem::path &rootdir, const Key &key, cpputils::Data data, bool directIO = false);
+  // Loads the blocks with one batch of reads. The result has one entry per key, which is boost::none if the block doesn't exist.
+  static std::vector<boost::optional<cpputils::unique_ref<OnDiskBlock>>> LoadManyFromDisk(const boost::filesystem::path &rootdir, const std::vector<Key> &keys, bool directIO, AsyncFileIO *fileIO);
+  // Writes the blocks with one batch of writes, overwriting blocks that already exist. If a key appears multiple times,
+  // its last entry is stored.
+  static void StoreManyToDisk(const boost::filesystem::path &rootdir, const std::vector<std::pair<Key, cpputils::Data>> &blocks, bool directIO, AsyncFileIO *fileIO);
   static void RemoveFromDisk(const boost::filesystem::path &rootdir, const Key &key);
 
   const void *data() const override;
@@ -40,15 +52,20 @@ private:
 
   static bool _isAcceptedCryfsHeader(const cpputils::Data &data);
   static bool _isOtherCryfsHeader(const cpputils::Data &data);
-  static void _checkHeader(std::istream *str);
+  static void _checkHeader(const cpputils::Data &header);
   static boost::filesystem::path _getFilepath(const boost::filesystem::path &rootdir, const Key &key);
 
   const boost::filesystem::path _filepath;
   cpputils::Data _data;
   bool _dataChanged;
+  const bool _directIO;
+
+  class PendingRead;
+  class PendingWrite;
 
-  static boost::optional<cpputils::Data> _loadFromDisk(const boost::filesystem::path &filepath);
   void _storeToDisk() const;
+  // Returns false if the block already exists
+  bool _createOnDisk() const;
 
   std::mutex _mutex;
 
@@ -14,8 +14,8 @@ namespace bf = boost::filesystem;
 namespace blockstore {
 namespace ondisk {
 
-OnDiskBlockStore::OnDiskBlockStore(const boost::filesystem::path &rootdir)
- : _rootdir(rootdir) {
+OnDiskBlockStore::OnDiskBlockStore(const boost::filesystem::path &rootdir, bool directIO)
+ : _rootdir(rootdir), _directIO(directIO), _fileIO(AsyncFileIO::Create()) {
   if (!bf::exists(rootdir)) {
     throw std::runtime_error("Base directory not found");
   }
@@ -58,7 +58,7 @@ bool OnDiskBlockStore::_isValidBlockKey(const string &key) {
 
 optional<unique_ref<Block>> OnDiskBlockStore::tryCreate(const Key &key, Data data) {
   //TODO Easier implementation? This is only so complicated because of the cast OnDiskBlock -> Block
-  auto result = std::move(OnDiskBlock::CreateOnDisk(_rootdir, key, std::move(data)));
+  auto result = std::move(OnDiskBlock::CreateOnDisk(_rootdir, key, std::move(data), _directIO));
   if (result == boost::none) {
     return boost::none;
   }
@@ -66,12 +66,32 @@ optional<unique_ref<Block>> OnDiskBlockStore::tryCreate(const Key &key, Data dat
 }
 
 optional<unique_ref<Block>> OnDiskBlockStore::load(const Key &key) {
-  return optional<unique_ref<Block>>(OnDiskBlock::LoadFromDisk(_rootdir, key));
+  return optional<unique_ref<Block>>(OnDiskBlock::LoadFromDisk(_rootdir, key, _directIO));
+}
+
+vector<optional<unique_ref<Block>>> OnDiskBlockStore::loadMany(const vector<Key> &keys) {
+  auto blocks = OnDiskBlock::LoadManyFromDisk(_rootdir, keys, _directIO, _fileIO.get());
+  // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+  vector<optional<unique_ref<Block>>> result(blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (blocks[i] != none) {
+      result[i] = unique_ref<Block>(std::move(*blocks[i]));
+    }
+  }
+  return result;
+}
+
+void OnDiskBlockStore::storeMany(vector<std::pair<Key, Data>> blocks) {
+  OnDiskBlock::StoreManyToDisk(_rootdir, blocks, _directIO, _fileIO.get());
 }
 
 void OnDiskBlockStore::remove(unique_ref<Block> block) {
   Key key = block->key();
   cpputils::destruct(std::move(block));
+  remove(key);
+}
+
+void OnDiskBlockStore::remove(const Key &key) {
   OnDiskBlock::RemoveFromDisk(_rootdir, key);
 }
 
@@ -79,12 +99,23 @@ uint64_t OnDiskBlockStore::numBlocks() const {
   uint64_t count = 0;
   for (auto entry = bf::directory_iterator(_rootdir); entry != bf::directory_iterator(); ++entry) {
     if (bf::is_directory(entry->path())) {
-      count += std::distance(bf::directory_iterator(entry->path()), bf::directory_iterator());
+      for (auto block = bf::directory_iterator(entry->path()); block != bf::directory_iterator(); ++block) {
+        // Leftovers from a crash while storing a block aren't blocks
+        if (!_isTempfile(block->path())) {
+          ++count;
+        }
+      }
     }
   }
   return count;
 }
 
+bool OnDiskBlockStore::_isTempfile(const bf::path &path) {
+  const string &filename = path.filename().native();
+  const string &suffix = OnDiskBlock::TEMPFILE_SUFFIX;
+  return filename.size() >= suffix.size() && 0 == filename.compare(filename.size() - suffix.size(), suffix.size(), suffix);
+}
+
 uint64_t OnDiskBlockStore::estimateNumFreeBytes() const {
   struct statvfs stat;
   ::statvfs(_rootdir.c_str(), &stat);
@@ -4,6 +4,7 @@
 
 #include <boost/filesystem.hpp>
 #include "../../interface/helpers/BlockStoreWithRandomKeys.h"
+#include "AsyncFileIO.h"
 
 #include <cpp-utils/macros.h>
 
@@ -12,18 +13,29 @@ namespace ondisk {
 
 class OnDiskBlockStore final: public BlockStoreWithRandomKeys {
 public:
-  explicit OnDiskBlockStore(const boost::filesystem::path &rootdir);
+  // With directIO, block files are read and written with O_DIRECT, bypassing the page cache of the kernel.
+  // This is useful when there is a cache on top of this store anyway, so blocks aren't cached twice.
+  explicit OnDiskBlockStore(const boost::filesystem::path &rootdir, bool directIO = false);
 
   boost::optional<cpputils::unique_ref<Block>> tryCreate(const Key &key, cpputils::Data data) override;
   boost::optional<cpputils::unique_ref<Block>> load(const Key &key) override;
-  //TODO Can we make this faster by allowing to delete blocks by only having theiy Key? So we wouldn't have to load it first?
+  // Loads the blocks with one batch of reads that are in flight at the same time.
+  // The result has one entry per key, which is boost::none if the block doesn't exist.
+  std::vector<boost::optional<cpputils::unique_ref<Block>>> loadMany(const std::vector<Key> &keys) override;
+  // Writes the blocks with one batch of concurrent writes. Blocks that don't exist are created, others are overwritten.
+  void storeMany(std::vector<std::pair<Key, cpputils::Data>> blocks) override;
   void remove(cpputils::unique_ref<Block> block) override;
+  void remove(const Key &key) override;
   uint64_t numBlocks() const override;
   uint64_t estimateNumFreeBytes() const override;
   uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize) const override;
 
 private:
   const boost::filesystem::path _rootdir;
+  const bool _directIO;
+  cpputils::unique_ref<AsyncFileIO> _fileIO;
+
+  static bool _isTempfile(const boost::filesystem::path &path);
 #ifndef CRYFS_NO_COMPATIBILITY
   void _migrateBlockStore();
   bool _isValidBlockKey(const std::string &key);
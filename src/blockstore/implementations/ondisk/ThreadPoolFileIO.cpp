@@ -0,0 +1,41 @@
+#include "ThreadPoolFileIO.h"
+#include <future>
+
+using cpputils::WorkerPool;
+using std::vector;
+
+namespace blockstore {
+namespace ondisk {
+
+constexpr uint32_t ThreadPoolFileIO::NUM_THREADS;
+
+ThreadPoolFileIO::ThreadPoolFileIO(): _workersStarted(), _workerPool(nullptr) {
+}
+
+WorkerPool *ThreadPoolFileIO::_workers() {
+  std::call_once(_workersStarted, [this] {
+    _workerPool = std::make_unique<WorkerPool>(NUM_THREADS, NUM_THREADS);
+  });
+  return _workerPool.get();
+}
+
+void ThreadPoolFileIO::run(vector<Request> *requests) {
+  if (requests->size() == 1) {
+    // Handing a single request to another thread would only add latency
+    RunSynchronously(&(*requests)[0]);
+    return;
+  }
+  vector<std::future<void>> done;
+  done.reserve(requests->size());
+  for (Request &request : *requests) {
+    done.push_back(_workers()->schedule([&request] {
+      RunSynchronously(&request);
+    }));
+  }
+  for (auto &future : done) {
+    future.get();
+  }
+}
+
+}
+}
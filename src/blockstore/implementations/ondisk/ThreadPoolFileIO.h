@@ -0,0 +1,39 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_IMPLEMENTATIONS_ONDISK_THREADPOOLFILEIO_H_
+#define MESSMER_BLOCKSTORE_IMPLEMENTATIONS_ONDISK_THREADPOOLFILEIO_H_
+
+#include "AsyncFileIO.h"
+#include <cpp-utils/thread/WorkerPool.h>
+#include <cpp-utils/macros.h>
+#include <memory>
+#include <mutex>
+
+namespace blockstore {
+namespace ondisk {
+
+// Runs the requests of a batch with blocking system calls on a pool of threads.
+// This is the fallback for systems without io_uring.
+class ThreadPoolFileIO final: public AsyncFileIO {
+public:
+  // The threads only wait for the disk, so there can be more of them than cores.
+  // This is the number of requests that can be in flight at the same time.
+  static constexpr uint32_t NUM_THREADS = 32;
+
+  ThreadPoolFileIO();
+
+  void run(std::vector<Request> *requests) override;
+
+private:
+  cpputils::WorkerPool *_workers();
+
+  // The threads are only started when the first batch is run, because most stores never run one.
+  std::once_flag _workersStarted;
+  std::unique_ptr<cpputils::WorkerPool> _workerPool;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadPoolFileIO);
+};
+
+}
+}
+
+#endif
@@ -14,6 +14,9 @@ using cpputils::unique_ref;
 using cpputils::make_unique_ref;
 using boost::optional;
 using boost::none;
+using std::vector;
+using std::pair;
+using cpputils::Data;
 
 namespace blockstore {
 namespace parallelaccess {
@@ -52,6 +55,84 @@ void ParallelAccessBlockStore::remove(unique_ref<Block> block) {
   return _parallelAccessStore.remove(key, std::move(*block_ref));
 }
 
+void ParallelAccessBlockStore::remove(const Key &key) {
+  _parallelAccessStore.removeManyByKey(vector<Key>{key});
+}
+
+vector<optional<unique_ref<Block>>> ParallelAccessBlockStore::loadMany(const vector<Key> &keys) {
+  auto blocks = _parallelAccessStore.loadMany(keys);
+  // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+  vector<optional<unique_ref<Block>>> result(blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (blocks[i] != none) {
+      result[i] = unique_ref<Block>(std::move(*blocks[i]));
+    }
+  }
+  return result;
+}
+
+void ParallelAccessBlockStore::storeMany(vector<pair<Key, Data>> blocks) {
+  // Blocks that are currently opened have to be overwritten through the open instance, otherwise it would write its
+  // old data back when it is closed. The other blocks are passed to the base store in one batch. Loads of them wait until
+  // they're stored, so they can't be opened with their old data in the meantime.
+  vector<Key> keys;
+  keys.reserve(blocks.size());
+  for (const auto &block : blocks) {
+    keys.push_back(block.first);
+  }
+  auto opened = _parallelAccessStore.loadManyIfOpened(keys, [this, &blocks] (const vector<size_t> &notOpened) {
+    vector<pair<Key, Data>> notOpenedBlocks;
+    notOpenedBlocks.reserve(notOpened.size());
+    for (size_t index : notOpened) {
+      notOpenedBlocks.push_back(std::move(blocks[index]));
+    }
+    _baseBlockStore->storeMany(std::move(notOpenedBlocks));
+  });
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (opened[i] != none) {
+      // Resizing reallocates the block data, so it is skipped if it isn't needed
+      if ((*opened[i])->size() != blocks[i].second.size()) {
+        (*opened[i])->resize(blocks[i].second.size());
+      }
+      (*opened[i])->write(blocks[i].second.data(), 0, blocks[i].second.size());
+    }
+  }
+}
+
+void ParallelAccessBlockStore::removeMany(vector<unique_ref<Block>> blocks) {
+  vector<pair<Key, unique_ref<BlockRef>>> blockRefs;
+  blockRefs.reserve(blocks.size());
+  for (auto &block : blocks) {
+    Key key = block->key();
+    auto blockRef = dynamic_pointer_move<BlockRef>(block);
+    ASSERT(blockRef != none, "Block is not a BlockRef");
+    blockRefs.emplace_back(key, std::move(*blockRef));
+  }
+  _parallelAccessStore.removeMany(std::move(blockRefs));
+}
+
+void ParallelAccessBlockStore::removeMany(const vector<Key> &keys) {
+  _parallelAccessStore.removeManyByKey(keys);
+}
+
+void ParallelAccessBlockStore::prefetchMany(const vector<Key> &keys) {
+  // Blocks that are loaded at the moment are in memory already. Skipping them is only an optimization,
+  // the base store has to handle blocks that are loaded while they are prefetched anyway.
+  vector<Key> keysToPrefetch;
+  for (const Key &key : keys) {
+    if (!_parallelAccessStore.isOpened(key)) {
+      keysToPrefetch.push_back(key);
+    }
+  }
+  if (!keysToPrefetch.empty()) {
+    _baseBlockStore->prefetchMany(keysToPrefetch);
+  }
+}
+
+void ParallelAccessBlockStore::waitForPendingWrites() {
+  _baseBlockStore->waitForPendingWrites();
+}
+
 uint64_t ParallelAccessBlockStore::numBlocks() const {
   return _baseBlockStore->numBlocks();
 }
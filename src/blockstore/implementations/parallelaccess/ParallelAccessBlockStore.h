@@ -19,6 +19,13 @@ public:
   boost::optional<cpputils::unique_ref<Block>> tryCreate(const Key &key, cpputils::Data data) override;
   boost::optional<cpputils::unique_ref<Block>> load(const Key &key) override;
   void remove(cpputils::unique_ref<Block> block) override;
+  void remove(const Key &key) override;
+  std::vector<boost::optional<cpputils::unique_ref<Block>>> loadMany(const std::vector<Key> &keys) override;
+  void storeMany(std::vector<std::pair<Key, cpputils::Data>> blocks) override;
+  void removeMany(std::vector<cpputils::unique_ref<Block>> blocks) override;
+  void removeMany(const std::vector<Key> &keys) override;
+  void prefetchMany(const std::vector<Key> &keys) override;
+  void waitForPendingWrites() override;
   uint64_t numBlocks() const override;
   uint64_t estimateNumFreeBytes() const override;
   uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize) const override;
@@ -23,6 +23,18 @@ public:
 	return _baseBlockStore->remove(std::move(block));
   }
 
+  std::vector<boost::optional<cpputils::unique_ref<Block>>> loadManyFromBaseStore(const std::vector<Key> &keys) override {
+    return _baseBlockStore->loadMany(keys);
+  }
+
+  void removeManyFromBaseStore(std::vector<cpputils::unique_ref<Block>> blocks) override {
+    return _baseBlockStore->removeMany(std::move(blocks));
+  }
+
+  void removeManyFromBaseStoreByKey(const std::vector<Key> &keys) override {
+    return _baseBlockStore->removeMany(keys);
+  }
+
 private:
   BlockStore *_baseBlockStore;
 
@@ -4,9 +4,12 @@
 
 #include "Block.h"
 #include <string>
+#include <vector>
+#include <utility>
 #include <boost/optional.hpp>
 #include <cpp-utils/pointer/unique_ref.h>
 #include <cpp-utils/data/Data.h>
+#include <cpp-utils/assert/assert.h>
 
 namespace blockstore {
 
@@ -21,6 +24,56 @@ public:
   // Return nullptr if block with this key doesn't exists
   virtual boost::optional<cpputils::unique_ref<Block>> load(const Key &key) = 0;
   virtual void remove(cpputils::unique_ref<Block> block) = 0;
+  // Removes the block without loading it. The block must exist and must not be loaded at the moment.
+  // Modifications of the block that weren't written back yet are discarded instead of being written back first.
+  virtual void remove(const Key &key) = 0;
+
+  // The *Many() functions work on several blocks at once, so block stores can process them concurrently
+  // (e.g. decrypt them in parallel or have their disk reads in flight at the same time).
+  // The default implementations process the blocks one after the other. A key must not appear twice in one call.
+
+  // Returns one entry per key, in the order of the keys. An entry is boost::none if the block doesn't exist.
+  virtual std::vector<boost::optional<cpputils::unique_ref<Block>>> loadMany(const std::vector<Key> &keys) {
+    // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+    std::vector<boost::optional<cpputils::unique_ref<Block>>> result(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      result[i] = load(keys[i]);
+    }
+    return result;
+  }
+  // Overwrites the blocks with the given data. Blocks that don't exist yet are created.
+  virtual void storeMany(std::vector<std::pair<Key, cpputils::Data>> blocks) {
+    for (auto &block : blocks) {
+      auto existing = load(block.first);
+      if (existing == boost::none) {
+        auto created = tryCreate(block.first, std::move(block.second));
+        ASSERT(created != boost::none, "Block was created by someone else while storing it");
+      } else {
+        (*existing)->resize(block.second.size());
+        (*existing)->write(block.second.data(), 0, block.second.size());
+      }
+    }
+  }
+  virtual void removeMany(std::vector<cpputils::unique_ref<Block>> blocks) {
+    for (auto &block : blocks) {
+      remove(std::move(block));
+    }
+  }
+  virtual void removeMany(const std::vector<Key> &keys) {
+    for (const Key &key : keys) {
+      remove(key);
+    }
+  }
+  // Loads the blocks into the cache of the block store, so loading them afterwards doesn't have to wait for them.
+  // This is only a hint. Block stores without a cache ignore it and blocks that don't exist are skipped.
+  virtual void prefetchMany(const std::vector<Key> &/*keys*/) {
+  }
+
+  // Block stores that write blocks in the background wait here until these writes reached their base store
+  // and throw if one of them failed. Stores wrapping another store forward this to it.
+  virtual void waitForPendingWrites() {
+  }
+
   virtual uint64_t numBlocks() const = 0;
   //TODO Test estimateNumFreeBytes in all block stores
   virtual uint64_t estimateNumFreeBytes() const = 0;
@@ -8,6 +8,7 @@
 #include <boost/optional.hpp>
 #include <cryptopp/modes.h>
 #include "Cipher.h"
+#include "ThreadLocalCipherMode.h"
 
 namespace cpputils {
 
@@ -28,20 +29,47 @@ public:
     return ciphertextBlockSize - IV_SIZE;
   }
 
+  // Writes ciphertextSize(plaintextSize) bytes to ciphertext
+  static void encrypt(const byte *plaintext, unsigned int plaintextSize, byte *ciphertext, const EncryptionKey &encKey);
+  // Writes plaintextSize(ciphertextSize) bytes to plaintext. Returns false if the ciphertext is too small.
+  static bool decrypt(const byte *ciphertext, unsigned int ciphertextSize, byte *plaintext, const EncryptionKey &encKey);
+
   static Data encrypt(const byte *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey);
   static boost::optional<Data> decrypt(const byte *ciphertext, unsigned int ciphertextSize, const EncryptionKey &encKey);
 
 private:
   static constexpr unsigned int IV_SIZE = BlockCipher::BLOCKSIZE;
+
+  using Encryption = typename CryptoPP::CFB_Mode<BlockCipher>::Encryption;
+  using Decryption = typename CryptoPP::CFB_Mode<BlockCipher>::Decryption;
 };
 
 template<typename BlockCipher, unsigned int KeySize>
-Data CFB_Cipher<BlockCipher, KeySize>::encrypt(const byte *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey) {
+void CFB_Cipher<BlockCipher, KeySize>::encrypt(const byte *plaintext, unsigned int plaintextSize, byte *ciphertext, const EncryptionKey &encKey) {
   FixedSizeData<IV_SIZE> iv = Random::PseudoRandom().getFixedSize<IV_SIZE>();
-  auto encryption = typename CryptoPP::CFB_Mode<BlockCipher>::Encryption(encKey.data(), encKey.BINARY_LENGTH, iv.data());
+  Encryption &encryption = threadLocalCipherMode<Encryption>(encKey, IV_SIZE);
+  encryption.Resynchronize(iv.data(), IV_SIZE);
+  std::memcpy(ciphertext, iv.data(), IV_SIZE);
+  encryption.ProcessData(ciphertext + IV_SIZE, plaintext, plaintextSize);
+}
+
+template<typename BlockCipher, unsigned int KeySize>
+bool CFB_Cipher<BlockCipher, KeySize>::decrypt(const byte *ciphertext, unsigned int ciphertextSize, byte *plaintext, const EncryptionKey &encKey) {
+  if (ciphertextSize < IV_SIZE) {
+    return false;
+  }
+  const byte *ciphertextIV = ciphertext;
+  const byte *ciphertextData = ciphertext + IV_SIZE;
+  Decryption &decryption = threadLocalCipherMode<Decryption>(encKey, IV_SIZE);
+  decryption.Resynchronize(ciphertextIV, IV_SIZE);
+  decryption.ProcessData(plaintext, ciphertextData, plaintextSize(ciphertextSize));
+  return true;
+}
+
+template<typename BlockCipher, unsigned int KeySize>
+Data CFB_Cipher<BlockCipher, KeySize>::encrypt(const byte *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey) {
   Data ciphertext(ciphertextSize(plaintextSize));
-  std::memcpy(ciphertext.data(), iv.data(), IV_SIZE);
-  encryption.ProcessData((byte*)ciphertext.data() + IV_SIZE, plaintext, plaintextSize);
+  encrypt(plaintext, plaintextSize, (byte*)ciphertext.data(), encKey);
   return ciphertext;
 }
 
@@ -50,12 +78,8 @@ boost::optional<Data> CFB_Cipher<BlockCipher, KeySize>::decrypt(const byte *ciph
   if (ciphertextSize < IV_SIZE) {
     return boost::none;
   }
-
-  const byte *ciphertextIV = ciphertext;
-  const byte *ciphertextData = ciphertext + IV_SIZE;
-  auto decryption = typename CryptoPP::CFB_Mode<BlockCipher>::Decryption((byte*)encKey.data(), encKey.BINARY_LENGTH, ciphertextIV);
   Data plaintext(plaintextSize(ciphertextSize));
-  decryption.ProcessData((byte*)plaintext.data(), ciphertextData, plaintext.size());
+  decrypt(ciphertext, ciphertextSize, (byte*)plaintext.data(), encKey);
   return std::move(plaintext);
 }
 
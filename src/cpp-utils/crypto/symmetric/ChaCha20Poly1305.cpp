@@ -0,0 +1,295 @@
+#include "ChaCha20Poly1305.h"
+#include <algorithm>
+#include <cstring>
+
+namespace cpputils {
+
+constexpr unsigned int ChaCha20Poly1305::KEY_SIZE;
+constexpr unsigned int ChaCha20Poly1305::NONCE_SIZE;
+constexpr unsigned int ChaCha20Poly1305::XNONCE_SIZE;
+constexpr unsigned int ChaCha20Poly1305::TAG_SIZE;
+
+namespace {
+
+// Four 32 bit lanes. GCC and Clang map operations on it to the vector instructions of the target CPU.
+typedef uint32_t Vector __attribute__((vector_size(16)));
+
+// ChaCha20 and Poly1305 read and write words in little endian order, which is how most CPUs store them anyway
+inline uint32_t load32(const uint8_t *source) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint32_t value;
+    std::memcpy(&value, source, sizeof(value));
+    return value;
+#else
+    return static_cast<uint32_t>(source[0]) | (static_cast<uint32_t>(source[1]) << 8)
+           | (static_cast<uint32_t>(source[2]) << 16) | (static_cast<uint32_t>(source[3]) << 24);
+#endif
+}
+
+inline void store32(uint8_t *target, uint32_t value) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::memcpy(target, &value, sizeof(value));
+#else
+    target[0] = static_cast<uint8_t>(value);
+    target[1] = static_cast<uint8_t>(value >> 8);
+    target[2] = static_cast<uint8_t>(value >> 16);
+    target[3] = static_cast<uint8_t>(value >> 24);
+#endif
+}
+
+inline void store64(uint8_t *target, uint64_t value) {
+    store32(target, static_cast<uint32_t>(value));
+    store32(target + 4, static_cast<uint32_t>(value >> 32));
+}
+
+// Works for single words and for vectors of words
+template<class Word>
+inline Word rotateLeft(Word value, int count) {
+    return (value << count) | (value >> (32 - count));
+}
+
+template<class Word>
+inline void quarterRound(Word &a, Word &b, Word &c, Word &d) {
+    a += b; d ^= a; d = rotateLeft(d, 16);
+    c += d; b ^= c; b = rotateLeft(b, 12);
+    a += b; d ^= a; d = rotateLeft(d, 8);
+    c += d; b ^= c; b = rotateLeft(b, 7);
+}
+
+template<class Word>
+inline void chacha20Rounds(Word *x) {
+    for (unsigned int i = 0; i < 10; ++i) {
+        quarterRound(x[0], x[4], x[8], x[12]);
+        quarterRound(x[1], x[5], x[9], x[13]);
+        quarterRound(x[2], x[6], x[10], x[14]);
+        quarterRound(x[3], x[7], x[11], x[15]);
+        quarterRound(x[0], x[5], x[10], x[15]);
+        quarterRound(x[1], x[6], x[11], x[12]);
+        quarterRound(x[2], x[7], x[8], x[13]);
+        quarterRound(x[3], x[4], x[9], x[14]);
+    }
+}
+
+// The input of the ChaCha20 block function. The last four words are the block counter and the nonce.
+void initState(uint32_t *state, const uint8_t *key, const uint8_t *counterAndNonce) {
+    state[0] = 0x61707865;
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+    for (unsigned int i = 0; i < 8; ++i) {
+        state[4 + i] = load32(key + 4 * i);
+    }
+    for (unsigned int i = 0; i < 4; ++i) {
+        state[12 + i] = load32(counterAndNonce + 4 * i);
+    }
+}
+
+// XORs the ChaCha20 keystream beginning with the given block onto input and writes the result to output
+void chacha20Xor(const uint8_t *key, const uint8_t *nonce, uint32_t firstBlock, const uint8_t *input, uint8_t *output, size_t size) {
+    uint8_t counterAndNonce[16];
+    store32(counterAndNonce, firstBlock);
+    std::memcpy(counterAndNonce + 4, nonce, ChaCha20Poly1305::NONCE_SIZE);
+    uint32_t state[16];
+    initState(state, key, counterAndNonce);
+
+    // Four blocks at once, lane i of each vector computes the word of block i
+    for (; size >= 4 * 64; input += 4 * 64, output += 4 * 64, size -= 4 * 64) {
+        Vector initial[16];
+        for (unsigned int i = 0; i < 16; ++i) {
+            initial[i] = Vector{state[i], state[i], state[i], state[i]};
+        }
+        initial[12] += Vector{0, 1, 2, 3};
+        Vector x[16];
+        std::copy(initial, initial + 16, x);
+        chacha20Rounds(x);
+        uint32_t words[16][4];
+        for (unsigned int i = 0; i < 16; ++i) {
+            x[i] += initial[i];
+            std::memcpy(words[i], &x[i], sizeof(words[i]));
+        }
+        for (unsigned int block = 0; block < 4; ++block) {
+            for (unsigned int i = 0; i < 16; ++i) {
+                size_t offset = 64 * block + 4 * i;
+                store32(output + offset, load32(input + offset) ^ words[i][block]);
+            }
+        }
+        state[12] += 4;
+    }
+
+    for (; size > 0; input += 64, output += 64, size -= std::min(size, static_cast<size_t>(64))) {
+        uint32_t x[16];
+        std::copy(state, state + 16, x);
+        chacha20Rounds(x);
+        uint8_t keystream[64];
+        for (unsigned int i = 0; i < 16; ++i) {
+            store32(keystream + 4 * i, x[i] + state[i]);
+        }
+        size_t blockSize = std::min(size, static_cast<size_t>(64));
+        for (size_t i = 0; i < blockSize; ++i) {
+            output[i] = input[i] ^ keystream[i];
+        }
+        state[12] += 1;
+    }
+}
+
+// Poly1305 with 26 bit limbs, after poly1305-donna by Andrew Moon
+class Poly1305 final {
+public:
+    explicit Poly1305(const uint8_t *key)
+        : _r{load32(key) & 0x3ffffff, (load32(key + 3) >> 2) & 0x3ffff03, (load32(key + 6) >> 4) & 0x3ffc0ff,
+             (load32(key + 9) >> 6) & 0x3f03fff, (load32(key + 12) >> 8) & 0x00fffff},
+          _h{0, 0, 0, 0, 0},
+          _pad{load32(key + 16), load32(key + 20), load32(key + 24), load32(key + 28)} {
+    }
+
+    // Adds the data zero padded to full 16 byte blocks, like the AEAD construction does it
+    void updatePadded(const uint8_t *data, size_t size) {
+        size_t fullBlocksSize = size - size % 16;
+        _blocks(data, fullBlocksSize);
+        if (fullBlocksSize < size) {
+            uint8_t block[16] = {0};
+            std::memcpy(block, data + fullBlocksSize, size - fullBlocksSize);
+            _blocks(block, 16);
+        }
+    }
+
+    void finish(uint8_t *tag) {
+        uint32_t h0 = _h[0], h1 = _h[1], h2 = _h[2], h3 = _h[3], h4 = _h[4];
+        uint32_t c = h1 >> 26; h1 &= 0x3ffffff;
+        h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+        h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+        h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+        h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+        h1 += c;
+
+        // Compute h - p and take it instead of h if it doesn't underflow, without branching on the secret value
+        uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+        uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+        uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+        uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+        uint32_t g4 = h4 + c - (UINT32_C(1) << 26);
+        uint32_t mask = (g4 >> 31) - 1;
+        h0 = (h0 & ~mask) | (g0 & mask);
+        h1 = (h1 & ~mask) | (g1 & mask);
+        h2 = (h2 & ~mask) | (g2 & mask);
+        h3 = (h3 & ~mask) | (g3 & mask);
+        h4 = (h4 & ~mask) | (g4 & mask);
+
+        uint64_t f = static_cast<uint64_t>(h0 | (h1 << 26)) + _pad[0];
+        store32(tag, static_cast<uint32_t>(f));
+        f = static_cast<uint64_t>((h1 >> 6) | (h2 << 20)) + _pad[1] + (f >> 32);
+        store32(tag + 4, static_cast<uint32_t>(f));
+        f = static_cast<uint64_t>((h2 >> 12) | (h3 << 14)) + _pad[2] + (f >> 32);
+        store32(tag + 8, static_cast<uint32_t>(f));
+        f = static_cast<uint64_t>((h3 >> 18) | (h4 << 8)) + _pad[3] + (f >> 32);
+        store32(tag + 12, static_cast<uint32_t>(f));
+    }
+
+private:
+    void _blocks(const uint8_t *data, size_t size) {
+        const uint32_t r0 = _r[0], r1 = _r[1], r2 = _r[2], r3 = _r[3], r4 = _r[4];
+        const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+        uint32_t h0 = _h[0], h1 = _h[1], h2 = _h[2], h3 = _h[3], h4 = _h[4];
+        for (; size >= 16; data += 16, size -= 16) {
+            h0 += load32(data) & 0x3ffffff;
+            h1 += (load32(data + 3) >> 2) & 0x3ffffff;
+            h2 += (load32(data + 6) >> 4) & 0x3ffffff;
+            h3 += (load32(data + 9) >> 6) & 0x3ffffff;
+            h4 += (load32(data + 12) >> 8) | (UINT32_C(1) << 24);
+
+            uint64_t d0 = static_cast<uint64_t>(h0) * r0 + static_cast<uint64_t>(h1) * s4 + static_cast<uint64_t>(h2) * s3 + static_cast<uint64_t>(h3) * s2 + static_cast<uint64_t>(h4) * s1;
+            uint64_t d1 = static_cast<uint64_t>(h0) * r1 + static_cast<uint64_t>(h1) * r0 + static_cast<uint64_t>(h2) * s4 + static_cast<uint64_t>(h3) * s3 + static_cast<uint64_t>(h4) * s2;
+            uint64_t d2 = static_cast<uint64_t>(h0) * r2 + static_cast<uint64_t>(h1) * r1 + static_cast<uint64_t>(h2) * r0 + static_cast<uint64_t>(h3) * s4 + static_cast<uint64_t>(h4) * s3;
+            uint64_t d3 = static_cast<uint64_t>(h0) * r3 + static_cast<uint64_t>(h1) * r2 + static_cast<uint64_t>(h2) * r1 + static_cast<uint64_t>(h3) * r0 + static_cast<uint64_t>(h4) * s4;
+            uint64_t d4 = static_cast<uint64_t>(h0) * r4 + static_cast<uint64_t>(h1) * r3 + static_cast<uint64_t>(h2) * r2 + static_cast<uint64_t>(h3) * r1 + static_cast<uint64_t>(h4) * r0;
+
+            uint32_t c = static_cast<uint32_t>(d0 >> 26); h0 = static_cast<uint32_t>(d0) & 0x3ffffff;
+            d1 += c; c = static_cast<uint32_t>(d1 >> 26); h1 = static_cast<uint32_t>(d1) & 0x3ffffff;
+            d2 += c; c = static_cast<uint32_t>(d2 >> 26); h2 = static_cast<uint32_t>(d2) & 0x3ffffff;
+            d3 += c; c = static_cast<uint32_t>(d3 >> 26); h3 = static_cast<uint32_t>(d3) & 0x3ffffff;
+            d4 += c; c = static_cast<uint32_t>(d4 >> 26); h4 = static_cast<uint32_t>(d4) & 0x3ffffff;
+            h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+            h1 += c;
+        }
+        _h[0] = h0; _h[1] = h1; _h[2] = h2; _h[3] = h3; _h[4] = h4;
+    }
+
+    uint32_t _r[5];
+    uint32_t _h[5];
+    uint32_t _pad[4];
+};
+
+void computeTag(const uint8_t *key, const uint8_t *nonce, const uint8_t *additionalData, size_t additionalDataSize,
+                const uint8_t *ciphertext, size_t size, uint8_t *tag) {
+    // The Poly1305 key is the beginning of the keystream block 0, the message is encrypted from block 1 on
+    uint8_t polyKey[32] = {0};
+    chacha20Xor(key, nonce, 0, polyKey, polyKey, sizeof(polyKey));
+    Poly1305 poly1305(polyKey);
+    poly1305.updatePadded(additionalData, additionalDataSize);
+    poly1305.updatePadded(ciphertext, size);
+    uint8_t lengths[16];
+    store64(lengths, additionalDataSize);
+    store64(lengths + 8, size);
+    poly1305.updatePadded(lengths, sizeof(lengths));
+    poly1305.finish(tag);
+}
+
+// The ChaCha20-Poly1305 nonce for the subkey of an XChaCha20-Poly1305 nonce
+void subnonce(const uint8_t *xnonce, uint8_t *nonce) {
+    std::memset(nonce, 0, 4);
+    std::memcpy(nonce + 4, xnonce + 16, 8);
+}
+
+}
+
+void ChaCha20Poly1305::encrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *additionalData, size_t additionalDataSize,
+                               const uint8_t *plaintext, size_t size, uint8_t *ciphertext, uint8_t *tag) {
+    chacha20Xor(key, nonce, 1, plaintext, ciphertext, size);
+    computeTag(key, nonce, additionalData, additionalDataSize, ciphertext, size, tag);
+}
+
+bool ChaCha20Poly1305::decrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *additionalData, size_t additionalDataSize,
+                               const uint8_t *ciphertext, size_t size, const uint8_t *tag, uint8_t *plaintext) {
+    uint8_t expectedTag[TAG_SIZE];
+    computeTag(key, nonce, additionalData, additionalDataSize, ciphertext, size, expectedTag);
+    // Compare in constant time to not leak how many bytes of the tag were right
+    uint8_t difference = 0;
+    for (unsigned int i = 0; i < TAG_SIZE; ++i) {
+        difference |= expectedTag[i] ^ tag[i];
+    }
+    if (difference != 0) {
+        return false;
+    }
+    chacha20Xor(key, nonce, 1, ciphertext, plaintext, size);
+    return true;
+}
+
+void ChaCha20Poly1305::xencrypt(const uint8_t *key, const uint8_t *xnonce, const uint8_t *additionalData, size_t additionalDataSize,
+                                const uint8_t *plaintext, size_t size, uint8_t *ciphertext, uint8_t *tag) {
+    uint8_t subkey[KEY_SIZE];
+    uint8_t nonce[NONCE_SIZE];
+    hchacha20(key, xnonce, subkey);
+    subnonce(xnonce, nonce);
+    encrypt(subkey, nonce, additionalData, additionalDataSize, plaintext, size, ciphertext, tag);
+}
+
+bool ChaCha20Poly1305::xdecrypt(const uint8_t *key, const uint8_t *xnonce, const uint8_t *additionalData, size_t additionalDataSize,
+                                const uint8_t *ciphertext, size_t size, const uint8_t *tag, uint8_t *plaintext) {
+    uint8_t subkey[KEY_SIZE];
+    uint8_t nonce[NONCE_SIZE];
+    hchacha20(key, xnonce, subkey);
+    subnonce(xnonce, nonce);
+    return decrypt(subkey, nonce, additionalData, additionalDataSize, ciphertext, size, tag, plaintext);
+}
+
+void ChaCha20Poly1305::hchacha20(const uint8_t *key, const uint8_t *nonce, uint8_t *subkey) {
+    uint32_t x[16];
+    initState(x, key, nonce);
+    chacha20Rounds(x);
+    for (unsigned int i = 0; i < 4; ++i) {
+        store32(subkey + 4 * i, x[i]);
+        store32(subkey + 16 + 4 * i, x[12 + i]);
+    }
+}
+
+}
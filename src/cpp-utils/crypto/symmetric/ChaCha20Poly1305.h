@@ -0,0 +1,40 @@
+#pragma once
+#ifndef MESSMER_CPPUTILS_CRYPTO_SYMMETRIC_CHACHA20POLY1305_H_
+#define MESSMER_CPPUTILS_CRYPTO_SYMMETRIC_CHACHA20POLY1305_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cpputils {
+
+// The ChaCha20-Poly1305 AEAD construction of RFC 8439 and its XChaCha20-Poly1305 variant with 24 byte nonces.
+// Other than AES, ChaCha20 is fast without special CPU instructions. This implementation computes four
+// ChaCha20 blocks at once in the vector registers of the CPU (SSE2 on x86, NEON on ARM).
+class ChaCha20Poly1305 final {
+public:
+    static constexpr unsigned int KEY_SIZE = 32;
+    static constexpr unsigned int NONCE_SIZE = 12;
+    static constexpr unsigned int XNONCE_SIZE = 24;
+    static constexpr unsigned int TAG_SIZE = 16;
+
+    // Encrypts size bytes from plaintext to ciphertext and writes the tag authenticating them and the additional data.
+    static void encrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *additionalData, size_t additionalDataSize,
+                        const uint8_t *plaintext, size_t size, uint8_t *ciphertext, uint8_t *tag);
+    // Returns false if the tag doesn't match, the content of plaintext is undefined then.
+    static bool decrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *additionalData, size_t additionalDataSize,
+                        const uint8_t *ciphertext, size_t size, const uint8_t *tag, uint8_t *plaintext);
+
+    // XChaCha20-Poly1305 derives a subkey from the first 16 bytes of the nonce with HChaCha20 and uses the
+    // remaining 8 bytes as ChaCha20-Poly1305 nonce. Its nonces are long enough to be chosen randomly.
+    static void xencrypt(const uint8_t *key, const uint8_t *xnonce, const uint8_t *additionalData, size_t additionalDataSize,
+                         const uint8_t *plaintext, size_t size, uint8_t *ciphertext, uint8_t *tag);
+    static bool xdecrypt(const uint8_t *key, const uint8_t *xnonce, const uint8_t *additionalData, size_t additionalDataSize,
+                         const uint8_t *ciphertext, size_t size, const uint8_t *tag, uint8_t *plaintext);
+
+    // Writes the 32 byte subkey for key and the first 16 bytes of an XChaCha20 nonce
+    static void hchacha20(const uint8_t *key, const uint8_t *nonce, uint8_t *subkey);
+};
+
+}
+
+#endif
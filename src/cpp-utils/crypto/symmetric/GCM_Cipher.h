@@ -6,7 +6,11 @@
 #include "../../data/Data.h"
 #include "../../random/Random.h"
 #include <cryptopp/gcm.h>
+#include <cryptopp/aes.h>
+#include <type_traits>
 #include "Cipher.h"
+#include "ThreadLocalCipherMode.h"
+#include "HardwareAesGcm.h"
 
 namespace cpputils {
 
@@ -27,56 +31,81 @@ public:
         return ciphertextBlockSize - IV_SIZE - TAG_SIZE;
     }
 
+    // Writes ciphertextSize(plaintextSize) bytes to ciphertext
+    static void encrypt(const byte *plaintext, unsigned int plaintextSize, byte *ciphertext, const EncryptionKey &encKey);
+    // Writes plaintextSize(ciphertextSize) bytes to plaintext. Returns false if the ciphertext was modified,
+    // the content of plaintext is undefined then.
+    static bool decrypt(const byte *ciphertext, unsigned int ciphertextSize, byte *plaintext, const EncryptionKey &encKey);
+
     static Data encrypt(const byte *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey);
     static boost::optional<Data> decrypt(const byte *ciphertext, unsigned int ciphertextSize, const EncryptionKey &encKey);
 
 private:
     static constexpr unsigned int IV_SIZE = BlockCipher::BLOCKSIZE;
     static constexpr unsigned int TAG_SIZE = 16;
+
+    using Encryption = typename CryptoPP::GCM<BlockCipher, CryptoPP::GCM_64K_Tables>::Encryption;
+    using Decryption = typename CryptoPP::GCM<BlockCipher, CryptoPP::GCM_64K_Tables>::Decryption;
+
+    // AES is computed with the AES instructions of the CPU if it has them. The ciphertexts are the same.
+    static bool _useHardwareAes() {
+        return std::is_same<BlockCipher, CryptoPP::AES>::value && HardwareAesGcm::isSupported();
+    }
 };
 
 template<typename BlockCipher, unsigned int KeySize>
-Data GCM_Cipher<BlockCipher, KeySize>::encrypt(const byte *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey) {
+void GCM_Cipher<BlockCipher, KeySize>::encrypt(const byte *plaintext, unsigned int plaintextSize, byte *ciphertext, const EncryptionKey &encKey) {
     FixedSizeData<IV_SIZE> iv = Random::PseudoRandom().getFixedSize<IV_SIZE>();
-    typename CryptoPP::GCM<BlockCipher, CryptoPP::GCM_64K_Tables>::Encryption encryption;
-    encryption.SetKeyWithIV(encKey.data(), encKey.BINARY_LENGTH, iv.data(), IV_SIZE);
-    Data ciphertext(ciphertextSize(plaintextSize));
+    std::memcpy(ciphertext, iv.data(), IV_SIZE);
+    // The tag follows the encrypted data, like the AuthenticatedEncryptionFilter of Crypto++ places it
+    auto encryptWith = [&] (auto &encryption) {
+        encryption.EncryptAndAuthenticate(ciphertext + IV_SIZE, ciphertext + IV_SIZE + plaintextSize, TAG_SIZE,
+                                          iv.data(), IV_SIZE, nullptr, 0, plaintext, plaintextSize);
+    };
+    if (_useHardwareAes()) {
+        encryptWith(threadLocalCipherMode<HardwareAesGcm>(encKey, IV_SIZE));
+    } else {
+        encryptWith(threadLocalCipherMode<Encryption>(encKey, IV_SIZE));
+    }
+}
+
+template<typename BlockCipher, unsigned int KeySize>
+bool GCM_Cipher<BlockCipher, KeySize>::decrypt(const byte *ciphertext, unsigned int ciphertextSize, byte *plaintext, const EncryptionKey &encKey) {
+    if (ciphertextSize < IV_SIZE + TAG_SIZE) {
+        return false;
+    }
+    const byte *ciphertextIV = ciphertext;
+    const byte *ciphertextData = ciphertext + IV_SIZE;
+    const byte *ciphertextTag = ciphertext + ciphertextSize - TAG_SIZE;
+    auto decryptWith = [&] (auto &decryption) {
+        return decryption.DecryptAndVerify(plaintext, ciphertextTag, TAG_SIZE, ciphertextIV, IV_SIZE, nullptr, 0,
+                                           ciphertextData, plaintextSize(ciphertextSize));
+    };
+    if (_useHardwareAes()) {
+        return decryptWith(threadLocalCipherMode<HardwareAesGcm>(encKey, IV_SIZE));
+    }
+    return decryptWith(threadLocalCipherMode<Decryption>(encKey, IV_SIZE));
+}
 
-    std::memcpy(ciphertext.data(), iv.data(), IV_SIZE);
-    CryptoPP::ArraySource(plaintext, plaintextSize, true,
-      new CryptoPP::AuthenticatedEncryptionFilter(encryption,
-        new CryptoPP::ArraySink((byte*)ciphertext.data() + IV_SIZE, ciphertext.size() - IV_SIZE),
-        false, TAG_SIZE
-      )
-    );
+template<typename BlockCipher, unsigned int KeySize>
+Data GCM_Cipher<BlockCipher, KeySize>::encrypt(const byte *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey) {
+    Data ciphertext(ciphertextSize(plaintextSize));
+    encrypt(plaintext, plaintextSize, (byte*)ciphertext.data(), encKey);
     return ciphertext;
 }
 
 template<typename BlockCipher, unsigned int KeySize>
 boost::optional<Data> GCM_Cipher<BlockCipher, KeySize>::decrypt(const byte *ciphertext, unsigned int ciphertextSize, const EncryptionKey &encKey) {
     if (ciphertextSize < IV_SIZE + TAG_SIZE) {
-      return boost::none;
+        return boost::none;
     }
-
-    const byte *ciphertextIV = ciphertext;
-    const byte *ciphertextData = ciphertext + IV_SIZE;
-    typename CryptoPP::GCM<BlockCipher, CryptoPP::GCM_64K_Tables>::Decryption decryption;
-    decryption.SetKeyWithIV((byte*)encKey.data(), encKey.BINARY_LENGTH, ciphertextIV, IV_SIZE);
     Data plaintext(plaintextSize(ciphertextSize));
-
-    try {
-        CryptoPP::ArraySource((byte*)ciphertextData, ciphertextSize - IV_SIZE, true,
-        new CryptoPP::AuthenticatedDecryptionFilter(decryption,
-          new CryptoPP::ArraySink((byte*)plaintext.data(), plaintext.size()),
-          CryptoPP::AuthenticatedDecryptionFilter::DEFAULT_FLAGS, TAG_SIZE
-        )
-      );
-      return std::move(plaintext);
-    } catch (const CryptoPP::HashVerificationFilter::HashVerificationFailed &e) {
-      return boost::none;
+    if (!decrypt(ciphertext, ciphertextSize, (byte*)plaintext.data(), encKey)) {
+        return boost::none;
     }
+    return std::move(plaintext);
 }
-    
+
 }
 
 #endif
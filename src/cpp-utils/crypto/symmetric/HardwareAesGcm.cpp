@@ -0,0 +1,420 @@
+#include "HardwareAesGcm.h"
+#include "../../assert/assert.h"
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+# define CPPUTILS_HARDWARE_AES_GCM
+# include <cpuid.h>
+# include <immintrin.h>
+#endif
+
+namespace cpputils {
+
+#ifdef CPPUTILS_HARDWARE_AES_GCM
+
+// The functions using the AES and carry-less multiplication instructions are compiled for them even if the
+// rest of the build targets older CPUs. They are only called after checking that the CPU supports them.
+#define TARGET_AESNI __attribute__((target("aes,pclmul,ssse3,sse4.1")))
+#define TARGET_VAES __attribute__((target("aes,pclmul,ssse3,sse4.1,avx,avx2,avx512f,avx512bw,vaes,vpclmulqdq")))
+
+namespace {
+
+struct CpuFeatures final {
+    bool aesni;
+    bool vaes;
+};
+
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures result{false, false};
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return result;
+    }
+    constexpr unsigned int PCLMUL = 1u << 1, SSSE3 = 1u << 9, SSE41 = 1u << 19, AES = 1u << 25, OSXSAVE = 1u << 27;
+    result.aesni = (ecx & (PCLMUL | SSSE3 | SSE41 | AES)) == (PCLMUL | SSSE3 | SSE41 | AES);
+    if (!result.aesni || (ecx & OSXSAVE) == 0 || __get_cpuid_max(0, nullptr) < 7) {
+        return result;
+    }
+    // The operating system has to save the SSE, AVX and AVX-512 registers on context switches
+    unsigned int xcr0 = 0, xcr0High = 0;
+    __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+    constexpr unsigned int SAVED_REGISTERS = 0xe6;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    constexpr unsigned int AVX512F = 1u << 16, AVX512BW = 1u << 30, VAES = 1u << 9, VPCLMULQDQ = 1u << 10;
+    result.vaes = (xcr0 & SAVED_REGISTERS) == SAVED_REGISTERS
+                  && (ebx & (AVX512F | AVX512BW)) == (AVX512F | AVX512BW)
+                  && (ecx & (VAES | VPCLMULQDQ)) == (VAES | VPCLMULQDQ);
+    return result;
+}
+
+const CpuFeatures &cpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+constexpr unsigned int NUM_HASHKEY_POWERS = 16;
+
+// GHASH interprets blocks as bit reflected polynomials. Reversing the bytes of a block lets the
+// carry-less multiplication work on them, see Intel's white paper "Intel Carry-Less Multiplication
+// Instruction and its Usage for Computing the GCM Mode".
+TARGET_AESNI inline __m128i byteswapMask() {
+    return _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+}
+
+TARGET_AESNI inline __m128i byteswap(__m128i block) {
+    return _mm_shuffle_epi8(block, byteswapMask());
+}
+
+// Adds the 256 bit product of a and b, split into its low, middle and high part, to the given sums.
+// Summing up several products and reducing only once is how runs of blocks are hashed.
+TARGET_AESNI inline void multiplyAdd(__m128i a, __m128i b, __m128i *lo, __m128i *mid, __m128i *hi) {
+    *lo = _mm_xor_si128(*lo, _mm_clmulepi64_si128(a, b, 0x00));
+    *hi = _mm_xor_si128(*hi, _mm_clmulepi64_si128(a, b, 0x11));
+    *mid = _mm_xor_si128(*mid, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x01), _mm_clmulepi64_si128(a, b, 0x10)));
+}
+
+// Reduces a 256 bit product modulo the GCM polynomial x^128 + x^7 + x^2 + x + 1
+TARGET_AESNI inline __m128i reduce(__m128i lo, __m128i mid, __m128i hi) {
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+    // Because the operands are bit reflected, the product has to be shifted left by one bit
+    __m128i loCarry = _mm_srli_epi32(lo, 31);
+    __m128i hiCarry = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i loToHiCarry = _mm_srli_si128(loCarry, 12);
+    lo = _mm_or_si128(lo, _mm_slli_si128(loCarry, 4));
+    hi = _mm_or_si128(hi, _mm_slli_si128(hiCarry, 4));
+    hi = _mm_or_si128(hi, loToHiCarry);
+
+    __m128i first = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+    __m128i firstHigh = _mm_srli_si128(first, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(first, 12));
+    __m128i second = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+    lo = _mm_xor_si128(lo, _mm_xor_si128(second, firstHigh));
+    return _mm_xor_si128(hi, lo);
+}
+
+TARGET_AESNI inline __m128i multiply(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    multiplyAdd(a, b, &lo, &mid, &hi);
+    return reduce(lo, mid, hi);
+}
+
+// Hashes the data, zero padded to full blocks, into the byte reversed hash
+TARGET_AESNI __m128i ghash(__m128i hash, __m128i hashKey, const uint8_t *data, size_t size) {
+    for (; size >= 16; data += 16, size -= 16) {
+        hash = multiply(_mm_xor_si128(hash, byteswap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)))), hashKey);
+    }
+    if (size > 0) {
+        alignas(16) uint8_t block[16] = {0};
+        std::memcpy(block, data, size);
+        hash = multiply(_mm_xor_si128(hash, byteswap(_mm_load_si128(reinterpret_cast<const __m128i*>(block)))), hashKey);
+    }
+    return hash;
+}
+
+// Hashes the block holding the two bit lengths as big endian 64 bit numbers
+TARGET_AESNI inline __m128i ghashLengths(__m128i hash, __m128i hashKey, uint64_t firstBytes, uint64_t secondBytes) {
+    __m128i lengths = _mm_set_epi64x(static_cast<long long>(firstBytes * 8), static_cast<long long>(secondBytes * 8));
+    return multiply(_mm_xor_si128(hash, lengths), hashKey);
+}
+
+TARGET_AESNI inline __m128i expandKeyStep(__m128i previous, __m128i assisted) {
+    previous = _mm_xor_si128(previous, _mm_slli_si128(previous, 4));
+    previous = _mm_xor_si128(previous, _mm_slli_si128(previous, 4));
+    previous = _mm_xor_si128(previous, _mm_slli_si128(previous, 4));
+    return _mm_xor_si128(previous, assisted);
+}
+
+template<int RoundConstant>
+TARGET_AESNI inline void expandKey128Round(__m128i *roundKeys, unsigned int index) {
+    roundKeys[index] = expandKeyStep(roundKeys[index - 1], _mm_shuffle_epi32(_mm_aeskeygenassist_si128(roundKeys[index - 1], RoundConstant), 0xff));
+}
+
+template<int RoundConstant>
+TARGET_AESNI inline void expandKey256Round(__m128i *roundKeys, unsigned int index) {
+    roundKeys[index] = expandKeyStep(roundKeys[index - 2], _mm_shuffle_epi32(_mm_aeskeygenassist_si128(roundKeys[index - 1], RoundConstant), 0xff));
+    if (index + 1 <= 14) {
+        roundKeys[index + 1] = expandKeyStep(roundKeys[index - 1], _mm_shuffle_epi32(_mm_aeskeygenassist_si128(roundKeys[index], 0x00), 0xaa));
+    }
+}
+
+TARGET_AESNI void expandKey(const uint8_t *key, size_t keyLength, __m128i *roundKeys) {
+    roundKeys[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+    if (keyLength == 16) {
+        expandKey128Round<0x01>(roundKeys, 1);
+        expandKey128Round<0x02>(roundKeys, 2);
+        expandKey128Round<0x04>(roundKeys, 3);
+        expandKey128Round<0x08>(roundKeys, 4);
+        expandKey128Round<0x10>(roundKeys, 5);
+        expandKey128Round<0x20>(roundKeys, 6);
+        expandKey128Round<0x40>(roundKeys, 7);
+        expandKey128Round<0x80>(roundKeys, 8);
+        expandKey128Round<0x1b>(roundKeys, 9);
+        expandKey128Round<0x36>(roundKeys, 10);
+    } else {
+        roundKeys[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 16));
+        expandKey256Round<0x01>(roundKeys, 2);
+        expandKey256Round<0x02>(roundKeys, 4);
+        expandKey256Round<0x04>(roundKeys, 6);
+        expandKey256Round<0x08>(roundKeys, 8);
+        expandKey256Round<0x10>(roundKeys, 10);
+        expandKey256Round<0x20>(roundKeys, 12);
+        expandKey256Round<0x40>(roundKeys, 14);
+    }
+}
+
+TARGET_AESNI inline __m128i encryptBlock(__m128i block, const __m128i *roundKeys, unsigned int numRounds) {
+    block = _mm_xor_si128(block, roundKeys[0]);
+    for (unsigned int round = 1; round < numRounds; ++round) {
+        block = _mm_aesenc_si128(block, roundKeys[round]);
+    }
+    return _mm_aesenclast_si128(block, roundKeys[numRounds]);
+}
+
+TARGET_AESNI void computeHashKeyPowers(const __m128i *roundKeys, unsigned int numRounds, __m128i *hashKeyPowers) {
+    __m128i hashKey = byteswap(encryptBlock(_mm_setzero_si128(), roundKeys, numRounds));
+    hashKeyPowers[NUM_HASHKEY_POWERS - 1] = hashKey;
+    for (unsigned int i = NUM_HASHKEY_POWERS - 1; i > 0; --i) {
+        hashKeyPowers[i - 1] = multiply(hashKeyPowers[i], hashKey);
+    }
+}
+
+struct GcmState final {
+    const __m128i *roundKeys;
+    unsigned int numRounds;
+    const __m128i *hashKeyPowers;
+    // The byte reversed counter block used last. Its lowest lane is the 32 bit counter GCM increments.
+    __m128i counter;
+    // The byte reversed GHASH value so far
+    __m128i hash;
+};
+
+TARGET_AESNI inline __m128i counterBlock(__m128i counter, int increment) {
+    return byteswap(_mm_add_epi32(counter, _mm_set_epi32(0, 0, 0, increment)));
+}
+
+// Copies the block into all four 128 bit lanes. The masked variant avoids a false uninitialized warning of GCC.
+TARGET_VAES inline __m512i broadcastLanes(__m128i block) {
+    return _mm512_maskz_broadcast_i32x4(0xffff, block);
+}
+
+// Adds up the four 128 bit lanes
+TARGET_VAES inline __m128i foldLanes(__m512i value) {
+    __m128i lanes[4];
+    _mm512_storeu_si512(lanes, value);
+    return _mm_xor_si128(_mm_xor_si128(lanes[0], lanes[1]), _mm_xor_si128(lanes[2], lanes[3]));
+}
+
+// Encrypts or decrypts 16 blocks per iteration in the 512 bit registers. Returns the number of bytes processed,
+// the remaining bytes are fewer than 16 blocks.
+TARGET_VAES size_t cryptWithVaes(GcmState *state, bool encrypting, const uint8_t *input, uint8_t *output, size_t size) {
+    constexpr size_t CHUNK_SIZE = 16 * 16;
+    if (size < CHUNK_SIZE) {
+        return 0;
+    }
+    __m512i roundKeys[15];
+    for (unsigned int round = 0; round <= state->numRounds; ++round) {
+        roundKeys[round] = broadcastLanes(state->roundKeys[round]);
+    }
+    __m512i hashKeyPowers[4];
+    for (unsigned int i = 0; i < 4; ++i) {
+        hashKeyPowers[i] = _mm512_loadu_si512(state->hashKeyPowers + 4 * i);
+    }
+    const __m512i mask = broadcastLanes(byteswapMask());
+    const __m512i increment = _mm512_set_epi32(0, 0, 0, 4, 0, 0, 0, 4, 0, 0, 0, 4, 0, 0, 0, 4);
+    __m512i counter = _mm512_add_epi32(broadcastLanes(state->counter), _mm512_set_epi32(0, 0, 0, 4, 0, 0, 0, 3, 0, 0, 0, 2, 0, 0, 0, 1));
+
+    size_t processed = 0;
+    for (; size - processed >= CHUNK_SIZE; processed += CHUNK_SIZE) {
+        __m512i keystream[4];
+        for (unsigned int i = 0; i < 4; ++i) {
+            keystream[i] = _mm512_xor_si512(_mm512_shuffle_epi8(counter, mask), roundKeys[0]);
+            counter = _mm512_add_epi32(counter, increment);
+        }
+        for (unsigned int round = 1; round < state->numRounds; ++round) {
+            for (unsigned int i = 0; i < 4; ++i) {
+                keystream[i] = _mm512_aesenc_epi128(keystream[i], roundKeys[round]);
+            }
+        }
+        __m512i lo = _mm512_setzero_si512(), mid = _mm512_setzero_si512(), hi = _mm512_setzero_si512();
+        for (unsigned int i = 0; i < 4; ++i) {
+            __m512i in = _mm512_loadu_si512(input + processed + 64 * i);
+            __m512i out = _mm512_xor_si512(in, _mm512_aesenclast_epi128(keystream[i], roundKeys[state->numRounds]));
+            _mm512_storeu_si512(output + processed + 64 * i, out);
+            __m512i ciphertext = _mm512_shuffle_epi8(encrypting ? out : in, mask);
+            if (i == 0) {
+                ciphertext = _mm512_xor_si512(ciphertext, _mm512_inserti32x4(_mm512_setzero_si512(), state->hash, 0));
+            }
+            lo = _mm512_xor_si512(lo, _mm512_clmulepi64_epi128(ciphertext, hashKeyPowers[i], 0x00));
+            hi = _mm512_xor_si512(hi, _mm512_clmulepi64_epi128(ciphertext, hashKeyPowers[i], 0x11));
+            mid = _mm512_xor_si512(mid, _mm512_xor_si512(_mm512_clmulepi64_epi128(ciphertext, hashKeyPowers[i], 0x01),
+                                                         _mm512_clmulepi64_epi128(ciphertext, hashKeyPowers[i], 0x10)));
+        }
+        state->hash = reduce(foldLanes(lo), foldLanes(mid), foldLanes(hi));
+    }
+    state->counter = _mm_add_epi32(state->counter, _mm_set_epi32(0, 0, 0, static_cast<int>(processed / 16)));
+    return processed;
+}
+
+// Encrypts or decrypts 8 blocks per iteration, then the remaining blocks one by one.
+TARGET_AESNI void cryptWithAesNi(GcmState *state, bool encrypting, const uint8_t *input, uint8_t *output, size_t size) {
+    const __m128i *roundKeys = state->roundKeys;
+    const unsigned int numRounds = state->numRounds;
+    for (; size >= 8 * 16; input += 8 * 16, output += 8 * 16, size -= 8 * 16) {
+        __m128i keystream[8];
+        for (unsigned int i = 0; i < 8; ++i) {
+            keystream[i] = _mm_xor_si128(counterBlock(state->counter, i + 1), roundKeys[0]);
+        }
+        state->counter = _mm_add_epi32(state->counter, _mm_set_epi32(0, 0, 0, 8));
+        for (unsigned int round = 1; round < numRounds; ++round) {
+            for (unsigned int i = 0; i < 8; ++i) {
+                keystream[i] = _mm_aesenc_si128(keystream[i], roundKeys[round]);
+            }
+        }
+        __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        for (unsigned int i = 0; i < 8; ++i) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 16 * i));
+            __m128i out = _mm_xor_si128(in, _mm_aesenclast_si128(keystream[i], roundKeys[numRounds]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 16 * i), out);
+            __m128i ciphertext = byteswap(encrypting ? out : in);
+            if (i == 0) {
+                ciphertext = _mm_xor_si128(ciphertext, state->hash);
+            }
+            multiplyAdd(ciphertext, state->hashKeyPowers[NUM_HASHKEY_POWERS - 8 + i], &lo, &mid, &hi);
+        }
+        state->hash = reduce(lo, mid, hi);
+    }
+
+    const __m128i hashKey = state->hashKeyPowers[NUM_HASHKEY_POWERS - 1];
+    for (; size > 0; input += 16, output += 16, size -= std::min(size, static_cast<size_t>(16))) {
+        state->counter = _mm_add_epi32(state->counter, _mm_set_epi32(0, 0, 0, 1));
+        __m128i keystream = encryptBlock(byteswap(state->counter), roundKeys, numRounds);
+        if (size >= 16) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+            __m128i out = _mm_xor_si128(in, keystream);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output), out);
+            state->hash = multiply(_mm_xor_si128(state->hash, byteswap(encrypting ? out : in)), hashKey);
+        } else {
+            alignas(16) uint8_t in[16] = {0};
+            alignas(16) uint8_t out[16];
+            std::memcpy(in, input, size);
+            _mm_store_si128(reinterpret_cast<__m128i*>(out), _mm_xor_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(in)), keystream));
+            std::memcpy(output, out, size);
+            // GHASH pads the last ciphertext block with zeroes
+            std::memset(out + size, 0, 16 - size);
+            state->hash = ghash(state->hash, hashKey, encrypting ? out : in, 16);
+        }
+    }
+}
+
+TARGET_AESNI void gcmCrypt(bool encrypting, const __m128i *roundKeys, unsigned int numRounds, const __m128i *hashKeyPowers,
+                           uint8_t *tag, const uint8_t *iv, size_t ivLength, const uint8_t *header, size_t headerLength,
+                           const uint8_t *input, uint8_t *output, size_t size) {
+    const __m128i hashKey = hashKeyPowers[NUM_HASHKEY_POWERS - 1];
+    __m128i initialCounter;
+    if (ivLength == 12) {
+        alignas(16) uint8_t block[16] = {0};
+        std::memcpy(block, iv, 12);
+        block[15] = 1;
+        initialCounter = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+    } else {
+        __m128i ivHash = ghash(_mm_setzero_si128(), hashKey, iv, ivLength);
+        initialCounter = byteswap(ghashLengths(ivHash, hashKey, 0, ivLength));
+    }
+
+    GcmState state;
+    state.roundKeys = roundKeys;
+    state.numRounds = numRounds;
+    state.hashKeyPowers = hashKeyPowers;
+    state.counter = byteswap(initialCounter);
+    state.hash = ghash(_mm_setzero_si128(), hashKey, header, headerLength);
+    size_t processed = 0;
+    if (cpuFeatures().vaes) {
+        processed = cryptWithVaes(&state, encrypting, input, output, size);
+    }
+    cryptWithAesNi(&state, encrypting, input + processed, output + processed, size - processed);
+
+    __m128i hash = ghashLengths(state.hash, hashKey, headerLength, size);
+    __m128i result = _mm_xor_si128(encryptBlock(initialCounter, roundKeys, numRounds), byteswap(hash));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(tag), result);
+}
+
+}
+
+bool HardwareAesGcm::isSupported() {
+    return cpuFeatures().aesni;
+}
+
+bool HardwareAesGcm::usesVaes() {
+    return cpuFeatures().vaes;
+}
+
+HardwareAesGcm::HardwareAesGcm(): _numRounds(0), _roundKeys(), _hashKeyPowers() {
+}
+
+void HardwareAesGcm::SetKeyWithIV(const uint8_t *key, size_t keyLength, const uint8_t * /*iv*/, size_t /*ivLength*/) {
+    ASSERT(isSupported(), "The CPU doesn't support AES-NI");
+    ASSERT(keyLength == 16 || keyLength == 32, "Only 128 bit and 256 bit keys are supported");
+    _numRounds = (keyLength == 16) ? 10 : 14;
+    __m128i *roundKeys = reinterpret_cast<__m128i*>(_roundKeys);
+    expandKey(key, keyLength, roundKeys);
+    computeHashKeyPowers(roundKeys, _numRounds, reinterpret_cast<__m128i*>(_hashKeyPowers));
+}
+
+void HardwareAesGcm::_crypt(bool encrypting, uint8_t *output, uint8_t *tag, const uint8_t *iv, size_t ivLength,
+                            const uint8_t *header, size_t headerLength, const uint8_t *input, size_t size) const {
+    ASSERT(_numRounds != 0, "No key set");
+    ASSERT(ivLength > 0, "GCM needs an iv");
+    gcmCrypt(encrypting, reinterpret_cast<const __m128i*>(_roundKeys), _numRounds, reinterpret_cast<const __m128i*>(_hashKeyPowers),
+             tag, iv, ivLength, header, headerLength, input, output, size);
+}
+
+#else
+
+bool HardwareAesGcm::isSupported() {
+    return false;
+}
+
+bool HardwareAesGcm::usesVaes() {
+    return false;
+}
+
+HardwareAesGcm::HardwareAesGcm(): _numRounds(0), _roundKeys(), _hashKeyPowers() {
+}
+
+void HardwareAesGcm::SetKeyWithIV(const uint8_t * /*key*/, size_t /*keyLength*/, const uint8_t * /*iv*/, size_t /*ivLength*/) {
+    ASSERT(false, "Hardware AES-GCM is only available on x86 CPUs");
+}
+
+void HardwareAesGcm::_crypt(bool /*encrypting*/, uint8_t * /*output*/, uint8_t * /*tag*/, const uint8_t * /*iv*/, size_t /*ivLength*/,
+                            const uint8_t * /*header*/, size_t /*headerLength*/, const uint8_t * /*input*/, size_t /*size*/) const {
+    ASSERT(false, "Hardware AES-GCM is only available on x86 CPUs");
+}
+
+#endif
+
+void HardwareAesGcm::EncryptAndAuthenticate(uint8_t *ciphertext, uint8_t *mac, size_t macSize, const uint8_t *iv, int ivLength,
+                                            const uint8_t *header, size_t headerLength, const uint8_t *message, size_t messageLength) {
+    ASSERT(macSize <= 16, "GCM tags have at most 16 bytes");
+    uint8_t tag[16];
+    _crypt(true, ciphertext, tag, iv, ivLength, header, headerLength, message, messageLength);
+    std::memcpy(mac, tag, macSize);
+}
+
+bool HardwareAesGcm::DecryptAndVerify(uint8_t *message, const uint8_t *mac, size_t macLength, const uint8_t *iv, int ivLength,
+                                      const uint8_t *header, size_t headerLength, const uint8_t *ciphertext, size_t ciphertextLength) {
+    ASSERT(macLength <= 16, "GCM tags have at most 16 bytes");
+    uint8_t tag[16];
+    _crypt(false, message, tag, iv, ivLength, header, headerLength, ciphertext, ciphertextLength);
+    // Compare in constant time to not leak how many bytes of the tag were right
+    uint8_t difference = 0;
+    for (size_t i = 0; i < macLength; ++i) {
+        difference |= tag[i] ^ mac[i];
+    }
+    return difference == 0;
+}
+
+}
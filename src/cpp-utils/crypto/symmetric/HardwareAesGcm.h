@@ -0,0 +1,52 @@
+#pragma once
+#ifndef MESSMER_CPPUTILS_CRYPTO_SYMMETRIC_HARDWAREAESGCM_H_
+#define MESSMER_CPPUTILS_CRYPTO_SYMMETRIC_HARDWAREAESGCM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "../../macros.h"
+
+namespace cpputils {
+
+// AES-GCM using the AES-NI and PCLMULQDQ instructions, and VAES/VPCLMULQDQ on CPUs with AVX-512.
+// It produces the same ciphertexts and tags as the GCM mode of Crypto++, so GCM_Cipher uses it for AES
+// whenever the CPU supports it (see isSupported()) and existing file systems stay readable.
+// The methods have the signatures of the Crypto++ GCM mode objects, so both can be used the same way.
+class HardwareAesGcm final {
+public:
+    // Whether the CPU supports the AES-NI and PCLMULQDQ instructions. All other methods require it.
+    static bool isSupported();
+    // Whether the wider VAES and VPCLMULQDQ instructions are used for large messages.
+    static bool usesVaes();
+
+    HardwareAesGcm();
+
+    // Supports 128 bit and 256 bit keys. The iv is ignored, each message passes its own iv.
+    void SetKeyWithIV(const uint8_t *key, size_t keyLength, const uint8_t *iv, size_t ivLength);
+
+    void EncryptAndAuthenticate(uint8_t *ciphertext, uint8_t *mac, size_t macSize, const uint8_t *iv, int ivLength,
+                                const uint8_t *header, size_t headerLength, const uint8_t *message, size_t messageLength);
+    // Returns false if the mac doesn't match. The content of message is undefined then.
+    bool DecryptAndVerify(uint8_t *message, const uint8_t *mac, size_t macLength, const uint8_t *iv, int ivLength,
+                          const uint8_t *header, size_t headerLength, const uint8_t *ciphertext, size_t ciphertextLength);
+
+private:
+    static constexpr unsigned int MAX_ROUNDS = 14;
+    static constexpr unsigned int NUM_HASHKEY_POWERS = 16;
+
+    void _crypt(bool encrypting, uint8_t *output, uint8_t *mac, const uint8_t *iv, size_t ivLength,
+                const uint8_t *header, size_t headerLength, const uint8_t *input, size_t size) const;
+
+    unsigned int _numRounds;
+    // Round keys of the AES key schedule, 16 bytes each
+    alignas(64) uint8_t _roundKeys[16 * (MAX_ROUNDS + 1)];
+    // The GHASH key H to the powers NUM_HASHKEY_POWERS down to 1, byte reversed, so that
+    // a run of blocks can be multiplied with the powers they need in one go.
+    alignas(64) uint8_t _hashKeyPowers[16 * NUM_HASHKEY_POWERS];
+
+    DISALLOW_COPY_AND_ASSIGN(HardwareAesGcm);
+};
+
+}
+
+#endif
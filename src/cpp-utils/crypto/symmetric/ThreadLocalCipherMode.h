@@ -0,0 +1,33 @@
+#pragma once
+#ifndef MESSMER_CPPUTILS_CRYPTO_SYMMETRIC_THREADLOCALCIPHERMODE_H_
+#define MESSMER_CPPUTILS_CRYPTO_SYMMETRIC_THREADLOCALCIPHERMODE_H_
+
+#include "../../data/Data.h"
+#include <boost/optional.hpp>
+#include <cstdint>
+
+namespace cpputils {
+
+// Returns a Crypto++ cipher mode object (e.g. GCM<AES>::Encryption) of the calling thread with the given key set.
+// Setting a key computes the key schedule (and for GCM its multiplication tables), which costs more than
+// encrypting a block. So each thread keeps its object and only sets the key again when it uses a different one.
+// The callers set the IV of each message themselves.
+template<class Mode, class EncryptionKey>
+Mode &threadLocalCipherMode(const EncryptionKey &encKey, unsigned int ivSize) {
+    struct Context final {
+        boost::optional<EncryptionKey> key;
+        Mode mode;
+    };
+    static thread_local Context context;
+    if (context.key == boost::none || *context.key != encKey) {
+        Data initialIV(ivSize);
+        initialIV.FillWithZeroes();
+        context.mode.SetKeyWithIV(encKey.data(), EncryptionKey::BINARY_LENGTH, static_cast<const uint8_t*>(initialIV.data()), ivSize);
+        context.key = encKey;
+    }
+    return context.mode;
+}
+
+}
+
+#endif
@@ -0,0 +1,47 @@
+#include "XChaCha20Poly1305_Cipher.h"
+
+using boost::optional;
+using boost::none;
+
+namespace cpputils {
+
+constexpr unsigned int XChaCha20Poly1305_Cipher::NONCE_SIZE;
+constexpr unsigned int XChaCha20Poly1305_Cipher::TAG_SIZE;
+
+void XChaCha20Poly1305_Cipher::encrypt(const uint8_t *plaintext, unsigned int plaintextSize, uint8_t *ciphertext, const EncryptionKey &encKey) {
+    FixedSizeData<NONCE_SIZE> nonce = Random::PseudoRandom().getFixedSize<NONCE_SIZE>();
+    std::memcpy(ciphertext, nonce.data(), NONCE_SIZE);
+    // Like for GCM_Cipher, the tag follows the encrypted data
+    ChaCha20Poly1305::xencrypt(encKey.data(), nonce.data(), nullptr, 0, plaintext, plaintextSize,
+                               ciphertext + NONCE_SIZE, ciphertext + NONCE_SIZE + plaintextSize);
+}
+
+bool XChaCha20Poly1305_Cipher::decrypt(const uint8_t *ciphertext, unsigned int ciphertextSize, uint8_t *plaintext, const EncryptionKey &encKey) {
+    if (ciphertextSize < NONCE_SIZE + TAG_SIZE) {
+        return false;
+    }
+    const uint8_t *ciphertextNonce = ciphertext;
+    const uint8_t *ciphertextData = ciphertext + NONCE_SIZE;
+    const uint8_t *ciphertextTag = ciphertext + ciphertextSize - TAG_SIZE;
+    return ChaCha20Poly1305::xdecrypt(encKey.data(), ciphertextNonce, nullptr, 0, ciphertextData, plaintextSize(ciphertextSize),
+                                      ciphertextTag, plaintext);
+}
+
+Data XChaCha20Poly1305_Cipher::encrypt(const uint8_t *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey) {
+    Data ciphertext(ciphertextSize(plaintextSize));
+    encrypt(plaintext, plaintextSize, static_cast<uint8_t*>(ciphertext.data()), encKey);
+    return ciphertext;
+}
+
+optional<Data> XChaCha20Poly1305_Cipher::decrypt(const uint8_t *ciphertext, unsigned int ciphertextSize, const EncryptionKey &encKey) {
+    if (ciphertextSize < NONCE_SIZE + TAG_SIZE) {
+        return none;
+    }
+    Data plaintext(plaintextSize(ciphertextSize));
+    if (!decrypt(ciphertext, ciphertextSize, static_cast<uint8_t*>(plaintext.data()), encKey)) {
+        return none;
+    }
+    return std::move(plaintext);
+}
+
+}
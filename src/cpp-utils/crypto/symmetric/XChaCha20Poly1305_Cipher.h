@@ -0,0 +1,48 @@
+#pragma once
+#ifndef MESSMER_CPPUTILS_CRYPTO_SYMMETRIC_XCHACHA20POLY1305CIPHER_H_
+#define MESSMER_CPPUTILS_CRYPTO_SYMMETRIC_XCHACHA20POLY1305CIPHER_H_
+
+#include "../../data/FixedSizeData.h"
+#include "../../data/Data.h"
+#include "../../random/Random.h"
+#include <boost/optional.hpp>
+#include "Cipher.h"
+#include "ChaCha20Poly1305.h"
+
+namespace cpputils {
+
+// Authenticated encryption with XChaCha20-Poly1305 and a random nonce per message.
+// It is the fastest authenticated cipher on CPUs without AES instructions.
+class XChaCha20Poly1305_Cipher {
+public:
+    using EncryptionKey = FixedSizeData<ChaCha20Poly1305::KEY_SIZE>;
+
+    static EncryptionKey CreateKey(RandomGenerator &randomGenerator) {
+        return randomGenerator.getFixedSize<EncryptionKey::BINARY_LENGTH>();
+    }
+
+    static constexpr unsigned int ciphertextSize(unsigned int plaintextBlockSize) {
+        return plaintextBlockSize + NONCE_SIZE + TAG_SIZE;
+    }
+
+    static constexpr unsigned int plaintextSize(unsigned int ciphertextBlockSize) {
+        return ciphertextBlockSize - NONCE_SIZE - TAG_SIZE;
+    }
+
+    // Writes ciphertextSize(plaintextSize) bytes to ciphertext
+    static void encrypt(const uint8_t *plaintext, unsigned int plaintextSize, uint8_t *ciphertext, const EncryptionKey &encKey);
+    // Writes plaintextSize(ciphertextSize) bytes to plaintext. Returns false if the ciphertext was modified,
+    // the content of plaintext is undefined then.
+    static bool decrypt(const uint8_t *ciphertext, unsigned int ciphertextSize, uint8_t *plaintext, const EncryptionKey &encKey);
+
+    static Data encrypt(const uint8_t *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey);
+    static boost::optional<Data> decrypt(const uint8_t *ciphertext, unsigned int ciphertextSize, const EncryptionKey &encKey);
+
+private:
+    static constexpr unsigned int NONCE_SIZE = ChaCha20Poly1305::XNONCE_SIZE;
+    static constexpr unsigned int TAG_SIZE = ChaCha20Poly1305::TAG_SIZE;
+};
+
+}
+
+#endif
@@ -10,6 +10,8 @@ namespace cpputils {
     DEFINE_CIPHER(AES128_GCM);
     DEFINE_CIPHER(AES128_CFB);
 
+    DEFINE_CIPHER(XChaCha20Poly1305);
+
     DEFINE_CIPHER(Twofish256_GCM);
     DEFINE_CIPHER(Twofish256_CFB);
     DEFINE_CIPHER(Twofish128_GCM);
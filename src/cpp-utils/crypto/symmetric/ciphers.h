@@ -9,6 +9,7 @@
 #include <cryptopp/mars.h>
 #include "GCM_Cipher.h"
 #include "CFB_Cipher.h"
+#include "XChaCha20Poly1305_Cipher.h"
 
 #define DECLARE_CIPHER(InstanceName, StringName, Mode, Base, Keysize) \
     class InstanceName final: public Mode<Base, Keysize> {            \
@@ -25,6 +26,12 @@ DECLARE_CIPHER(AES256_CFB, "aes-256-cfb", CFB_Cipher, CryptoPP::AES, 32);
 DECLARE_CIPHER(AES128_GCM, "aes-128-gcm", GCM_Cipher, CryptoPP::AES, 16);
 DECLARE_CIPHER(AES128_CFB, "aes-128-cfb", CFB_Cipher, CryptoPP::AES, 16);
 
+class XChaCha20Poly1305 final: public XChaCha20Poly1305_Cipher {
+public:
+    BOOST_CONCEPT_ASSERT((CipherConcept<XChaCha20Poly1305>));
+    static constexpr const char *NAME = "xchacha20-poly1305";
+};
+
 static_assert(32 == CryptoPP::Twofish::MAX_KEYLENGTH, "If Twofish offered larger keys, we should offer a variant with it");
 DECLARE_CIPHER(Twofish256_GCM, "twofish-256-gcm", GCM_Cipher, CryptoPP::Twofish, 32);
 DECLARE_CIPHER(Twofish256_CFB, "twofish-256-cfb", CFB_Cipher, CryptoPP::Twofish, 32);
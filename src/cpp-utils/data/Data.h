@@ -6,19 +6,24 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/optional.hpp>
 #include "../macros.h"
+#include "../assert/assert.h"
 #include <memory>
 #include <fstream>
+#include <cstring>
 
 namespace cpputils {
 
 class Data final {
 public:
   explicit Data(size_t size);
+  // Reserves headroom bytes in front of the data, so headers can be prepended later without copying the data (see growFront()).
+  Data(size_t size, size_t headroom);
   ~Data();
 
   Data(Data &&rhs); // move constructor
   Data &operator=(Data &&rhs); // move assignment
 
+  // The copy has the same headroom
   Data copy() const;
 
   void *data();
@@ -30,6 +35,14 @@ public:
 
   size_t size() const;
 
+  // Number of bytes in front of the data that are allocated but not part of it
+  size_t headroom() const;
+  // Prepends count uninitialized bytes to the data. They are taken from the headroom if it is large enough,
+  // otherwise the data is copied into a new allocation.
+  Data &growFront(size_t count);
+  // Removes count bytes from the front of the data without copying it. They become part of the headroom.
+  Data &shrinkFront(size_t count);
+
   Data &FillWithZeroes();
 
   void StoreToFile(const boost::filesystem::path &filepath) const;
@@ -42,6 +55,7 @@ public:
 
 private:
   size_t _size;
+  size_t _headroom;
   void *_data;
 
   static std::streampos _getStreamSize(std::istream &stream);
@@ -59,36 +73,44 @@ bool operator!=(const Data &lhs, const Data &rhs);
 // ---------------------------
 
 inline Data::Data(size_t size)
-        : _size(size), _data(std::malloc(size)) {
+        : Data(size, 0) {
+}
+
+inline Data::Data(size_t size, size_t headroom)
+        : _size(size), _headroom(headroom), _data(std::malloc(headroom + size)) {
   if (nullptr == _data) {
     throw std::bad_alloc();
   }
+  _data = static_cast<uint8_t*>(_data) + headroom;
 }
 
 inline Data::Data(Data &&rhs)
-        : _size(rhs._size), _data(rhs._data) {
+        : _size(rhs._size), _headroom(rhs._headroom), _data(rhs._data) {
   // Make rhs invalid, so the memory doesn't get freed in its destructor.
   rhs._data = nullptr;
   rhs._size = 0;
+  rhs._headroom = 0;
 }
 
 inline Data &Data::operator=(Data &&rhs) {
-  std::free(_data);
+  std::free(static_cast<uint8_t*>(_data) - _headroom);
   _data = rhs._data;
   _size = rhs._size;
+  _headroom = rhs._headroom;
   rhs._data = nullptr;
   rhs._size = 0;
+  rhs._headroom = 0;
 
   return *this;
 }
 
 inline Data::~Data() {
-  std::free(_data);
+  std::free(static_cast<uint8_t*>(_data) - _headroom);
   _data = nullptr;
 }
 
 inline Data Data::copy() const {
-  Data copy(_size);
+  Data copy(_size, _headroom);
   std::memcpy(copy._data, _data, _size);
   return copy;
 }
@@ -113,6 +135,31 @@ inline size_t Data::size() const {
   return _size;
 }
 
+inline size_t Data::headroom() const {
+  return _headroom;
+}
+
+inline Data &Data::growFront(size_t count) {
+  if (count <= _headroom) {
+    _data = static_cast<uint8_t*>(_data) - count;
+    _headroom -= count;
+    _size += count;
+  } else {
+    Data grown(count + _size);
+    std::memcpy(grown.dataOffset(count), _data, _size);
+    *this = std::move(grown);
+  }
+  return *this;
+}
+
+inline Data &Data::shrinkFront(size_t count) {
+  ASSERT(count <= _size, "Can't remove more bytes than there are");
+  _data = static_cast<uint8_t*>(_data) + count;
+  _headroom += count;
+  _size -= count;
+  return *this;
+}
+
 inline Data &Data::FillWithZeroes() {
   std::memset(_data, 0, _size);
   return *this;
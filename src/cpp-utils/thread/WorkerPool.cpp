@@ -0,0 +1,118 @@
+#include "WorkerPool.h"
+#include "../assert/assert.h"
+#include <algorithm>
+#include <exception>
+
+using std::function;
+using std::future;
+using std::packaged_task;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+namespace cpputils {
+
+    WorkerPool::WorkerPool(uint32_t numThreads, uint32_t maxQueueSize)
+        : _maxQueueSize(maxQueueSize), _mutex(), _queueNotEmpty(), _queueNotFull(), _queue(),
+          _numFinishedTasks(0), _totalLatency(steady_clock::duration::zero()), _maxLatency(steady_clock::duration::zero()), _threads() {
+        ASSERT(numThreads > 0, "WorkerPool needs at least one thread");
+        ASSERT(maxQueueSize > 0, "WorkerPool needs a queue that can hold at least one task");
+        _threads.reserve(numThreads);
+        for (uint32_t i = 0; i < numThreads; ++i) {
+            _threads.push_back(make_unique_ref<LoopThread>(std::bind(&WorkerPool::_loopIteration, this)));
+            _threads.back()->start();
+        }
+    }
+
+    WorkerPool::~WorkerPool() {
+        // Stop the threads before the queue is destructed
+        _threads.clear();
+    }
+
+    uint32_t WorkerPool::numThreads() const {
+        return _threads.size();
+    }
+
+    future<void> WorkerPool::schedule(function<void ()> task) {
+        packaged_task<void ()> packagedTask(std::move(task));
+        future<void> result = packagedTask.get_future();
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        _queueNotFull.wait(lock, [this] {
+            return _queue.size() < _maxQueueSize;
+        });
+        _queue.push_back(QueuedTask{std::move(packagedTask), steady_clock::now()});
+        _queueNotEmpty.notify_one();
+        return result;
+    }
+
+    void WorkerPool::runOnAllWorkers(const function<void (uint32_t workerIndex)> &task) {
+        std::vector<future<void>> waitHandles;
+        waitHandles.reserve(numThreads());
+        for (uint32_t i = 0; i < numThreads(); ++i) {
+            waitHandles.push_back(schedule(std::bind(task, i)));
+        }
+        // The first exception is only rethrown once all workers finished, because the task can access data of the caller
+        std::exception_ptr error;
+        for (auto &waitHandle : waitHandles) {
+            // std::future::wait() isn't interruptible, so poll for interruption requests while waiting.
+            while (waitHandle.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+                boost::this_thread::interruption_point();
+            }
+            try {
+                waitHandle.get();
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void WorkerPool::parallelFor(size_t count, const function<void (size_t index)> &task) {
+        if (count <= 1) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+        uint32_t numWorkers = std::min<size_t>(numThreads(), count);
+        runOnAllWorkers([count, numWorkers, &task] (uint32_t workerIndex) {
+            for (size_t i = workerIndex; i < count; i += numWorkers) {
+                task(i);
+            }
+        });
+    }
+
+    bool WorkerPool::_loopIteration() {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        // This is an interruption point, i.e. LoopThread can stop us here.
+        _queueNotEmpty.wait(lock, [this] {
+            return !_queue.empty();
+        });
+        QueuedTask task = std::move(_queue.front());
+        _queue.pop_front();
+        _queueNotFull.notify_one();
+        lock.unlock();
+
+        // packaged_task passes exceptions to the future, so they don't terminate the worker
+        task.task();
+
+        steady_clock::duration latency = steady_clock::now() - task.scheduledAt;
+        lock.lock();
+        ++_numFinishedTasks;
+        _totalLatency += latency;
+        _maxLatency = std::max(_maxLatency, latency);
+        return true; // Run another iteration (don't terminate thread)
+    }
+
+    WorkerPool::Statistics WorkerPool::statistics() const {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        double averageLatencySec = 0;
+        if (_numFinishedTasks > 0) {
+            averageLatencySec = duration<double>(_totalLatency).count() / _numFinishedTasks;
+        }
+        return Statistics{static_cast<uint32_t>(_queue.size()), _numFinishedTasks, averageLatencySec, duration<double>(_maxLatency).count()};
+    }
+}
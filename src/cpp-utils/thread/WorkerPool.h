@@ -0,0 +1,81 @@
+#pragma once
+#ifndef MESSMER_CPPUTILS_THREAD_WORKERPOOL_H
+#define MESSMER_CPPUTILS_THREAD_WORKERPOOL_H
+
+#include "LoopThread.h"
+#include "../macros.h"
+#include "../pointer/unique_ref.h"
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <vector>
+
+namespace cpputils {
+
+    // A fixed number of worker threads that run tasks from a bounded queue.
+    // The threads are started once and then wait for tasks, so scheduling a task doesn't create a thread.
+    // The threads are LoopThreads, i.e. they are stopped and restarted around fork().
+    class WorkerPool final {
+    public:
+        struct Statistics final {
+            // Number of tasks that are scheduled but haven't been started yet
+            uint32_t queueDepth;
+            uint64_t numFinishedTasks;
+            // Latency is the time from scheduling a task until it finished
+            double averageLatencySec;
+            double maxLatencySec;
+        };
+
+        WorkerPool(uint32_t numThreads, uint32_t maxQueueSize);
+        // Waits for running tasks to finish. Tasks that haven't been started yet are dropped,
+        // i.e. their futures throw std::future_error.
+        ~WorkerPool();
+
+        uint32_t numThreads() const;
+
+        // Adds a task to the queue. If the queue is full, this blocks until a worker took a task from the queue.
+        // Don't wait for the returned future from within a task, because that deadlocks if all workers do it.
+        std::future<void> schedule(std::function<void ()> task);
+
+        // Runs task(0), ..., task(numThreads()-1) on the workers and waits until all of them finished.
+        // If tasks throw, one of the exceptions is rethrown after all of them finished.
+        // Waiting is an interruption point, so LoopThreads can call this and still be stopped.
+        void runOnAllWorkers(const std::function<void (uint32_t workerIndex)> &task);
+
+        // Runs task(0), ..., task(count-1) spread over the workers and waits until all of them finished.
+        // A single task is run in the calling thread, because handing it to a worker would only add latency.
+        // If a task throws, tasks that didn't start yet may be skipped. One of the exceptions is rethrown,
+        // but only after no task is running anymore, so tasks can safely access data of the caller.
+        void parallelFor(size_t count, const std::function<void (size_t index)> &task);
+
+        Statistics statistics() const;
+
+    private:
+        struct QueuedTask final {
+            std::packaged_task<void ()> task;
+            std::chrono::steady_clock::time_point scheduledAt;
+        };
+
+        bool _loopIteration();
+
+        const uint32_t _maxQueueSize;
+        mutable boost::mutex _mutex;
+        // boost::condition_variable, because waiting on it has to be interruptible, so the LoopThreads can be stopped
+        boost::condition_variable _queueNotEmpty;
+        boost::condition_variable _queueNotFull;
+        std::deque<QueuedTask> _queue;
+        uint64_t _numFinishedTasks;
+        std::chrono::steady_clock::duration _totalLatency;
+        std::chrono::steady_clock::duration _maxLatency;
+
+        //This member has to be last, so the threads are destructed first. Otherwise the threads might access elements
+        //from a partly destructed WorkerPool.
+        std::vector<unique_ref<LoopThread>> _threads;
+
+        DISALLOW_COPY_AND_ASSIGN(WorkerPool);
+    };
+}
+
+#endif
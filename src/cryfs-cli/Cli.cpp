@@ -9,6 +9,7 @@
 #include <cpp-utils/assert/backtrace.h>
 
 #include <fspp/fuse/Fuse.h>
+#include <fspp/fuse/FuseLowlevel.h>
 #include <fspp/impl/FilesystemImpl.h>
 #include <cpp-utils/process/subprocess.h>
 #include <cpp-utils/io/DontEchoStdinToStdoutRAII.h>
@@ -227,30 +228,41 @@ namespace cryfs {
         }
     }
 
+    template<class FuseFrontend>
+    void Cli::_runFuse(FuseFrontend *fuse, CryDevice *device, const ProgramOptions &options) {
+        _initLogfile(options);
+
+        //TODO Test auto unmounting after idle timeout
+        //TODO This can fail due to a race condition if the filesystem isn't started yet (e.g. passing --unmount-idle 0").
+        auto idleUnmounter = _createIdleCallback(options.unmountAfterIdleMinutes(), [fuse] {fuse->stop();});
+        if (idleUnmounter != none) {
+            device->onFsAction(std::bind(&CallAfterTimeout::resetTimer, idleUnmounter->get()));
+        }
+
+#ifdef __APPLE__
+        std::cout << "\nMounting filesystem. To unmount, call:\n$ umount " << options.mountDir() << "\n" << std::endl;
+#else
+        std::cout << "\nMounting filesystem. To unmount, call:\n$ fusermount -u " << options.mountDir() << "\n" << std::endl;
+#endif
+        fuse->run(options.mountDir(), options.fuseOptions());
+    }
+
     void Cli::_runFilesystem(const ProgramOptions &options) {
         try {
             auto blockStore = make_unique_ref<OnDiskBlockStore>(options.baseDir());
             auto config = _loadOrCreateConfig(options);
-            CryDevice device(std::move(config), std::move(blockStore));
+            CryDevice device(std::move(config), std::move(blockStore), options.cacheSizeBytes().value_or(CryDevice::DEFAULT_CACHE_SIZE_BYTES));
             _sanityCheckFilesystem(&device);
-            fspp::FilesystemImpl fsimpl(&device);
-            fspp::fuse::Fuse fuse(&fsimpl, "cryfs", "cryfs@"+options.baseDir().native());
-
-            _initLogfile(options);
-
-            //TODO Test auto unmounting after idle timeout
-            //TODO This can fail due to a race condition if the filesystem isn't started yet (e.g. passing --unmount-idle 0").
-            auto idleUnmounter = _createIdleCallback(options.unmountAfterIdleMinutes(), [&fuse] {fuse.stop();});
-            if (idleUnmounter != none) {
-                device.onFsAction(std::bind(&CallAfterTimeout::resetTimer, idleUnmounter->get()));
+            if (options.lowlevelFuse()) {
+                fspp::fuse::FuseLowlevel fuse(&device, "cryfs", "cryfs@"+options.baseDir().native(),
+                                              options.entryTimeoutSeconds().value_or(fspp::fuse::FuseLowlevel::DEFAULT_ENTRY_TIMEOUT_SECONDS),
+                                              options.attrTimeoutSeconds().value_or(fspp::fuse::FuseLowlevel::DEFAULT_ATTR_TIMEOUT_SECONDS));
+                _runFuse(&fuse, &device, options);
+            } else {
+                fspp::FilesystemImpl fsimpl(&device);
+                fspp::fuse::Fuse fuse(&fsimpl, "cryfs", "cryfs@"+options.baseDir().native());
+                _runFuse(&fuse, &device, options);
             }
-
-#ifdef __APPLE__
-            std::cout << "\nMounting filesystem. To unmount, call:\n$ umount " << options.mountDir() << "\n" << std::endl;
-#else
-            std::cout << "\nMounting filesystem. To unmount, call:\n$ fusermount -u " << options.mountDir() << "\n" << std::endl;
-#endif
-            fuse.run(options.mountDir(), options.fuseOptions());
         } catch (const std::exception &e) {
             LOG(ERROR, "Crashed: {}", e.what());
         } catch (...) {
@@ -21,6 +21,7 @@ namespace cryfs {
     private:
         void _checkForUpdates();
         void _runFilesystem(const program_options::ProgramOptions &options);
+        template<class FuseFrontend> void _runFuse(FuseFrontend *fuse, CryDevice *device, const program_options::ProgramOptions &options);
         CryConfigFile _loadOrCreateConfig(const program_options::ProgramOptions &options);
         boost::optional<CryConfigFile> _loadOrCreateConfigFile(const boost::filesystem::path &configFilePath, const boost::optional<std::string> &cipher, const boost::optional<uint32_t> &blocksizeBytes);
         boost::filesystem::path _determineConfigFile(const program_options::ProgramOptions &options);
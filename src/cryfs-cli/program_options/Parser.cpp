@@ -3,12 +3,17 @@
 #include <iostream>
 #include <boost/optional.hpp>
 #include <cryfs/config/CryConfigConsole.h>
+#include <cryfs/filesystem/CryDevice.h>
+#include <fspp/fuse/FuseLowlevel.h>
+#include <boost/lexical_cast.hpp>
 #include <cryfs-cli/Environment.h>
 
 namespace po = boost::program_options;
 namespace bf = boost::filesystem;
 using namespace cryfs::program_options;
 using cryfs::CryConfigConsole;
+using cryfs::CryDevice;
+using fspp::fuse::FuseLowlevel;
 using std::pair;
 using std::vector;
 using std::cerr;
@@ -68,8 +73,26 @@ ProgramOptions Parser::parse(const vector<string> &supportedCiphers) const {
     if (vm.count("blocksize")) {
         blocksizeBytes = vm["blocksize"].as<uint32_t>();
     }
+    optional<uint64_t> cacheSizeBytes = none;
+    if (vm.count("cache-size")) {
+        cacheSizeBytes = vm["cache-size"].as<uint64_t>();
+    }
+    bool lowlevelFuse = vm.count("fuse-lowlevel");
+    optional<double> entryTimeoutSeconds = none;
+    if (vm.count("entry-timeout")) {
+        entryTimeoutSeconds = vm["entry-timeout"].as<double>();
+    }
+    optional<double> attrTimeoutSeconds = none;
+    if (vm.count("attr-timeout")) {
+        attrTimeoutSeconds = vm["attr-timeout"].as<double>();
+    }
+    if (!lowlevelFuse && (entryTimeoutSeconds != none || attrTimeoutSeconds != none)) {
+        std::cerr << "--entry-timeout and --attr-timeout can only be used with --fuse-lowlevel.\n";
+        _showHelpAndExit();
+    }
 
-    return ProgramOptions(baseDir, mountDir, configfile, foreground, unmountAfterIdleMinutes, logfile, cipher, blocksizeBytes, options.second);
+    return ProgramOptions(baseDir, mountDir, configfile, foreground, unmountAfterIdleMinutes, logfile, cipher, blocksizeBytes, cacheSizeBytes,
+                          lowlevelFuse, entryTimeoutSeconds, attrTimeoutSeconds, options.second);
 }
 
 void Parser::_checkValidCipher(const string &cipher, const vector<string> &supportedCiphers) {
@@ -124,12 +147,22 @@ void Parser::_addAllowedOptions(po::options_description *desc) {
     cipher_description += CryConfigConsole::DEFAULT_CIPHER;
     string blocksize_description = "The block size used when storing ciphertext blocks (in bytes). Default: ";
     blocksize_description += std::to_string(CryConfigConsole::DEFAULT_BLOCKSIZE_BYTES);
+    string cachesize_description = "Maximal amount of memory used to cache blocks (in bytes). Default: ";
+    cachesize_description += std::to_string(CryDevice::DEFAULT_CACHE_SIZE_BYTES);
+    string entrytimeout_description = "With --fuse-lowlevel, the kernel caches file names for this many seconds. Default: ";
+    entrytimeout_description += boost::lexical_cast<string>(FuseLowlevel::DEFAULT_ENTRY_TIMEOUT_SECONDS);
+    string attrtimeout_description = "With --fuse-lowlevel, the kernel caches file attributes for this many seconds. Default: ";
+    attrtimeout_description += boost::lexical_cast<string>(FuseLowlevel::DEFAULT_ATTR_TIMEOUT_SECONDS);
     options.add_options()
             ("help,h", "show help message")
             ("config,c", po::value<string>(), "Configuration file")
             ("foreground,f", "Run CryFS in foreground.")
             ("cipher", po::value<string>(), cipher_description.c_str())
             ("blocksize", po::value<uint32_t>(), blocksize_description.c_str())
+            ("cache-size", po::value<uint64_t>(), cachesize_description.c_str())
+            ("fuse-lowlevel", "Use the inode based FUSE interface. This is faster, because the path of a file isn't resolved again for each access.")
+            ("entry-timeout", po::value<double>(), entrytimeout_description.c_str())
+            ("attr-timeout", po::value<double>(), attrtimeout_description.c_str())
             ("show-ciphers", "Show list of supported ciphers.")
             ("unmount-idle", po::value<double>(), "Automatically unmount after specified number of idle minutes.")
             ("logfile", po::value<string>(), "Specify the file to write log messages to. If this is not specified, log messages will go to stdout, or syslog if CryFS is running in the background.")
@@ -12,9 +12,14 @@ ProgramOptions::ProgramOptions(const bf::path &baseDir, const bf::path &mountDir
                                bool foreground, const optional<double> &unmountAfterIdleMinutes,
                                const optional<bf::path> &logFile, const optional<string> &cipher,
                                const optional<uint32_t> &blocksizeBytes,
+                               const optional<uint64_t> &cacheSizeBytes,
+                               bool lowlevelFuse,
+                               const optional<double> &entryTimeoutSeconds,
+                               const optional<double> &attrTimeoutSeconds,
                                const vector<string> &fuseOptions)
     :_baseDir(baseDir), _mountDir(mountDir), _configFile(configFile), _foreground(foreground),
-     _cipher(cipher), _blocksizeBytes(blocksizeBytes), _unmountAfterIdleMinutes(unmountAfterIdleMinutes),
+     _cipher(cipher), _blocksizeBytes(blocksizeBytes), _cacheSizeBytes(cacheSizeBytes),
+     _lowlevelFuse(lowlevelFuse), _entryTimeoutSeconds(entryTimeoutSeconds), _attrTimeoutSeconds(attrTimeoutSeconds), _unmountAfterIdleMinutes(unmountAfterIdleMinutes),
      _logFile(logFile), _fuseOptions(fuseOptions) {
 }
 
@@ -50,6 +55,22 @@ const optional<uint32_t> &ProgramOptions::blocksizeBytes() const {
     return _blocksizeBytes;
 }
 
+const optional<uint64_t> &ProgramOptions::cacheSizeBytes() const {
+    return _cacheSizeBytes;
+}
+
+bool ProgramOptions::lowlevelFuse() const {
+    return _lowlevelFuse;
+}
+
+const optional<double> &ProgramOptions::entryTimeoutSeconds() const {
+    return _entryTimeoutSeconds;
+}
+
+const optional<double> &ProgramOptions::attrTimeoutSeconds() const {
+    return _attrTimeoutSeconds;
+}
+
 const vector<string> &ProgramOptions::fuseOptions() const {
     return _fuseOptions;
 }
@@ -18,6 +18,10 @@ namespace cryfs {
                            const boost::optional<boost::filesystem::path> &logFile,
                            const boost::optional<std::string> &cipher,
                            const boost::optional<uint32_t> &blocksizeBytes,
+                           const boost::optional<uint64_t> &cacheSizeBytes,
+                           bool lowlevelFuse,
+                           const boost::optional<double> &entryTimeoutSeconds,
+                           const boost::optional<double> &attrTimeoutSeconds,
                            const std::vector<std::string> &fuseOptions);
             ProgramOptions(ProgramOptions &&rhs) = default;
 
@@ -27,6 +31,10 @@ namespace cryfs {
             bool foreground() const;
             const boost::optional<std::string> &cipher() const;
             const boost::optional<uint32_t> &blocksizeBytes() const;
+            const boost::optional<uint64_t> &cacheSizeBytes() const;
+            bool lowlevelFuse() const;
+            const boost::optional<double> &entryTimeoutSeconds() const;
+            const boost::optional<double> &attrTimeoutSeconds() const;
             const boost::optional<double> &unmountAfterIdleMinutes() const;
             const boost::optional<boost::filesystem::path> &logFile() const;
             const std::vector<std::string> &fuseOptions() const;
@@ -38,6 +46,10 @@ namespace cryfs {
             bool _foreground;
             boost::optional<std::string> _cipher;
             boost::optional<uint32_t> _blocksizeBytes;
+            boost::optional<uint64_t> _cacheSizeBytes;
+            bool _lowlevelFuse;
+            boost::optional<double> _entryTimeoutSeconds;
+            boost::optional<double> _attrTimeoutSeconds;
             boost::optional<double> _unmountAfterIdleMinutes;
             boost::optional<boost::filesystem::path> _logFile;
             std::vector<std::string> _fuseOptions;
@@ -63,6 +63,7 @@ const vector<shared_ptr<CryCipher>> CryCiphers::SUPPORTED_CIPHERS = {
         make_shared<CryCipherInstance<AES256_CFB>>(INTEGRITY_WARNING),
         make_shared<CryCipherInstance<AES128_GCM>>(),
         make_shared<CryCipherInstance<AES128_CFB>>(INTEGRITY_WARNING),
+        make_shared<CryCipherInstance<XChaCha20Poly1305>>(),
         make_shared<CryCipherInstance<Twofish256_GCM>>(),
         make_shared<CryCipherInstance<Twofish256_CFB>>(INTEGRITY_WARNING),
         make_shared<CryCipherInstance<Twofish128_GCM>>(),
@@ -14,8 +14,11 @@
 #include "parallelaccessfsblobstore/ParallelAccessFsBlobStore.h"
 #include "cachingfsblobstore/CachingFsBlobStore.h"
 #include "../config/CryCipher.h"
+#include <algorithm>
+#include <thread>
 
 using std::string;
+using std::vector;
 
 //TODO Get rid of this in favor of exception hierarchy
 using fspp::fuse::CHECK_RETVAL;
@@ -45,21 +48,42 @@ namespace bf = boost::filesystem;
 
 namespace cryfs {
 
-CryDevice::CryDevice(CryConfigFile configFile, unique_ref<BlockStore> blockStore)
+constexpr uint64_t CryDevice::DEFAULT_CACHE_SIZE_BYTES;
+constexpr uint64_t CryDevice::MAX_READ_AHEAD_BYTES;
+constexpr uint32_t CryDevice::DEFAULT_MAX_CACHED_PATHS;
+
+CryDevice::CryDevice(CryConfigFile configFile, unique_ref<BlockStore> blockStore, uint64_t cacheSizeBytes, uint32_t maxCachedPaths)
 : _fsBlobStore(
       make_unique_ref<ParallelAccessFsBlobStore>(
         make_unique_ref<CachingFsBlobStore>(
           make_unique_ref<FsBlobStore>(
             make_unique_ref<BlobStoreOnBlocks>(
               make_unique_ref<CachingBlockStore>(
-                CreateEncryptedBlockStore(*configFile.config(), std::move(blockStore))
+                CreateEncryptedBlockStore(*configFile.config(), std::move(blockStore)), cacheSizeBytes
               ), configFile.config()->BlocksizeBytes())))
         )
       ),
+  _maxReadAheadBytes(std::min(MAX_READ_AHEAD_BYTES, cacheSizeBytes / 8)),
+  _readAheadWorkersStarted(),
+  _readAheadWorkers(nullptr),
   _rootKey(GetOrCreateRootKey(&configFile)),
+  _dentryCache(maxCachedPaths),
   _onFsAction() {
 }
 
+cpputils::WorkerPool *CryDevice::readAheadWorkers() const {
+  std::call_once(_readAheadWorkersStarted, [this] {
+    uint32_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    // Each open file has at most one prefetch scheduled, so the queue only fills up if many files are read at once
+    _readAheadWorkers = std::make_unique<cpputils::WorkerPool>(numThreads, 4 * numThreads);
+  });
+  return _readAheadWorkers.get();
+}
+
+uint64_t CryDevice::maxReadAheadBytes() const {
+  return _maxReadAheadBytes;
+}
+
 Key CryDevice::CreateRootBlobAndReturnKey() {
   auto rootBlob =  _fsBlobStore->createDirBlob();
   rootBlob->flush(); // Don't cache, but directly write the root blob (this causes it to fail early if the base directory is not accessible)
@@ -114,23 +138,78 @@ optional<unique_ref<fspp::Node>> CryDevice::Load(const bf::path &path) {
     return optional<unique_ref<fspp::Node>>(make_unique_ref<CryDir>(this, none, none, _rootKey));
   }
 
+  uint64_t cacheGeneration = _dentryCache.generation();
+  auto cached = _dentryCache.lookup(path);
   auto parentWithGrandparent = LoadDirBlobWithParent(path.parent_path());
   auto parent = std::move(parentWithGrandparent.blob);
   auto grandparent = std::move(parentWithGrandparent.parent);
 
-  auto optEntry = parent->GetChild(path.filename().native());
-  if (optEntry == boost::none) {
-    return boost::none;
+  // If the path is cached, there's no need to search the directory for the entry
+  if (cached == none || cached->parentKey != parent->key()) {
+    auto optEntry = parent->GetChild(path.filename().native());
+    if (optEntry == boost::none) {
+      return boost::none;
+    }
+    cached = DentryCache::Entry{optEntry->key(), parent->key(), optEntry->type()};
+    _dentryCache.insert(path, *cached, cacheGeneration);
+  }
+  return CreateNode(cached->type, std::move(parent), std::move(grandparent), cached->key);
+}
+
+optional<unique_ref<fspp::Node>> CryDevice::LoadById(const vector<NodeId> &ids) {
+  callFsActionCallbacks();
+
+  if (ids.empty()) {
+    return optional<unique_ref<fspp::Node>>(make_unique_ref<CryDir>(this, none, none, _rootKey));
+  }
+
+  // The node ids are the blob keys, so parent and grandparent are loaded directly without searching any directory by name
+  const Key &key = ids.back();
+  auto parent = LoadDirBlobOfPath((ids.size() >= 2) ? ids[ids.size() - 2] : _rootKey);
+  auto optEntry = parent->GetChild(key);
+  if (optEntry == none) {
+    return none;
+  }
+  fspp::Dir::EntryType type = optEntry->type();
+  optional<unique_ref<DirBlobRef>> grandparent = none;
+  if (ids.size() >= 2) {
+    grandparent = LoadDirBlobOfPath((ids.size() >= 3) ? ids[ids.size() - 3] : _rootKey);
+  }
+  return CreateNode(type, std::move(parent), std::move(grandparent), key);
+}
+
+optional<fspp::Device::NodeId> CryDevice::LookupChildId(const vector<NodeId> &dirIds, const string &name) {
+  callFsActionCallbacks();
+
+  auto dir = LoadDirBlobOfPath(dirIds.empty() ? _rootKey : dirIds.back());
+  auto optEntry = dir->GetChild(name);
+  if (optEntry == none) {
+    return none;
   }
-  const auto &entry = *optEntry;
+  return optEntry->key();
+}
+
+optional<fspp::Device::NodeId> CryDevice::StatChild(const vector<NodeId> &dirIds, const string &name, struct ::stat *result) {
+  callFsActionCallbacks();
 
-  switch(entry.type()) {
+  auto dir = LoadDirBlobOfPath(dirIds.empty() ? _rootKey : dirIds.back());
+  auto optEntry = dir->GetChild(name);
+  if (optEntry == none) {
+    return none;
+  }
+  Key key = optEntry->key();
+  dir->statChild(key, result);
+  return key;
+}
+
+unique_ref<fspp::Node> CryDevice::CreateNode(fspp::Dir::EntryType type, unique_ref<DirBlobRef> parent, optional<unique_ref<DirBlobRef>> grandparent, const Key &key) {
+  switch(type) {
     case fspp::Dir::EntryType::DIR:
-      return optional<unique_ref<fspp::Node>>(make_unique_ref<CryDir>(this, std::move(parent), std::move(grandparent), entry.key()));
+      return make_unique_ref<CryDir>(this, std::move(parent), std::move(grandparent), key);
     case fspp::Dir::EntryType::FILE:
-      return optional<unique_ref<fspp::Node>>(make_unique_ref<CryFile>(this, std::move(parent), std::move(grandparent), entry.key()));
+      return make_unique_ref<CryFile>(this, std::move(parent), std::move(grandparent), key);
     case  fspp::Dir::EntryType::SYMLINK:
-	  return optional<unique_ref<fspp::Node>>(make_unique_ref<CrySymlink>(this, std::move(parent), std::move(grandparent), entry.key()));
+	  return make_unique_ref<CrySymlink>(this, std::move(parent), std::move(grandparent), key);
   }
   ASSERT(false, "Switch/case not exhaustive");
 }
@@ -145,31 +224,59 @@ CryDevice::DirBlobWithParent CryDevice::LoadDirBlobWithParent(const bf::path &pa
 }
 
 CryDevice::BlobWithParent CryDevice::LoadBlobWithParent(const bf::path &path) {
+  uint64_t cacheGeneration = _dentryCache.generation();
+  vector<bf::path> prefixes;
+  bf::path prefix = "/";
+  for (const bf::path &component : path.relative_path()) {
+    prefix /= component;
+    prefixes.push_back(prefix);
+  }
+
+  // Start walking at the deepest cached directory on the path instead of the root directory
+  size_t numResolved = prefixes.size();
+  optional<DentryCache::Entry> deepestCached = none;
+  for (; numResolved > 0; --numResolved) {
+    deepestCached = _dentryCache.lookup(prefixes[numResolved - 1]);
+    if (deepestCached != none) {
+      break;
+    }
+  }
+
   optional<unique_ref<DirBlobRef>> parentBlob = none;
-  optional<unique_ref<FsBlobRef>> currentBlobOpt = _fsBlobStore->load(_rootKey);
-  if (currentBlobOpt == none) {
-    LOG(ERROR, "Could not load root blob. Is the base directory accessible?");
-    throw FuseErrnoException(EIO);
+  unique_ref<FsBlobRef> currentBlob = [this, &deepestCached] {
+    if (deepestCached == none) {
+      optional<unique_ref<FsBlobRef>> root = _fsBlobStore->load(_rootKey);
+      if (root == none) {
+        LOG(ERROR, "Could not load root blob. Is the base directory accessible?");
+        throw FuseErrnoException(EIO);
+      }
+      return std::move(*root);
+    }
+    return LoadBlobOfPath(deepestCached->key);
+  }();
+  if (deepestCached != none && numResolved == prefixes.size()) {
+    auto parent = LoadBlobOfPath(deepestCached->parentKey);
+    auto parentDir = dynamic_pointer_move<DirBlobRef>(parent);
+    if (parentDir == none) {
+      throw FuseErrnoException(ENOTDIR);
+    }
+    parentBlob = std::move(*parentDir);
   }
-  unique_ref<FsBlobRef> currentBlob = std::move(*currentBlobOpt);
 
-  for (const bf::path &component : path.relative_path()) {
+  for (size_t i = numResolved; i < prefixes.size(); ++i) {
     auto currentDir = dynamic_pointer_move<DirBlobRef>(currentBlob);
     if (currentDir == none) {
       throw FuseErrnoException(ENOTDIR); // Path component is not a dir
     }
 
-    auto childOpt = (*currentDir)->GetChild(component.c_str());
+    auto childOpt = (*currentDir)->GetChild(prefixes[i].filename().c_str());
     if (childOpt == boost::none) {
       throw FuseErrnoException(ENOENT); // Child entry in directory not found
     }
     Key childKey = childOpt->key();
-    auto nextBlob = _fsBlobStore->load(childKey);
-    if (nextBlob == none) {
-      throw FuseErrnoException(ENOENT); // Blob for directory entry not found
-    }
+    _dentryCache.insert(prefixes[i], DentryCache::Entry{childKey, (*currentDir)->key(), childOpt->type()}, cacheGeneration);
+    currentBlob = LoadBlobOfPath(childKey);
     parentBlob = std::move(*currentDir);
-    currentBlob = std::move(*nextBlob);
   }
 
   return BlobWithParent{std::move(currentBlob), std::move(parentBlob)};
@@ -208,6 +315,23 @@ unique_ref<SymlinkBlobRef> CryDevice::CreateSymlinkBlob(const bf::path &target)
   return _fsBlobStore->createSymlinkBlob(target);
 }
 
+unique_ref<FsBlobRef> CryDevice::LoadBlobOfPath(const blockstore::Key &key) {
+  auto blob = _fsBlobStore->load(key);
+  if (blob == none) {
+    throw FuseErrnoException(ENOENT); // Blob for directory entry not found
+  }
+  return std::move(*blob);
+}
+
+unique_ref<DirBlobRef> CryDevice::LoadDirBlobOfPath(const blockstore::Key &key) {
+  auto blob = LoadBlobOfPath(key);
+  auto dir = dynamic_pointer_move<DirBlobRef>(blob);
+  if (dir == none) {
+    throw FuseErrnoException(ENOTDIR);
+  }
+  return std::move(*dir);
+}
+
 unique_ref<FsBlobRef> CryDevice::LoadBlob(const blockstore::Key &key) {
   auto blob = _fsBlobStore->load(key);
   if (blob == none) {
@@ -218,6 +342,7 @@ unique_ref<FsBlobRef> CryDevice::LoadBlob(const blockstore::Key &key) {
 }
 
 void CryDevice::RemoveBlob(const blockstore::Key &key) {
+  _dentryCache.invalidate(key);
   auto blob = _fsBlobStore->load(key);
   if (blob == none) {
     LOG(ERROR, "Could not load blob. Is the base directory accessible?", key.ToString());
@@ -226,6 +351,10 @@ void CryDevice::RemoveBlob(const blockstore::Key &key) {
   _fsBlobStore->remove(std::move(*blob));
 }
 
+void CryDevice::InvalidateCachedPath(const blockstore::Key &key) {
+  _dentryCache.invalidate(key);
+}
+
 Key CryDevice::GetOrCreateRootKey(CryConfigFile *configFile) {
   string root_key = configFile->config()->RootBlob();
   if (root_key == "") {
@@ -257,4 +386,8 @@ uint64_t CryDevice::numBlocks() const {
   return _fsBlobStore->numBlocks();
 }
 
+void CryDevice::waitForPendingWrites() const {
+  _fsBlobStore->waitForPendingWrites();
+}
+
 }
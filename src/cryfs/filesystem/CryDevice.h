@@ -3,10 +3,14 @@
 #define MESSMER_CRYFS_FILESYSTEM_CRYDEVICE_H_
 
 #include <blockstore/interface/BlockStore.h>
+#include <blockstore/implementations/caching/CachingBlockStore.h>
 #include "../config/CryConfigFile.h"
+#include "DentryCache.h"
 
 #include <boost/filesystem.hpp>
 #include <fspp/fs_interface/Device.h>
+#include <cpp-utils/thread/WorkerPool.h>
+#include <mutex>
 
 #include "parallelaccessfsblobstore/ParallelAccessFsBlobStore.h"
 #include "parallelaccessfsblobstore/DirBlobRef.h"
@@ -17,7 +21,15 @@ namespace cryfs {
 
 class CryDevice final: public fspp::Device {
 public:
-  CryDevice(CryConfigFile config, cpputils::unique_ref<blockstore::BlockStore> blockStore);
+  static constexpr uint64_t DEFAULT_CACHE_SIZE_BYTES = blockstore::caching::CachingBlockStore::DEFAULT_MAX_CACHE_SIZE_BYTES;
+  // Sequential reads of a file prefetch up to this many bytes ahead (see ReadAhead), but at most an eighth of the cache size,
+  // so the prefetched blocks fit into the part of the cache for new blocks together with the blocks read right now.
+  static constexpr uint64_t MAX_READ_AHEAD_BYTES = 4 * 1024 * 1024;
+  // A cached path takes about 200 bytes, so this is about 20MB
+  static constexpr uint32_t DEFAULT_MAX_CACHED_PATHS = 100000;
+
+  // cacheSizeBytes is the memory budget for cached blocks, maxCachedPaths the number of paths in the DentryCache
+  CryDevice(CryConfigFile config, cpputils::unique_ref<blockstore::BlockStore> blockStore, uint64_t cacheSizeBytes = DEFAULT_CACHE_SIZE_BYTES, uint32_t maxCachedPaths = DEFAULT_MAX_CACHED_PATHS);
 
   void statfs(const boost::filesystem::path &path, struct ::statvfs *fsstat) override;
 
@@ -31,6 +43,8 @@ public:
   };
   DirBlobWithParent LoadDirBlobWithParent(const boost::filesystem::path &path);
   void RemoveBlob(const blockstore::Key &key);
+  // Call this after a node was moved, so paths to it and below it aren't resolved from the cache anymore
+  void InvalidateCachedPath(const blockstore::Key &key);
 
   void onFsAction(std::function<void()> callback);
 
@@ -38,16 +52,31 @@ public:
   boost::optional<cpputils::unique_ref<fspp::File>> LoadFile(const boost::filesystem::path &path) override;
   boost::optional<cpputils::unique_ref<fspp::Dir>> LoadDir(const boost::filesystem::path &path) override;
   boost::optional<cpputils::unique_ref<fspp::Symlink>> LoadSymlink(const boost::filesystem::path &path) override;
+  boost::optional<cpputils::unique_ref<fspp::Node>> LoadById(const std::vector<NodeId> &ids) override;
+  boost::optional<NodeId> LookupChildId(const std::vector<NodeId> &dirIds, const std::string &name) override;
+  boost::optional<NodeId> StatChild(const std::vector<NodeId> &dirIds, const std::string &name, struct ::stat *result) override;
 
   void callFsActionCallbacks() const;
 
   uint64_t numBlocks() const;
+  // Waits until blocks that are written in the background reached the disk, and throws if that failed
+  void waitForPendingWrites() const;
+
+  // Worker threads shared by all open files to prefetch data for sequential reads
+  cpputils::WorkerPool *readAheadWorkers() const;
+  uint64_t maxReadAheadBytes() const;
 
 private:
 
   cpputils::unique_ref<parallelaccessfsblobstore::ParallelAccessFsBlobStore> _fsBlobStore;
+  const uint64_t _maxReadAheadBytes;
+  // The threads are only started when the first file is opened.
+  // Declared after _fsBlobStore, so running prefetches finish before the blob store is destructed.
+  mutable std::once_flag _readAheadWorkersStarted;
+  mutable std::unique_ptr<cpputils::WorkerPool> _readAheadWorkers;
 
   blockstore::Key _rootKey;
+  DentryCache _dentryCache;
   std::vector<std::function<void()>> _onFsAction;
 
   blockstore::Key GetOrCreateRootKey(CryConfigFile *config);
@@ -59,6 +88,9 @@ private:
       boost::optional<cpputils::unique_ref<parallelaccessfsblobstore::DirBlobRef>> parent;
   };
   BlobWithParent LoadBlobWithParent(const boost::filesystem::path &path);
+  cpputils::unique_ref<parallelaccessfsblobstore::FsBlobRef> LoadBlobOfPath(const blockstore::Key &key);
+  cpputils::unique_ref<parallelaccessfsblobstore::DirBlobRef> LoadDirBlobOfPath(const blockstore::Key &key);
+  cpputils::unique_ref<fspp::Node> CreateNode(fspp::Dir::EntryType type, cpputils::unique_ref<parallelaccessfsblobstore::DirBlobRef> parent, boost::optional<cpputils::unique_ref<parallelaccessfsblobstore::DirBlobRef>> grandparent, const blockstore::Key &key);
 
   DISALLOW_COPY_AND_ASSIGN(CryDevice);
 };
@@ -102,6 +102,7 @@ void CryNode::rename(const bf::path &to) {
     // targetDir is now the new parent for this node. Adapt to it, so we can call further operations on this node object.
     _parent = cpputils::to_unique_ptr(std::move(targetDir));
   }
+  _device->InvalidateCachedPath(_key);
 }
 
 void CryNode::_updateParentModificationTimestamp() {
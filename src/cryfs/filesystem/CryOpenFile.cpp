@@ -20,7 +20,10 @@ using fspp::fuse::FuseErrnoException;
 namespace cryfs {
 
 CryOpenFile::CryOpenFile(const CryDevice *device, shared_ptr<DirBlobRef> parent, unique_ref<FileBlobRef> fileBlob)
-: _device(device), _parent(parent), _fileBlob(std::move(fileBlob)) {
+: _device(device), _parent(parent), _fileBlob(std::move(fileBlob)),
+  _readAhead(device->readAheadWorkers(), [this] (uint64_t offset, uint64_t count) {
+    _fileBlob->prefetch(offset, count);
+  }, device->maxReadAheadBytes()) {
 }
 
 CryOpenFile::~CryOpenFile() {
@@ -31,6 +34,8 @@ void CryOpenFile::flush() {
   _device->callFsActionCallbacks();
   _fileBlob->flush();
   _parent->flush();
+  // Blocks that were evicted from the cache are written in the background. Report if writing them failed.
+  _device->waitForPendingWrites();
 }
 
 void CryOpenFile::stat(struct ::stat *result) const {
@@ -48,6 +53,7 @@ void CryOpenFile::truncate(off_t size) const {
 size_t CryOpenFile::read(void *buf, size_t count, off_t offset) const {
   _device->callFsActionCallbacks();
   _parent->updateAccessTimestampForChild(_fileBlob->key());
+  _readAhead.onRead(offset, count);
   return _fileBlob->read(buf, offset, count);
 }
 
@@ -61,11 +67,13 @@ void CryOpenFile::fsync() {
   _device->callFsActionCallbacks();
   _fileBlob->flush();
   _parent->flush();
+  _device->waitForPendingWrites();
 }
 
 void CryOpenFile::fdatasync() {
   _device->callFsActionCallbacks();
   _fileBlob->flush();
+  _device->waitForPendingWrites();
 }
 
 }
@@ -5,6 +5,7 @@
 #include <fspp/fs_interface/OpenFile.h>
 #include "parallelaccessfsblobstore/FileBlobRef.h"
 #include "parallelaccessfsblobstore/DirBlobRef.h"
+#include "ReadAhead.h"
 
 namespace cryfs {
 class CryDevice;
@@ -26,6 +27,8 @@ private:
   const CryDevice *_device;
   std::shared_ptr<parallelaccessfsblobstore::DirBlobRef> _parent;
   cpputils::unique_ref<parallelaccessfsblobstore::FileBlobRef> _fileBlob;
+  // Declared after _fileBlob, so it is destructed first and waits for prefetches accessing the file
+  mutable ReadAhead _readAhead;
 
   DISALLOW_COPY_AND_ASSIGN(CryOpenFile);
 };
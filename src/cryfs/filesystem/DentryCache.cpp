@@ -0,0 +1,123 @@
+#include "DentryCache.h"
+
+using std::string;
+using std::unique_lock;
+using std::mutex;
+using boost::optional;
+using boost::none;
+using blockstore::Key;
+
+namespace bf = boost::filesystem;
+
+namespace cryfs {
+
+DentryCache::DentryCache(uint32_t maxEntries)
+  : _maxEntries(maxEntries), _mutex(), _paths(), _lru(), _pathByKey(), _generation(0) {
+}
+
+optional<DentryCache::Entry> DentryCache::lookup(const bf::path &path) {
+  unique_lock<mutex> lock(_mutex);
+  auto found = _paths.find(path.string());
+  if (found == _paths.end()) {
+    return none;
+  }
+  _touch(&found->second);
+  _touchAncestors(found->first);
+  return found->second.entry;
+}
+
+uint64_t DentryCache::generation() const {
+  unique_lock<mutex> lock(_mutex);
+  return _generation;
+}
+
+void DentryCache::insert(const bf::path &path, const Entry &entry, uint64_t generation) {
+  unique_lock<mutex> lock(_mutex);
+  if (_maxEntries == 0 || generation != _generation) {
+    return;
+  }
+  string pathStr = path.string();
+  // Only cache paths whose parent is cached, so invalidating a directory always finds the paths below it
+  string parentPath = pathStr.substr(0, pathStr.rfind('/'));
+  if (!parentPath.empty()) {
+    auto parent = _paths.find(parentPath);
+    if (parent == _paths.end() || parent->second.entry.key != entry.parentKey) {
+      return;
+    }
+  }
+  auto previousPathOfKey = _pathByKey.find(entry.key);
+  if (previousPathOfKey != _pathByKey.end() && previousPathOfKey->second != pathStr) {
+    _removeWithDescendants(previousPathOfKey->second);
+  }
+  auto found = _paths.find(pathStr);
+  if (found != _paths.end()) {
+    if (found->second.entry.key == entry.key) {
+      found->second.entry = entry;
+      _touch(&found->second);
+      _touchAncestors(pathStr);
+      return;
+    }
+    _removeWithDescendants(pathStr);
+  }
+  _lru.push_front(pathStr);
+  _paths.emplace(pathStr, CachedPath{entry, _lru.begin()});
+  _pathByKey[entry.key] = pathStr;
+  _touchAncestors(pathStr);
+
+  while (_paths.size() > _maxEntries) {
+    // Ancestors are touched with their descendants, so this is usually a path without cached descendants
+    _removeWithDescendants(_lru.back());
+  }
+}
+
+void DentryCache::invalidate(const Key &key) {
+  unique_lock<mutex> lock(_mutex);
+  ++_generation;
+  auto found = _pathByKey.find(key);
+  if (found != _pathByKey.end()) {
+    _removeWithDescendants(found->second);
+  }
+}
+
+uint32_t DentryCache::size() const {
+  unique_lock<mutex> lock(_mutex);
+  return _paths.size();
+}
+
+void DentryCache::_touch(CachedPath *cached) {
+  _lru.splice(_lru.begin(), _lru, cached->lruPosition);
+}
+
+void DentryCache::_touchAncestors(const string &path) {
+  for (size_t separator = path.rfind('/'); separator != string::npos && separator > 0; separator = path.rfind('/', separator - 1)) {
+    auto ancestor = _paths.find(path.substr(0, separator));
+    if (ancestor != _paths.end()) {
+      _touch(&ancestor->second);
+    }
+  }
+}
+
+void DentryCache::_removeWithDescendants(const string &path) {
+  // path might be owned by one of the erased elements, so only the copy in prefix is used after erasing
+  string prefix = path + "/";
+  auto current = _paths.find(path);
+  if (current != _paths.end()) {
+    _remove(current);
+  }
+  // Paths like "/dir-a" are ordered between "/dir" and "/dir/a", so the descendants start at the prefix
+  current = _paths.lower_bound(prefix);
+  while (current != _paths.end() && 0 == current->first.compare(0, prefix.size(), prefix)) {
+    current = _remove(current);
+  }
+}
+
+std::map<string, DentryCache::CachedPath>::iterator DentryCache::_remove(std::map<string, CachedPath>::iterator cached) {
+  auto byKey = _pathByKey.find(cached->second.entry.key);
+  if (byKey != _pathByKey.end() && byKey->second == cached->first) {
+    _pathByKey.erase(byKey);
+  }
+  _lru.erase(cached->second.lruPosition);
+  return _paths.erase(cached);
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef MESSMER_CRYFS_FILESYSTEM_DENTRYCACHE_H_
+#define MESSMER_CRYFS_FILESYSTEM_DENTRYCACHE_H_
+
+#include <blockstore/utils/Key.h>
+#include <fspp/fs_interface/Dir.h>
+#include <cpp-utils/macros.h>
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace cryfs {
+
+// Remembers which blob the absolute paths of recently loaded nodes lead to, so CryDevice doesn't have to load
+// and search all directories along a path to find a node. The root directory isn't cached, it has a fixed key.
+//
+// When a node is renamed or removed, the paths of the node and of everything below it have to be invalidated.
+// Because a path can be resolved while it is invalidated, insert() takes the generation from before the path was
+// resolved, and doesn't insert anything if something was invalidated since.
+class DentryCache final {
+public:
+  struct Entry final {
+    blockstore::Key key;
+    blockstore::Key parentKey;
+    fspp::Dir::EntryType type;
+  };
+
+  // If more paths are cached, the least recently used ones are dropped. A maxEntries of zero disables the cache.
+  explicit DentryCache(uint32_t maxEntries);
+
+  boost::optional<Entry> lookup(const boost::filesystem::path &path);
+
+  uint64_t generation() const;
+  void insert(const boost::filesystem::path &path, const Entry &entry, uint64_t generation);
+
+  // Removes the path of the node with this key and the paths of all nodes below it
+  void invalidate(const blockstore::Key &key);
+
+  uint32_t size() const;
+
+private:
+  struct CachedPath final {
+    Entry entry;
+    std::list<std::string>::iterator lruPosition;
+  };
+
+  void _touch(CachedPath *cached);
+  void _touchAncestors(const std::string &path);
+  void _removeWithDescendants(const std::string &path);
+  std::map<std::string, CachedPath>::iterator _remove(std::map<std::string, CachedPath>::iterator cached);
+
+  const uint32_t _maxEntries;
+  mutable std::mutex _mutex;
+  // Ordered, so the paths below a directory are next to each other
+  std::map<std::string, CachedPath> _paths;
+  // Most recently used path first
+  std::list<std::string> _lru;
+  // CryFS doesn't support hard links, so each key has at most one path
+  std::unordered_map<blockstore::Key, std::string> _pathByKey;
+  uint64_t _generation;
+
+  DISALLOW_COPY_AND_ASSIGN(DentryCache);
+};
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "ReadAhead.h"
+#include <algorithm>
+
+using cpputils::WorkerPool;
+
+namespace cryfs {
+
+ReadAhead::ReadAhead(WorkerPool *workers, PrefetchFunction prefetch, uint64_t maxWindowSize)
+: _workers(workers), _prefetch(std::move(prefetch)), _maxWindowSize(maxWindowSize), _mutex(),
+  _nextSequentialOffset(0), _windowSize(0), _prefetchedUntil(0), _runningPrefetch() {
+}
+
+ReadAhead::~ReadAhead() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_runningPrefetch.valid()) {
+    _runningPrefetch.wait();
+  }
+}
+
+void ReadAhead::onRead(uint64_t offset, uint64_t count) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_maxWindowSize == 0 || count == 0) {
+    return;
+  }
+  uint64_t end = offset + count;
+  // Reading a file from its beginning counts as sequential
+  if (offset == _nextSequentialOffset) {
+    _windowSize = std::min(_maxWindowSize, std::max(2 * _windowSize, 2 * count));
+  } else {
+    _windowSize = 0;
+    _prefetchedUntil = 0;
+  }
+  _nextSequentialOffset = end;
+  if (_windowSize == 0) {
+    return;
+  }
+  // Only prefetch again once the reads consumed half of the prefetched data, so each prefetch covers many blocks
+  // that can be loaded in one batch. A prefetch that is still running isn't waited for, the reads don't block on it.
+  uint64_t lead = (_prefetchedUntil > end) ? (_prefetchedUntil - end) : 0;
+  if (lead >= _windowSize / 2) {
+    return;
+  }
+  if (_runningPrefetch.valid() && _runningPrefetch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return;
+  }
+  uint64_t prefetchBegin = end + lead;
+  uint64_t prefetchEnd = end + _windowSize;
+  _prefetchedUntil = prefetchEnd;
+  PrefetchFunction prefetch = _prefetch;
+  _runningPrefetch = _workers->schedule([prefetch, prefetchBegin, prefetchEnd] {
+    try {
+      prefetch(prefetchBegin, prefetchEnd - prefetchBegin);
+    } catch (...) {
+      // Prefetching is only an optimization. If the data can't be loaded, the read of it reports the error.
+    }
+  });
+}
+
+uint64_t ReadAhead::windowSize() const {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return _windowSize;
+}
+
+}
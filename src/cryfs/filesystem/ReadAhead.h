@@ -0,0 +1,47 @@
+#pragma once
+#ifndef MESSMER_CRYFS_FILESYSTEM_READAHEAD_H_
+#define MESSMER_CRYFS_FILESYSTEM_READAHEAD_H_
+
+#include <cpp-utils/macros.h>
+#include <cpp-utils/thread/WorkerPool.h>
+#include <functional>
+#include <future>
+#include <mutex>
+
+namespace cryfs {
+
+// Detects sequential reads of an open file and prefetches the data following them in the background,
+// so the next reads find their blocks already decrypted in the block cache.
+// Like the read-ahead of the kernel's page cache, the window starts at twice the size of the first sequential read
+// and doubles with each further sequential read, up to maxWindowSize. A read at another offset resets the window,
+// so random reads don't prefetch anything.
+class ReadAhead final {
+public:
+  using PrefetchFunction = std::function<void (uint64_t offset, uint64_t count)>;
+
+  // The prefetch function is called on the given workers. A maxWindowSize of zero disables read-ahead.
+  ReadAhead(cpputils::WorkerPool *workers, PrefetchFunction prefetch, uint64_t maxWindowSize);
+  // Waits for a running prefetch, because the prefetch function usually accesses the file
+  ~ReadAhead();
+
+  // Call this for each read before executing it, so the prefetch runs while the read is executed
+  void onRead(uint64_t offset, uint64_t count);
+
+  uint64_t windowSize() const;
+
+private:
+  cpputils::WorkerPool *_workers;
+  PrefetchFunction _prefetch;
+  const uint64_t _maxWindowSize;
+  mutable std::mutex _mutex;
+  uint64_t _nextSequentialOffset;
+  uint64_t _windowSize;
+  uint64_t _prefetchedUntil;
+  std::future<void> _runningPrefetch;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadAhead);
+};
+
+}
+
+#endif
@@ -4,7 +4,7 @@
 
 #include <cpp-utils/pointer/unique_ref.h>
 #include "../fsblobstore/FsBlobStore.h"
-#include <blockstore/implementations/caching/cache/Cache.h>
+#include <blockstore/implementations/caching/cache/ShardedCache.h>
 #include "FileBlobRef.h"
 #include "DirBlobRef.h"
 #include "SymlinkBlobRef.h"
@@ -27,6 +27,7 @@ namespace cryfs {
             uint64_t virtualBlocksizeBytes() const;
             uint64_t numBlocks() const;
             uint64_t estimateSpaceForNumBlocksLeft() const;
+            void waitForPendingWrites();
 
             void releaseForCache(cpputils::unique_ref<fsblobstore::FsBlob> baseBlob);
 
@@ -35,16 +36,19 @@ namespace cryfs {
 
             cpputils::unique_ref<fsblobstore::FsBlobStore> _baseBlobStore;
 
+            // A cached blob keeps its root block loaded, which isn't accounted for in the byte budget of the
+            // CachingBlockStore. Bounding this cache by the number of blobs keeps that overhead small.
+            static constexpr uint32_t MAX_CACHED_BLOBS = 50;
+
             //TODO Move Cache to some common location, not in blockstore
-            //TODO Use other cache config (i.e. smaller max number of entries) here than in blockstore
-            blockstore::caching::Cache<blockstore::Key, cpputils::unique_ref<fsblobstore::FsBlob>, 50> _cache;
+            blockstore::caching::ShardedCache<blockstore::Key, cpputils::unique_ref<fsblobstore::FsBlob>, 5> _cache;
 
             DISALLOW_COPY_AND_ASSIGN(CachingFsBlobStore);
         };
 
 
         inline CachingFsBlobStore::CachingFsBlobStore(cpputils::unique_ref<fsblobstore::FsBlobStore> baseBlobStore)
-                : _baseBlobStore(std::move(baseBlobStore)), _cache() {
+                : _baseBlobStore(std::move(baseBlobStore)), _cache(MAX_CACHED_BLOBS) {
         }
 
         inline CachingFsBlobStore::~CachingFsBlobStore() {
@@ -93,6 +97,10 @@ namespace cryfs {
             return _baseBlobStore->estimateSpaceForNumBlocksLeft();
         }
 
+        inline void CachingFsBlobStore::waitForPendingWrites() {
+            _baseBlobStore->waitForPendingWrites();
+        }
+
     }
 }
 
@@ -32,6 +32,10 @@ public:
         return _base->write(source, offset, count);
     }
 
+    void prefetch(uint64_t offset, uint64_t count) const {
+        return _base->prefetch(offset, count);
+    }
+
     void flush() {
         return _base->flush();
     }
@@ -44,6 +48,14 @@ public:
         return _base->lstat_size();
     }
 
+    boost::optional<off_t> seekData(off_t offset) const {
+        return _base->seekData(offset);
+    }
+
+    boost::optional<off_t> seekHole(off_t offset) const {
+        return _base->seekHole(offset);
+    }
+
 private:
 
     fsblobstore::FileBlob *_base;
@@ -52,9 +52,11 @@ unique_ref<DirBlob> DirBlob::InitializeEmptyDir(FsBlobStore *fsBlobStore, unique
 
 void DirBlob::_writeEntriesToBlob() {
   if (_changed) {
-    Data serialized = _entries.serialize();
-    baseBlob().resize(serialized.size());
-    baseBlob().write(serialized.data(), 0, serialized.size());
+    // Only rewrites the pages of large directories that changed
+    baseBlob().resize(_entries.serializedSize());
+    _entries.serializeChanges([this] (uint64_t offset, const Data &data) {
+      baseBlob().write(data.data(), offset, data.size());
+    });
     _changed = false;
   }
 }
@@ -135,7 +137,16 @@ off_t DirBlob::lstat_size() const {
 }
 
 void DirBlob::statChild(const Key &key, struct ::stat *result) const {
-  result->st_size = _getLstatSize(key);
+  auto childOpt = GetChild(key);
+  if (childOpt == boost::none) {
+    throw fspp::fuse::FuseErrnoException(ENOENT);
+  }
+  // All directories have the same size, so their blobs don't have to be loaded for it
+  if (childOpt->type() == fspp::Dir::EntryType::DIR) {
+    result->st_size = DIR_LSTAT_SIZE;
+  } else {
+    result->st_size = _getLstatSize(key);
+  }
   statChildWithSizeAlreadySet(key, result);
 }
 
@@ -29,6 +29,10 @@ void FileBlob::write(const void *source, uint64_t offset, uint64_t count) {
   baseBlob().write(source, offset, count);
 }
 
+void FileBlob::prefetch(uint64_t offset, uint64_t count) const {
+  baseBlob().prefetch(offset, count);
+}
+
 void FileBlob::flush() {
   baseBlob().flush();
 }
@@ -45,6 +49,22 @@ off_t FileBlob::size() const {
   return baseBlob().size();
 }
 
+boost::optional<off_t> FileBlob::seekData(off_t offset) const {
+  auto result = baseBlob().seekData(offset);
+  if (result == boost::none) {
+    return boost::none;
+  }
+  return static_cast<off_t>(*result);
+}
+
+boost::optional<off_t> FileBlob::seekHole(off_t offset) const {
+  auto result = baseBlob().seekHole(offset);
+  if (result == boost::none) {
+    return boost::none;
+  }
+  return static_cast<off_t>(*result);
+}
+
 }
 }
 
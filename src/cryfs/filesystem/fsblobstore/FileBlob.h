@@ -17,6 +17,9 @@ namespace cryfs {
 
             void write(const void *source, uint64_t offset, uint64_t count);
 
+            // See blobstore::Blob::prefetch()
+            void prefetch(uint64_t offset, uint64_t count) const;
+
             void flush();
 
             void resize(off_t size);
@@ -24,6 +27,10 @@ namespace cryfs {
             off_t lstat_size() const override;
 
             off_t size() const;
+
+            // Like lseek() with SEEK_DATA and SEEK_HOLE, see blobstore::Blob::seekData()
+            boost::optional<off_t> seekData(off_t offset) const;
+            boost::optional<off_t> seekHole(off_t offset) const;
         private:
             DISALLOW_COPY_AND_ASSIGN(FileBlob);
         };
@@ -24,6 +24,7 @@ namespace cryfs {
             void remove(cpputils::unique_ref<FsBlob> blob);
             uint64_t numBlocks() const;
             uint64_t estimateSpaceForNumBlocksLeft() const;
+            void waitForPendingWrites();
 
             uint64_t virtualBlocksizeBytes() const;
 
@@ -63,6 +64,10 @@ namespace cryfs {
             return _baseBlobStore->estimateSpaceForNumBlocksLeft();
         }
 
+        inline void FsBlobStore::waitForPendingWrites() {
+            _baseBlobStore->waitForPendingWrites();
+        }
+
         inline void FsBlobStore::remove(cpputils::unique_ref<FsBlob> blob) {
             _baseBlobStore->remove(blob->releaseBaseBlob());
         }
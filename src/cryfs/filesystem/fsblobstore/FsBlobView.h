@@ -51,10 +51,9 @@ namespace cryfs {
 
         cpputils::Data readAll() const override {
             cpputils::Data data = _baseBlob->readAll();
-            cpputils::Data dataWithoutHeader(data.size() - sizeof(FORMAT_VERSION_HEADER) - 1);
-            //Can we avoid this memcpy? Maybe by having Data::subdata() that returns a reference to the same memory region? Should we?
-            std::memcpy(dataWithoutHeader.data(), data.dataOffset(sizeof(FORMAT_VERSION_HEADER) + 1), dataWithoutHeader.size());
-            return dataWithoutHeader;
+            // Stripping the header doesn't copy the data, it only moves the begin of the data behind it
+            data.shrinkFront(sizeof(FORMAT_VERSION_HEADER) + 1);
+            return data;
         }
 
         void read(void *target, uint64_t offset, uint64_t size) const override {
@@ -69,6 +68,18 @@ namespace cryfs {
             return _baseBlob->write(source, offset + sizeof(FORMAT_VERSION_HEADER) + 1, size);
         }
 
+        void prefetch(uint64_t offset, uint64_t size) const override {
+            return _baseBlob->prefetch(offset + sizeof(FORMAT_VERSION_HEADER) + 1, size);
+        }
+
+        boost::optional<uint64_t> seekData(uint64_t offset) const override {
+            return _withoutHeader(_baseBlob->seekData(offset + sizeof(FORMAT_VERSION_HEADER) + 1));
+        }
+
+        boost::optional<uint64_t> seekHole(uint64_t offset) const override {
+            return _withoutHeader(_baseBlob->seekHole(offset + sizeof(FORMAT_VERSION_HEADER) + 1));
+        }
+
         void flush() override {
             return _baseBlob->flush();
         }
@@ -89,6 +100,13 @@ namespace cryfs {
             }
         }
 
+        static boost::optional<uint64_t> _withoutHeader(boost::optional<uint64_t> offset) {
+            if (offset == boost::none) {
+                return boost::none;
+            }
+            return *offset - sizeof(FORMAT_VERSION_HEADER) - 1;
+        }
+
         static BlobType _blobType(const blobstore::Blob &blob) {
             uint8_t result;
             blob.read(&result, sizeof(FORMAT_VERSION_HEADER), 1);
@@ -1,5 +1,8 @@
 #include "DirEntryList.h"
+#include <algorithm>
+#include <cstring>
 #include <limits>
+#include <stdexcept>
 #include <cpp-utils/system/time.h>
 
 //TODO Get rid of that in favor of better error handling
@@ -8,44 +11,224 @@
 using cpputils::Data;
 using std::string;
 using std::vector;
+using boost::optional;
+using boost::none;
 using blockstore::Key;
 
 namespace cryfs {
 namespace fsblobstore {
 
-DirEntryList::DirEntryList() : _entries() {
+constexpr uint32_t DirEntryList::PAGE_SIZE;
+
+namespace {
+// The flat format starts with the type of the first entry, which is never this value.
+constexpr uint8_t PAGED_FORMAT_MARKER = 0xff;
+// Marker and page size
+constexpr uint64_t HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t);
+// Depth, prefix and number of entries
+constexpr uint64_t PAGE_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t);
+constexpr uint64_t PAGE_CAPACITY = DirEntryList::PAGE_SIZE - PAGE_HEADER_SIZE;
+// Keys are random, so this is only reached if the directory is corrupted
+constexpr uint8_t MAX_DEPTH = 24;
+
+// The first 64 bits of the key, with the first bit of the key as the most significant bit
+uint64_t keyBits(const Key &key) {
+    const uint8_t *data = static_cast<const uint8_t*>(key.data());
+    uint64_t result = 0;
+    for (unsigned int i = 0; i < sizeof(uint64_t); ++i) {
+        result = (result << 8) | data[i];
+    }
+    return result;
+}
+
+uint64_t keyPrefix(const Key &key, uint8_t depth) {
+    return (depth == 0) ? 0 : keyBits(key) >> (64 - depth);
+}
+
+template<typename T>
+void serializeValue(uint8_t **dest, T value) {
+    std::memcpy(*dest, &value, sizeof(T));
+    *dest += sizeof(T);
+}
+
+template<typename T>
+T deserializeValue(const char **pos) {
+    T value;
+    std::memcpy(&value, *pos, sizeof(T));
+    *pos += sizeof(T);
+    return value;
+}
+}
+
+DirEntryList::Page::Page(uint8_t depth_, uint64_t prefix_)
+    : depth(depth_), prefix(prefix_), entries(), entriesSerializedSize(0), changed(false) {
+}
+
+DirEntryList::DirEntryList()
+    : _pages(), _pageIndex(), _depth(0), _isPaged(false), _changedPages(), _allPagesChanged(false), _size(0), _nameIndex() {
+    _pages.emplace_back(0, 0);
+    _buildPageIndex();
 }
 
 Data DirEntryList::serialize() const {
-    Data serialized(_serializedSize());
-    unsigned int offset = 0;
-    for (auto iter = _entries.begin(); iter != _entries.end(); ++iter) {
-        ASSERT(iter == _entries.begin() || std::less<Key>()((iter-1)->key(), iter->key()), "Invariant hurt: Directory entries should be ordered by key and not have duplicate keys.");
-        iter->serialize(static_cast<uint8_t*>(serialized.dataOffset(offset)));
-        offset += iter->serializedSize();
+    Data serialized(serializedSize());
+    if (!_isPaged) {
+        _serializeFlat(static_cast<uint8_t*>(serialized.data()));
+        return serialized;
+    }
+    serialized.FillWithZeroes();
+    uint8_t *header = static_cast<uint8_t*>(serialized.data());
+    serializeValue<uint8_t>(&header, PAGED_FORMAT_MARKER);
+    serializeValue<uint32_t>(&header, PAGE_SIZE);
+    for (size_t i = 0; i < _pages.size(); ++i) {
+        _serializePage(_pages[i], static_cast<uint8_t*>(serialized.dataOffset(HEADER_SIZE + i * PAGE_SIZE)));
     }
     return serialized;
 }
 
-uint64_t DirEntryList::_serializedSize() const {
-    uint64_t serializedSize = 0;
-    for (const auto &entry : _entries) {
-        serializedSize += entry.serializedSize();
+uint64_t DirEntryList::serializedSize() const {
+    if (!_isPaged) {
+        return _pages[0].entriesSerializedSize;
+    }
+    return HEADER_SIZE + _pages.size() * PAGE_SIZE;
+}
+
+void DirEntryList::serializeChanges(std::function<void (uint64_t offset, const Data &data)> write) {
+    if (!_isPaged || _allPagesChanged) {
+        write(0, serialize());
+    } else {
+        for (size_t pageIndex : _changedPages) {
+            Data page(PAGE_SIZE);
+            page.FillWithZeroes();
+            _serializePage(_pages[pageIndex], static_cast<uint8_t*>(page.data()));
+            write(HEADER_SIZE + pageIndex * PAGE_SIZE, page);
+        }
+    }
+    for (size_t pageIndex : _changedPages) {
+        _pages[pageIndex].changed = false;
+    }
+    _changedPages.clear();
+    _allPagesChanged = false;
+}
+
+void DirEntryList::_serializeFlat(uint8_t *dest) const {
+    const vector<DirEntry> &entries = _pages[0].entries;
+    for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
+        ASSERT(iter == entries.begin() || std::less<Key>()((iter-1)->key(), iter->key()), "Invariant hurt: Directory entries should be ordered by key and not have duplicate keys.");
+        iter->serialize(dest);
+        dest += iter->serializedSize();
+    }
+}
+
+void DirEntryList::_serializePage(const Page &page, uint8_t *dest) const {
+    ASSERT(page.entriesSerializedSize <= PAGE_CAPACITY, "Page overflow");
+    serializeValue<uint8_t>(&dest, page.depth);
+    serializeValue<uint64_t>(&dest, page.prefix);
+    serializeValue<uint32_t>(&dest, page.entries.size());
+    for (const auto &entry : page.entries) {
+        entry.serialize(dest);
+        dest += entry.serializedSize();
     }
-    return serializedSize;
 }
 
 void DirEntryList::deserializeFrom(const void *data, uint64_t size) {
-    _entries.clear();
+    _pages.clear();
+    _changedPages.clear();
+    _allPagesChanged = false;
+    _size = 0;
     const char *pos = static_cast<const char*>(data);
-    while (pos < static_cast<const char*>(data) + size) {
-        pos = DirEntry::deserializeAndAddToVector(pos, &_entries);
-        ASSERT(_entries.size() == 1 || std::less<Key>()(_entries[_entries.size()-2].key(), _entries[_entries.size()-1].key()), "Invariant hurt: Directory entries should be ordered by key and not have duplicate keys.");
+    if (size > 0 && static_cast<uint8_t>(*pos) == PAGED_FORMAT_MARKER) {
+        _deserializePages(pos, size);
+    } else {
+        _deserializeFlat(pos, size);
+    }
+    _buildPageIndex();
+    _rebuildNameIndex();
+}
+
+void DirEntryList::_deserializeFlat(const char *data, uint64_t size) {
+    _isPaged = false;
+    _pages.emplace_back(0, 0);
+    Page &page = _pages.back();
+    const char *pos = data;
+    while (pos < data + size) {
+        pos = DirEntry::deserializeAndAddToVector(pos, &page.entries);
+        ASSERT(page.entries.size() == 1 || std::less<Key>()(page.entries[page.entries.size()-2].key(), page.entries[page.entries.size()-1].key()), "Invariant hurt: Directory entries should be ordered by key and not have duplicate keys.");
+        page.entriesSerializedSize += page.entries.back().serializedSize();
+    }
+    _size = page.entries.size();
+}
+
+void DirEntryList::_deserializePages(const char *data, uint64_t size) {
+    _isPaged = true;
+    if (size < HEADER_SIZE) {
+        throw std::runtime_error("Directory has an unsupported page size");
+    }
+    const char *pos = data + sizeof(uint8_t);
+    uint32_t pageSize = deserializeValue<uint32_t>(&pos);
+    if (pageSize != PAGE_SIZE || (size - HEADER_SIZE) % PAGE_SIZE != 0) {
+        throw std::runtime_error("Directory has an unsupported page size");
+    }
+    uint64_t numPages = (size - HEADER_SIZE) / PAGE_SIZE;
+    _pages.reserve(numPages);
+    for (uint64_t i = 0; i < numPages; ++i) {
+        pos = data + HEADER_SIZE + i * PAGE_SIZE;
+        uint8_t depth = deserializeValue<uint8_t>(&pos);
+        uint64_t prefix = deserializeValue<uint64_t>(&pos);
+        uint32_t numEntries = deserializeValue<uint32_t>(&pos);
+        if (depth > MAX_DEPTH) {
+            throw std::runtime_error("Directory page is corrupted");
+        }
+        _pages.emplace_back(depth, prefix);
+        Page &page = _pages.back();
+        for (uint32_t j = 0; j < numEntries; ++j) {
+            pos = DirEntry::deserializeAndAddToVector(pos, &page.entries);
+            ASSERT(page.entries.size() == 1 || std::less<Key>()(page.entries[page.entries.size()-2].key(), page.entries[page.entries.size()-1].key()), "Invariant hurt: Directory entries should be ordered by key and not have duplicate keys.");
+            if (keyPrefix(page.entries.back().key(), depth) != prefix) {
+                throw std::runtime_error("Directory page contains an entry that doesn't belong there");
+            }
+            page.entriesSerializedSize += page.entries.back().serializedSize();
+        }
+        if (page.entriesSerializedSize > PAGE_CAPACITY) {
+            throw std::runtime_error("Directory page is corrupted");
+        }
+        _size += numEntries;
+    }
+}
+
+void DirEntryList::_buildPageIndex() {
+    _depth = 0;
+    for (const auto &page : _pages) {
+        _depth = std::max(_depth, page.depth);
+    }
+    constexpr uint32_t NO_PAGE = std::numeric_limits<uint32_t>::max();
+    _pageIndex.assign(static_cast<size_t>(1) << _depth, NO_PAGE);
+    for (uint32_t pageIndex = 0; pageIndex < _pages.size(); ++pageIndex) {
+        const Page &page = _pages[pageIndex];
+        uint8_t shift = _depth - page.depth;
+        for (uint64_t slot = page.prefix << shift; slot < (page.prefix + 1) << shift; ++slot) {
+            if (slot >= _pageIndex.size() || _pageIndex[slot] != NO_PAGE) {
+                throw std::runtime_error("Directory pages are corrupted");
+            }
+            _pageIndex[slot] = pageIndex;
+        }
+    }
+    if (std::find(_pageIndex.begin(), _pageIndex.end(), NO_PAGE) != _pageIndex.end()) {
+        throw std::runtime_error("Directory pages are corrupted");
+    }
+}
+
+void DirEntryList::_rebuildNameIndex() {
+    _nameIndex.clear();
+    for (const auto &page : _pages) {
+        for (const auto &entry : page.entries) {
+            _nameIndex.add(entry.name(), entry.key());
+        }
     }
 }
 
 bool DirEntryList::_hasChild(const string &name) const {
-    return _entries.end() != _findByName(name);
+    return none != const_cast<DirEntryList*>(this)->_findByName(name);
 }
 
 void DirEntryList::add(const string &name, const Key &blobKey, fspp::Dir::EntryType entryType, mode_t mode,
@@ -58,17 +241,36 @@ void DirEntryList::add(const string &name, const Key &blobKey, fspp::Dir::EntryT
 
 void DirEntryList::_add(const string &name, const Key &blobKey, fspp::Dir::EntryType entryType, mode_t mode,
                        uid_t uid, gid_t gid, timespec lastAccessTime, timespec lastModificationTime) {
-    auto insert_pos = _findUpperBound(blobKey);
-    _entries.emplace(insert_pos, entryType, name, blobKey, mode, uid, gid, lastAccessTime, lastModificationTime, cpputils::time::now());
+    size_t pageIndex = _findPage(blobKey);
+    Page *page = &_pages[pageIndex];
+    auto insert_pos = _findUpperBound(page, blobKey);
+    auto inserted = page->entries.emplace(insert_pos, entryType, name, blobKey, mode, uid, gid, lastAccessTime, lastModificationTime, cpputils::time::now());
+    if (inserted->serializedSize() > PAGE_CAPACITY) {
+        page->entries.erase(inserted);
+        throw fspp::fuse::FuseErrnoException(ENAMETOOLONG);
+    }
+    page->entriesSerializedSize += inserted->serializedSize();
+    ++_size;
+    _nameIndex.add(name, blobKey);
+    _pageChanged(pageIndex);
+}
+
+void DirEntryList::_erase(Position entry) {
+    Page *page = &_pages[entry.page];
+    _nameIndex.remove(entry.entry->name(), entry.entry->key());
+    page->entriesSerializedSize -= entry.entry->serializedSize();
+    page->entries.erase(entry.entry);
+    --_size;
+    _pageChanged(entry.page);
 }
 
 void DirEntryList::addOrOverwrite(const string &name, const Key &blobKey, fspp::Dir::EntryType entryType, mode_t mode,
                        uid_t uid, gid_t gid, timespec lastAccessTime, timespec lastModificationTime,
                        std::function<void (const blockstore::Key &key)> onOverwritten) {
     auto found = _findByName(name);
-    if (found != _entries.end()) {
-        onOverwritten(found->key());
-        _overwrite(found, name, blobKey, entryType, mode, uid, gid, lastAccessTime, lastModificationTime);
+    if (found != none) {
+        onOverwritten(found->entry->key());
+        _overwrite(*found, name, blobKey, entryType, mode, uid, gid, lastAccessTime, lastModificationTime);
     } else {
         _add(name, blobKey, entryType, mode, uid, gid, lastAccessTime, lastModificationTime);
     }
@@ -76,13 +278,23 @@ void DirEntryList::addOrOverwrite(const string &name, const Key &blobKey, fspp::
 
 void DirEntryList::rename(const blockstore::Key &key, const std::string &name, std::function<void (const blockstore::Key &key)> onOverwritten) {
     auto foundSameName = _findByName(name);
-    if (foundSameName != _entries.end() && foundSameName->key() != key) {
-        _checkAllowedOverwrite(foundSameName->type(), _findByKey(key)->type());
-        onOverwritten(foundSameName->key());
-        _entries.erase(foundSameName);
+    if (foundSameName != none && foundSameName->entry->key() != key) {
+        _checkAllowedOverwrite(foundSameName->entry->type(), _findByKey(key).entry->type());
+        onOverwritten(foundSameName->entry->key());
+        _erase(*foundSameName);
     }
 
-    _findByKey(key)->setName(name);
+    auto found = _findByKey(key);
+    Page *page = &_pages[found.page];
+    uint64_t oldSerializedSize = found.entry->serializedSize();
+    if (oldSerializedSize - found.entry->name().size() + name.size() > PAGE_CAPACITY) {
+        throw fspp::fuse::FuseErrnoException(ENAMETOOLONG);
+    }
+    _nameIndex.remove(found.entry->name(), key);
+    found.entry->setName(name);
+    _nameIndex.add(name, key);
+    page->entriesSerializedSize = page->entriesSerializedSize - oldSerializedSize + found.entry->serializedSize();
+    _pageChanged(found.page);
 }
 
 void DirEntryList::_checkAllowedOverwrite(fspp::Dir::EntryType oldType, fspp::Dir::EntryType newType) {
@@ -98,145 +310,251 @@ void DirEntryList::_checkAllowedOverwrite(fspp::Dir::EntryType oldType, fspp::Di
     }
 }
 
-void DirEntryList::_overwrite(vector<DirEntry>::iterator entry, const string &name, const Key &blobKey, fspp::Dir::EntryType entryType, mode_t mode,
+void DirEntryList::_overwrite(Position entry, const string &name, const Key &blobKey, fspp::Dir::EntryType entryType, mode_t mode,
                         uid_t uid, gid_t gid, timespec lastAccessTime, timespec lastModificationTime) {
-    _checkAllowedOverwrite(entry->type(), entryType);
+    _checkAllowedOverwrite(entry.entry->type(), entryType);
     // The new entry has possibly a different key, so it has to be in a different list position (list is ordered by keys).
     // That's why we remove-and-add instead of just modifying the existing entry.
-    _entries.erase(entry);
+    _erase(entry);
     _add(name, blobKey, entryType, mode, uid, gid, lastAccessTime, lastModificationTime);
 }
 
 boost::optional<const DirEntry&> DirEntryList::get(const string &name) const {
-    auto found = _findByName(name);
-    if (found == _entries.end()) {
+    auto found = const_cast<DirEntryList*>(this)->_findByName(name);
+    if (found == none) {
         return boost::none;
     }
-    return *found;
+    return *found->entry;
 }
 
 boost::optional<const DirEntry&> DirEntryList::get(const Key &key) const {
-    auto found = _findByKey(key);
-    if (found == _entries.end()) {
-        return boost::none;
-    }
-    return *found;
+    return *const_cast<DirEntryList*>(this)->_findByKey(key).entry;
 }
 
 void DirEntryList::remove(const string &name) {
     auto found = _findByName(name);
-    if (found == _entries.end()) {
+    if (found == none) {
         throw fspp::fuse::FuseErrnoException(ENOENT);
     }
-    _entries.erase(found);
+    _erase(*found);
 }
 
 void DirEntryList::remove(const Key &key) {
-    auto lowerBound = _findLowerBound(key);
-    auto upperBound = std::find_if(lowerBound, _entries.end(), [&key] (const DirEntry &entry) {
+    size_t pageIndex = _findPage(key);
+    Page *page = &_pages[pageIndex];
+    auto lowerBound = _findLowerBound(page, key);
+    auto upperBound = std::find_if(lowerBound, page->entries.end(), [&key] (const DirEntry &entry) {
         return entry.key() != key;
     });
-    _entries.erase(lowerBound, upperBound);
+    for (auto entry = lowerBound; entry != upperBound; ++entry) {
+        _nameIndex.remove(entry->name(), entry->key());
+        page->entriesSerializedSize -= entry->serializedSize();
+        --_size;
+    }
+    page->entries.erase(lowerBound, upperBound);
+    _pageChanged(pageIndex);
+}
+
+optional<DirEntryList::Position> DirEntryList::_findByName(const string &name) {
+    optional<Position> found = none;
+    _nameIndex.find(name, [this, &name, &found] (const Key &key) {
+        size_t pageIndex = _findPage(key);
+        Page *page = &_pages[pageIndex];
+        for (auto entry = _findLowerBound(page, key); entry != page->entries.end() && entry->key() == key; ++entry) {
+            if (entry->name() == name) {
+                found = Position{pageIndex, entry};
+                return true;
+            }
+        }
+        return false;
+    });
+    return found;
 }
 
-vector<DirEntry>::iterator DirEntryList::_findByName(const string &name) {
-    return std::find_if(_entries.begin(), _entries.end(), [&name] (const DirEntry &entry) {
-        return entry.name() == name;
+DirEntryList::Position DirEntryList::_findByKey(const Key &key) {
+    size_t pageIndex = _findPage(key);
+    auto found = _findLowerBound(&_pages[pageIndex], key);
+    if (found == _pages[pageIndex].entries.end() || found->key() != key) {
+        throw fspp::fuse::FuseErrnoException(ENOENT);
+    }
+    return Position{pageIndex, found};
+}
+
+size_t DirEntryList::_findPage(const Key &key) const {
+    return _pageIndex[keyPrefix(key, _depth)];
+}
+
+vector<DirEntry>::iterator DirEntryList::_findLowerBound(Page *page, const Key &key) {
+    return std::lower_bound(page->entries.begin(), page->entries.end(), key, [] (const DirEntry &entry, const Key &value) {
+        return std::less<Key>()(entry.key(), value);
     });
 }
 
-vector<DirEntry>::const_iterator DirEntryList::_findByName(const string &name) const {
-    return const_cast<DirEntryList*>(this)->_findByName(name);
+vector<DirEntry>::iterator DirEntryList::_findUpperBound(Page *page, const Key &key) {
+    return std::upper_bound(page->entries.begin(), page->entries.end(), key, [] (const Key &value, const DirEntry &entry) {
+        return std::less<Key>()(value, entry.key());
+    });
 }
 
-vector<DirEntry>::iterator DirEntryList::_findByKey(const Key &key) {
-    auto found = _findLowerBound(key);
-    if (found == _entries.end() || found->key() != key) {
-        throw fspp::fuse::FuseErrnoException(ENOENT);
+void DirEntryList::_pageChanged(size_t pageIndex) {
+    _markChanged(pageIndex);
+    if (_pages[pageIndex].entriesSerializedSize > PAGE_CAPACITY) {
+        if (!_isPaged) {
+            // Convert from the flat format. The first write has to write all pages, because the blob still contains the flat format.
+            _isPaged = true;
+            _allPagesChanged = true;
+        }
+        _splitUntilFits(pageIndex);
     }
-    return found;
 }
 
-vector<DirEntry>::iterator DirEntryList::_findLowerBound(const Key &key) {
-    return _findFirst(key, [&key] (const DirEntry &entry) {
-        return !std::less<Key>()(entry.key(), key);
-    });
+void DirEntryList::_markChanged(size_t pageIndex) {
+    if (!_pages[pageIndex].changed) {
+        _pages[pageIndex].changed = true;
+        _changedPages.push_back(pageIndex);
+    }
 }
 
-vector<DirEntry>::iterator DirEntryList::_findUpperBound(const Key &key) {
-    return _findFirst(key, [&key] (const DirEntry &entry) {
-        return std::less<Key>()(key, entry.key());
-    });
+void DirEntryList::_splitUntilFits(size_t pageIndex) {
+    while (_pages[pageIndex].entriesSerializedSize > PAGE_CAPACITY) {
+        size_t newPageIndex = _split(pageIndex);
+        if (_pages[newPageIndex].entriesSerializedSize > PAGE_CAPACITY) {
+            _splitUntilFits(newPageIndex);
+        }
+    }
 }
 
-vector<DirEntry>::iterator DirEntryList::_findFirst(const Key &hint, std::function<bool (const DirEntry&)> pred) {
-    //TODO Factor out a datastructure that keeps a sorted std::vector and allows these _findLowerBound()/_findUpperBound operations using this hinted linear search
-    if (_entries.size() == 0) {
-        return _entries.end();
+size_t DirEntryList::_split(size_t pageIndex) {
+    uint8_t depth = _pages[pageIndex].depth;
+    if (depth >= MAX_DEPTH) {
+        throw std::runtime_error("Directory page can't be split anymore");
+    }
+    if (depth == _depth) {
+        _doublePageIndex();
     }
-    double startpos_percent = static_cast<double>(*static_cast<const unsigned char*>(hint.data())) / std::numeric_limits<unsigned char>::max();
-    auto iter = _entries.begin() + static_cast<int>(startpos_percent * (_entries.size()-1));
-    ASSERT(iter >= _entries.begin() && iter < _entries.end(), "Startpos out of range");
-    while(iter != _entries.begin() && pred(*iter)) {
-        --iter;
+    size_t newPageIndex = _pages.size();
+    _pages.emplace_back(depth + 1, (_pages[pageIndex].prefix << 1) | 1);
+    Page *page = &_pages[pageIndex];
+    Page *newPage = &_pages[newPageIndex];
+    // All entries of the page start with the same bits, so the entries whose next bit is set are at the end of the page.
+    auto moved = std::partition_point(page->entries.begin(), page->entries.end(), [depth] (const DirEntry &entry) {
+        return 0 == ((keyBits(entry.key()) >> (63 - depth)) & 1);
+    });
+    for (auto entry = moved; entry != page->entries.end(); ++entry) {
+        newPage->entriesSerializedSize += entry->serializedSize();
     }
-    while(iter != _entries.end() && !pred(*iter)) {
-        ++iter;
+    newPage->entries.assign(std::make_move_iterator(moved), std::make_move_iterator(page->entries.end()));
+    page->entries.erase(moved, page->entries.end());
+    page->entriesSerializedSize -= newPage->entriesSerializedSize;
+    page->depth = depth + 1;
+    page->prefix <<= 1;
+
+    uint8_t shift = _depth - newPage->depth;
+    for (uint64_t slot = newPage->prefix << shift; slot < (newPage->prefix + 1) << shift; ++slot) {
+        _pageIndex[slot] = newPageIndex;
     }
-    return iter;
+    _markChanged(pageIndex);
+    _markChanged(newPageIndex);
+    return newPageIndex;
 }
 
-vector<DirEntry>::const_iterator DirEntryList::_findByKey(const Key &key) const {
-    return const_cast<DirEntryList*>(this)->_findByKey(key);
+void DirEntryList::_doublePageIndex() {
+    vector<uint32_t> pageIndex(2 * _pageIndex.size());
+    for (size_t slot = 0; slot < pageIndex.size(); ++slot) {
+        pageIndex[slot] = _pageIndex[slot >> 1];
+    }
+    _pageIndex = std::move(pageIndex);
+    ++_depth;
 }
 
 size_t DirEntryList::size() const {
-    return _entries.size();
+    return _size;
 }
 
 DirEntryList::const_iterator DirEntryList::begin() const {
-    return _entries.begin();
+    return const_iterator(_pages.begin(), _pages.end());
 }
 
 DirEntryList::const_iterator DirEntryList::end() const {
-    return _entries.end();
+    return const_iterator(_pages.end(), _pages.end());
 }
 
 void DirEntryList::setMode(const Key &key, mode_t mode) {
     auto found = _findByKey(key);
-    ASSERT ((S_ISREG(mode) && S_ISREG(found->mode())) || (S_ISDIR(mode) && S_ISDIR(found->mode())) || (S_ISLNK(mode)), "Unknown mode in entry");
-    found->setMode(mode);
+    ASSERT ((S_ISREG(mode) && S_ISREG(found.entry->mode())) || (S_ISDIR(mode) && S_ISDIR(found.entry->mode())) || (S_ISLNK(mode)), "Unknown mode in entry");
+    found.entry->setMode(mode);
+    _pageChanged(found.page);
 }
 
 bool DirEntryList::setUidGid(const Key &key, uid_t uid, gid_t gid) {
     auto found = _findByKey(key);
     bool changed = false;
     if (uid != (uid_t)-1) {
-        found->setUid(uid);
+        found.entry->setUid(uid);
         changed = true;
     }
     if (gid != (gid_t)-1) {
-        found->setGid(gid);
+        found.entry->setGid(gid);
         changed = true;
     }
+    if (changed) {
+        _pageChanged(found.page);
+    }
     return changed;
 }
 
 void DirEntryList::setAccessTimes(const blockstore::Key &key, timespec lastAccessTime, timespec lastModificationTime) {
     auto found = _findByKey(key);
-    found->setLastAccessTime(lastAccessTime);
-    found->setLastModificationTime(lastModificationTime);
+    found.entry->setLastAccessTime(lastAccessTime);
+    found.entry->setLastModificationTime(lastModificationTime);
+    _pageChanged(found.page);
 }
 
 void DirEntryList::updateAccessTimestampForChild(const blockstore::Key &key) {
     auto found = _findByKey(key);
     // TODO Think about implementing relatime behavior. Currently, CryFS follows strictatime.
-    found->setLastAccessTime(cpputils::time::now());
+    found.entry->setLastAccessTime(cpputils::time::now());
+    _pageChanged(found.page);
 }
 
 void DirEntryList::updateModificationTimestampForChild(const blockstore::Key &key) {
     auto found = _findByKey(key);
-    found->setLastModificationTime(cpputils::time::now());
+    found.entry->setLastModificationTime(cpputils::time::now());
+    _pageChanged(found.page);
+}
+
+DirEntryList::const_iterator::const_iterator(vector<Page>::const_iterator page, vector<Page>::const_iterator pagesEnd)
+    : _page(page), _pagesEnd(pagesEnd), _entry(0) {
+    _skipEmptyPages();
+}
+
+const DirEntry &DirEntryList::const_iterator::operator*() const {
+    return _page->entries[_entry];
+}
+
+const DirEntry *DirEntryList::const_iterator::operator->() const {
+    return &_page->entries[_entry];
+}
+
+DirEntryList::const_iterator &DirEntryList::const_iterator::operator++() {
+    ++_entry;
+    _skipEmptyPages();
+    return *this;
+}
+
+bool DirEntryList::const_iterator::operator==(const const_iterator &rhs) const {
+    return _page == rhs._page && _entry == rhs._entry;
+}
+
+bool DirEntryList::const_iterator::operator!=(const const_iterator &rhs) const {
+    return !operator==(rhs);
+}
+
+void DirEntryList::const_iterator::_skipEmptyPages() {
+    while (_page != _pagesEnd && _entry >= _page->entries.size()) {
+        ++_page;
+        _entry = 0;
+    }
 }
 
 }
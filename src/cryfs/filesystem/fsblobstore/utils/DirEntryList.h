@@ -4,6 +4,8 @@
 
 #include <cpp-utils/data/Data.h>
 #include "DirEntry.h"
+#include "DirEntryNameIndex.h"
+#include <iterator>
 #include <vector>
 #include <string>
 
@@ -12,15 +14,63 @@
 namespace cryfs {
     namespace fsblobstore {
 
+        // Small directories are stored in the flat format, a list of all entries ordered by key.
+        // Once the entries don't fit into one page anymore, the directory is stored in pages of fixed size instead,
+        // so a change only rewrites the page containing the changed entry. The pages form an extendible hash table
+        // over the first bits of the entry keys. Each page holds the entries whose keys start with the prefix of the page,
+        // and a full page is split into two pages with a one bit longer prefix.
+        // Directories in the flat format stay readable and are converted when they are changed.
         class DirEntryList final {
+        private:
+            struct Page final {
+                Page(uint8_t depth, uint64_t prefix);
+
+                // Number of leading key bits that all entries of this page have in common, and these bits.
+                uint8_t depth;
+                uint64_t prefix;
+                // Ordered by key
+                std::vector<DirEntry> entries;
+                uint64_t entriesSerializedSize;
+                bool changed;
+            };
+
         public:
-            using const_iterator = std::vector<DirEntry>::const_iterator;
+            class const_iterator final {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = const DirEntry;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const DirEntry*;
+                using reference = const DirEntry&;
+
+                const_iterator(std::vector<Page>::const_iterator page, std::vector<Page>::const_iterator pagesEnd);
+
+                const DirEntry &operator*() const;
+                const DirEntry *operator->() const;
+                const_iterator &operator++();
+                bool operator==(const const_iterator &rhs) const;
+                bool operator!=(const const_iterator &rhs) const;
+
+            private:
+                void _skipEmptyPages();
+
+                std::vector<Page>::const_iterator _page;
+                std::vector<Page>::const_iterator _pagesEnd;
+                size_t _entry;
+            };
+
+            static constexpr uint32_t PAGE_SIZE = 4096;
 
             DirEntryList();
 
             cpputils::Data serialize() const;
             void deserializeFrom(const void *data, uint64_t size);
 
+            uint64_t serializedSize() const;
+            // Calls write() with the parts of the serialized list that changed since the list was deserialized or
+            // since the last call. The caller has to resize the serialized data to serializedSize() before writing them.
+            void serializeChanges(std::function<void (uint64_t offset, const cpputils::Data &data)> write);
+
             void add(const std::string &name, const blockstore::Key &blobKey, fspp::Dir::EntryType entryType,
                      mode_t mode, uid_t uid, gid_t gid, timespec lastAccessTime, timespec lastModificationTime);
             void addOrOverwrite(const std::string &name, const blockstore::Key &blobKey, fspp::Dir::EntryType entryType,
@@ -43,22 +93,45 @@ namespace cryfs {
             void updateModificationTimestampForChild(const blockstore::Key &key);
 
         private:
-            uint64_t _serializedSize() const;
+            struct Position final {
+                size_t page;
+                std::vector<DirEntry>::iterator entry;
+            };
+
+            void _deserializeFlat(const char *data, uint64_t size);
+            void _deserializePages(const char *data, uint64_t size);
+            void _buildPageIndex();
+            void _serializeFlat(uint8_t *dest) const;
+            void _serializePage(const Page &page, uint8_t *dest) const;
+            void _rebuildNameIndex();
             bool _hasChild(const std::string &name) const;
-            std::vector<DirEntry>::iterator _findByName(const std::string &name);
-            std::vector<DirEntry>::const_iterator _findByName(const std::string &name) const;
-            std::vector<DirEntry>::iterator _findByKey(const blockstore::Key &key);
-            std::vector<DirEntry>::const_iterator _findByKey(const blockstore::Key &key) const;
-            std::vector<DirEntry>::iterator _findUpperBound(const blockstore::Key &key);
-            std::vector<DirEntry>::iterator _findLowerBound(const blockstore::Key &key);
-            std::vector<DirEntry>::iterator _findFirst(const blockstore::Key &hint, std::function<bool (const DirEntry&)> pred);
+            boost::optional<Position> _findByName(const std::string &name);
+            Position _findByKey(const blockstore::Key &key);
+            size_t _findPage(const blockstore::Key &key) const;
+            static std::vector<DirEntry>::iterator _findLowerBound(Page *page, const blockstore::Key &key);
+            static std::vector<DirEntry>::iterator _findUpperBound(Page *page, const blockstore::Key &key);
             void _add(const std::string &name, const blockstore::Key &blobKey, fspp::Dir::EntryType entryType,
                      mode_t mode, uid_t uid, gid_t gid, timespec lastAccessTime, timespec lastModificationTime);
-            void _overwrite(std::vector<DirEntry>::iterator entry, const std::string &name, const blockstore::Key &blobKey, fspp::Dir::EntryType entryType,
+            void _overwrite(Position entry, const std::string &name, const blockstore::Key &blobKey, fspp::Dir::EntryType entryType,
                       mode_t mode, uid_t uid, gid_t gid, timespec lastAccessTime, timespec lastModificationTime);
+            void _erase(Position entry);
+            void _pageChanged(size_t pageIndex);
+            void _markChanged(size_t pageIndex);
+            void _splitUntilFits(size_t pageIndex);
+            size_t _split(size_t pageIndex);
+            void _doublePageIndex();
             static void _checkAllowedOverwrite(fspp::Dir::EntryType oldType, fspp::Dir::EntryType newType);
 
-            std::vector<DirEntry> _entries;
+            std::vector<Page> _pages;
+            // Maps the first _depth bits of a key to the page that contains the entry with this key
+            std::vector<uint32_t> _pageIndex;
+            uint8_t _depth;
+            bool _isPaged;
+            // Pages that changed since the last serialization. If _allPagesChanged is set, all pages are written.
+            std::vector<size_t> _changedPages;
+            bool _allPagesChanged;
+            size_t _size;
+            DirEntryNameIndex _nameIndex;
 
             DISALLOW_COPY_AND_ASSIGN(DirEntryList);
         };
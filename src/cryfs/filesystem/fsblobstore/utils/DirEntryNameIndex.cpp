@@ -0,0 +1,116 @@
+#include "DirEntryNameIndex.h"
+#include <cpp-utils/assert/assert.h>
+
+using std::string;
+using std::function;
+using boost::optional;
+using boost::none;
+using blockstore::Key;
+
+namespace cryfs {
+namespace fsblobstore {
+
+namespace {
+constexpr size_t INITIAL_NUM_SLOTS = 16;
+}
+
+DirEntryNameIndex::DirEntryNameIndex() : _slots(), _size(0) {
+}
+
+void DirEntryNameIndex::add(const string &name, const Key &key) {
+    // Keep at most half of the slots used, so the probe sequences stay short
+    if (2 * (_size + 1) > _slots.size()) {
+        _grow();
+    }
+    _insert(_hash(name), key);
+    ++_size;
+}
+
+void DirEntryNameIndex::remove(const string &name, const Key &key) {
+    if (_slots.empty()) {
+        ASSERT(false, "Name to remove isn't in the index");
+        return;
+    }
+    uint64_t hash = _hash(name);
+    for (size_t slot = _firstSlot(hash); _slots[slot].hash != 0; slot = _nextSlot(slot)) {
+        if (_slots[slot].hash == hash && _slots[slot].key == key) {
+            _erase(slot);
+            return;
+        }
+    }
+    ASSERT(false, "Name to remove isn't in the index");
+}
+
+void DirEntryNameIndex::clear() {
+    _slots.clear();
+    _size = 0;
+}
+
+optional<Key> DirEntryNameIndex::find(const string &name, function<bool (const Key &key)> hasName) const {
+    if (_slots.empty()) {
+        return none;
+    }
+    uint64_t hash = _hash(name);
+    for (size_t slot = _firstSlot(hash); _slots[slot].hash != 0; slot = _nextSlot(slot)) {
+        if (_slots[slot].hash == hash && hasName(_slots[slot].key)) {
+            return _slots[slot].key;
+        }
+    }
+    return none;
+}
+
+size_t DirEntryNameIndex::size() const {
+    return _size;
+}
+
+uint64_t DirEntryNameIndex::_hash(const string &name) {
+    uint64_t hash = std::hash<string>()(name);
+    // Zero marks empty slots
+    return (hash == 0) ? 1 : hash;
+}
+
+size_t DirEntryNameIndex::_firstSlot(uint64_t hash) const {
+    // The number of slots is a power of two
+    return hash & (_slots.size() - 1);
+}
+
+size_t DirEntryNameIndex::_nextSlot(size_t slot) const {
+    return (slot + 1) & (_slots.size() - 1);
+}
+
+void DirEntryNameIndex::_insert(uint64_t hash, const Key &key) {
+    size_t slot = _firstSlot(hash);
+    while (_slots[slot].hash != 0) {
+        slot = _nextSlot(slot);
+    }
+    _slots[slot] = Slot{hash, key};
+}
+
+void DirEntryNameIndex::_erase(size_t slot) {
+    // Instead of leaving a tombstone, move later entries of the probe sequence back into the hole,
+    // so lookups can still stop at the first empty slot.
+    size_t mask = _slots.size() - 1;
+    size_t hole = slot;
+    for (size_t current = _nextSlot(slot); _slots[current].hash != 0; current = _nextSlot(current)) {
+        size_t desired = _firstSlot(_slots[current].hash);
+        if (((hole - desired) & mask) < ((current - desired) & mask)) {
+            _slots[hole] = _slots[current];
+            hole = current;
+        }
+    }
+    _slots[hole].hash = 0;
+    --_size;
+}
+
+void DirEntryNameIndex::_grow() {
+    std::vector<Slot> oldSlots = std::move(_slots);
+    _slots = std::vector<Slot>(oldSlots.empty() ? INITIAL_NUM_SLOTS : 2 * oldSlots.size(), Slot{0, Key::Null()});
+    for (const Slot &slot : oldSlots) {
+        if (slot.hash != 0) {
+            _insert(slot.hash, slot.key);
+        }
+    }
+}
+
+}
+}
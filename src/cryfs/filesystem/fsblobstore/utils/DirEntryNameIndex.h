@@ -0,0 +1,54 @@
+#pragma once
+#ifndef MESSMER_CRYFS_FILESYSTEM_FSBLOBSTORE_UTILS_DIRENTRYNAMEINDEX_H
+#define MESSMER_CRYFS_FILESYSTEM_FSBLOBSTORE_UTILS_DIRENTRYNAMEINDEX_H
+
+#include <blockstore/utils/Key.h>
+#include <cpp-utils/macros.h>
+#include <boost/optional.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace cryfs {
+    namespace fsblobstore {
+
+        // Finds the key of a directory entry by its name without searching all entries.
+        // This is an open addressing hash table with linear probing. It only stores the hash of each name and the key
+        // of the entry, because the entries move around in DirEntryList. The caller has to compare the names.
+        class DirEntryNameIndex final {
+        public:
+            DirEntryNameIndex();
+
+            void add(const std::string &name, const blockstore::Key &key);
+            void remove(const std::string &name, const blockstore::Key &key);
+            void clear();
+
+            // Returns the first key stored for the hash of this name for which hasName returns true
+            boost::optional<blockstore::Key> find(const std::string &name, std::function<bool (const blockstore::Key &key)> hasName) const;
+
+            size_t size() const;
+
+        private:
+            struct Slot final {
+                // Zero marks an empty slot
+                uint64_t hash;
+                blockstore::Key key;
+            };
+
+            static uint64_t _hash(const std::string &name);
+            size_t _firstSlot(uint64_t hash) const;
+            size_t _nextSlot(size_t slot) const;
+            void _insert(uint64_t hash, const blockstore::Key &key);
+            void _erase(size_t slot);
+            void _grow();
+
+            std::vector<Slot> _slots;
+            size_t _size;
+
+            DISALLOW_COPY_AND_ASSIGN(DirEntryNameIndex);
+        };
+
+    }
+}
+
+#endif
@@ -4,16 +4,18 @@
 
 #include "FsBlobRef.h"
 #include "../cachingfsblobstore/FileBlobRef.h"
+#include "LstatSizeCache.h"
 
 namespace cryfs {
 namespace parallelaccessfsblobstore {
 
 class FileBlobRef final: public FsBlobRef {
 public:
-    FileBlobRef(cachingfsblobstore::FileBlobRef *base) : _base(base) {}
+    FileBlobRef(cachingfsblobstore::FileBlobRef *base, LstatSizeCache *lstatSizeCache) : _base(base), _lstatSizeCache(lstatSizeCache) {}
 
     void resize(off_t size) {
-        return _base->resize(size);
+        _base->resize(size);
+        _lstatSizeCache->invalidate(key());
     }
 
     off_t size() const {
@@ -25,7 +27,12 @@ public:
     }
 
     void write(const void *source, uint64_t offset, uint64_t count) {
-        return _base->write(source, offset, count);
+        _base->write(source, offset, count);
+        _lstatSizeCache->invalidate(key());
+    }
+
+    void prefetch(uint64_t offset, uint64_t count) const {
+        return _base->prefetch(offset, count);
     }
 
     void flush() {
@@ -40,8 +47,17 @@ public:
         return _base->lstat_size();
     }
 
+    boost::optional<off_t> seekData(off_t offset) const {
+        return _base->seekData(offset);
+    }
+
+    boost::optional<off_t> seekHole(off_t offset) const {
+        return _base->seekHole(offset);
+    }
+
 private:
     cachingfsblobstore::FileBlobRef *_base;
+    LstatSizeCache *_lstatSizeCache;
 
     DISALLOW_COPY_AND_ASSIGN(FileBlobRef);
 };
@@ -0,0 +1,70 @@
+#include "LstatSizeCache.h"
+
+using std::function;
+using std::unique_lock;
+using std::mutex;
+using boost::none;
+using blockstore::Key;
+
+namespace cryfs {
+namespace parallelaccessfsblobstore {
+
+LstatSizeCache::LstatSizeCache(uint32_t maxEntries)
+    : _maxEntries(maxEntries), _mutex(), _sizes(), _lru(), _nextVersion(0) {
+}
+
+off_t LstatSizeCache::getOrCompute(const Key &key, function<off_t ()> computeSize) {
+    if (_maxEntries == 0) {
+        return computeSize();
+    }
+    uint64_t version = 0;
+    {
+        unique_lock<mutex> lock(_mutex);
+        auto found = _sizes.find(key);
+        if (found != _sizes.end()) {
+            _lru.splice(_lru.begin(), _lru, found->second.lruPosition);
+            if (found->second.size != none) {
+                return *found->second.size;
+            }
+            // Another thread is computing the size. Computing it here as well gives the same result.
+            version = found->second.version;
+        } else {
+            version = _nextVersion++;
+            _lru.push_front(key);
+            _sizes.emplace(key, CachedSize{none, version, _lru.begin()});
+            while (_sizes.size() > _maxEntries) {
+                _remove(_sizes.find(_lru.back()));
+            }
+        }
+    }
+
+    off_t size = computeSize();
+
+    unique_lock<mutex> lock(_mutex);
+    auto found = _sizes.find(key);
+    if (found != _sizes.end() && found->second.version == version) {
+        found->second.size = size;
+    }
+    return size;
+}
+
+void LstatSizeCache::invalidate(const Key &key) {
+    unique_lock<mutex> lock(_mutex);
+    auto found = _sizes.find(key);
+    if (found != _sizes.end()) {
+        _remove(found);
+    }
+}
+
+uint32_t LstatSizeCache::size() const {
+    unique_lock<mutex> lock(_mutex);
+    return _sizes.size();
+}
+
+void LstatSizeCache::_remove(std::unordered_map<Key, CachedSize>::iterator cached) {
+    _lru.erase(cached->second.lruPosition);
+    _sizes.erase(cached);
+}
+
+}
+}
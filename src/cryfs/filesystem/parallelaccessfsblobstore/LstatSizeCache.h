@@ -0,0 +1,60 @@
+#pragma once
+#ifndef MESSMER_CRYFS_FILESYSTEM_PARALLELACCESSFSBLOBSTORE_LSTATSIZECACHE_H
+#define MESSMER_CRYFS_FILESYSTEM_PARALLELACCESSFSBLOBSTORE_LSTATSIZECACHE_H
+
+#include <blockstore/utils/Key.h>
+#include <cpp-utils/macros.h>
+#include <boost/optional.hpp>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <sys/types.h>
+
+namespace cryfs {
+    namespace parallelaccessfsblobstore {
+
+        // Remembers the lstat sizes of recently stat'ed blobs, so a directory can stat its entries, e.g. for `ls -l`,
+        // without loading the blob of each entry.
+        //
+        // Everything that changes the size of a blob has to invalidate it afterwards. A size that is computed while
+        // the blob is changed isn't cached, because the invalidation removes the entry the computation started with.
+        class LstatSizeCache final {
+        public:
+            // If more sizes are cached, the least recently used ones are dropped. A maxEntries of zero disables the cache.
+            explicit LstatSizeCache(uint32_t maxEntries);
+
+            // Returns the cached size or calls computeSize(). computeSize() is called without holding a lock,
+            // so it can load the blob.
+            off_t getOrCompute(const blockstore::Key &key, std::function<off_t ()> computeSize);
+
+            void invalidate(const blockstore::Key &key);
+
+            uint32_t size() const;
+
+        private:
+            struct CachedSize final {
+                // none while the size is computed
+                boost::optional<off_t> size;
+                // Identifies this entry, so a computation doesn't store its result into an entry that was
+                // invalidated and created again in the meantime.
+                uint64_t version;
+                std::list<blockstore::Key>::iterator lruPosition;
+            };
+
+            void _remove(std::unordered_map<blockstore::Key, CachedSize>::iterator cached);
+
+            const uint32_t _maxEntries;
+            mutable std::mutex _mutex;
+            std::unordered_map<blockstore::Key, CachedSize> _sizes;
+            // Most recently used key first
+            std::list<blockstore::Key> _lru;
+            uint64_t _nextVersion;
+
+            DISALLOW_COPY_AND_ASSIGN(LstatSizeCache);
+        };
+
+    }
+}
+
+#endif
@@ -21,7 +21,7 @@ optional<unique_ref<FsBlobRef>> ParallelAccessFsBlobStore::load(const Key &key)
     return _parallelAccessStore.load(key, [this] (cachingfsblobstore::FsBlobRef *blob) {
         cachingfsblobstore::FileBlobRef *fileBlob = dynamic_cast<cachingfsblobstore::FileBlobRef*>(blob);
         if (fileBlob != nullptr) {
-            return unique_ref<FsBlobRef>(make_unique_ref<FileBlobRef>(fileBlob));
+            return unique_ref<FsBlobRef>(make_unique_ref<FileBlobRef>(fileBlob, &_lstatSizeCache));
         }
         cachingfsblobstore::DirBlobRef *dirBlob = dynamic_cast<cachingfsblobstore::DirBlobRef*>(blob);
         if (dirBlob != nullptr) {
@@ -50,10 +50,10 @@ unique_ref<DirBlobRef> ParallelAccessFsBlobStore::createDirBlob() {
 unique_ref<FileBlobRef> ParallelAccessFsBlobStore::createFileBlob() {
     auto blob = _baseBlobStore->createFileBlob();
     Key key = blob->key();
-    return _parallelAccessStore.add<FileBlobRef>(key, std::move(blob), [] (cachingfsblobstore::FsBlobRef *resource) {
+    return _parallelAccessStore.add<FileBlobRef>(key, std::move(blob), [this] (cachingfsblobstore::FsBlobRef *resource) {
         auto fileBlob = dynamic_cast<cachingfsblobstore::FileBlobRef*>(resource);
         ASSERT(fileBlob != nullptr, "Wrong resource given");
-        return make_unique_ref<FileBlobRef>(fileBlob);
+        return make_unique_ref<FileBlobRef>(fileBlob, &_lstatSizeCache);
     });
 }
 
@@ -8,6 +8,7 @@
 #include "SymlinkBlobRef.h"
 #include "../cachingfsblobstore/CachingFsBlobStore.h"
 #include "ParallelAccessFsBlobStoreAdapter.h"
+#include "LstatSizeCache.h"
 
 namespace cryfs {
     namespace parallelaccessfsblobstore {
@@ -29,12 +30,17 @@ namespace cryfs {
             uint64_t virtualBlocksizeBytes() const;
             uint64_t numBlocks() const;
             uint64_t estimateSpaceForNumBlocksLeft() const;
+            void waitForPendingWrites();
 
         private:
 
             cpputils::unique_ref<cachingfsblobstore::CachingFsBlobStore> _baseBlobStore;
             parallelaccessstore::ParallelAccessStore<cachingfsblobstore::FsBlobRef, FsBlobRef, blockstore::Key> _parallelAccessStore;
 
+            // Enough for the entries of large directories. An entry takes about 100 bytes.
+            static constexpr uint32_t MAX_CACHED_LSTAT_SIZES = 100000;
+            LstatSizeCache _lstatSizeCache;
+
             std::function<off_t (const blockstore::Key &)> _getLstatSize();
 
             DISALLOW_COPY_AND_ASSIGN(ParallelAccessFsBlobStore);
@@ -42,19 +48,23 @@ namespace cryfs {
 
         inline ParallelAccessFsBlobStore::ParallelAccessFsBlobStore(cpputils::unique_ref<cachingfsblobstore::CachingFsBlobStore> baseBlobStore)
                 : _baseBlobStore(std::move(baseBlobStore)),
-                  _parallelAccessStore(cpputils::make_unique_ref<ParallelAccessFsBlobStoreAdapter>(_baseBlobStore.get())) {
+                  _parallelAccessStore(cpputils::make_unique_ref<ParallelAccessFsBlobStoreAdapter>(_baseBlobStore.get())),
+                  _lstatSizeCache(MAX_CACHED_LSTAT_SIZES) {
         }
 
         inline void ParallelAccessFsBlobStore::remove(cpputils::unique_ref<FsBlobRef> blob) {
             blockstore::Key key = blob->key();
-            return _parallelAccessStore.remove(key, std::move(blob));
+            _parallelAccessStore.remove(key, std::move(blob));
+            _lstatSizeCache.invalidate(key);
         }
 
         inline std::function<off_t (const blockstore::Key &key)> ParallelAccessFsBlobStore::_getLstatSize() {
             return [this] (const blockstore::Key &key) {
-                auto blob = load(key);
-                ASSERT(blob != boost::none, "Blob not found");
-                return (*blob)->lstat_size();
+                return _lstatSizeCache.getOrCompute(key, [this, &key] {
+                    auto blob = load(key);
+                    ASSERT(blob != boost::none, "Blob not found");
+                    return (*blob)->lstat_size();
+                });
             };
         }
 
@@ -69,6 +79,10 @@ namespace cryfs {
         inline uint64_t ParallelAccessFsBlobStore::estimateSpaceForNumBlocksLeft() const {
             return _baseBlobStore->estimateSpaceForNumBlocksLeft();
         }
+
+        inline void ParallelAccessFsBlobStore::waitForPendingWrites() {
+            _baseBlobStore->waitForPendingWrites();
+        }
     }
 }
 
@@ -4,7 +4,11 @@
 
 #include <boost/filesystem.hpp>
 #include <cpp-utils/pointer/unique_ref.h>
+#include <cpp-utils/data/FixedSizeData.h>
+#include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <string>
+#include <vector>
 
 namespace fspp {
 class Node;
@@ -26,6 +30,18 @@ public:
 	virtual boost::optional<cpputils::unique_ref<Dir>> LoadDir(const boost::filesystem::path &path) = 0;
 	virtual boost::optional<cpputils::unique_ref<Symlink>> LoadSymlink(const boost::filesystem::path &path) = 0;
 
+	// Nodes can also be loaded by their ids instead of their path, so the directories on the path don't have to be searched.
+	// A node is given by the ids of all nodes from the root directory (exclusive) to the node itself (inclusive),
+	// i.e. the root directory is given by an empty vector.
+	using NodeId = cpputils::FixedSizeData<16>;
+	// Returns none if the node isn't in its parent directory (anymore)
+	virtual boost::optional<cpputils::unique_ref<Node>> LoadById(const std::vector<NodeId> &ids) = 0;
+	// Returns the id of the child with this name, or none if the directory doesn't have such a child
+	virtual boost::optional<NodeId> LookupChildId(const std::vector<NodeId> &dirIds, const std::string &name) = 0;
+	// Like LookupChildId, but also returns the attributes of the child. They are read from the directory
+	// instead of the child, so the child doesn't have to be loaded, e.g. when listing a directory with `ls -l`.
+	virtual boost::optional<NodeId> StatChild(const std::vector<NodeId> &dirIds, const std::string &name, struct ::stat *result) = 0;
+
 };
 
 }
@@ -4,6 +4,7 @@
 
 #include "testutils/FileSystemTest.h"
 #include "FsppDeviceTest.h"
+#include "FsppDeviceTest_LoadById.h"
 #include "FsppDirTest.h"
 #include "FsppFileTest.h"
 #include "FsppSymlinkTest.h"
@@ -20,6 +21,7 @@
 #define FSPP_ADD_FILESYTEM_TESTS(FS_NAME, FIXTURE) \
   INSTANTIATE_TYPED_TEST_CASE_P(FS_NAME, FsppDeviceTest_One,             FIXTURE);  \
   INSTANTIATE_TYPED_TEST_CASE_P(FS_NAME, FsppDeviceTest_Two,             FIXTURE);  \
+  INSTANTIATE_TYPED_TEST_CASE_P(FS_NAME, FsppDeviceTest_LoadById,        FIXTURE);  \
   INSTANTIATE_NODE_TEST_CASE(   FS_NAME, FsppDeviceTest_Timestamps,      FIXTURE);  \
   INSTANTIATE_TYPED_TEST_CASE_P(FS_NAME, FsppDirTest,                    FIXTURE);  \
   INSTANTIATE_TYPED_TEST_CASE_P(FS_NAME, FsppDirTest_Timestamps,         FIXTURE);  \
@@ -0,0 +1,204 @@
+#pragma once
+#ifndef MESSMER_FSPP_FSTEST_FSPPDEVICETEST_LOADBYID_H_
+#define MESSMER_FSPP_FSTEST_FSPPDEVICETEST_LOADBYID_H_
+
+#include <sys/fcntl.h>
+#include <fspp/fuse/FuseErrnoException.h>
+
+template<class ConcreteFileSystemTestFixture>
+class FsppDeviceTest_LoadById: public FileSystemTest<ConcreteFileSystemTestFixture> {
+public:
+  // Looks up the ids of all nodes on the path
+  std::vector<fspp::Device::NodeId> Ids(const boost::filesystem::path &path) {
+    std::vector<fspp::Device::NodeId> ids;
+    for (const boost::filesystem::path &component : path.relative_path()) {
+      auto id = this->device->LookupChildId(ids, component.native());
+      EXPECT_TRUE(id != boost::none);
+      ids.push_back(*id);
+    }
+    return ids;
+  }
+
+  cpputils::unique_ref<fspp::Node> LoadById(const boost::filesystem::path &path) {
+    auto loaded = this->device->LoadById(Ids(path));
+    EXPECT_NE(boost::none, loaded);
+    return std::move(*loaded);
+  }
+
+  void EXPECT_DOESNT_EXIST(const std::vector<fspp::Device::NodeId> &ids) {
+    try {
+      EXPECT_EQ(boost::none, this->device->LoadById(ids));
+    } catch (const fspp::fuse::FuseErrnoException &e) {
+      EXPECT_EQ(ENOENT, e.getErrno());
+    }
+  }
+};
+
+TYPED_TEST_CASE_P(FsppDeviceTest_LoadById);
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadRootDir) {
+  auto node = this->device->LoadById({}).value();
+  this->EXPECT_IS_DIR(node);
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LookupNonexisting) {
+  EXPECT_TRUE(boost::none == this->device->LookupChildId({}, "nonexisting"));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LookupNonexisting_Nesting1) {
+  this->CreateDir("/mydir");
+  EXPECT_TRUE(boost::none == this->device->LookupChildId(this->Ids("/mydir"), "nonexisting"));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LookupGivesDifferentIds) {
+  this->CreateFile("/myfile");
+  this->CreateFile("/myfile2");
+  EXPECT_NE(this->Ids("/myfile"), this->Ids("/myfile2"));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadFile) {
+  this->CreateFile("/myfile");
+  this->EXPECT_IS_FILE(this->LoadById("/myfile"));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadDir) {
+  this->CreateDir("/mydir");
+  this->EXPECT_IS_DIR(this->LoadById("/mydir"));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadSymlink) {
+  this->CreateSymlink("/mysymlink");
+  this->EXPECT_IS_SYMLINK(this->LoadById("/mysymlink"));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadFile_Nesting1) {
+  this->CreateDir("/mydir");
+  this->CreateFile("/mydir/myfile");
+  this->EXPECT_IS_FILE(this->LoadById("/mydir/myfile"));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadFile_Nesting2) {
+  this->CreateDir("/mydir");
+  this->CreateDir("/mydir/mysubdir");
+  this->CreateFile("/mydir/mysubdir/myfile");
+  this->EXPECT_IS_FILE(this->LoadById("/mydir/mysubdir/myfile"));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadDir_Nesting2) {
+  this->CreateDir("/mydir");
+  this->CreateDir("/mydir/mysubdir");
+  this->CreateDir("/mydir/mysubdir/mysubsubdir");
+  this->EXPECT_IS_DIR(this->LoadById("/mydir/mysubdir/mysubsubdir"));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadsSameNodeAsPath) {
+  this->CreateDir("/mydir");
+  this->CreateFile("/mydir/myfile")->truncate(100);
+  struct stat expected;
+  this->Load("/mydir/myfile")->stat(&expected);
+  struct stat actual;
+  this->LoadById("/mydir/myfile")->stat(&actual);
+  EXPECT_EQ(expected.st_size, actual.st_size);
+  EXPECT_EQ(expected.st_mode, actual.st_mode);
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, IdStaysSameAfterRename) {
+  this->CreateDir("/mydir");
+  this->CreateFile("/myfile");
+  auto ids = this->Ids("/myfile");
+  this->Load("/myfile")->rename("/mydir/myrenamedfile");
+  auto newIds = this->Ids("/mydir/myrenamedfile");
+  EXPECT_EQ(ids.back(), newIds.back());
+  this->EXPECT_IS_FILE(this->device->LoadById(newIds).value());
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadAtOldPositionAfterRename) {
+  this->CreateDir("/mydir");
+  this->CreateFile("/myfile");
+  auto ids = this->Ids("/myfile");
+  this->Load("/myfile")->rename("/mydir/myrenamedfile");
+  this->EXPECT_DOESNT_EXIST(ids);
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, LoadRemoved) {
+  this->CreateFile("/myfile");
+  auto ids = this->Ids("/myfile");
+  this->Load("/myfile")->remove();
+  this->EXPECT_DOESNT_EXIST(ids);
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, StatChildNonexisting) {
+  struct stat stat;
+  EXPECT_TRUE(boost::none == this->device->StatChild({}, "nonexisting", &stat));
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, StatChildGivesSameIdAsLookup) {
+  this->CreateDir("/mydir");
+  this->CreateFile("/mydir/myfile");
+  struct stat stat;
+  auto id = this->device->StatChild(this->Ids("/mydir"), "myfile", &stat);
+  EXPECT_TRUE(id != boost::none);
+  EXPECT_EQ(this->Ids("/mydir/myfile").back(), *id);
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, StatChildGivesSameAttributesAsNode) {
+  this->CreateFile("/myfile")->truncate(100);
+  this->CreateDir("/mydir");
+  this->CreateSymlink("/mysymlink");
+  for (const char *name : {"myfile", "mydir", "mysymlink"}) {
+    struct stat expected;
+    this->Load(boost::filesystem::path("/") / name)->stat(&expected);
+    struct stat actual;
+    EXPECT_TRUE(boost::none != this->device->StatChild({}, name, &actual));
+    EXPECT_EQ(expected.st_mode, actual.st_mode);
+    EXPECT_EQ(expected.st_size, actual.st_size);
+    EXPECT_EQ(expected.st_uid, actual.st_uid);
+    EXPECT_EQ(expected.st_gid, actual.st_gid);
+    EXPECT_EQ(expected.st_mtim.tv_sec, actual.st_mtim.tv_sec);
+  }
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, StatChildGivesSizeAfterWrite) {
+  struct stat stat;
+  auto openFile = this->CreateFile("/myfile")->open(O_RDWR);
+  EXPECT_TRUE(boost::none != this->device->StatChild({}, "myfile", &stat));
+  EXPECT_EQ(0, stat.st_size);
+  openFile->write("data", 4, 10);
+  EXPECT_TRUE(boost::none != this->device->StatChild({}, "myfile", &stat));
+  EXPECT_EQ(14, stat.st_size);
+}
+
+TYPED_TEST_P(FsppDeviceTest_LoadById, StatChildGivesSizeAfterTruncate) {
+  struct stat stat;
+  auto file = this->CreateFile("/myfile");
+  file->truncate(100);
+  EXPECT_TRUE(boost::none != this->device->StatChild({}, "myfile", &stat));
+  EXPECT_EQ(100, stat.st_size);
+  file->truncate(50);
+  EXPECT_TRUE(boost::none != this->device->StatChild({}, "myfile", &stat));
+  EXPECT_EQ(50, stat.st_size);
+}
+
+REGISTER_TYPED_TEST_CASE_P(FsppDeviceTest_LoadById,
+  LoadRootDir,
+  LookupNonexisting,
+  LookupNonexisting_Nesting1,
+  LookupGivesDifferentIds,
+  LoadFile,
+  LoadDir,
+  LoadSymlink,
+  LoadFile_Nesting1,
+  LoadFile_Nesting2,
+  LoadDir_Nesting2,
+  LoadsSameNodeAsPath,
+  IdStaysSameAfterRename,
+  LoadAtOldPositionAfterRename,
+  LoadRemoved,
+  StatChildNonexisting,
+  StatChildGivesSameIdAsLookup,
+  StatChildGivesSameAttributesAsNode,
+  StatChildGivesSizeAfterWrite,
+  StatChildGivesSizeAfterTruncate
+);
+
+#endif
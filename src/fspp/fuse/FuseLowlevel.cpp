@@ -0,0 +1,626 @@
+#include "FuseLowlevel.h"
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "FuseErrnoException.h"
+#include "../fs_interface/Device.h"
+#include "../fs_interface/File.h"
+#include "../fs_interface/Node.h"
+#include "../fs_interface/OpenFile.h"
+#include "../fs_interface/Symlink.h"
+#include <cpp-utils/assert/assert.h>
+#include <cpp-utils/logging/logging.h>
+#include <cpp-utils/pointer/cast.h>
+#include <cpp-utils/system/time.h>
+
+using std::vector;
+using std::string;
+using cpputils::unique_ref;
+using cpputils::dynamic_pointer_move;
+using boost::none;
+using fspp::Device;
+using fspp::Node;
+using fspp::Dir;
+using fspp::File;
+using fspp::Symlink;
+
+namespace bf = boost::filesystem;
+using namespace cpputils::logging;
+using namespace fspp::fuse;
+
+#define FUSE_OBJ(req) ((FuseLowlevel *) fuse_req_userdata(req))
+
+namespace {
+// Inode number for readdir() entries that the kernel didn't look up yet (same as libfuse uses in the high level interface)
+constexpr ino_t UNKNOWN_INODE = 0xffffffff;
+
+void fusepp_init(void *userdata, fuse_conn_info *conn) {
+  ((FuseLowlevel *) userdata)->init(conn);
+}
+
+void fusepp_destroy(void *userdata) {
+  ((FuseLowlevel *) userdata)->destroy();
+}
+
+void fusepp_lookup(fuse_req_t req, fuse_ino_t parent, const char *name) {
+  FUSE_OBJ(req)->lookup(req, parent, name);
+}
+
+void fusepp_forget(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup) {
+  FUSE_OBJ(req)->forget(req, ino, nlookup);
+}
+
+void fusepp_getattr(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->getattr(req, ino, fileinfo);
+}
+
+void fusepp_setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int toSet, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->setattr(req, ino, attr, toSet, fileinfo);
+}
+
+void fusepp_readlink(fuse_req_t req, fuse_ino_t ino) {
+  FUSE_OBJ(req)->readlink(req, ino);
+}
+
+void fusepp_mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode) {
+  FUSE_OBJ(req)->mkdir(req, parent, name, mode);
+}
+
+void fusepp_unlink(fuse_req_t req, fuse_ino_t parent, const char *name) {
+  FUSE_OBJ(req)->unlink(req, parent, name);
+}
+
+void fusepp_rmdir(fuse_req_t req, fuse_ino_t parent, const char *name) {
+  FUSE_OBJ(req)->rmdir(req, parent, name);
+}
+
+void fusepp_symlink(fuse_req_t req, const char *target, fuse_ino_t parent, const char *name) {
+  FUSE_OBJ(req)->symlink(req, target, parent, name);
+}
+
+void fusepp_rename(fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname) {
+  FUSE_OBJ(req)->rename(req, parent, name, newparent, newname);
+}
+
+void fusepp_open(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->open(req, ino, fileinfo);
+}
+
+void fusepp_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->read(req, ino, size, offset, fileinfo);
+}
+
+void fusepp_write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t offset, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->write(req, ino, buf, size, offset, fileinfo);
+}
+
+void fusepp_flush(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->flush(req, ino, fileinfo);
+}
+
+void fusepp_release(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->release(req, ino, fileinfo);
+}
+
+void fusepp_fsync(fuse_req_t req, fuse_ino_t ino, int datasync, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->fsync(req, ino, datasync, fileinfo);
+}
+
+void fusepp_opendir(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->opendir(req, ino, fileinfo);
+}
+
+void fusepp_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->readdir(req, ino, size, offset, fileinfo);
+}
+
+void fusepp_releasedir(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->releasedir(req, ino, fileinfo);
+}
+
+void fusepp_statfs(fuse_req_t req, fuse_ino_t ino) {
+  FUSE_OBJ(req)->statfs(req, ino);
+}
+
+void fusepp_access(fuse_req_t req, fuse_ino_t ino, int mask) {
+  FUSE_OBJ(req)->access(req, ino, mask);
+}
+
+void fusepp_create(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, fuse_file_info *fileinfo) {
+  FUSE_OBJ(req)->create(req, parent, name, mode, fileinfo);
+}
+
+fuse_lowlevel_ops *operations() {
+  static std::unique_ptr<fuse_lowlevel_ops> singleton(nullptr);
+
+  if (!singleton) {
+    singleton = std::make_unique<fuse_lowlevel_ops>();
+    singleton->init = &fusepp_init;
+    singleton->destroy = &fusepp_destroy;
+    singleton->lookup = &fusepp_lookup;
+    singleton->forget = &fusepp_forget;
+    singleton->getattr = &fusepp_getattr;
+    singleton->setattr = &fusepp_setattr;
+    singleton->readlink = &fusepp_readlink;
+    singleton->mkdir = &fusepp_mkdir;
+    singleton->unlink = &fusepp_unlink;
+    singleton->rmdir = &fusepp_rmdir;
+    singleton->symlink = &fusepp_symlink;
+    singleton->rename = &fusepp_rename;
+    singleton->open = &fusepp_open;
+    singleton->read = &fusepp_read;
+    singleton->write = &fusepp_write;
+    singleton->flush = &fusepp_flush;
+    singleton->release = &fusepp_release;
+    singleton->fsync = &fusepp_fsync;
+    singleton->opendir = &fusepp_opendir;
+    singleton->readdir = &fusepp_readdir;
+    singleton->releasedir = &fusepp_releasedir;
+    singleton->statfs = &fusepp_statfs;
+    singleton->access = &fusepp_access;
+    singleton->create = &fusepp_create;
+  }
+
+  return singleton.get();
+}
+
+// Runs the operation and answers the request with an error if it throws.
+// The operation itself sends the reply if it succeeds.
+template<class Operation>
+void handleErrors(fuse_req_t req, const char *operationName, Operation operation) {
+  try {
+    operation();
+  } catch(const cpputils::AssertFailed &e) {
+    LOG(ERROR, "AssertFailed in FuseLowlevel::{}: {}", operationName, e.what());
+    fuse_reply_err(req, EIO);
+  } catch(fspp::fuse::FuseErrnoException &e) {
+    fuse_reply_err(req, e.getErrno());
+  } catch(const std::exception &e) {
+    LOG(ERROR, "Exception thrown in FuseLowlevel::{}: {}", operationName, e.what());
+    fuse_reply_err(req, EIO);
+  } catch(...) {
+    LOG(ERROR, "Unknown exception thrown in FuseLowlevel::{}", operationName);
+    fuse_reply_err(req, EIO);
+  }
+}
+
+bool hasOption(const vector<string> &options, const string &key) {
+  // The fuse option can either be present as "-okey=value" or as "-o key=value", we have to check both.
+  return std::any_of(options.begin(), options.end(), [&key] (const string &option) {
+    return option.compare(0, key.size() + 1, key + "=") == 0 || option.compare(0, key.size() + 3, "-o" + key + "=") == 0;
+  });
+}
+}
+
+constexpr double FuseLowlevel::DEFAULT_ENTRY_TIMEOUT_SECONDS;
+constexpr double FuseLowlevel::DEFAULT_ATTR_TIMEOUT_SECONDS;
+
+FuseLowlevel::FuseLowlevel(Device *device, const string &fstype, const boost::optional<string> &fsname, double entryTimeoutSeconds, double attrTimeoutSeconds)
+  :_device(device), _inodes(), _openFiles(), _openDirs(), _entryTimeoutSeconds(entryTimeoutSeconds), _attrTimeoutSeconds(attrTimeoutSeconds),
+   _fstype(fstype), _fsname(fsname), _mountdir(), _running(false) {
+}
+
+void FuseLowlevel::run(const bf::path &mountdir, const vector<string> &fuseOptions) {
+  _mountdir = mountdir;
+
+  // fuse_parse_cmdline() and fuse_mount() only keep pointers into these strings, so they have to live until we're done
+  vector<string> args = _buildArgs(mountdir, fuseOptions);
+  vector<char*> argv;
+  for (string &arg : args) {
+    argv.push_back(&arg[0]);
+  }
+  fuse_args fuseArgs = FUSE_ARGS_INIT(static_cast<int>(argv.size()), argv.data());
+
+  // Same steps as fuse_main() in the high level interface
+  char *mountpoint = nullptr;
+  int multithreaded = 0;
+  int foreground = 0;
+  if (fuse_parse_cmdline(&fuseArgs, &mountpoint, &multithreaded, &foreground) == -1 || mountpoint == nullptr) {
+    LOG(ERROR, "Invalid FUSE options");
+    fuse_opt_free_args(&fuseArgs);
+    return;
+  }
+  fuse_chan *channel = fuse_mount(mountpoint, &fuseArgs);
+  if (channel == nullptr) {
+    LOG(ERROR, "Could not mount filesystem");
+    free(mountpoint);
+    fuse_opt_free_args(&fuseArgs);
+    return;
+  }
+  fuse_session *session = fuse_lowlevel_new(&fuseArgs, operations(), sizeof(fuse_lowlevel_ops), this);
+  if (session != nullptr) {
+    fuse_session_add_chan(session, channel);
+    if (fuse_daemonize(foreground) == 0 && fuse_set_signal_handlers(session) == 0) {
+      if (multithreaded) {
+        fuse_session_loop_mt(session);
+      } else {
+        fuse_session_loop(session);
+      }
+      fuse_remove_signal_handlers(session);
+    }
+    fuse_session_remove_chan(channel);
+    fuse_session_destroy(session);
+  }
+  fuse_unmount(mountpoint, channel);
+  free(mountpoint);
+  fuse_opt_free_args(&fuseArgs);
+}
+
+vector<string> FuseLowlevel::_buildArgs(const bf::path &mountdir, const vector<string> &fuseOptions) const {
+  vector<string> args;
+  args.push_back(_fstype); // The first argument (executable name) is the file system type
+  args.push_back(mountdir.native()); // The second argument is the mountdir
+  args.insert(args.end(), fuseOptions.begin(), fuseOptions.end());
+  if (!hasOption(args, "subtype")) {
+    args.push_back("-o");
+    args.push_back("subtype=" + _fstype);
+  }
+  if (!hasOption(args, "fsname")) {
+    args.push_back("-o");
+    args.push_back("fsname=" + _fsname.get_value_or(_fstype));
+  }
+  return args;
+}
+
+bool FuseLowlevel::running() const {
+  return _running;
+}
+
+void FuseLowlevel::stop() {
+#ifdef __APPLE__
+  int ret = system(("umount " + _mountdir.native()).c_str());
+#else
+  int ret = system(("fusermount -z -u " + _mountdir.native()).c_str()); // "-z" takes care that if the filesystem can't be unmounted right now because something is opened, it will be unmounted as soon as it can be.
+#endif
+  if (ret != 0) {
+    LOG(ERROR, "Could not unmount filesystem");
+  }
+}
+
+unique_ref<Node> FuseLowlevel::_load(fuse_ino_t ino) {
+  auto node = _device->LoadById(_inodes.ids(ino));
+  if (node == none) {
+    throw FuseErrnoException(ENOENT);
+  }
+  return std::move(*node);
+}
+
+unique_ref<Dir> FuseLowlevel::_loadDir(fuse_ino_t ino) {
+  auto node = _load(ino);
+  auto dir = dynamic_pointer_move<Dir>(node);
+  if (dir == none) {
+    throw FuseErrnoException(ENOTDIR);
+  }
+  return std::move(*dir);
+}
+
+unique_ref<Node> FuseLowlevel::_loadChild(fuse_ino_t parent, const string &name, Device::NodeId *id) {
+  auto ids = _inodes.ids(parent);
+  auto childId = _device->LookupChildId(ids, name);
+  if (childId == none) {
+    throw FuseErrnoException(ENOENT);
+  }
+  ids.push_back(*childId);
+  auto node = _device->LoadById(ids);
+  if (node == none) {
+    throw FuseErrnoException(ENOENT);
+  }
+  *id = *childId;
+  return std::move(*node);
+}
+
+fuse_entry_param FuseLowlevel::_lookupEntry(fuse_ino_t parent, const string &name) {
+  fuse_entry_param entry;
+  std::memset(&entry, 0, sizeof(entry));
+  // The kernel doesn't get attributes from readdir() and looks up each entry, e.g. for `ls -l`.
+  // Reading the attributes from the directory is much faster than loading each child.
+  auto id = _device->StatChild(_inodes.ids(parent), name, &entry.attr);
+  if (id == none) {
+    throw FuseErrnoException(ENOENT);
+  }
+  // Only count the lookup once the entry is complete, because the kernel doesn't know the inode if we reply an error
+  entry.ino = _inodes.lookup(parent, name, *id);
+  entry.attr.st_ino = entry.ino;
+  entry.attr_timeout = _attrTimeoutSeconds;
+  entry.entry_timeout = _entryTimeoutSeconds;
+  return entry;
+}
+
+void FuseLowlevel::_replyEntry(fuse_req_t req, const fuse_entry_param &entry) {
+  if (fuse_reply_entry(req, &entry) != 0) {
+    // The request was interrupted, so the kernel didn't get the inode
+    _inodes.forget(entry.ino, 1);
+  }
+}
+
+void FuseLowlevel::init(fuse_conn_info *conn) {
+  UNUSED(conn);
+  LOG(INFO, "Filesystem started.");
+
+  _running = true;
+}
+
+void FuseLowlevel::destroy() {
+  LOG(INFO, "Filesystem stopped.");
+  _running = false;
+}
+
+void FuseLowlevel::lookup(fuse_req_t req, fuse_ino_t parent, const char *name) {
+  handleErrors(req, "lookup", [&] {
+    try {
+      _replyEntry(req, _lookupEntry(parent, name));
+    } catch (FuseErrnoException &e) {
+      if (e.getErrno() != ENOENT) {
+        throw;
+      }
+      // Let the kernel cache that the entry doesn't exist. Creating it through the kernel invalidates this.
+      fuse_entry_param entry;
+      std::memset(&entry, 0, sizeof(entry));
+      entry.ino = 0;
+      entry.entry_timeout = _entryTimeoutSeconds;
+      fuse_reply_entry(req, &entry);
+    }
+  });
+}
+
+void FuseLowlevel::forget(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup) {
+  try {
+    _inodes.forget(ino, nlookup);
+  } catch(const std::exception &e) {
+    LOG(ERROR, "Exception thrown in FuseLowlevel::forget: {}", e.what());
+  }
+  fuse_reply_none(req);
+}
+
+void FuseLowlevel::getattr(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  UNUSED(fileinfo);
+  handleErrors(req, "getattr", [&] {
+    struct stat stbuf;
+    _load(ino)->stat(&stbuf);
+    stbuf.st_ino = ino;
+    fuse_reply_attr(req, &stbuf, _attrTimeoutSeconds);
+  });
+}
+
+void FuseLowlevel::setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int toSet, fuse_file_info *fileinfo) {
+  handleErrors(req, "setattr", [&] {
+    auto node = _load(ino);
+    if (toSet & FUSE_SET_ATTR_MODE) {
+      node->chmod(attr->st_mode);
+    }
+    if (toSet & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID)) {
+      uid_t uid = (toSet & FUSE_SET_ATTR_UID) ? attr->st_uid : (uid_t)-1;
+      gid_t gid = (toSet & FUSE_SET_ATTR_GID) ? attr->st_gid : (gid_t)-1;
+      node->chown(uid, gid);
+    }
+    if (toSet & FUSE_SET_ATTR_SIZE) {
+      if (fileinfo != nullptr) {
+        _openFiles.get(fileinfo->fh)->truncate(attr->st_size);
+      } else {
+        auto file = dynamic_pointer_move<File>(node);
+        if (file == none) {
+          throw FuseErrnoException(EISDIR);
+        }
+        (*file)->truncate(attr->st_size);
+        node = _load(ino);
+      }
+    }
+    if (toSet & (FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME | FUSE_SET_ATTR_ATIME_NOW | FUSE_SET_ATTR_MTIME_NOW)) {
+      // Node::utimens() sets both timestamps, so keep the current value of the one that isn't set
+      struct stat current;
+      node->stat(&current);
+      timespec now = cpputils::time::now();
+      timespec lastAccessTime = (toSet & FUSE_SET_ATTR_ATIME_NOW) ? now : (toSet & FUSE_SET_ATTR_ATIME) ? attr->st_atim : current.st_atim;
+      timespec lastModificationTime = (toSet & FUSE_SET_ATTR_MTIME_NOW) ? now : (toSet & FUSE_SET_ATTR_MTIME) ? attr->st_mtim : current.st_mtim;
+      node->utimens(lastAccessTime, lastModificationTime);
+    }
+    struct stat stbuf;
+    node->stat(&stbuf);
+    stbuf.st_ino = ino;
+    fuse_reply_attr(req, &stbuf, _attrTimeoutSeconds);
+  });
+}
+
+void FuseLowlevel::readlink(fuse_req_t req, fuse_ino_t ino) {
+  handleErrors(req, "readlink", [&] {
+    auto node = _load(ino);
+    auto symlink = dynamic_pointer_move<Symlink>(node);
+    if (symlink == none) {
+      throw FuseErrnoException(EINVAL);
+    }
+    fuse_reply_readlink(req, (*symlink)->target().c_str());
+  });
+}
+
+void FuseLowlevel::mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode) {
+  handleErrors(req, "mkdir", [&] {
+    const fuse_ctx *context = fuse_req_ctx(req);
+    _loadDir(parent)->createDir(name, mode, context->uid, context->gid);
+    _replyEntry(req, _lookupEntry(parent, name));
+  });
+}
+
+void FuseLowlevel::unlink(fuse_req_t req, fuse_ino_t parent, const char *name) {
+  handleErrors(req, "unlink", [&] {
+    //TODO Don't allow removing directories with this
+    Device::NodeId id = Device::NodeId::Null();
+    _loadChild(parent, name, &id)->remove();
+    fuse_reply_err(req, 0);
+  });
+}
+
+void FuseLowlevel::rmdir(fuse_req_t req, fuse_ino_t parent, const char *name) {
+  handleErrors(req, "rmdir", [&] {
+    //TODO Don't allow removing files/symlinks with this
+    Device::NodeId id = Device::NodeId::Null();
+    _loadChild(parent, name, &id)->remove();
+    fuse_reply_err(req, 0);
+  });
+}
+
+void FuseLowlevel::symlink(fuse_req_t req, const char *target, fuse_ino_t parent, const char *name) {
+  handleErrors(req, "symlink", [&] {
+    const fuse_ctx *context = fuse_req_ctx(req);
+    _loadDir(parent)->createSymlink(name, target, context->uid, context->gid);
+    _replyEntry(req, _lookupEntry(parent, name));
+  });
+}
+
+void FuseLowlevel::rename(fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname) {
+  handleErrors(req, "rename", [&] {
+    Device::NodeId id = Device::NodeId::Null();
+    auto node = _loadChild(parent, name, &id);
+    node->rename(_inodes.path(newparent) / newname);
+    _inodes.rename(id, newparent, newname);
+    fuse_reply_err(req, 0);
+  });
+}
+
+void FuseLowlevel::open(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  handleErrors(req, "open", [&] {
+    auto node = _load(ino);
+    auto file = dynamic_pointer_move<File>(node);
+    if (file == none) {
+      throw FuseErrnoException(EISDIR);
+    }
+    fileinfo->fh = _openFiles.open((*file)->open(fileinfo->flags));
+    if (fuse_reply_open(req, fileinfo) != 0) {
+      // The request was interrupted, so the kernel won't release the file
+      _openFiles.close(fileinfo->fh);
+    }
+  });
+}
+
+void FuseLowlevel::read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, fuse_file_info *fileinfo) {
+  UNUSED(ino);
+  handleErrors(req, "read", [&] {
+    vector<char> buf(size);
+    size_t numRead = _openFiles.get(fileinfo->fh)->read(buf.data(), size, offset);
+    fuse_reply_buf(req, buf.data(), numRead);
+  });
+}
+
+void FuseLowlevel::write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t offset, fuse_file_info *fileinfo) {
+  UNUSED(ino);
+  handleErrors(req, "write", [&] {
+    _openFiles.get(fileinfo->fh)->write(buf, size, offset);
+    fuse_reply_write(req, size);
+  });
+}
+
+void FuseLowlevel::flush(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  UNUSED(ino);
+  handleErrors(req, "flush", [&] {
+    _openFiles.get(fileinfo->fh)->flush();
+    fuse_reply_err(req, 0);
+  });
+}
+
+void FuseLowlevel::release(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  UNUSED(ino);
+  handleErrors(req, "release", [&] {
+    _openFiles.close(fileinfo->fh);
+    fuse_reply_err(req, 0);
+  });
+}
+
+void FuseLowlevel::fsync(fuse_req_t req, fuse_ino_t ino, int datasync, fuse_file_info *fileinfo) {
+  UNUSED(ino);
+  handleErrors(req, "fsync", [&] {
+    if (datasync) {
+      _openFiles.get(fileinfo->fh)->fdatasync();
+    } else {
+      _openFiles.get(fileinfo->fh)->fsync();
+    }
+    fuse_reply_err(req, 0);
+  });
+}
+
+void FuseLowlevel::opendir(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  handleErrors(req, "opendir", [&] {
+    fileinfo->fh = _openDirs.add(_loadDir(ino)->children());
+    if (fuse_reply_open(req, fileinfo) != 0) {
+      // The request was interrupted, so the kernel won't release the directory
+      _openDirs.remove(fileinfo->fh);
+    }
+  });
+}
+
+void FuseLowlevel::readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, fuse_file_info *fileinfo) {
+  UNUSED(ino);
+  handleErrors(req, "readdir", [&] {
+    const vector<Dir::Entry> &entries = *_openDirs.get(fileinfo->fh);
+    // The offset of an entry is the index of the entry after it, so the next call continues there
+    vector<char> buf(size);
+    size_t bufUsed = 0;
+    struct stat stbuf;
+    std::memset(&stbuf, 0, sizeof(stbuf));
+    for (size_t index = offset; index < entries.size(); ++index) {
+      const Dir::Entry &entry = entries[index];
+      if (entry.type == Dir::EntryType::DIR) {
+        stbuf.st_mode = S_IFDIR;
+      } else if (entry.type == Dir::EntryType::FILE) {
+        stbuf.st_mode = S_IFREG;
+      } else if (entry.type == Dir::EntryType::SYMLINK) {
+        stbuf.st_mode = S_IFLNK;
+      } else {
+        ASSERT(false, "Unknown entry type");
+      }
+      stbuf.st_ino = UNKNOWN_INODE;
+      size_t entrySize = fuse_add_direntry(req, buf.data() + bufUsed, size - bufUsed, entry.name.c_str(), &stbuf, index + 1);
+      if (entrySize > size - bufUsed) {
+        // The entry doesn't fit anymore, it is returned by the next call
+        break;
+      }
+      bufUsed += entrySize;
+    }
+    fuse_reply_buf(req, buf.data(), bufUsed);
+  });
+}
+
+void FuseLowlevel::releasedir(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo) {
+  UNUSED(ino);
+  handleErrors(req, "releasedir", [&] {
+    _openDirs.remove(fileinfo->fh);
+    fuse_reply_err(req, 0);
+  });
+}
+
+void FuseLowlevel::statfs(fuse_req_t req, fuse_ino_t ino) {
+  UNUSED(ino);
+  handleErrors(req, "statfs", [&] {
+    struct statvfs fsstat;
+    std::memset(&fsstat, 0, sizeof(fsstat));
+    _device->statfs("/", &fsstat);
+    fuse_reply_statfs(req, &fsstat);
+  });
+}
+
+void FuseLowlevel::access(fuse_req_t req, fuse_ino_t ino, int mask) {
+  handleErrors(req, "access", [&] {
+    _load(ino)->access(mask);
+    fuse_reply_err(req, 0);
+  });
+}
+
+void FuseLowlevel::create(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, fuse_file_info *fileinfo) {
+  handleErrors(req, "create", [&] {
+    const fuse_ctx *context = fuse_req_ctx(req);
+    auto openFile = _loadDir(parent)->createAndOpenFile(name, mode, context->uid, context->gid);
+    fileinfo->fh = _openFiles.open(std::move(openFile));
+    fuse_entry_param entry;
+    try {
+      entry = _lookupEntry(parent, name);
+    } catch (...) {
+      _openFiles.close(fileinfo->fh);
+      throw;
+    }
+    if (fuse_reply_create(req, &entry, fileinfo) != 0) {
+      // The request was interrupted, so the kernel neither got the inode nor will it release the file
+      _inodes.forget(entry.ino, 1);
+      _openFiles.close(fileinfo->fh);
+    }
+  });
+}
@@ -0,0 +1,95 @@
+#pragma once
+#ifndef MESSMER_FSPP_FUSE_FUSELOWLEVEL_H_
+#define MESSMER_FSPP_FUSE_FUSELOWLEVEL_H_
+
+#include "params.h"
+#ifdef __linux__
+#include <fuse_lowlevel.h>
+#elif __APPLE__
+#include <osxfuse/fuse_lowlevel.h>
+#endif
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <cpp-utils/macros.h>
+#include <cpp-utils/pointer/unique_ref.h>
+#include "../fs_interface/Dir.h"
+#include "../impl/InodeTable.h"
+#include "../impl/FuseOpenFileList.h"
+#include "../impl/IdList.h"
+
+namespace fspp {
+class Device;
+class Node;
+
+namespace fuse {
+
+// Alternative to Fuse that uses the inode based low level FUSE interface. The kernel addresses nodes by inode
+// instead of by path, and each inode knows the ids of the nodes on its path (see InodeTable), so an operation loads
+// its node with Device::LoadById() instead of resolving the path again. The kernel caches the looked up names and
+// the attributes for the given timeouts.
+class FuseLowlevel final {
+public:
+  static constexpr double DEFAULT_ENTRY_TIMEOUT_SECONDS = 1.0;
+  static constexpr double DEFAULT_ATTR_TIMEOUT_SECONDS = 1.0;
+
+  FuseLowlevel(Device *device, const std::string &fstype, const boost::optional<std::string> &fsname,
+               double entryTimeoutSeconds = DEFAULT_ENTRY_TIMEOUT_SECONDS, double attrTimeoutSeconds = DEFAULT_ATTR_TIMEOUT_SECONDS);
+
+  void run(const boost::filesystem::path &mountdir, const std::vector<std::string> &fuseOptions);
+  bool running() const;
+  void stop();
+
+  void init(fuse_conn_info *conn);
+  void destroy();
+  void lookup(fuse_req_t req, fuse_ino_t parent, const char *name);
+  void forget(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup);
+  void getattr(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo);
+  void setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int toSet, fuse_file_info *fileinfo);
+  void readlink(fuse_req_t req, fuse_ino_t ino);
+  void mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode);
+  void unlink(fuse_req_t req, fuse_ino_t parent, const char *name);
+  void rmdir(fuse_req_t req, fuse_ino_t parent, const char *name);
+  void symlink(fuse_req_t req, const char *target, fuse_ino_t parent, const char *name);
+  void rename(fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname);
+  void open(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo);
+  void read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, fuse_file_info *fileinfo);
+  void write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t offset, fuse_file_info *fileinfo);
+  void flush(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo);
+  void release(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo);
+  void fsync(fuse_req_t req, fuse_ino_t ino, int datasync, fuse_file_info *fileinfo);
+  void opendir(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo);
+  void readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, fuse_file_info *fileinfo);
+  void releasedir(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fileinfo);
+  void statfs(fuse_req_t req, fuse_ino_t ino);
+  void access(fuse_req_t req, fuse_ino_t ino, int mask);
+  void create(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, fuse_file_info *fileinfo);
+
+private:
+  cpputils::unique_ref<Node> _load(fuse_ino_t ino);
+  cpputils::unique_ref<Dir> _loadDir(fuse_ino_t ino);
+  cpputils::unique_ref<Node> _loadChild(fuse_ino_t parent, const std::string &name, Device::NodeId *id);
+  fuse_entry_param _lookupEntry(fuse_ino_t parent, const std::string &name);
+  void _replyEntry(fuse_req_t req, const fuse_entry_param &entry);
+  std::vector<std::string> _buildArgs(const boost::filesystem::path &mountdir, const std::vector<std::string> &fuseOptions) const;
+
+  Device *_device;
+  InodeTable _inodes;
+  FuseOpenFileList _openFiles;
+  // Children of the open directories, so the directory isn't loaded again for each readdir() call
+  IdList<std::vector<Dir::Entry>> _openDirs;
+  double _entryTimeoutSeconds;
+  double _attrTimeoutSeconds;
+  std::string _fstype;
+  boost::optional<std::string> _fsname;
+  boost::filesystem::path _mountdir;
+  bool _running;
+
+  DISALLOW_COPY_AND_ASSIGN(FuseLowlevel);
+};
+}
+}
+
+#endif
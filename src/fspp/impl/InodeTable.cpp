@@ -0,0 +1,145 @@
+#include "InodeTable.h"
+#include "../fuse/FuseErrnoException.h"
+#include <cpp-utils/assert/assert.h>
+#include <algorithm>
+#include <cstring>
+
+using std::string;
+using std::vector;
+using std::unique_lock;
+using std::mutex;
+
+namespace bf = boost::filesystem;
+
+namespace fspp {
+
+constexpr InodeTable::Inode InodeTable::ROOT_INODE;
+
+InodeTable::InodeTable()
+  : _entries(), _inodesById(), _nextInode(ROOT_INODE + 1), _mutex() {
+  // The root directory has an empty id path, so its id is never used. It is never forgotten.
+  _entries.emplace(ROOT_INODE, Entry{Device::NodeId::Null(), ROOT_INODE, "", 1, 0});
+}
+
+InodeTable::Inode InodeTable::lookup(Inode parent, const string &name, const Device::NodeId &id) {
+  unique_lock<mutex> lock(_mutex);
+  auto found = _inodesById.find(id);
+  if (found != _inodesById.end()) {
+    Inode inode = found->second;
+    Entry &entry = _get(inode);
+    if (entry.parent != parent || entry.name != name) {
+      _move(inode, parent, name);
+    }
+    ++entry.numLookups;
+    return inode;
+  }
+
+  Entry &parentEntry = _get(parent);
+  Inode inode = _nextInode++;
+  _entries.emplace(inode, Entry{id, parent, name, 1, 0});
+  _inodesById.emplace(id, inode);
+  ++parentEntry.numChildren;
+  return inode;
+}
+
+void InodeTable::forget(Inode inode, uint64_t numLookups) {
+  unique_lock<mutex> lock(_mutex);
+  if (inode == ROOT_INODE) {
+    return;
+  }
+  auto found = _entries.find(inode);
+  if (found == _entries.end()) {
+    ASSERT(false, "Forgot unknown inode");
+    return;
+  }
+  ASSERT(found->second.numLookups >= numLookups, "Forgot more lookups than there were");
+  found->second.numLookups -= std::min(numLookups, found->second.numLookups);
+  _removeIfUnused(inode);
+}
+
+void InodeTable::rename(const Device::NodeId &id, Inode newParent, const string &newName) {
+  unique_lock<mutex> lock(_mutex);
+  auto found = _inodesById.find(id);
+  if (found == _inodesById.end()) {
+    // The kernel doesn't know the node, so there is no inode to move
+    return;
+  }
+  _move(found->second, newParent, newName);
+}
+
+vector<Device::NodeId> InodeTable::ids(Inode inode) const {
+  unique_lock<mutex> lock(_mutex);
+  vector<Device::NodeId> result;
+  for (; inode != ROOT_INODE; inode = _get(inode).parent) {
+    result.push_back(_get(inode).id);
+  }
+  std::reverse(result.begin(), result.end());
+  return result;
+}
+
+bf::path InodeTable::path(Inode inode) const {
+  unique_lock<mutex> lock(_mutex);
+  vector<const string*> names;
+  for (; inode != ROOT_INODE; inode = _get(inode).parent) {
+    names.push_back(&_get(inode).name);
+  }
+  bf::path result = "/";
+  for (auto name = names.rbegin(); name != names.rend(); ++name) {
+    result /= **name;
+  }
+  return result;
+}
+
+size_t InodeTable::size() const {
+  unique_lock<mutex> lock(_mutex);
+  return _entries.size();
+}
+
+const InodeTable::Entry &InodeTable::_get(Inode inode) const {
+  auto found = _entries.find(inode);
+  if (found == _entries.end()) {
+    throw fuse::FuseErrnoException(ENOENT);
+  }
+  return found->second;
+}
+
+InodeTable::Entry &InodeTable::_get(Inode inode) {
+  return const_cast<Entry&>(const_cast<const InodeTable*>(this)->_get(inode));
+}
+
+void InodeTable::_move(Inode inode, Inode newParent, const string &newName) {
+  ASSERT(inode != ROOT_INODE, "Can't move the root directory");
+  Entry &entry = _get(inode);
+  Inode oldParent = entry.parent;
+  ++_get(newParent).numChildren;
+  entry.parent = newParent;
+  entry.name = newName;
+  --_get(oldParent).numChildren;
+  _removeIfUnused(oldParent);
+}
+
+void InodeTable::_removeIfUnused(Inode inode) {
+  // Removing an inode can leave its parent unused
+  while (inode != ROOT_INODE) {
+    auto found = _entries.find(inode);
+    ASSERT(found != _entries.end(), "Inode not found");
+    const Entry &entry = found->second;
+    if (entry.numLookups > 0 || entry.numChildren > 0) {
+      return;
+    }
+    Inode parent = entry.parent;
+    _inodesById.erase(entry.id);
+    _entries.erase(found);
+    --_get(parent).numChildren;
+    inode = parent;
+  }
+}
+
+size_t InodeTable::IdHash::operator()(const Device::NodeId &id) const {
+  // Node ids are random, so it is enough to use the first few bytes as a hash
+  size_t result;
+  std::memcpy(&result, id.data(), sizeof(result));
+  return result;
+}
+
+}
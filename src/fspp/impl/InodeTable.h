@@ -0,0 +1,69 @@
+#pragma once
+#ifndef MESSMER_FSPP_IMPL_INODETABLE_H_
+#define MESSMER_FSPP_IMPL_INODETABLE_H_
+
+#include "../fs_interface/Device.h"
+#include <cpp-utils/macros.h>
+#include <boost/filesystem/path.hpp>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fspp {
+
+// Assigns inode numbers to the nodes the kernel knows, for the inode based FUSE interface.
+// Each inode stores the id of its node and its parent inode, so the ids of all nodes on the path to it are known
+// without searching any directory. The kernel counts the lookups of an inode and forgets them when it drops the inode
+// from its cache. An inode is removed once it is forgotten and no other inode has it as parent anymore.
+class InodeTable final {
+public:
+  using Inode = uint64_t;
+  static constexpr Inode ROOT_INODE = 1;
+
+  InodeTable();
+
+  // Returns the inode for the child with this name and id of the parent directory and increases its lookup count
+  Inode lookup(Inode parent, const std::string &name, const Device::NodeId &id);
+  void forget(Inode inode, uint64_t numLookups);
+  // Call this after a node was moved, so its inode is moved too
+  void rename(const Device::NodeId &id, Inode newParent, const std::string &newName);
+
+  // Ids of the nodes on the path to the inode, as Device::LoadById() expects them. Throws ENOENT for unknown inodes.
+  std::vector<Device::NodeId> ids(Inode inode) const;
+  // Path of the inode when it was last looked up or renamed. Throws ENOENT for unknown inodes.
+  boost::filesystem::path path(Inode inode) const;
+
+  // Number of inodes, including the root directory
+  size_t size() const;
+
+private:
+  struct Entry final {
+    Device::NodeId id;
+    Inode parent;
+    std::string name;
+    uint64_t numLookups;
+    // Number of inodes that have this inode as parent
+    uint64_t numChildren;
+  };
+
+  struct IdHash final {
+    size_t operator()(const Device::NodeId &id) const;
+  };
+
+  const Entry &_get(Inode inode) const;
+  Entry &_get(Inode inode);
+  void _move(Inode inode, Inode newParent, const std::string &newName);
+  void _removeIfUnused(Inode inode);
+
+  std::unordered_map<Inode, Entry> _entries;
+  std::unordered_map<Device::NodeId, Inode, IdHash> _inodesById;
+  Inode _nextInode;
+  mutable std::mutex _mutex;
+
+  DISALLOW_COPY_AND_ASSIGN(InodeTable);
+};
+
+}
+
+#endif
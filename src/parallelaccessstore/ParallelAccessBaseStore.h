@@ -4,6 +4,8 @@
 
 #include <cpp-utils/pointer/unique_ref.h>
 #include <boost/optional.hpp>
+#include <cpp-utils/assert/assert.h>
+#include <vector>
 
 namespace parallelaccessstore {
 
@@ -13,6 +15,32 @@ public:
   virtual ~ParallelAccessBaseStore() {}
   virtual boost::optional<cpputils::unique_ref<Resource>> loadFromBaseStore(const Key &key) = 0;
   virtual void removeFromBaseStore(cpputils::unique_ref<Resource> block) = 0;
+
+  // Base stores that can load or remove several resources at once more efficiently override these.
+  virtual std::vector<boost::optional<cpputils::unique_ref<Resource>>> loadManyFromBaseStore(const std::vector<Key> &keys) {
+    // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+    std::vector<boost::optional<cpputils::unique_ref<Resource>>> result(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      result[i] = loadFromBaseStore(keys[i]);
+    }
+    return result;
+  }
+  virtual void removeManyFromBaseStore(std::vector<cpputils::unique_ref<Resource>> resources) {
+    for (auto &resource : resources) {
+      removeFromBaseStore(std::move(resource));
+    }
+  }
+  // Removes resources that aren't loaded. Base stores that can remove a resource without loading it override this.
+  virtual void removeManyFromBaseStoreByKey(const std::vector<Key> &keys) {
+    std::vector<cpputils::unique_ref<Resource>> resources;
+    resources.reserve(keys.size());
+    for (const Key &key : keys) {
+      auto resource = loadFromBaseStore(key);
+      ASSERT(resource != boost::none, "Resource to remove doesn't exist");
+      resources.push_back(std::move(*resource));
+    }
+    removeManyFromBaseStore(std::move(resources));
+  }
 };
 
 }
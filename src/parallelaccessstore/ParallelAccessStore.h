@@ -6,7 +6,11 @@
 #include <memory>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <future>
+#include <condition_variable>
+#include <algorithm>
 #include <cassert>
 #include <type_traits>
 #include <cpp-utils/macros.h>
@@ -26,6 +30,7 @@ public:
     ~ParallelAccessStore() {
         ASSERT(_openResources.size() == 0, "Still resources open when trying to destruct");
         ASSERT(_resourcesToRemove.size() == 0, "Still resources to remove when trying to destruct");
+        ASSERT(_keysInBaseStoreOperation.size() == 0, "Still base store operations running when trying to destruct");
     };
 
   class ResourceRefBase {
@@ -54,6 +59,19 @@ public:
   boost::optional<cpputils::unique_ref<ResourceRef>> load(const Key &key);
   boost::optional<cpputils::unique_ref<ResourceRef>> load(const Key &key, std::function<cpputils::unique_ref<ResourceRef>(Resource*)> createResourceRef);
   void remove(const Key &key, cpputils::unique_ref<ResourceRef> block);
+  // Like load() for each key, but the resources that aren't open yet are loaded with one call to the base store.
+  // A key can appear multiple times and then gets multiple references.
+  std::vector<boost::optional<cpputils::unique_ref<ResourceRef>>> loadMany(const std::vector<Key> &keys);
+  // Like remove() for each resource, but the resources are removed with one call to the base store
+  // once all other references to all of them are released.
+  void removeMany(std::vector<std::pair<Key, cpputils::unique_ref<ResourceRef>>> resources);
+  // Removes the resources with the given keys. The ones that aren't loaded at the moment are removed with one call
+  // to the base store without loading them. Loads of these keys wait until that call returned. The loaded ones
+  // are removed like in removeMany().
+  void removeManyByKey(const std::vector<Key> &keys);
+  // Returns references to the resources with the given keys that are loaded at the moment, and none for the other keys.
+  // notLoaded is called with the indices of the other keys, and loads of these keys wait until it returns.
+  std::vector<boost::optional<cpputils::unique_ref<ResourceRef>>> loadManyIfOpened(const std::vector<Key> &keys, std::function<void (const std::vector<size_t> &)> notLoaded);
 
 private:
   class OpenResource final {
@@ -89,6 +107,10 @@ private:
 
   std::unordered_map<Key, OpenResource> _openResources;
   std::map<Key, std::promise<cpputils::unique_ref<Resource>>> _resourcesToRemove;
+  // Keys of resources that aren't loaded and that are changed in the base store without holding _mutex.
+  // Loading them waits until the base store operation finished.
+  std::unordered_set<Key> _keysInBaseStoreOperation;
+  std::condition_variable _baseStoreOperationFinished;
 
   template<class ActualResourceRef>
   cpputils::unique_ref<ActualResourceRef> _add(const Key &key, cpputils::unique_ref<Resource> resource, std::function<cpputils::unique_ref<ActualResourceRef>(Resource*)> createResourceRef);
@@ -96,6 +118,10 @@ private:
   void release(const Key &key);
   friend class CachedResource;
 
+  void _waitForBaseStoreOperations(const std::vector<Key> &keys, std::unique_lock<std::mutex> *lock);
+  // Runs operation without holding _mutex. The keys must have been added to _keysInBaseStoreOperation while holding it.
+  void _runBaseStoreOperation(const std::vector<Key> &keys, const std::function<void ()> &operation);
+
   DISALLOW_COPY_AND_ASSIGN(ParallelAccessStore);
 };
 
@@ -104,7 +130,9 @@ ParallelAccessStore<Resource, ResourceRef, Key>::ParallelAccessStore(cpputils::u
   : _mutex(),
   _baseStore(std::move(baseStore)),
   _openResources(),
-  _resourcesToRemove() {
+  _resourcesToRemove(),
+  _keysInBaseStoreOperation(),
+  _baseStoreOperationFinished() {
   static_assert(std::is_base_of<ResourceRefBase, ResourceRef>::value, "ResourceRef must inherit from ResourceRefBase");
 }
 
@@ -150,7 +178,8 @@ boost::optional<cpputils::unique_ref<ResourceRef>> ParallelAccessStore<Resource,
 template<class Resource, class ResourceRef, class Key>
 boost::optional<cpputils::unique_ref<ResourceRef>> ParallelAccessStore<Resource, ResourceRef, Key>::load(const Key &key, std::function<cpputils::unique_ref<ResourceRef>(Resource*)> createResourceRef) {
   //TODO This lock doesn't allow loading different blocks in parallel. Can we only lock the requested key?
-  std::lock_guard<std::mutex> lock(_mutex);
+  std::unique_lock<std::mutex> lock(_mutex);
+  _waitForBaseStoreOperations({key}, &lock);
   auto found = _openResources.find(key);
   if (found == _openResources.end()) {
     auto resource = _baseStore->loadFromBaseStore(key);
@@ -175,13 +204,172 @@ void ParallelAccessStore<Resource, ResourceRef, Key>::remove(const Key &key, cpp
     resourceToRemoveFuture = insertResult.first->second.get_future();
   }
   cpputils::destruct(std::move(resource));
-  //Wait for last resource user to release it
+  //Wait for last resource user to release it. release() added the key to _keysInBaseStoreOperation.
   auto resourceToRemove = resourceToRemoveFuture.get();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _resourcesToRemove.erase(key);
+  }
+  _runBaseStoreOperation({key}, [this, &resourceToRemove] {
+    _baseStore->removeFromBaseStore(std::move(resourceToRemove));
+  });
+}
+
+template<class Resource, class ResourceRef, class Key>
+std::vector<boost::optional<cpputils::unique_ref<ResourceRef>>> ParallelAccessStore<Resource, ResourceRef, Key>::loadMany(const std::vector<Key> &keys) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _waitForBaseStoreOperations(keys, &lock);
+  std::vector<Key> keysToLoad;
+  std::unordered_set<Key> keysToLoadSet;
+  for (const Key &key : keys) {
+    if (_openResources.find(key) == _openResources.end() && keysToLoadSet.insert(key).second) {
+      keysToLoad.push_back(key);
+    }
+  }
+  auto loaded = _baseStore->loadManyFromBaseStore(keysToLoad);
+  for (size_t i = 0; i < keysToLoad.size(); ++i) {
+    if (loaded[i] != boost::none) {
+      // This doesn't get a reference yet, but the loop below adds one because its key is in keys
+      auto insertResult = _openResources.emplace(keysToLoad[i], std::move(*loaded[i]));
+      ASSERT(true == insertResult.second, "Inserting failed. Already exists.");
+    }
+  }
+
+  // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+  std::vector<boost::optional<cpputils::unique_ref<ResourceRef>>> result(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto found = _openResources.find(keys[i]);
+    if (found != _openResources.end()) {
+      auto resourceRef = cpputils::make_unique_ref<ResourceRef>(found->second.getReference());
+      resourceRef->init(this, keys[i]);
+      result[i] = std::move(resourceRef);
+    }
+  }
+  return result;
+}
+
+template<class Resource, class ResourceRef, class Key>
+void ParallelAccessStore<Resource, ResourceRef, Key>::removeMany(std::vector<std::pair<Key, cpputils::unique_ref<ResourceRef>>> resources) {
+  std::vector<std::future<cpputils::unique_ref<Resource>>> resourceToRemoveFutures;
+  resourceToRemoveFutures.reserve(resources.size());
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto &resource : resources) {
+      auto insertResult = _resourcesToRemove.emplace(resource.first, std::promise<cpputils::unique_ref<Resource>>());
+      ASSERT(true == insertResult.second, "Inserting failed");
+      resourceToRemoveFutures.push_back(insertResult.first->second.get_future());
+    }
+  }
+  for (auto &resource : resources) {
+    cpputils::destruct(std::move(resource.second));
+  }
+  //Wait for the last users of all resources to release them. release() added their keys to _keysInBaseStoreOperation.
+  std::vector<cpputils::unique_ref<Resource>> resourcesToRemove;
+  resourcesToRemove.reserve(resources.size());
+  for (auto &future : resourceToRemoveFutures) {
+    resourcesToRemove.push_back(future.get());
+  }
+  std::vector<Key> keys;
+  keys.reserve(resources.size());
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto &resource : resources) {
+      _resourcesToRemove.erase(resource.first);
+      keys.push_back(resource.first);
+    }
+  }
+  _runBaseStoreOperation(keys, [this, &resourcesToRemove] {
+    _baseStore->removeManyFromBaseStore(std::move(resourcesToRemove));
+  });
+}
 
-  std::lock_guard<std::mutex> lock(_mutex); // TODO Just added this as a precaution on a whim, but I seriously need to rethink locking here.
-  _resourcesToRemove.erase(key); //TODO Is this erase causing a race condition?
+template<class Resource, class ResourceRef, class Key>
+void ParallelAccessStore<Resource, ResourceRef, Key>::removeManyByKey(const std::vector<Key> &keys) {
+  std::vector<std::pair<Key, cpputils::unique_ref<ResourceRef>>> loadedResources;
+  std::vector<Key> keysToRemoveFromBaseStore;
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _waitForBaseStoreOperations(keys, &lock);
+    for (const Key &key : keys) {
+      auto found = _openResources.find(key);
+      if (found == _openResources.end()) {
+        if (_keysInBaseStoreOperation.insert(key).second) {
+          keysToRemoveFromBaseStore.push_back(key);
+        }
+      } else {
+        auto resourceRef = cpputils::make_unique_ref<ResourceRef>(found->second.getReference());
+        resourceRef->init(this, key);
+        loadedResources.emplace_back(key, std::move(resourceRef));
+      }
+    }
+  }
+  if (!keysToRemoveFromBaseStore.empty()) {
+    // Nobody can load these resources while they are removed, but other resources can be loaded and released meanwhile
+    _runBaseStoreOperation(keysToRemoveFromBaseStore, [this, &keysToRemoveFromBaseStore] {
+      _baseStore->removeManyFromBaseStoreByKey(keysToRemoveFromBaseStore);
+    });
+  }
+  if (!loadedResources.empty()) {
+    removeMany(std::move(loadedResources));
+  }
+}
 
-  _baseStore->removeFromBaseStore(std::move(resourceToRemove));
+template<class Resource, class ResourceRef, class Key>
+std::vector<boost::optional<cpputils::unique_ref<ResourceRef>>> ParallelAccessStore<Resource, ResourceRef, Key>::loadManyIfOpened(const std::vector<Key> &keys, std::function<void (const std::vector<size_t> &)> notLoaded) {
+  // Sized upfront, because vector can't move boost::optional<unique_ref> when growing
+  std::vector<boost::optional<cpputils::unique_ref<ResourceRef>>> result(keys.size());
+  std::vector<size_t> notLoadedIndices;
+  std::vector<Key> notLoadedKeys;
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _waitForBaseStoreOperations(keys, &lock);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      auto found = _openResources.find(keys[i]);
+      if (found == _openResources.end()) {
+        notLoadedIndices.push_back(i);
+        if (_keysInBaseStoreOperation.insert(keys[i]).second) {
+          notLoadedKeys.push_back(keys[i]);
+        }
+      } else {
+        auto resourceRef = cpputils::make_unique_ref<ResourceRef>(found->second.getReference());
+        resourceRef->init(this, keys[i]);
+        result[i] = std::move(resourceRef);
+      }
+    }
+  }
+  if (!notLoadedIndices.empty()) {
+    _runBaseStoreOperation(notLoadedKeys, [&notLoaded, &notLoadedIndices] {
+      notLoaded(notLoadedIndices);
+    });
+  }
+  return result;
+}
+
+template<class Resource, class ResourceRef, class Key>
+void ParallelAccessStore<Resource, ResourceRef, Key>::_waitForBaseStoreOperations(const std::vector<Key> &keys, std::unique_lock<std::mutex> *lock) {
+  _baseStoreOperationFinished.wait(*lock, [this, &keys] {
+    return std::none_of(keys.begin(), keys.end(), [this] (const Key &key) {
+      return _keysInBaseStoreOperation.find(key) != _keysInBaseStoreOperation.end();
+    });
+  });
+}
+
+template<class Resource, class ResourceRef, class Key>
+void ParallelAccessStore<Resource, ResourceRef, Key>::_runBaseStoreOperation(const std::vector<Key> &keys, const std::function<void ()> &operation) {
+  auto finish = [this, &keys] {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const Key &key : keys) {
+      _keysInBaseStoreOperation.erase(key);
+    }
+    _baseStoreOperationFinished.notify_all();
+  };
+  try {
+    operation();
+  } catch (...) {
+    finish();
+    throw;
+  }
+  finish();
 }
 
 template<class Resource, class ResourceRef, class Key>
@@ -193,6 +381,8 @@ void ParallelAccessStore<Resource, ResourceRef, Key>::release(const Key &key) {
   if (found->second.refCountIsZero()) {
 	  auto foundToRemove = _resourcesToRemove.find(key);
 	  if (foundToRemove != _resourcesToRemove.end()) {
+	    // The resource is removed from the base store without holding the lock. Loading it has to wait until then.
+	    _keysInBaseStoreOperation.insert(key);
 	    foundToRemove->second.set_value(found->second.moveResourceOut());
 	  }
 	  _openResources.erase(found);
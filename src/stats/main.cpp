@@ -65,6 +65,9 @@ set<Key> _getBlockstoreUnaccountedBlocks(const CryConfig &config) {
             auto innerNode = dynamic_pointer_move<DataInnerNode>(*node);
             if (innerNode != none) {
                 for (uint32_t childIndex = 0; childIndex < (*innerNode)->numChildren(); ++childIndex) {
+                    if ((*innerNode)->getChild(childIndex)->isHole()) {
+                        continue;
+                    }
                     auto child = (*innerNode)->getChild(childIndex)->key();
                     unaccountedBlocks.erase(child);
                 }
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <blockstore/implementations/inmemory/InMemoryBlockStore.h>
+#include <cpp-utils/data/Data.h>
+#include <cpp-utils/data/DataFixture.h>
+#include "blobstore/implementations/onblocks/BlobStoreOnBlocks.h"
+#include "blobstore/implementations/onblocks/datanodestore/DataNodeStore.h"
+#include "blobstore/implementations/onblocks/datanodestore/DataInnerNode.h"
+#include "blobstore/implementations/onblocks/datanodestore/DataLeafNode.h"
+#include "blobstore/implementations/onblocks/datanodestore/DataNodeView.h"
+
+using namespace blobstore;
+using namespace blobstore::onblocks;
+using blobstore::onblocks::datanodestore::DataNodeStore;
+using blobstore::onblocks::datanodestore::DataNodeLayout;
+using blockstore::BlockStore;
+using blockstore::Block;
+using blockstore::Key;
+using blockstore::inmemory::InMemoryBlockStore;
+using cpputils::unique_ref;
+using cpputils::make_unique_ref;
+using cpputils::Data;
+using cpputils::DataFixture;
+using boost::optional;
+using std::vector;
+
+namespace {
+// Forwards to a block store it doesn't own and counts how many blocks are loaded and prefetched from it.
+// Blocks stored with storeMany() are loaded by the base store, which doesn't count.
+class LoadCountingBlockStore final: public BlockStore {
+public:
+  LoadCountingBlockStore(BlockStore *baseBlockStore): _baseBlockStore(baseBlockStore), numLoads(0), numPrefetches(0) {}
+
+  Key createKey() override {
+    return _baseBlockStore->createKey();
+  }
+  optional<unique_ref<Block>> tryCreate(const Key &key, Data data) override {
+    return _baseBlockStore->tryCreate(key, std::move(data));
+  }
+  optional<unique_ref<Block>> load(const Key &key) override {
+    ++numLoads;
+    return _baseBlockStore->load(key);
+  }
+  vector<optional<unique_ref<Block>>> loadMany(const vector<Key> &keys) override {
+    numLoads += keys.size();
+    return _baseBlockStore->loadMany(keys);
+  }
+  void prefetchMany(const vector<Key> &keys) override {
+    numPrefetches += keys.size();
+  }
+  void storeMany(vector<std::pair<Key, Data>> blocks) override {
+    return _baseBlockStore->storeMany(std::move(blocks));
+  }
+  void remove(unique_ref<Block> block) override {
+    return _baseBlockStore->remove(std::move(block));
+  }
+  void remove(const Key &key) override {
+    return _baseBlockStore->remove(key);
+  }
+  uint64_t numBlocks() const override {
+    return _baseBlockStore->numBlocks();
+  }
+  uint64_t estimateNumFreeBytes() const override {
+    return _baseBlockStore->estimateNumFreeBytes();
+  }
+  uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize) const override {
+    return _baseBlockStore->blockSizeFromPhysicalBlockSize(blockSize);
+  }
+
+private:
+  BlockStore *_baseBlockStore;
+
+public:
+  uint64_t numLoads;
+  uint64_t numPrefetches;
+};
+}
+
+// Test cases, ensuring that reading from a large blob only loads the nodes on the path to the leaves that are read,
+// and that the size of the blob isn't computed again with each access.
+class BlobBlockLoadsTest : public ::testing::Test {
+public:
+    static constexpr size_t BLOCKSIZE = 32 * 1024;
+    static constexpr uint64_t MIN_BLOB_SIZE = UINT64_C(10)*1024*1024*1024; // 10 GiB
+
+    BlobBlockLoadsTest(): baseBlockStore(), blobSize(0), blobKey(createBlobWithSharedNodes()), blockStore(nullptr), blobStore(nullptr) {
+      auto countingBlockStore = make_unique_ref<LoadCountingBlockStore>(&baseBlockStore);
+      blockStore = countingBlockStore.get();
+      blobStore = std::make_unique<BlobStoreOnBlocks>(std::move(countingBlockStore), BLOCKSIZE);
+    }
+
+    // Storing 10 GiB of leaves would take too long and too much memory. But since the tree only references its
+    // children by key, all children of an inner node can be the same node. This is a valid tree for reading.
+    Key createBlobWithSharedNodes() {
+      DataNodeStore nodeStore(make_unique_ref<LoadCountingBlockStore>(&baseBlockStore), BLOCKSIZE);
+      uint32_t maxChildren = nodeStore.layout().maxChildrenPerInnerNode();
+      uint64_t maxBytesPerLeaf = nodeStore.layout().maxBytesPerLeaf();
+      auto leaf = nodeStore.createNewLeafNode();
+      leaf->resize(maxBytesPerLeaf);
+      auto fullTwoLevelTree = nodeStore.createNewInnerNode(*leaf);
+      while (fullTwoLevelTree->numChildren() < maxChildren) {
+        fullTwoLevelTree->addChild(*leaf);
+      }
+      auto root = nodeStore.createNewInnerNode(*fullTwoLevelTree);
+      while (root->numChildren() * maxChildren * maxBytesPerLeaf < MIN_BLOB_SIZE) {
+        root->addChild(*fullTwoLevelTree);
+      }
+      blobSize = root->numChildren() * maxChildren * maxBytesPerLeaf;
+      return root->key();
+    }
+
+    InMemoryBlockStore baseBlockStore;
+    uint64_t blobSize;
+    Key blobKey;
+    LoadCountingBlockStore *blockStore;
+    std::unique_ptr<BlobStore> blobStore;
+};
+
+constexpr size_t BlobBlockLoadsTest::BLOCKSIZE;
+constexpr uint64_t BlobBlockLoadsTest::MIN_BLOB_SIZE;
+
+TEST_F(BlobBlockLoadsTest, SizeIsCorrect) {
+    auto blob = blobStore->load(blobKey).value();
+    EXPECT_LE(MIN_BLOB_SIZE, blob->size());
+    EXPECT_EQ(blobSize, blob->size());
+}
+
+TEST_F(BlobBlockLoadsTest, RandomReadOnlyLoadsPathToLeaf) {
+    auto blob = blobStore->load(blobKey).value();
+    blob->size();
+    // Somewhere in the middle of a leaf, far from the end of the blob
+    uint64_t offset = blobSize / 3 / BLOCKSIZE * BLOCKSIZE + 100;
+    Data target(4096);
+    blockStore->numLoads = 0;
+    blob->read(target.data(), offset, target.size());
+    // The root node is already loaded. There is one inner node between the root and the leaf.
+    EXPECT_EQ(2u, blockStore->numLoads);
+}
+
+TEST_F(BlobBlockLoadsTest, PrefetchLoadsInnerNodesAndPrefetchesLeaves) {
+    DataNodeLayout layout(BLOCKSIZE);
+    auto blob = blobStore->load(blobKey).value();
+    blob->size();
+    // Ten leaves in the middle of one inner node, far from the end of the blob
+    uint64_t firstLeaf = blobSize / 3 / layout.maxBytesPerLeaf() / layout.maxChildrenPerInnerNode() * layout.maxChildrenPerInnerNode() + 5;
+    blockStore->numLoads = 0;
+    blob->prefetch(firstLeaf * layout.maxBytesPerLeaf(), 10 * layout.maxBytesPerLeaf());
+    // The root node is already loaded. There is one inner node between the root and the leaves.
+    EXPECT_EQ(1u, blockStore->numLoads);
+    EXPECT_EQ(10u, blockStore->numPrefetches);
+}
+
+TEST_F(BlobBlockLoadsTest, PrefetchAfterEndOfBlobDoesNothing) {
+    auto blob = blobStore->load(blobKey).value();
+    blob->size();
+    blockStore->numLoads = 0;
+    blob->prefetch(blobSize, 10 * BLOCKSIZE);
+    EXPECT_EQ(0u, blockStore->numLoads);
+    EXPECT_EQ(0u, blockStore->numPrefetches);
+}
+
+TEST_F(BlobBlockLoadsTest, SizeIsOnlyComputedOnceForAllInstancesOfABlob) {
+    auto blob1 = blobStore->load(blobKey).value();
+    blob1->size();
+    auto blob2 = blobStore->load(blobKey).value();
+    blockStore->numLoads = 0;
+    EXPECT_EQ(blobSize, blob2->size());
+    EXPECT_EQ(0u, blockStore->numLoads);
+}
+
+TEST_F(BlobBlockLoadsTest, RemovingBlobDoesntLoadLeaves) {
+    uint64_t numBlocksBefore = baseBlockStore.numBlocks();
+    auto blob = blobStore->create();
+    Data data(100 * BLOCKSIZE);
+    data.FillWithZeroes();
+    // Written zeroes aren't holes, so the blob has real leaves
+    blob->write(data.data(), 0, data.size());
+    EXPECT_LT(numBlocksBefore + 100, baseBlockStore.numBlocks());
+    blockStore->numLoads = 0;
+    blobStore->remove(std::move(blob));
+    // The root node is already loaded and all other nodes are leaves
+    EXPECT_EQ(0u, blockStore->numLoads);
+    EXPECT_EQ(numBlocksBefore, baseBlockStore.numBlocks());
+}
+
+TEST_F(BlobBlockLoadsTest, OverwritingFullLeavesDoesntLoadThem) {
+    DataNodeLayout layout(BLOCKSIZE);
+    auto blob = blobStore->create();
+    blob->write(DataFixture::generate(100 * layout.maxBytesPerLeaf()).data(), 0, 100 * layout.maxBytesPerLeaf());
+    Data data = DataFixture::generate(50 * layout.maxBytesPerLeaf(), 1);
+    blockStore->numLoads = 0;
+    blob->write(data.data(), 10 * layout.maxBytesPerLeaf(), data.size());
+    // The root node is already loaded and all other nodes are leaves
+    EXPECT_EQ(0u, blockStore->numLoads);
+    Data read(data.size());
+    blob->read(read.data(), 10 * layout.maxBytesPerLeaf(), read.size());
+    EXPECT_EQ(data, read);
+}
+
+TEST_F(BlobBlockLoadsTest, OverwritingPartsOfLeavesOnlyLoadsThePartialLeaves) {
+    DataNodeLayout layout(BLOCKSIZE);
+    auto blob = blobStore->create();
+    blob->write(DataFixture::generate(100 * layout.maxBytesPerLeaf()).data(), 0, 100 * layout.maxBytesPerLeaf());
+    Data data = DataFixture::generate(50 * layout.maxBytesPerLeaf(), 1);
+    blockStore->numLoads = 0;
+    blob->write(data.data(), 10 * layout.maxBytesPerLeaf() + 100, data.size());
+    // Only the first and the last leaf of the range are written partially
+    EXPECT_EQ(2u, blockStore->numLoads);
+    Data read(data.size());
+    blob->read(read.data(), 10 * layout.maxBytesPerLeaf() + 100, read.size());
+    EXPECT_EQ(data, read);
+}
@@ -0,0 +1,88 @@
+#include "testutils/BlobStoreTest.h"
+#include <cpp-utils/data/Data.h>
+#include <cpp-utils/data/DataFixture.h>
+#include "blobstore/implementations/onblocks/datanodestore/DataNodeView.h"
+
+using namespace blobstore;
+using blobstore::onblocks::datanodestore::DataNodeLayout;
+using cpputils::Data;
+using cpputils::DataFixture;
+using cpputils::unique_ref;
+
+class BlobHolesTest: public BlobStoreTest {
+public:
+  static constexpr uint64_t LARGE_SIZE = 10 * 1024 * 1024;
+  static constexpr DataNodeLayout LAYOUT = DataNodeLayout(BLOCKSIZE_BYTES);
+
+  BlobHolesTest(): blob(blobStore->create()) {
+    blob->resize(LARGE_SIZE);
+  }
+
+  void EXPECT_IS_ZERO(uint64_t offset, uint64_t size) {
+    Data read(size);
+    blob->read(read.data(), offset, size);
+    Data zeroes(size);
+    zeroes.FillWithZeroes();
+    EXPECT_EQ(zeroes, read);
+  }
+
+  unique_ref<Blob> blob;
+};
+constexpr uint64_t BlobHolesTest::LARGE_SIZE;
+constexpr DataNodeLayout BlobHolesTest::LAYOUT;
+
+TEST_F(BlobHolesTest, GrownBlobReadsAsZeroes) {
+  EXPECT_IS_ZERO(0, LARGE_SIZE);
+}
+
+TEST_F(BlobHolesTest, GrownBlobReadsAsZeroesAfterReloading) {
+  auto key = blob->key();
+  reset(std::move(blob));
+  blob = loadBlob(key);
+  EXPECT_EQ(LARGE_SIZE, blob->size());
+  EXPECT_IS_ZERO(0, LARGE_SIZE);
+}
+
+TEST_F(BlobHolesTest, WritingIntoHoleKeepsSurroundingZeroes) {
+  Data data = DataFixture::generate(3 * LAYOUT.maxBytesPerLeaf());
+  uint64_t offset = LARGE_SIZE / 2 + 100;
+  blob->write(data.data(), offset, data.size());
+  Data read(data.size());
+  blob->read(read.data(), offset, read.size());
+  EXPECT_EQ(data, read);
+  EXPECT_IS_ZERO(0, offset);
+  EXPECT_IS_ZERO(offset + data.size(), LARGE_SIZE - offset - data.size());
+}
+
+TEST_F(BlobHolesTest, WritingAfterEndLeavesHoleInBetween) {
+  Data data = DataFixture::generate(1000);
+  blob->write(data.data(), 2 * LARGE_SIZE, data.size());
+  EXPECT_EQ(2 * LARGE_SIZE + data.size(), blob->size());
+  EXPECT_IS_ZERO(0, 2 * LARGE_SIZE);
+}
+
+TEST_F(BlobHolesTest, SeekData) {
+  uint64_t offset = LARGE_SIZE / 2 + 100;
+  blob->write("a", offset, 1);
+  uint64_t leafBegin = offset / LAYOUT.maxBytesPerLeaf() * LAYOUT.maxBytesPerLeaf();
+  // The first leaf always exists
+  EXPECT_EQ(10u, blob->seekData(10).value());
+  EXPECT_EQ(leafBegin, blob->seekData(LAYOUT.maxBytesPerLeaf()).value());
+  EXPECT_EQ(offset, blob->seekData(offset).value());
+  // The last leaf always exists
+  uint64_t lastLeafBegin = (LARGE_SIZE - 1) / LAYOUT.maxBytesPerLeaf() * LAYOUT.maxBytesPerLeaf();
+  EXPECT_EQ(lastLeafBegin, blob->seekData(leafBegin + LAYOUT.maxBytesPerLeaf()).value());
+  EXPECT_EQ(boost::none, blob->seekData(LARGE_SIZE));
+}
+
+TEST_F(BlobHolesTest, SeekHole) {
+  uint64_t offset = LARGE_SIZE / 2 + 100;
+  blob->write("a", offset, 1);
+  uint64_t leafBegin = offset / LAYOUT.maxBytesPerLeaf() * LAYOUT.maxBytesPerLeaf();
+  EXPECT_EQ(LAYOUT.maxBytesPerLeaf(), blob->seekHole(0).value());
+  EXPECT_EQ(leafBegin - 10, blob->seekHole(leafBegin - 10).value());
+  EXPECT_EQ(leafBegin + LAYOUT.maxBytesPerLeaf(), blob->seekHole(offset).value());
+  // The end of the blob counts as hole
+  EXPECT_EQ(LARGE_SIZE, blob->seekHole(LARGE_SIZE - 1).value());
+  EXPECT_EQ(boost::none, blob->seekHole(LARGE_SIZE));
+}
@@ -0,0 +1,113 @@
+#include "testutils/DataTreeTest.h"
+
+using blobstore::onblocks::datanodestore::DataLeafNode;
+using blobstore::onblocks::datatreestore::DataTree;
+using cpputils::unique_ref;
+using std::vector;
+
+class DataTreeTest_Holes: public DataTreeTest {
+public:
+  DataTreeTest_Holes(): NUM_LEAVES(3 * nodeStore->layout().maxChildrenPerInnerNode() * nodeStore->layout().maxChildrenPerInnerNode()) {}
+
+  unique_ref<DataTree> CreateGrownTree() {
+    auto tree = treeStore.createNewTree();
+    tree->resizeNumBytes(NUM_LEAVES * nodeStore->layout().maxBytesPerLeaf());
+    return tree;
+  }
+
+  // Returns the leaves passed to func and marks all leaves passed to func or in a hole in the returned coverage.
+  vector<uint32_t> Traverse(DataTree *tree, uint32_t beginIndex, uint32_t endIndex, vector<uint32_t> *coverage) {
+    vector<uint32_t> leaves;
+    tree->traverseLeaves(beginIndex, endIndex, [&leaves, coverage] (DataLeafNode*, uint32_t index) {
+      leaves.push_back(index);
+      ++(*coverage)[index];
+    }, [coverage] (uint32_t holeBegin, uint32_t holeEnd) {
+      for (uint32_t index = holeBegin; index < holeEnd; ++index) {
+        ++(*coverage)[index];
+      }
+    });
+    return leaves;
+  }
+
+  const uint32_t NUM_LEAVES;
+};
+
+TEST_F(DataTreeTest_Holes, GrowingDoesntStoreZeroLeaves) {
+  auto tree = CreateGrownTree();
+  EXPECT_EQ(NUM_LEAVES, tree->numLeaves());
+  // Only the root and the paths to the first and to the last leaf exist
+  EXPECT_EQ(7u, nodeStore->numNodes());
+}
+
+TEST_F(DataTreeTest_Holes, TraversalReportsHoles) {
+  auto tree = CreateGrownTree();
+  vector<uint32_t> coverage(NUM_LEAVES, 0);
+  vector<uint32_t> leaves = Traverse(tree.get(), 0, NUM_LEAVES, &coverage);
+  EXPECT_EQ(vector<uint32_t>({0, NUM_LEAVES-1}), leaves);
+  EXPECT_EQ(vector<uint32_t>(NUM_LEAVES, 1), coverage);
+}
+
+TEST_F(DataTreeTest_Holes, TraversalWithoutOnHolesFillsHoles) {
+  auto tree = CreateGrownTree();
+  uint64_t numNodesBefore = nodeStore->numNodes();
+  vector<uint32_t> leaves;
+  tree->traverseLeaves(100, 110, [&leaves] (DataLeafNode *leaf, uint32_t index) {
+    EXPECT_EQ(leaf->maxStoreableBytes(), leaf->numBytes());
+    leaves.push_back(index);
+  });
+  EXPECT_EQ(vector<uint32_t>({100, 101, 102, 103, 104, 105, 106, 107, 108, 109}), leaves);
+  EXPECT_LT(numNodesBefore + 10, nodeStore->numNodes());
+
+  vector<uint32_t> coverage(NUM_LEAVES, 0);
+  EXPECT_EQ(leaves, Traverse(tree.get(), 100, 110, &coverage));
+}
+
+TEST_F(DataTreeTest_Holes, FilledLeavesAreStillThereAfterReloading) {
+  auto key = CreateGrownTree()->key();
+  {
+    auto tree = treeStore.load(key).value();
+    tree->traverseLeaves(300, 301, [] (DataLeafNode *leaf, uint32_t) {
+      uint8_t value = 5;
+      leaf->write(&value, 0, 1);
+    });
+  }
+  auto tree = treeStore.load(key).value();
+  vector<uint32_t> coverage(NUM_LEAVES, 0);
+  EXPECT_EQ(vector<uint32_t>({0, 300, NUM_LEAVES-1}), Traverse(tree.get(), 0, NUM_LEAVES, &coverage));
+  EXPECT_EQ(vector<uint32_t>(NUM_LEAVES, 1), coverage);
+}
+
+TEST_F(DataTreeTest_Holes, FirstLeafInHole) {
+  auto tree = CreateGrownTree();
+  EXPECT_EQ(1u, tree->firstLeafInHole(0).value());
+  EXPECT_EQ(200u, tree->firstLeafInHole(200).value());
+  EXPECT_EQ(boost::none, tree->firstLeafInHole(NUM_LEAVES-1));
+}
+
+TEST_F(DataTreeTest_Holes, FirstLeafWithData) {
+  auto tree = CreateGrownTree();
+  EXPECT_EQ(0u, tree->firstLeafWithData(0).value());
+  EXPECT_EQ(NUM_LEAVES-1, tree->firstLeafWithData(1).value());
+  EXPECT_EQ(boost::none, tree->firstLeafWithData(NUM_LEAVES));
+}
+
+TEST_F(DataTreeTest_Holes, ShrinkingIntoHoleCreatesRightBorder) {
+  auto tree = CreateGrownTree();
+  uint32_t newNumLeaves = NUM_LEAVES/2 + 3;
+  tree->resizeNumBytes(newNumLeaves * nodeStore->layout().maxBytesPerLeaf() - 10);
+  EXPECT_EQ(newNumLeaves, tree->numLeaves());
+  EXPECT_EQ(newNumLeaves-1, tree->firstLeafWithData(1).value());
+
+  // Computing the size from scratch walks the right border
+  auto key = tree->key();
+  cpputils::destruct(std::move(tree));
+  auto loaded = treeStore.load(key).value();
+  EXPECT_EQ(newNumLeaves * nodeStore->layout().maxBytesPerLeaf() - 10, loaded->numStoredBytes());
+}
+
+TEST_F(DataTreeTest_Holes, ShrinkingRemovesHoles) {
+  auto tree = CreateGrownTree();
+  tree->resizeNumBytes(1);
+  EXPECT_EQ(1u, tree->numLeaves());
+  EXPECT_EQ(1u, nodeStore->numNodes());
+}
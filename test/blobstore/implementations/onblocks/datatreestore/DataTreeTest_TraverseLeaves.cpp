@@ -1,5 +1,8 @@
 #include "testutils/DataTreeTest.h"
 #include <gmock/gmock.h>
+#include <thread>
+#include <atomic>
+#include <chrono>
 
 using ::testing::_;
 
@@ -64,6 +67,14 @@ public:
     });
   }
 
+  void TraverseLeavesInParallel(DataNode *root, uint32_t beginIndex, uint32_t endIndex) {
+    root->flush();
+    auto tree = treeStore.load(root->key()).value();
+    tree->traverseLeavesInParallel(beginIndex, endIndex, [this] (DataLeafNode *leaf, uint32_t nodeIndex) {
+      traversor.called(leaf, nodeIndex);
+    });
+  }
+
   TraversorMock traversor;
 };
 
@@ -383,4 +394,77 @@ TEST_F(DataTreeTest_TraverseLeaves, TraverseMiddlePartOfFourLevelTree) {
   TraverseLeaves(root.get(), nodeStore->layout().maxChildrenPerInnerNode()+5, 2*nodeStore->layout().maxChildrenPerInnerNode()*nodeStore->layout().maxChildrenPerInnerNode() + nodeStore->layout().maxChildrenPerInnerNode() -1);
 }
 
+TEST_F(DataTreeTest_TraverseLeaves, TraverseAllLeavesOfThreelevelTreeInParallel) {
+  auto root = CreateThreeLevel();
+  for(unsigned int i = 0; i < 5; ++i) {
+    EXPECT_TRAVERSE_ALL_CHILDREN_OF(*LoadInnerNode(root->getChild(i)->key()), i * nodeStore->layout().maxChildrenPerInnerNode());
+  }
+  auto child = LoadInnerNode(root->getChild(5)->key());
+  EXPECT_TRAVERSE_ALL_CHILDREN_OF(*child, 5 * nodeStore->layout().maxChildrenPerInnerNode());
+
+  TraverseLeavesInParallel(root.get(), 0, 5 * nodeStore->layout().maxChildrenPerInnerNode() + child->numChildren());
+}
+
+TEST_F(DataTreeTest_TraverseLeaves, TraverseMiddlePartOfThreelevelTreeInParallel) {
+  auto root = CreateThreeLevel();
+  auto secondChild = LoadInnerNode(root->getChild(1)->key());
+  for(unsigned int i = 5; i < secondChild->numChildren(); ++i) {
+    EXPECT_TRAVERSE_LEAF(secondChild->getChild(i)->key(), nodeStore->layout().maxChildrenPerInnerNode() + i);
+  }
+  auto thirdChild = LoadInnerNode(root->getChild(2)->key());
+  for(unsigned int i = 0; i < 3; ++i) {
+    EXPECT_TRAVERSE_LEAF(thirdChild->getChild(i)->key(), 2 * nodeStore->layout().maxChildrenPerInnerNode() + i);
+  }
+
+  TraverseLeavesInParallel(root.get(), nodeStore->layout().maxChildrenPerInnerNode() + 5, 2 * nodeStore->layout().maxChildrenPerInnerNode() + 3);
+}
+
+TEST_F(DataTreeTest_TraverseLeaves, ReadsRunConcurrently) {
+  auto root = CreateFullTwoLevel();
+  root->flush();
+  auto tree = treeStore.load(root->key()).value();
+  bool innerReadRan = false;
+  tree->readLeavesInParallel(0, 1, [&tree, &innerReadRan] (const DataLeafNode*, uint32_t) {
+    // This would deadlock if the first read held the lock exclusively
+    std::thread other([&tree, &innerReadRan] {
+      tree->readLeavesInParallel(1, 2, [&innerReadRan] (const DataLeafNode*, uint32_t) {
+        innerReadRan = true;
+      }, [] (uint32_t, uint32_t) {});
+    });
+    other.join();
+  }, [] (uint32_t, uint32_t) {});
+  EXPECT_TRUE(innerReadRan);
+}
+
+TEST_F(DataTreeTest_TraverseLeaves, ReadsWaitForTraversals) {
+  auto root = CreateFullTwoLevel();
+  root->flush();
+  auto tree = treeStore.load(root->key()).value();
+  std::atomic<bool> readRan(false);
+  std::thread reader;
+  tree->traverseLeaves(0, 1, [&tree, &readRan, &reader] (DataLeafNode*, uint32_t) {
+    // The traversal can change the leaves, so the read has to wait until it is finished
+    reader = std::thread([&tree, &readRan] {
+      tree->readLeavesInParallel(1, 2, [&readRan] (const DataLeafNode*, uint32_t) {
+        readRan = true;
+      }, [] (uint32_t, uint32_t) {});
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(readRan);
+  });
+  reader.join();
+  EXPECT_TRUE(readRan);
+}
+
+TEST_F(DataTreeTest_TraverseLeaves, ReadAfterTheEndOfTheTreeReadsHoles) {
+  auto root = CreateLeaf();
+  root->flush();
+  auto tree = treeStore.load(root->key()).value();
+  std::vector<std::pair<uint32_t, uint32_t>> holes;
+  tree->readLeavesInParallel(0, 3, [] (const DataLeafNode*, uint32_t) {}, [&holes] (uint32_t begin, uint32_t end) {
+    holes.emplace_back(begin, end);
+  });
+  EXPECT_EQ((std::vector<std::pair<uint32_t, uint32_t>>{{1, 3}}), holes);
+}
+
 //TODO Refactor the test cases that are too long
@@ -50,7 +50,7 @@ private:
     } else {
       auto inner = dynamic_cast<blobstore::onblocks::datanodestore::DataInnerNode*>(node);
       int leafIndex = firstLeafIndex;
-      for (uint32_t i = 0; i < inner->numChildren(); ++i) {
+      for (uint32_t i = 0; i < inner->numChildren() && leafIndex != endLeafIndex; ++i) {
         auto child = _dataNodeStore->load(inner->getChild(i)->key()).value();
         leafIndex = ForEachLeaf(child.get(), leafIndex, endLeafIndex, action);
       }
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "blockstore/implementations/caching/CachingBlockStore.h"
 #include "blockstore/implementations/testfake/FakeBlockStore.h"
+#include <boost/thread/thread.hpp>
+#include <cpp-utils/pointer/unique_ref_boost_optional_gtest_workaround.h>
 
 using ::testing::Test;
 
@@ -54,3 +56,89 @@ TEST_F(CachingBlockStoreTest, PhysicalBlockSize_positive) {
     auto base = baseBlockStore->load(key).value();
     EXPECT_EQ(10*1024u, blockStore.blockSizeFromPhysicalBlockSize(base->size()));
 }
+
+TEST_F(CachingBlockStoreTest, PrefetchedBlockIsLoadedFromCache) {
+    blockstore::Key key = baseBlockStore->create(Data(1024).FillWithZeroes())->key();
+    blockStore.prefetchMany({key});
+    // Modify the block in the base store. If the caching block store prefetched it, it doesn't see that modification.
+    baseBlockStore->load(key).value()->write("data", 0, 4);
+    EXPECT_EQ(0, std::memcmp(Data(4).FillWithZeroes().data(), blockStore.load(key).value()->data(), 4));
+}
+
+TEST_F(CachingBlockStoreTest, PrefetchingLoadedBlock_ModificationsReplacePrefetchedVersion) {
+    blockstore::Key key = baseBlockStore->create(Data(1024).FillWithZeroes())->key();
+    {
+        auto block = blockStore.load(key).value();
+        blockStore.prefetchMany({key});
+        block->write("data", 0, 4);
+    }
+    EXPECT_EQ(0, std::memcmp("data", blockStore.load(key).value()->data(), 4));
+}
+
+TEST_F(CachingBlockStoreTest, PrefetchingNonexistingBlock_IsIgnored) {
+    blockstore::Key key = blockStore.createKey();
+    blockStore.prefetchMany({key});
+    EXPECT_EQ(boost::none, blockStore.load(key));
+}
+
+class CachingBlockStoreTest_WriteBack: public Test {
+public:
+    static constexpr double MAX_DIRTY_AGE_SEC = 0.1;
+
+    CachingBlockStoreTest_WriteBack():
+            baseBlockStore(new FakeBlockStore),
+            blockStore(std::move(cpputils::nullcheck(std::unique_ptr<FakeBlockStore>(baseBlockStore)).value()), CachingBlockStore::DEFAULT_MAX_CACHE_SIZE_BYTES, MAX_DIRTY_AGE_SEC)  {
+    }
+    FakeBlockStore *baseBlockStore;
+    CachingBlockStore blockStore;
+
+    static void waitLongerThanMaxDirtyAge() {
+        boost::this_thread::sleep_for(boost::chrono::seconds(1));
+    }
+};
+
+constexpr double CachingBlockStoreTest_WriteBack::MAX_DIRTY_AGE_SEC;
+
+TEST_F(CachingBlockStoreTest_WriteBack, NewBlockIsWrittenBackAfterMaxDirtyAge) {
+    blockstore::Key key = blockStore.create(Data(1024).FillWithZeroes())->key();
+    EXPECT_EQ(boost::none, baseBlockStore->load(key));
+    waitLongerThanMaxDirtyAge();
+    EXPECT_NE(boost::none, baseBlockStore->load(key));
+}
+
+TEST_F(CachingBlockStoreTest_WriteBack, ModifiedBlockIsWrittenBackAfterMaxDirtyAge) {
+    blockstore::Key key = blockStore.create(Data(1024).FillWithZeroes())->key();
+    waitLongerThanMaxDirtyAge();
+    blockStore.load(key).value()->write("data", 0, 4);
+    EXPECT_EQ(0, std::memcmp(Data(4).FillWithZeroes().data(), baseBlockStore->load(key).value()->data(), 4));
+    waitLongerThanMaxDirtyAge();
+    EXPECT_EQ(0, std::memcmp("data", baseBlockStore->load(key).value()->data(), 4));
+}
+
+TEST_F(CachingBlockStoreTest_WriteBack, WrittenBackBlockStaysInCache) {
+    blockstore::Key key = blockStore.create(Data(1024).FillWithZeroes())->key();
+    waitLongerThanMaxDirtyAge();
+    // Modify the block in the base store. If the caching block store still has it cached, it doesn't see that modification.
+    baseBlockStore->load(key).value()->write("data", 0, 4);
+    EXPECT_EQ(0, std::memcmp(Data(4).FillWithZeroes().data(), blockStore.load(key).value()->data(), 4));
+}
+
+TEST_F(CachingBlockStoreTest_WriteBack, BlockRemovedByKeyIsNotWrittenBack) {
+    blockstore::Key key = blockStore.create(Data(1024).FillWithZeroes())->key();
+    waitLongerThanMaxDirtyAge();
+    blockStore.load(key).value()->write("data", 0, 4);
+    blockStore.remove(key);
+    // If the modified block was still in the cache, writing it back would bring it back to the base store
+    waitLongerThanMaxDirtyAge();
+    EXPECT_EQ(boost::none, baseBlockStore->load(key));
+    EXPECT_EQ(0u, blockStore.numBlocks());
+}
+
+TEST_F(CachingBlockStoreTest_WriteBack, NewBlockRemovedByKeyIsNeverCreatedInBaseStore) {
+    blockstore::Key key = blockStore.create(Data(1024).FillWithZeroes())->key();
+    blockStore.remove(key);
+    EXPECT_EQ(0u, blockStore.numBlocks());
+    waitLongerThanMaxDirtyAge();
+    EXPECT_EQ(boost::none, baseBlockStore->load(key));
+    EXPECT_EQ(0u, baseBlockStore->numBlocks());
+}
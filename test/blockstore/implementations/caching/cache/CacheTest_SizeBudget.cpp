@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "blockstore/implementations/caching/cache/Cache.h"
+#include "blockstore/implementations/caching/cache/ShardedCache.h"
+
+using ::testing::Test;
+
+using namespace blockstore::caching;
+
+// In these tests, each value is accounted with its own value as size.
+template<class CacheType>
+class CacheTest_SizeBudget: public Test {
+public:
+  static constexpr uint64_t MAX_SIZE = 100;
+
+  CacheTest_SizeBudget(): cache(MAX_SIZE, [] (const int &value) {return static_cast<uint64_t>(value);}) {}
+
+  CacheType cache;
+};
+
+using CacheTypes = ::testing::Types<Cache<int, int>, ShardedCache<int, int>>;
+TYPED_TEST_CASE(CacheTest_SizeBudget, CacheTypes);
+
+TYPED_TEST(CacheTest_SizeBudget, Empty) {
+  EXPECT_EQ(0u, this->cache.totalSize());
+  EXPECT_EQ(100u, this->cache.maxSize());
+}
+
+TYPED_TEST(CacheTest_SizeBudget, PushIncreasesTotalSize) {
+  this->cache.push(1, 30);
+  this->cache.push(2, 40);
+  EXPECT_EQ(70u, this->cache.totalSize());
+  EXPECT_EQ(2u, this->cache.size());
+}
+
+TYPED_TEST(CacheTest_SizeBudget, PopDecreasesTotalSize) {
+  this->cache.push(1, 30);
+  this->cache.push(2, 40);
+  EXPECT_EQ(30, this->cache.pop(1).value());
+  EXPECT_EQ(40u, this->cache.totalSize());
+}
+
+TYPED_TEST(CacheTest_SizeBudget, FillExactly) {
+  this->cache.push(1, 60);
+  this->cache.push(2, 40);
+  EXPECT_EQ(100u, this->cache.totalSize());
+  EXPECT_EQ(60, this->cache.pop(1).value());
+  EXPECT_EQ(40, this->cache.pop(2).value());
+}
+
+TYPED_TEST(CacheTest_SizeBudget, OverflowDeletesOldestEntry) {
+  this->cache.push(1, 60);
+  this->cache.push(2, 30);
+  this->cache.push(3, 20);
+  EXPECT_EQ(50u, this->cache.totalSize());
+  EXPECT_EQ(boost::none, this->cache.pop(1));
+  EXPECT_EQ(30, this->cache.pop(2).value());
+  EXPECT_EQ(20, this->cache.pop(3).value());
+}
+
+TYPED_TEST(CacheTest_SizeBudget, ManySmallEntries) {
+  for (int i = 0; i < 1000; ++i) {
+    this->cache.push(i, 1);
+  }
+  EXPECT_EQ(100u, this->cache.size());
+  EXPECT_EQ(100u, this->cache.totalSize());
+}
+
+TYPED_TEST(CacheTest_SizeBudget, EntryLargerThanBudgetIsNotCached) {
+  this->cache.push(1, 30);
+  this->cache.push(2, 101);
+  EXPECT_GE(100u, this->cache.totalSize());
+  EXPECT_EQ(boost::none, this->cache.pop(2));
+}
+
+TYPED_TEST(CacheTest_SizeBudget, ZeroSizedEntries) {
+  for (int i = 0; i < 1000; ++i) {
+    this->cache.push(i, 0);
+  }
+  EXPECT_EQ(1000u, this->cache.size());
+  EXPECT_EQ(0u, this->cache.totalSize());
+}
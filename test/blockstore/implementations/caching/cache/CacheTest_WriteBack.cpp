@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <boost/optional/optional_io.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "blockstore/implementations/caching/cache/Cache.h"
+#include "blockstore/implementations/caching/cache/ShardedCache.h"
+
+using ::testing::Test;
+using boost::none;
+using boost::posix_time::ptime;
+using std::vector;
+
+using namespace blockstore::caching;
+
+// In these tests, each value is accounted with its own value as size. flush() records the values it was called for,
+// or throws if failFlushes is set.
+template<class CacheType>
+class CacheTest_WriteBack: public Test {
+public:
+  static constexpr uint64_t MAX_SIZE = 100;
+  static constexpr uint64_t MAX_DIRTY_SIZE = 50;
+  static constexpr double MAX_DIRTY_AGE_SEC = 0.2;
+
+  CacheTest_WriteBack(): flushed(), flushedMutex(), failFlushes(false), cache(MAX_SIZE, [] (const int &value) {return static_cast<uint64_t>(value);},
+                                                            LRUEvictionPolicy<int>::Factory(), WriteBackOptions<int>{[this] (int &value) {
+    if (failFlushes) {
+      throw std::runtime_error("Flushing failed");
+    }
+    std::unique_lock<std::mutex> lock(flushedMutex);
+    flushed.push_back(value);
+  }, MAX_DIRTY_AGE_SEC, MAX_DIRTY_SIZE}) {}
+
+  vector<int> flushedValues() {
+    std::unique_lock<std::mutex> lock(flushedMutex);
+    return flushed;
+  }
+
+  static ptime now() {
+    return boost::posix_time::microsec_clock::local_time();
+  }
+
+  static void waitLongerThanMaxDirtyAge() {
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(static_cast<long>(1000 * (MAX_DIRTY_AGE_SEC + 2 * CacheType::PURGE_INTERVAL))));
+  }
+
+  vector<int> flushed;
+  std::mutex flushedMutex;
+  std::atomic<bool> failFlushes;
+  CacheType cache;
+};
+
+template<class CacheType> constexpr uint64_t CacheTest_WriteBack<CacheType>::MAX_SIZE;
+template<class CacheType> constexpr uint64_t CacheTest_WriteBack<CacheType>::MAX_DIRTY_SIZE;
+template<class CacheType> constexpr double CacheTest_WriteBack<CacheType>::MAX_DIRTY_AGE_SEC;
+
+using CacheTypes = ::testing::Types<Cache<int, int>, ShardedCache<int, int>>;
+TYPED_TEST_CASE(CacheTest_WriteBack, CacheTypes);
+
+TYPED_TEST(CacheTest_WriteBack, CleanEntryIsNotPurged) {
+  this->cache.push(1, 10);
+  this->waitLongerThanMaxDirtyAge();
+  EXPECT_EQ(10, this->cache.pop(1).value());
+  EXPECT_EQ(vector<int>{}, this->flushedValues());
+}
+
+TYPED_TEST(CacheTest_WriteBack, DirtyEntryIsNotFlushedBeforeMaxDirtyAge) {
+  this->cache.push(1, 10, this->now());
+  EXPECT_EQ(vector<int>{}, this->flushedValues());
+  EXPECT_EQ(10u, this->cache.dirtySize());
+}
+
+TYPED_TEST(CacheTest_WriteBack, DirtyEntryIsFlushedButStaysInCache) {
+  this->cache.push(1, 10, this->now());
+  this->waitLongerThanMaxDirtyAge();
+  EXPECT_EQ(vector<int>{10}, this->flushedValues());
+  EXPECT_EQ(0u, this->cache.dirtySize());
+  boost::optional<ptime> dirtySince;
+  EXPECT_EQ(10, this->cache.pop(1, &dirtySince).value());
+  EXPECT_FALSE(dirtySince.is_initialized());
+}
+
+TYPED_TEST(CacheTest_WriteBack, PopReturnsDirtySince) {
+  ptime time = this->now();
+  this->cache.push(1, 10, time);
+  boost::optional<ptime> dirtySince;
+  EXPECT_EQ(10, this->cache.pop(1, &dirtySince).value());
+  EXPECT_EQ(time, dirtySince.value());
+  EXPECT_EQ(0u, this->cache.dirtySize());
+}
+
+TYPED_TEST(CacheTest_WriteBack, RepeatedModificationsAreFlushedOnce) {
+  ptime time = this->now();
+  this->cache.push(1, 10, time);
+  for (int i = 0; i < 5; ++i) {
+    boost::optional<ptime> dirtySince;
+    int value = this->cache.pop(1, &dirtySince).value();
+    this->cache.push(1, value, dirtySince);
+  }
+  this->waitLongerThanMaxDirtyAge();
+  EXPECT_EQ(vector<int>{10}, this->flushedValues());
+}
+
+TYPED_TEST(CacheTest_WriteBack, ExceedingDirtySizeFlushesOldestDirtyEntries) {
+  this->cache.push(1, 20, this->now());
+  this->cache.push(2, 20, this->now());
+  this->cache.push(3, 5);
+  EXPECT_EQ(vector<int>{}, this->flushedValues());
+  this->cache.push(4, 20, this->now());
+  EXPECT_EQ(vector<int>{20}, this->flushedValues());
+  EXPECT_EQ(40u, this->cache.dirtySize());
+  EXPECT_EQ(65u, this->cache.totalSize());
+}
+
+TYPED_TEST(CacheTest_WriteBack, EvictedDirtyEntryIsNotFlushed) {
+  // The Value destructor is responsible for writing back evicted entries
+  this->cache.push(1, 40, this->now());
+  this->cache.push(2, 30);
+  this->cache.push(3, 40);
+  EXPECT_EQ(none, this->cache.pop(1));
+  EXPECT_EQ(vector<int>{}, this->flushedValues());
+  EXPECT_EQ(0u, this->cache.dirtySize());
+}
+
+TYPED_TEST(CacheTest_WriteBack, FailedFlushKeepsEntryDirty) {
+  this->failFlushes = true;
+  ptime time = this->now();
+  this->cache.push(1, 10, time);
+  this->waitLongerThanMaxDirtyAge();
+  EXPECT_EQ(vector<int>{}, this->flushedValues());
+  EXPECT_EQ(10u, this->cache.dirtySize());
+  boost::optional<ptime> dirtySince;
+  EXPECT_EQ(10, this->cache.pop(1, &dirtySince).value());
+  EXPECT_EQ(time, dirtySince.value());
+}
+
+TYPED_TEST(CacheTest_WriteBack, FailedFlushIsRetried) {
+  this->failFlushes = true;
+  this->cache.push(1, 10, this->now());
+  this->waitLongerThanMaxDirtyAge();
+  this->failFlushes = false;
+  this->waitLongerThanMaxDirtyAge();
+  EXPECT_EQ(vector<int>{10}, this->flushedValues());
+  EXPECT_EQ(0u, this->cache.dirtySize());
+}
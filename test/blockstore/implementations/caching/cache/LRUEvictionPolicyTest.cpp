@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include <boost/optional/optional_io.hpp>
+#include "blockstore/implementations/caching/cache/LRUEvictionPolicy.h"
+
+using ::testing::Test;
+using boost::none;
+
+using namespace blockstore::caching;
+
+class LRUEvictionPolicyTest: public Test {
+public:
+  LRUEvictionPolicy<int> policy;
+};
+
+TEST_F(LRUEvictionPolicyTest, Empty) {
+  EXPECT_EQ(none, policy.victim());
+}
+
+TEST_F(LRUEvictionPolicyTest, VictimIsOldestEntry) {
+  policy.onPush(1, 10);
+  policy.onPush(2, 10);
+  EXPECT_EQ(1, policy.victim().value());
+}
+
+TEST_F(LRUEvictionPolicyTest, EvictingRemovesEntry) {
+  policy.onPush(1, 10);
+  policy.onPush(2, 10);
+  policy.onEvict(1);
+  EXPECT_EQ(2, policy.victim().value());
+  policy.onEvict(2);
+  EXPECT_EQ(none, policy.victim());
+}
+
+TEST_F(LRUEvictionPolicyTest, ReferencedEntryIsEvictedLast) {
+  policy.onPush(1, 10);
+  policy.onPush(2, 10);
+  policy.onPop(1);
+  policy.onPush(1, 10);
+  EXPECT_EQ(2, policy.victim().value());
+}
@@ -0,0 +1,103 @@
+#include "testutils/ShardedCacheTest.h"
+
+#include "blockstore/implementations/caching/cache/ShardedCache.h"
+#include "testutils/MinimalKeyType.h"
+#include "testutils/MinimalValueType.h"
+#include <cpp-utils/pointer/unique_ref_boost_optional_gtest_workaround.h>
+
+using ::testing::Test;
+
+using namespace blockstore::caching;
+
+// MinimalKeyType hashes to its value, so key i is stored in shard i % NUM_SHARDS.
+class ShardedCacheTest_PushAndPop: public ShardedCacheTest {};
+
+TEST_F(ShardedCacheTest_PushAndPop, PopNonExistingEntry_EmptyCache) {
+  EXPECT_EQ(boost::none, pop(10));
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, PopNonExistingEntry_NonEmptyCache) {
+  push(9, 10);
+  EXPECT_EQ(boost::none, pop(10));
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, PopNonExistingEntry_SameShard) {
+  push(10, 10);
+  EXPECT_EQ(boost::none, pop(10 + NUM_SHARDS));
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, OneEntry) {
+  push(10, 20);
+  EXPECT_EQ(20, pop(10).value());
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, MultipleEntries_DifferentShards) {
+  push(10, 20);
+  push(11, 30);
+  push(12, 40);
+  EXPECT_EQ(30, pop(11).value());
+  EXPECT_EQ(20, pop(10).value());
+  EXPECT_EQ(40, pop(12).value());
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, MultipleEntries_SameShard) {
+  push(10, 20);
+  push(10 + NUM_SHARDS, 30);
+  push(10 + 2*NUM_SHARDS, 40);
+  EXPECT_EQ(30, pop(10 + NUM_SHARDS).value());
+  EXPECT_EQ(20, pop(10).value());
+  EXPECT_EQ(40, pop(10 + 2*NUM_SHARDS).value());
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, Size) {
+  EXPECT_EQ(0u, size());
+  push(10, 20);
+  push(11, 30);
+  push(10 + NUM_SHARDS, 40);
+  EXPECT_EQ(3u, size());
+  pop(11);
+  EXPECT_EQ(2u, size());
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, FullCache) {
+  // Keys 0..MAX_ENTRIES-1 are evenly distributed, so they exactly fill all shards
+  for(unsigned int i = 0; i < MAX_ENTRIES; ++i) {
+    push(i, 2*i);
+  }
+  EXPECT_EQ(MAX_ENTRIES, size());
+  for(unsigned int i = 0; i < MAX_ENTRIES; ++i) {
+    EXPECT_EQ((signed int)(2*i), pop(i).value());
+  }
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, FullCache_DeletesOldestEntryOfLargestShard) {
+  push(1, 100);
+  for(unsigned int i = 0; i < MAX_ENTRIES - 1; ++i) {
+    push(i * NUM_SHARDS, i);
+  }
+  push((MAX_ENTRIES - 1) * NUM_SHARDS, MAX_ENTRIES - 1);
+  EXPECT_EQ(MAX_ENTRIES, size());
+  EXPECT_EQ(boost::none, pop(0));
+  EXPECT_EQ(100, pop(1).value());
+  for(unsigned int i = 1; i < MAX_ENTRIES; ++i) {
+    EXPECT_EQ((signed int)i, pop(i * NUM_SHARDS).value());
+  }
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, FullCache_KeepsEntryInSmallShard) {
+  push(1, 100);
+  for(unsigned int i = 0; i < 2*MAX_ENTRIES; ++i) {
+    push(i * NUM_SHARDS, i);
+  }
+  EXPECT_EQ(100, pop(1).value());
+}
+
+TEST_F(ShardedCacheTest_PushAndPop, FullCache_NewEntryInEmptyShard) {
+  for(unsigned int i = 0; i < MAX_ENTRIES; ++i) {
+    push(i * NUM_SHARDS, i);
+  }
+  push(1, 100);
+  EXPECT_EQ(MAX_ENTRIES, size());
+  EXPECT_EQ(100, pop(1).value());
+  EXPECT_EQ(boost::none, pop(0));
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <boost/optional/optional_io.hpp>
+#include "blockstore/implementations/caching/cache/TwoQueueEvictionPolicy.h"
+#include "blockstore/implementations/caching/cache/Cache.h"
+#include "blockstore/implementations/caching/cache/ShardedCache.h"
+
+using ::testing::Test;
+using boost::none;
+
+using namespace blockstore::caching;
+
+class TwoQueueEvictionPolicyTest: public Test {
+public:
+  // With a budget of 100, at most 25 are in the queue of new entries before they are evicted first,
+  // and the keys of up to 50 evicted entries are remembered.
+  TwoQueueEvictionPolicyTest(): policy(100) {}
+
+  void access(int key) {
+    policy.onPop(key);
+    policy.onPush(key, 10);
+  }
+
+  TwoQueueEvictionPolicy<int> policy;
+};
+
+TEST_F(TwoQueueEvictionPolicyTest, Empty) {
+  EXPECT_EQ(none, policy.victim());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, WithOnlyNewEntries_VictimIsOldestEntry) {
+  policy.onPush(1, 10);
+  policy.onPush(2, 10);
+  EXPECT_EQ(1, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, WithOnlyReferencedEntries_VictimIsLeastRecentlyUsed) {
+  policy.onPush(1, 10);
+  policy.onPush(2, 10);
+  access(1);
+  access(2);
+  EXPECT_EQ(1, policy.victim().value());
+  access(1);
+  EXPECT_EQ(2, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, WhileNewEntriesFitIntoTheirShare_ReferencedEntriesAreEvicted) {
+  policy.onPush(1, 10);
+  access(1);
+  policy.onPush(2, 10);
+  policy.onPush(3, 10);
+  EXPECT_EQ(1, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, WhenNewEntriesExceedTheirShare_NewEntriesAreEvicted) {
+  policy.onPush(1, 10);
+  access(1);
+  policy.onPush(2, 10);
+  policy.onPush(3, 10);
+  policy.onPush(4, 10);
+  EXPECT_EQ(2, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, EvictedNewEntryThatComesBack_CountsAsReferenced) {
+  policy.onPush(1, 10);
+  policy.onPush(2, 10);
+  policy.onEvict(1);
+  policy.onPush(1, 10);
+  policy.onPush(3, 10);
+  // 1 is in the queue of referenced entries now, so the oldest new entry is evicted first only if new entries exceed their share
+  EXPECT_EQ(1, policy.victim().value());
+  policy.onPush(4, 10);
+  EXPECT_EQ(2, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, EvictedReferencedEntryThatComesBack_CountsAsNew) {
+  policy.onPush(1, 10);
+  access(1);
+  policy.onEvict(1);
+  policy.onPush(2, 10);
+  access(2);
+  policy.onPush(1, 10);
+  EXPECT_EQ(2, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, RemembersOnlyLimitedNumberOfEvictedKeys) {
+  for (int key = 0; key < 10; ++key) {
+    policy.onPush(key, 10);
+    policy.onEvict(key);
+  }
+  // Key 0 was forgotten, key 9 is still remembered
+  policy.onPush(0, 10);
+  policy.onPush(9, 10);
+  policy.onPush(10, 10);
+  EXPECT_EQ(9, policy.victim().value());
+  policy.onEvict(9);
+  EXPECT_EQ(0, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, PrefetchedEntryThatIsUsedOnce_CountsAsNew) {
+  policy.onPush(1, 10);
+  access(1);
+  policy.onPrefetch(2, 10);
+  access(2);
+  policy.onPush(3, 10);
+  // 2 is still a new entry, so it is evicted before the referenced entry 1 once new entries exceed their share
+  policy.onPush(4, 10);
+  EXPECT_EQ(2, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, PrefetchedEntryThatIsUsedTwice_CountsAsReferenced) {
+  policy.onPrefetch(1, 10);
+  access(1);
+  access(1);
+  policy.onPush(2, 10);
+  EXPECT_EQ(1, policy.victim().value());
+  policy.onPush(3, 10);
+  policy.onPush(4, 10);
+  EXPECT_EQ(2, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, EvictedPrefetchedEntryThatComesBack_CountsAsNew) {
+  policy.onPrefetch(1, 10);
+  policy.onEvict(1);
+  policy.onPush(1, 10);
+  policy.onPush(2, 10);
+  policy.onPush(3, 10);
+  EXPECT_EQ(1, policy.victim().value());
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, CacheKeepsReferencedEntriesDuringScan) {
+  Cache<int, int> cache(10, Cache<int, int>::CountAsOneEntry, TwoQueueEvictionPolicy<int>::Factory());
+  for (int key = 0; key < 5; ++key) {
+    cache.push(key, key);
+    cache.push(key, cache.pop(key).value());
+  }
+  // Scan over more entries than fit into the cache
+  for (int key = 100; key < 200; ++key) {
+    cache.push(key, key);
+  }
+  for (int key = 0; key < 5; ++key) {
+    EXPECT_EQ(key, cache.pop(key).value());
+  }
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, LRUCacheLosesReferencedEntriesDuringScan) {
+  Cache<int, int> cache(10);
+  for (int key = 0; key < 5; ++key) {
+    cache.push(key, key);
+    cache.push(key, cache.pop(key).value());
+  }
+  for (int key = 100; key < 200; ++key) {
+    cache.push(key, key);
+  }
+  for (int key = 0; key < 5; ++key) {
+    EXPECT_EQ(none, cache.pop(key));
+  }
+}
+
+TEST_F(TwoQueueEvictionPolicyTest, CacheKeepsReferencedEntriesDuringScanWithPrefetching) {
+  ShardedCache<int, int, 1> cache(10, Cache<int, int>::CountAsOneEntry, TwoQueueEvictionPolicy<int>::Factory());
+  for (int key = 0; key < 5; ++key) {
+    cache.push(key, key);
+    cache.push(key, cache.pop(key).value());
+  }
+  // Scan with read-ahead: each entry is prefetched before it is used
+  for (int key = 100; key < 200; ++key) {
+    cache.pushPrefetched(key + 1, key + 1);
+    cache.push(key, cache.pop(key).value_or(key));
+  }
+  for (int key = 0; key < 5; ++key) {
+    EXPECT_EQ(key, cache.pop(key).value());
+  }
+}
@@ -13,14 +13,14 @@
 // Furthermore, the class checks that there are no memory leaks left after destructing the QueueMap (by counting leftover instances of Keys/Values).
 class CacheTest: public ::testing::Test {
 public:
-  CacheTest(): _cache() {}
+  CacheTest(): _cache(MAX_ENTRIES) {}
 
   void push(int key, int value);
   boost::optional<int> pop(int key);
 
   static constexpr unsigned int MAX_ENTRIES = 100;
 
-  using Cache = blockstore::caching::Cache<MinimalKeyType, MinimalValueType, MAX_ENTRIES>;
+  using Cache = blockstore::caching::Cache<MinimalKeyType, MinimalValueType>;
 
 private:
   Cache _cache;
@@ -0,0 +1,20 @@
+#include "ShardedCacheTest.h"
+
+constexpr unsigned int ShardedCacheTest::MAX_ENTRIES;
+constexpr unsigned int ShardedCacheTest::NUM_SHARDS;
+
+void ShardedCacheTest::push(int key, int value) {
+  return _cache.push(MinimalKeyType::create(key), MinimalValueType::create(value));
+}
+
+boost::optional<int> ShardedCacheTest::pop(int key) {
+  boost::optional<MinimalValueType> entry = _cache.pop(MinimalKeyType::create(key));
+  if (!entry) {
+    return boost::none;
+  }
+  return entry->value();
+}
+
+uint32_t ShardedCacheTest::size() const {
+  return _cache.size();
+}
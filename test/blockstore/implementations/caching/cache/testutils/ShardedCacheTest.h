@@ -0,0 +1,30 @@
+#pragma once
+#ifndef MESSMER_BLOCKSTORE_TEST_IMPLEMENTATIONS_CACHING_CACHE_TESTUTILS_SHARDEDCACHETEST_H_
+#define MESSMER_BLOCKSTORE_TEST_IMPLEMENTATIONS_CACHING_CACHE_TESTUTILS_SHARDEDCACHETEST_H_
+
+#include <gtest/gtest.h>
+#include "blockstore/implementations/caching/cache/ShardedCache.h"
+#include "MinimalKeyType.h"
+#include "MinimalValueType.h"
+#include <boost/optional.hpp>
+
+// This class is a parent class for tests on ShardedCache.
+// It offers functions to work with a ShardedCache test object which is built using types having only the minimal type requirements.
+class ShardedCacheTest: public ::testing::Test {
+public:
+  ShardedCacheTest(): _cache(MAX_ENTRIES) {}
+
+  void push(int key, int value);
+  boost::optional<int> pop(int key);
+  uint32_t size() const;
+
+  static constexpr unsigned int MAX_ENTRIES = 100;
+  static constexpr unsigned int NUM_SHARDS = 16;
+
+  using Cache = blockstore::caching::ShardedCache<MinimalKeyType, MinimalValueType, NUM_SHARDS>;
+
+private:
+  Cache _cache;
+};
+
+#endif
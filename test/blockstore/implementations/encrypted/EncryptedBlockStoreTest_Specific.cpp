@@ -44,13 +44,24 @@ public:
   }
 
   void ModifyBaseBlock(const blockstore::Key &key) {
+    // The base store is accessed directly, so the store doesn't wait for pending writes to it
+    blockStore->waitForPendingWrites();
     auto block = baseBlockStore->load(key).value();
     uint8_t middle_byte = ((byte*)block->data())[10];
     uint8_t new_middle_byte = middle_byte + 1;
     block->write(&new_middle_byte, 10, 1);
   }
 
+  Data LoadBaseBlockData(const blockstore::Key &key) {
+    blockStore->waitForPendingWrites();
+    auto block = baseBlockStore->load(key).value();
+    Data result(block->size());
+    std::memcpy(result.data(), block->data(), block->size());
+    return result;
+  }
+
   blockstore::Key CopyBaseBlock(const blockstore::Key &key) {
+    blockStore->waitForPendingWrites();
     auto source = baseBlockStore->load(key).value();
     return blockstore::utils::copyToNewBlock(baseBlockStore, *source)->key();
   }
@@ -143,3 +154,45 @@ TEST_F(EncryptedBlockStoreTest, PhysicalBlockSize_positive) {
   auto base = baseBlockStore->load(key).value();
   EXPECT_EQ(10*1024u, blockStore->blockSizeFromPhysicalBlockSize(base->size()));
 }
+
+TEST_F(EncryptedBlockStoreTest, LoadingWaitsForPendingWrite) {
+  for (int i = 0; i < 20; ++i) {
+    auto key = CreateBlockWriteFixtureToItAndReturnKey();
+    auto loaded = blockStore->load(key).value();
+    EXPECT_EQ(0, std::memcmp(data.data(), loaded->data(), data.size()));
+  }
+}
+
+TEST_F(EncryptedBlockStoreTest, FlushWritesBaseBlock) {
+  auto block = blockStore->create(Data(data.size()));
+  Data baseBefore = LoadBaseBlockData(block->key());
+  block->write(data.data(), 0, data.size());
+  block->flush();
+  blockStore->waitForPendingWrites();
+  EXPECT_NE(baseBefore, LoadBaseBlockData(block->key()));
+}
+
+TEST_F(EncryptedBlockStoreTest, FlushWritesBaseBlockBeforeReturning) {
+  auto block = blockStore->create(Data(data.size()));
+  Data baseBefore = LoadBaseBlockData(block->key());
+  block->write(data.data(), 0, data.size());
+  block->flush();
+  // Doesn't wait for pending writes
+  auto base = baseBlockStore->load(block->key()).value();
+  EXPECT_NE(0, std::memcmp(baseBefore.data(), base->data(), baseBefore.size()));
+}
+
+TEST_F(EncryptedBlockStoreTest, LoadingAfterFlushingSeveralTimesGivesNewestContent) {
+  Data data2 = DataFixture::generate(BLOCKSIZE, 2);
+  blockstore::Key key = blockStore->createKey();
+  {
+    auto block = blockStore->tryCreate(key, Data(data.size())).value();
+    for (int i = 0; i < 20; ++i) {
+      const Data &content = (i % 2 == 0) ? data : data2;
+      block->write(content.data(), 0, content.size());
+      block->flush();
+    }
+  }
+  auto loaded = blockStore->load(key).value();
+  EXPECT_EQ(0, std::memcmp(data2.data(), loaded->data(), data2.size()));
+}
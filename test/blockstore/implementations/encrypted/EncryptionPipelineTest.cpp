@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include "blockstore/implementations/encrypted/EncryptionPipeline.h"
+#include <cpp-utils/data/DataFixture.h>
+#include <cpp-utils/lock/ConditionBarrier.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <stdexcept>
+
+using cpputils::DataFixture;
+using cpputils::ConditionBarrier;
+using blockstore::Key;
+using blockstore::encrypted::EncryptionPipeline;
+
+class EncryptionPipelineTest: public ::testing::Test {
+public:
+  const Key key1 = DataFixture::generateFixedSize<Key::BINARY_LENGTH>(1);
+  const Key key2 = DataFixture::generateFixedSize<Key::BINARY_LENGTH>(2);
+
+  static bool IsBlocked(std::future<void> *future) {
+    return future->wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout;
+  }
+};
+
+TEST_F(EncryptionPipelineTest, RunsWrite) {
+  EncryptionPipeline pipeline(2, 10);
+  std::atomic<bool> written(false);
+  pipeline.schedule(key1, [&written] {
+    written = true;
+  });
+  pipeline.waitUntilWritten(key1);
+  EXPECT_TRUE(written);
+  EXPECT_EQ(0u, pipeline.numPendingWrites());
+}
+
+TEST_F(EncryptionPipelineTest, WaitingForKeyWithoutWritesDoesntBlock) {
+  EncryptionPipeline pipeline(2, 10);
+  pipeline.waitUntilWritten(key1);
+  pipeline.waitUntilAllWritten();
+}
+
+TEST_F(EncryptionPipelineTest, WaitUntilWrittenWaitsForWriteOfKey) {
+  EncryptionPipeline pipeline(2, 10);
+  ConditionBarrier finishWrite;
+  pipeline.schedule(key1, [&finishWrite] {
+    finishWrite.wait();
+  });
+  EXPECT_EQ(1u, pipeline.numPendingWrites());
+  auto waiting = std::async(std::launch::async, [&pipeline, this] {
+    pipeline.waitUntilWritten(key1);
+  });
+  EXPECT_TRUE(IsBlocked(&waiting));
+  finishWrite.release();
+  waiting.wait();
+}
+
+TEST_F(EncryptionPipelineTest, WaitUntilWrittenDoesntWaitForOtherKeys) {
+  EncryptionPipeline pipeline(2, 10);
+  ConditionBarrier finishWrite;
+  pipeline.schedule(key1, [&finishWrite] {
+    finishWrite.wait();
+  });
+  pipeline.waitUntilWritten(key2);
+  finishWrite.release();
+}
+
+TEST_F(EncryptionPipelineTest, SchedulingBlocksWhenQueueIsFull) {
+  EncryptionPipeline pipeline(1, 1);
+  ConditionBarrier finishWrite;
+  std::atomic<int> numWritten(0);
+  auto write = [&finishWrite, &numWritten] {
+    finishWrite.wait();
+    ++numWritten;
+  };
+  auto scheduling = std::async(std::launch::async, [&pipeline, &write, this] {
+    // The first write blocks the worker, the second one fills the queue, the third one has to wait
+    pipeline.schedule(key1, write);
+    pipeline.schedule(key1, write);
+    pipeline.schedule(key2, write);
+  });
+  EXPECT_TRUE(IsBlocked(&scheduling));
+  EXPECT_EQ(0, numWritten);
+  finishWrite.release();
+  scheduling.wait();
+  pipeline.waitUntilAllWritten();
+  EXPECT_EQ(3, numWritten);
+}
+
+TEST_F(EncryptionPipelineTest, FailedWriteCountsAsWritten) {
+  EncryptionPipeline pipeline(2, 10);
+  pipeline.schedule(key1, [] {
+    throw std::runtime_error("Writing failed");
+  });
+  EXPECT_THROW(pipeline.waitUntilWritten(key1), std::runtime_error);
+  EXPECT_EQ(0u, pipeline.numPendingWrites());
+}
+
+TEST_F(EncryptionPipelineTest, FailedWriteIsRethrownOnlyOnce) {
+  EncryptionPipeline pipeline(2, 10);
+  pipeline.schedule(key1, [] {
+    throw std::runtime_error("Writing failed");
+  });
+  EXPECT_THROW(pipeline.waitUntilWritten(key1), std::runtime_error);
+  pipeline.waitUntilWritten(key1);
+  pipeline.waitUntilAllWritten();
+}
+
+TEST_F(EncryptionPipelineTest, FailedWriteIsntRethrownForOtherKeys) {
+  EncryptionPipeline pipeline(2, 10);
+  pipeline.schedule(key1, [] {
+    throw std::runtime_error("Writing failed");
+  });
+  pipeline.schedule(key2, [] {});
+  pipeline.waitUntilWritten(key2);
+  EXPECT_THROW(pipeline.waitUntilWritten(key1), std::runtime_error);
+}
+
+TEST_F(EncryptionPipelineTest, WaitUntilAllWrittenRethrowsFailedWrite) {
+  EncryptionPipeline pipeline(2, 10);
+  pipeline.schedule(key1, [] {});
+  pipeline.schedule(key2, [] {
+    throw std::runtime_error("Writing failed");
+  });
+  EXPECT_THROW(pipeline.waitUntilAllWritten(), std::runtime_error);
+  pipeline.waitUntilWritten(key2);
+}
+
+TEST_F(EncryptionPipelineTest, DestructorDoesntThrowForFailedWrite) {
+  EncryptionPipeline pipeline(2, 10);
+  pipeline.schedule(key1, [] {
+    throw std::runtime_error("Writing failed");
+  });
+}
+
+TEST_F(EncryptionPipelineTest, DestructorWaitsForWrites) {
+  std::atomic<int> numWritten(0);
+  {
+    EncryptionPipeline pipeline(2, 100);
+    for (int i = 0; i < 100; ++i) {
+      pipeline.schedule(i % 2 == 0 ? key1 : key2, [&numWritten] {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        ++numWritten;
+      });
+    }
+  }
+  EXPECT_EQ(100, numWritten);
+}
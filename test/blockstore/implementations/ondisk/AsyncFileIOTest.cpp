@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include "blockstore/implementations/ondisk/IoUringFileIO.h"
+#include "blockstore/implementations/ondisk/ThreadPoolFileIO.h"
+#include <cpp-utils/data/DataFixture.h>
+#include <cpp-utils/tempfile/TempFile.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
+
+using ::testing::Test;
+using cpputils::Data;
+using cpputils::DataFixture;
+using cpputils::TempFile;
+using cpputils::unique_ref;
+using cpputils::make_unique_ref;
+using boost::optional;
+using std::vector;
+
+using namespace blockstore::ondisk;
+
+template<class FileIO> optional<unique_ref<AsyncFileIO>> createFileIO();
+template<> optional<unique_ref<AsyncFileIO>> createFileIO<IoUringFileIO>() {
+  auto fileIO = IoUringFileIO::Create();
+  if (fileIO == boost::none) {
+    return boost::none;
+  }
+  return unique_ref<AsyncFileIO>(std::move(*fileIO));
+}
+template<> optional<unique_ref<AsyncFileIO>> createFileIO<ThreadPoolFileIO>() {
+  return unique_ref<AsyncFileIO>(make_unique_ref<ThreadPoolFileIO>());
+}
+
+template<class FileIO>
+class AsyncFileIOTest: public Test {
+public:
+  static constexpr size_t FILE_SIZE = 64 * 1024;
+  static constexpr size_t NUM_FILES = 100; // More than IoUringFileIO::QUEUE_DEPTH
+
+  AsyncFileIOTest(): fileIO(createFileIO<FileIO>()), files(), fds() {
+    for (size_t i = 0; i < NUM_FILES; ++i) {
+      files.push_back(make_unique_ref<TempFile>());
+      fds.push_back(::open(files.back()->path().c_str(), O_RDWR));
+    }
+  }
+
+  ~AsyncFileIOTest() {
+    for (int fd : fds) {
+      ::close(fd);
+    }
+  }
+
+  // Returns false if the backend isn't available on this system, in which case the test doesn't run.
+  bool available() const {
+    return fileIO != boost::none;
+  }
+
+  AsyncFileIO::Request request(AsyncFileIO::Request::Type type, size_t fileIndex, const struct iovec *iov, int iovcnt) {
+    return AsyncFileIO::Request{type, fds[fileIndex], iov, iovcnt, 0, 0};
+  }
+
+  optional<unique_ref<AsyncFileIO>> fileIO;
+  vector<unique_ref<TempFile>> files;
+  vector<int> fds;
+};
+template<class FileIO> constexpr size_t AsyncFileIOTest<FileIO>::FILE_SIZE;
+template<class FileIO> constexpr size_t AsyncFileIOTest<FileIO>::NUM_FILES;
+
+typedef ::testing::Types<IoUringFileIO, ThreadPoolFileIO> FileIOTypes;
+TYPED_TEST_CASE(AsyncFileIOTest, FileIOTypes);
+
+TYPED_TEST(AsyncFileIOTest, WritesAndReadsBatch) {
+  if (!this->available()) {
+    return;
+  }
+  vector<Data> written;
+  vector<struct iovec> writeIov;
+  vector<AsyncFileIO::Request> writes;
+  for (size_t i = 0; i < this->NUM_FILES; ++i) {
+    written.push_back(DataFixture::generate(this->FILE_SIZE, i));
+  }
+  for (size_t i = 0; i < this->NUM_FILES; ++i) {
+    writeIov.push_back({written[i].data(), written[i].size()});
+  }
+  for (size_t i = 0; i < this->NUM_FILES; ++i) {
+    writes.push_back(this->request(AsyncFileIO::Request::Type::WRITE, i, &writeIov[i], 1));
+  }
+  (*this->fileIO)->run(&writes);
+  for (const auto &write : writes) {
+    EXPECT_EQ(static_cast<ssize_t>(this->FILE_SIZE), write.result);
+  }
+
+  vector<Data> read;
+  vector<struct iovec> readIov;
+  vector<AsyncFileIO::Request> reads;
+  for (size_t i = 0; i < this->NUM_FILES; ++i) {
+    read.push_back(Data(this->FILE_SIZE));
+  }
+  for (size_t i = 0; i < this->NUM_FILES; ++i) {
+    readIov.push_back({read[i].data(), read[i].size()});
+  }
+  for (size_t i = 0; i < this->NUM_FILES; ++i) {
+    reads.push_back(this->request(AsyncFileIO::Request::Type::READ, i, &readIov[i], 1));
+  }
+  (*this->fileIO)->run(&reads);
+  for (size_t i = 0; i < this->NUM_FILES; ++i) {
+    EXPECT_EQ(static_cast<ssize_t>(this->FILE_SIZE), reads[i].result);
+    EXPECT_EQ(written[i], read[i]);
+  }
+}
+
+TYPED_TEST(AsyncFileIOTest, ReadsIntoMultipleBuffers) {
+  if (!this->available()) {
+    return;
+  }
+  Data content = DataFixture::generate(this->FILE_SIZE);
+  content.StoreToFile(this->files[0]->path());
+  content.StoreToFile(this->files[1]->path());
+  Data first(100), second(this->FILE_SIZE - 100);
+  Data third(100), fourth(this->FILE_SIZE - 100);
+  struct iovec iov1[2] = {{first.data(), first.size()}, {second.data(), second.size()}};
+  struct iovec iov2[2] = {{third.data(), third.size()}, {fourth.data(), fourth.size()}};
+  vector<AsyncFileIO::Request> reads = {
+      this->request(AsyncFileIO::Request::Type::READ, 0, iov1, 2),
+      this->request(AsyncFileIO::Request::Type::READ, 1, iov2, 2)
+  };
+  (*this->fileIO)->run(&reads);
+  EXPECT_EQ(static_cast<ssize_t>(this->FILE_SIZE), reads[0].result);
+  EXPECT_EQ(0, std::memcmp(content.data(), first.data(), first.size()));
+  EXPECT_EQ(0, std::memcmp(content.dataOffset(100), second.data(), second.size()));
+  EXPECT_EQ(0, std::memcmp(content.dataOffset(100), fourth.data(), fourth.size()));
+}
+
+TYPED_TEST(AsyncFileIOTest, ReadStopsAtEndOfFile) {
+  if (!this->available()) {
+    return;
+  }
+  DataFixture::generate(1000).StoreToFile(this->files[0]->path());
+  Data buffer1(this->FILE_SIZE), buffer2(this->FILE_SIZE);
+  struct iovec iov1 = {buffer1.data(), buffer1.size()};
+  struct iovec iov2 = {buffer2.data(), buffer2.size()};
+  vector<AsyncFileIO::Request> reads = {
+      this->request(AsyncFileIO::Request::Type::READ, 0, &iov1, 1),
+      this->request(AsyncFileIO::Request::Type::READ, 1, &iov2, 1)
+  };
+  (*this->fileIO)->run(&reads);
+  EXPECT_EQ(1000, reads[0].result);
+  EXPECT_EQ(0, reads[1].result);
+}
+
+TYPED_TEST(AsyncFileIOTest, ReportsErrorPerRequest) {
+  if (!this->available()) {
+    return;
+  }
+  DataFixture::generate(1000).StoreToFile(this->files[0]->path());
+  Data buffer1(1000), buffer2(1000);
+  struct iovec iov1 = {buffer1.data(), buffer1.size()};
+  struct iovec iov2 = {buffer2.data(), buffer2.size()};
+  vector<AsyncFileIO::Request> reads = {
+      this->request(AsyncFileIO::Request::Type::READ, 0, &iov1, 1),
+      AsyncFileIO::Request{AsyncFileIO::Request::Type::READ, -1, &iov2, 1, 0, 0}
+  };
+  (*this->fileIO)->run(&reads);
+  EXPECT_EQ(1000, reads[0].result);
+  EXPECT_EQ(-EBADF, reads[1].result);
+}
+
+TYPED_TEST(AsyncFileIOTest, RunsBatchesFromMultipleThreads) {
+  if (!this->available()) {
+    return;
+  }
+  vector<Data> contents;
+  for (size_t i = 0; i < this->NUM_FILES; ++i) {
+    contents.push_back(DataFixture::generate(this->FILE_SIZE, i));
+    contents.back().StoreToFile(this->files[i]->path());
+  }
+  constexpr size_t NUM_THREADS = 4;
+  vector<std::thread> threads;
+  std::atomic<uint32_t> numCorrect(0);
+  for (size_t t = 0; t < NUM_THREADS; ++t) {
+    threads.emplace_back([this, t, &contents, &numCorrect] {
+      vector<Data> buffers;
+      vector<struct iovec> iov;
+      vector<AsyncFileIO::Request> reads;
+      for (size_t i = t; i < this->NUM_FILES; i += NUM_THREADS) {
+        buffers.push_back(Data(this->FILE_SIZE));
+      }
+      for (auto &buffer : buffers) {
+        iov.push_back({buffer.data(), buffer.size()});
+      }
+      for (size_t i = t, j = 0; i < this->NUM_FILES; i += NUM_THREADS, ++j) {
+        reads.push_back(this->request(AsyncFileIO::Request::Type::READ, i, &iov[j], 1));
+      }
+      (*this->fileIO)->run(&reads);
+      bool allCorrect = true;
+      for (size_t i = t, j = 0; i < this->NUM_FILES; i += NUM_THREADS, ++j) {
+        allCorrect = allCorrect && (contents[i] == buffers[j]);
+      }
+      if (allCorrect) {
+        ++numCorrect;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(NUM_THREADS, numCorrect);
+}
@@ -40,3 +40,16 @@ private:
 };
 
 INSTANTIATE_TYPED_TEST_CASE_P(OnDisk, BlockStoreWithRandomKeysTest, OnDiskBlockStoreWithRandomKeysTestFixture);
+
+class OnDiskBlockStoreWithDirectIOTestFixture: public BlockStoreTestFixture {
+public:
+  OnDiskBlockStoreWithDirectIOTestFixture(): tempdir() {}
+
+  unique_ref<BlockStore> createBlockStore() override {
+    return make_unique_ref<OnDiskBlockStore>(tempdir.path(), true);
+  }
+private:
+  TempDir tempdir;
+};
+
+INSTANTIATE_TYPED_TEST_CASE_P(OnDiskWithDirectIO, BlockStoreTest, OnDiskBlockStoreWithDirectIOTestFixture);
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include "blockstore/implementations/ondisk/OnDiskBlockStore.h"
+#include "blockstore/implementations/ondisk/OnDiskBlock.h"
 #include <cpp-utils/tempfile/TempDir.h>
+#include <cpp-utils/data/DataFixture.h>
+#include <cpp-utils/data/DataFixture.h>
 
 using ::testing::Test;
 
@@ -24,6 +27,11 @@ public:
     return blockStore.create(initData)->key();
   }
 
+  void EXPECT_BLOCK_DATA_EQ(const Data &expected, const blockstore::Block &block) {
+    EXPECT_EQ(expected.size(), block.size());
+    EXPECT_EQ(0, std::memcmp(expected.data(), block.data(), expected.size()));
+  }
+
   uint64_t getPhysicalBlockSize(const Key &key) {
     ifstream stream((baseDir.path() / key.ToString().substr(0,3) / key.ToString().substr(3)).c_str());
     stream.seekg(0, stream.end);
@@ -65,3 +73,86 @@ TEST_F(OnDiskBlockStoreTest, NumBlocksIsCorrectAfterAddingTwoBlocksWithSameKeyPr
   EXPECT_NE(boost::none, blockStore.tryCreate(key2, cpputils::Data(0)));
   EXPECT_EQ(2u, blockStore.numBlocks());
 }
+
+TEST_F(OnDiskBlockStoreTest, NumBlocksIgnoresTempfiles) {
+  const Key key = Key::FromString("4CE72ECDD20877A12ADBF4E3927C0A13");
+  EXPECT_NE(boost::none, blockStore.tryCreate(key, cpputils::Data(0)));
+  Data(10).StoreToFile(baseDir.path() / "4CE" / ("72ECDD20877A12ADBF4E3927C0A14" + OnDiskBlock::TEMPFILE_SUFFIX));
+  EXPECT_EQ(1u, blockStore.numBlocks());
+}
+
+TEST_F(OnDiskBlockStoreTest, StoringBlockDoesntLeaveTempfile) {
+  auto key = CreateBlockReturnKey(Data(1024));
+  blockStore.load(key).value()->write("data", 0, 4);
+  boost::filesystem::path blockDir = baseDir.path() / key.ToString().substr(0,3);
+  EXPECT_EQ(1, std::distance(boost::filesystem::directory_iterator(blockDir), boost::filesystem::directory_iterator()));
+}
+
+class OnDiskBlockStoreWithDirectIOTest: public Test {
+public:
+  OnDiskBlockStoreWithDirectIOTest(): baseDir(), blockStore(baseDir.path(), true) {
+  }
+  TempDir baseDir;
+  OnDiskBlockStore blockStore;
+
+  uint64_t getPhysicalBlockSize(const Key &key) {
+    return boost::filesystem::file_size(baseDir.path() / key.ToString().substr(0,3) / key.ToString().substr(3));
+  }
+};
+
+TEST_F(OnDiskBlockStoreWithDirectIOTest, PhysicalBlockSizeIsntPaddedToAlignment) {
+  auto key = blockStore.create(Data(1000))->key();
+  EXPECT_EQ(1000u, blockStore.blockSizeFromPhysicalBlockSize(getPhysicalBlockSize(key)));
+}
+
+TEST_F(OnDiskBlockStoreWithDirectIOTest, BlockCanBeLoadedWithoutDirectIO) {
+  Data data(5000);
+  std::memset(data.data(), 0x5A, data.size());
+  auto key = blockStore.create(data)->key();
+  OnDiskBlockStore bufferedBlockStore(baseDir.path(), false);
+  auto loaded = bufferedBlockStore.load(key).value();
+  EXPECT_EQ(data.size(), loaded->size());
+  EXPECT_EQ(0, std::memcmp(data.data(), loaded->data(), data.size()));
+}
+
+TEST_F(OnDiskBlockStoreTest, LoadManyReturnsBlocksInOrderOfKeys) {
+  Data data1 = cpputils::DataFixture::generate(1024, 1);
+  Data data2 = cpputils::DataFixture::generate(2048, 2);
+  auto key1 = CreateBlockReturnKey(data1);
+  auto key2 = CreateBlockReturnKey(data2);
+  auto blocks = blockStore.loadMany({key2, key1});
+  ASSERT_EQ(2u, blocks.size());
+  EXPECT_BLOCK_DATA_EQ(data2, **blocks[0]);
+  EXPECT_BLOCK_DATA_EQ(data1, **blocks[1]);
+}
+
+TEST_F(OnDiskBlockStoreTest, LoadManyReturnsNoneForNonexistingBlocks) {
+  auto key = CreateBlockReturnKey(Data(10));
+  auto blocks = blockStore.loadMany({Key::FromString("4CE72ECDD20877A12ADBF4E3927C0A13"), key});
+  ASSERT_EQ(2u, blocks.size());
+  EXPECT_EQ(boost::none, blocks[0]);
+  EXPECT_NE(boost::none, blocks[1]);
+}
+
+TEST_F(OnDiskBlockStoreTest, StoreManyCreatesAndOverwritesBlocks) {
+  auto existingKey = CreateBlockReturnKey(Data(10));
+  const Key newKey = Key::FromString("4CE72ECDD20877A12ADBF4E3927C0A13");
+  std::vector<std::pair<Key, Data>> blocks;
+  blocks.emplace_back(existingKey, cpputils::DataFixture::generate(100, 1));
+  blocks.emplace_back(newKey, cpputils::DataFixture::generate(200, 2));
+  blockStore.storeMany(std::move(blocks));
+  EXPECT_EQ(2u, blockStore.numBlocks());
+  auto loaded = blockStore.loadMany({existingKey, newKey});
+  EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(100, 1), **loaded[0]);
+  EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(200, 2), **loaded[1]);
+}
+
+TEST_F(OnDiskBlockStoreTest, StoreManyWithDuplicateKeysStoresLastEntry) {
+  auto key = CreateBlockReturnKey(Data(10));
+  std::vector<std::pair<Key, Data>> blocks;
+  blocks.emplace_back(key, cpputils::DataFixture::generate(100, 1));
+  blocks.emplace_back(key, cpputils::DataFixture::generate(200, 2));
+  blockStore.storeMany(std::move(blocks));
+  EXPECT_EQ(1u, blockStore.numBlocks());
+  EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(200, 2), *blockStore.load(key).value());
+}
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include "blockstore/implementations/parallelaccess/ParallelAccessBlockStore.h"
 #include "blockstore/implementations/testfake/FakeBlockStore.h"
+#include <cpp-utils/data/DataFixture.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 using ::testing::Test;
 
@@ -12,6 +16,11 @@ using blockstore::testfake::FakeBlockStore;
 
 using namespace blockstore::parallelaccess;
 
+void EXPECT_BLOCK_DATA_EQ(const Data &expected, const blockstore::Block &actual) {
+    EXPECT_EQ(expected.size(), actual.size());
+    EXPECT_EQ(0, std::memcmp(expected.data(), actual.data(), expected.size()));
+}
+
 class ParallelAccessBlockStoreTest: public Test {
 public:
     ParallelAccessBlockStoreTest():
@@ -52,3 +61,133 @@ TEST_F(ParallelAccessBlockStoreTest, PhysicalBlockSize_positive) {
     auto base = baseBlockStore->load(key).value();
     EXPECT_EQ(10*1024u, blockStore.blockSizeFromPhysicalBlockSize(base->size()));
 }
+
+TEST_F(ParallelAccessBlockStoreTest, StoreManyOverwritesOpenedAndNotOpenedBlocks) {
+    auto openedKey = CreateBlockReturnKey(cpputils::DataFixture::generate(100, 1));
+    auto notOpenedKey = CreateBlockReturnKey(cpputils::DataFixture::generate(100, 2));
+    auto opened = blockStore.load(openedKey).value();
+    std::vector<std::pair<blockstore::Key, Data>> blocks;
+    blocks.emplace_back(openedKey, cpputils::DataFixture::generate(100, 3));
+    blocks.emplace_back(notOpenedKey, cpputils::DataFixture::generate(200, 4));
+    blockStore.storeMany(std::move(blocks));
+    EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(100, 3), *opened);
+    cpputils::destruct(std::move(opened));
+    auto notOpened = baseBlockStore->load(notOpenedKey).value();
+    EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(200, 4), *notOpened);
+}
+
+TEST_F(ParallelAccessBlockStoreTest, StoreManyResizesOpenedBlock) {
+    auto key = CreateBlockReturnKey(cpputils::DataFixture::generate(100, 1));
+    auto opened = blockStore.load(key).value();
+    std::vector<std::pair<blockstore::Key, Data>> blocks;
+    blocks.emplace_back(key, cpputils::DataFixture::generate(300, 2));
+    blockStore.storeMany(std::move(blocks));
+    EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(300, 2), *opened);
+}
+
+// Calls a hook while the base store removes or stores blocks by key, so tests can access blocks concurrently
+class BlockStoreWithHook final: public blockstore::BlockStore {
+public:
+    BlockStoreWithHook(): baseBlockStore(), onBaseOperation([] {}) {}
+
+    blockstore::Key createKey() override { return baseBlockStore.createKey(); }
+    boost::optional<unique_ref<blockstore::Block>> tryCreate(const blockstore::Key &key, Data data) override { return baseBlockStore.tryCreate(key, std::move(data)); }
+    boost::optional<unique_ref<blockstore::Block>> load(const blockstore::Key &key) override { return baseBlockStore.load(key); }
+    void remove(unique_ref<blockstore::Block> block) override { baseBlockStore.remove(std::move(block)); }
+    void remove(const blockstore::Key &key) override { baseBlockStore.remove(key); }
+    void removeMany(const std::vector<blockstore::Key> &keys) override {
+        onBaseOperation();
+        baseBlockStore.removeMany(keys);
+    }
+    void storeMany(std::vector<std::pair<blockstore::Key, Data>> blocks) override {
+        onBaseOperation();
+        baseBlockStore.storeMany(std::move(blocks));
+    }
+    uint64_t numBlocks() const override { return baseBlockStore.numBlocks(); }
+    uint64_t estimateNumFreeBytes() const override { return baseBlockStore.estimateNumFreeBytes(); }
+    uint64_t blockSizeFromPhysicalBlockSize(uint64_t blockSize) const override { return baseBlockStore.blockSizeFromPhysicalBlockSize(blockSize); }
+
+    FakeBlockStore baseBlockStore;
+    std::function<void ()> onBaseOperation;
+};
+
+class ParallelAccessBlockStoreTest_BaseOperations: public Test {
+public:
+    ParallelAccessBlockStoreTest_BaseOperations():
+            baseBlockStore(new BlockStoreWithHook),
+            blockStore(std::move(cpputils::nullcheck(std::unique_ptr<BlockStoreWithHook>(baseBlockStore)).value())),
+            key1(blockStore.create(cpputils::DataFixture::generate(100, 1))->key()),
+            key2(blockStore.create(cpputils::DataFixture::generate(100, 2))->key()) {
+    }
+    BlockStoreWithHook *baseBlockStore;
+    ParallelAccessBlockStore blockStore;
+    blockstore::Key key1;
+    blockstore::Key key2;
+
+    std::vector<std::pair<blockstore::Key, Data>> NewDataFor(const blockstore::Key &key) {
+        std::vector<std::pair<blockstore::Key, Data>> blocks;
+        blocks.emplace_back(key, cpputils::DataFixture::generate(100, 3));
+        return blocks;
+    }
+};
+
+TEST_F(ParallelAccessBlockStoreTest_BaseOperations, RemovingBlocksDoesntBlockLoadsOfOtherBlocks) {
+    bool loaded = false;
+    baseBlockStore->onBaseOperation = [this, &loaded] {
+        // This would deadlock if the removal held the lock of the parallel access store
+        std::thread other([this, &loaded] {
+            loaded = (blockStore.load(key2) != boost::none);
+        });
+        other.join();
+    };
+    blockStore.removeMany(std::vector<blockstore::Key>{key1});
+    EXPECT_TRUE(loaded);
+}
+
+TEST_F(ParallelAccessBlockStoreTest_BaseOperations, LoadingWaitsUntilBlockIsRemoved) {
+    std::thread loader;
+    std::atomic<bool> finished(false);
+    boost::optional<unique_ref<blockstore::Block>> loaded;
+    baseBlockStore->onBaseOperation = [this, &loader, &finished, &loaded] {
+        loader = std::thread([this, &finished, &loaded] {
+            loaded = blockStore.load(key1);
+            finished = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        EXPECT_FALSE(finished);
+    };
+    blockStore.removeMany(std::vector<blockstore::Key>{key1});
+    loader.join();
+    EXPECT_EQ(boost::none, loaded);
+}
+
+TEST_F(ParallelAccessBlockStoreTest_BaseOperations, StoringBlocksDoesntBlockLoadsOfOtherBlocks) {
+    bool loaded = false;
+    baseBlockStore->onBaseOperation = [this, &loaded] {
+        // This would deadlock if storing held the lock of the parallel access store
+        std::thread other([this, &loaded] {
+            loaded = (blockStore.load(key2) != boost::none);
+        });
+        other.join();
+    };
+    blockStore.storeMany(NewDataFor(key1));
+    EXPECT_TRUE(loaded);
+}
+
+TEST_F(ParallelAccessBlockStoreTest_BaseOperations, LoadingWaitsUntilBlockIsStored) {
+    std::thread loader;
+    std::atomic<bool> finished(false);
+    boost::optional<unique_ref<blockstore::Block>> loaded;
+    baseBlockStore->onBaseOperation = [this, &loader, &finished, &loaded] {
+        loader = std::thread([this, &finished, &loaded] {
+            loaded = blockStore.load(key1);
+            finished = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        EXPECT_FALSE(finished);
+    };
+    blockStore.storeMany(NewDataFor(key1));
+    loader.join();
+    ASSERT_NE(boost::none, loaded);
+    EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(100, 3), **loaded);
+}
@@ -36,6 +36,11 @@ public:
     block = blockStore->load(key).value();
     EXPECT_EQ(0, std::memcmp(fixture.data(), block->data(), fixture.size()));
   }
+
+  void EXPECT_BLOCK_DATA_EQ(const cpputils::Data &expected, const blockstore::Block &block) {
+    EXPECT_EQ(expected.size(), block.size());
+    EXPECT_EQ(0, std::memcmp(expected.data(), block.data(), expected.size()));
+  }
 };
 
 TYPED_TEST_CASE_P(BlockStoreTest);
@@ -180,6 +185,90 @@ TYPED_TEST_P(BlockStoreTest, Resize_Smaller_ToZero_BlockIsStillUsable) {
   this->TestBlockIsUsable(std::move(block), blockStore.get());
 }
 
+TYPED_TEST_P(BlockStoreTest, LoadMany_ReturnsBlocksInOrderOfKeys) {
+  auto blockStore = this->fixture.createBlockStore();
+  auto key1 = blockStore->create(cpputils::DataFixture::generate(100, 1))->key();
+  auto key2 = blockStore->create(cpputils::DataFixture::generate(200, 2))->key();
+  auto nonExistingKey = blockStore->createKey();
+  auto blocks = blockStore->loadMany({key2, nonExistingKey, key1});
+  ASSERT_EQ(3u, blocks.size());
+  ASSERT_NE(boost::none, blocks[0]);
+  EXPECT_EQ(key2, (*blocks[0])->key());
+  this->EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(200, 2), **blocks[0]);
+  EXPECT_EQ(boost::none, blocks[1]);
+  ASSERT_NE(boost::none, blocks[2]);
+  EXPECT_EQ(key1, (*blocks[2])->key());
+  this->EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(100, 1), **blocks[2]);
+}
+
+TYPED_TEST_P(BlockStoreTest, LoadMany_Empty) {
+  auto blockStore = this->fixture.createBlockStore();
+  EXPECT_EQ(0u, blockStore->loadMany({}).size());
+}
+
+TYPED_TEST_P(BlockStoreTest, StoreMany_CreatesAndOverwritesBlocks) {
+  auto blockStore = this->fixture.createBlockStore();
+  auto existingKey = blockStore->create(cpputils::DataFixture::generate(100, 1))->key();
+  auto newKey = blockStore->createKey();
+  std::vector<std::pair<blockstore::Key, cpputils::Data>> blocks;
+  blocks.emplace_back(existingKey, cpputils::DataFixture::generate(300, 2));
+  blocks.emplace_back(newKey, cpputils::DataFixture::generate(50, 3));
+  blockStore->storeMany(std::move(blocks));
+  EXPECT_EQ(2u, blockStore->numBlocks());
+  auto existing = blockStore->load(existingKey).value();
+  this->EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(300, 2), *existing);
+  auto created = blockStore->load(newKey).value();
+  this->EXPECT_BLOCK_DATA_EQ(cpputils::DataFixture::generate(50, 3), *created);
+}
+
+TYPED_TEST_P(BlockStoreTest, RemoveMany_RemovesBlocks) {
+  auto blockStore = this->fixture.createBlockStore();
+  auto key1 = blockStore->create(cpputils::Data(100))->key();
+  auto key2 = blockStore->create(cpputils::Data(100))->key();
+  auto key3 = blockStore->create(cpputils::Data(100))->key();
+  std::vector<cpputils::unique_ref<blockstore::Block>> blocks;
+  blocks.push_back(blockStore->load(key1).value());
+  blocks.push_back(blockStore->create(cpputils::Data(100))); // not stored yet in caching stores
+  blocks.push_back(blockStore->load(key3).value());
+  blockStore->removeMany(std::move(blocks));
+  EXPECT_EQ(1u, blockStore->numBlocks());
+  EXPECT_EQ(boost::none, blockStore->load(key1));
+  EXPECT_NE(boost::none, blockStore->load(key2));
+  EXPECT_EQ(boost::none, blockStore->load(key3));
+}
+
+TYPED_TEST_P(BlockStoreTest, RemoveByKey_RemovesBlock) {
+  auto blockStore = this->fixture.createBlockStore();
+  auto key1 = blockStore->create(cpputils::Data(100))->key();
+  auto key2 = blockStore->create(cpputils::Data(100))->key();
+  blockStore->remove(key1);
+  EXPECT_EQ(1u, blockStore->numBlocks());
+  EXPECT_EQ(boost::none, blockStore->load(key1));
+  EXPECT_NE(boost::none, blockStore->load(key2));
+}
+
+TYPED_TEST_P(BlockStoreTest, RemoveByKey_RemovesModifiedBlock) {
+  auto blockStore = this->fixture.createBlockStore();
+  auto key = blockStore->create(cpputils::Data(100))->key();
+  blockStore->load(key).value()->write("data", 0, 4);
+  blockStore->remove(key);
+  EXPECT_EQ(0u, blockStore->numBlocks());
+  EXPECT_EQ(boost::none, blockStore->load(key));
+}
+
+TYPED_TEST_P(BlockStoreTest, RemoveManyByKey_RemovesBlocks) {
+  auto blockStore = this->fixture.createBlockStore();
+  auto key1 = blockStore->create(cpputils::Data(100))->key();
+  auto key2 = blockStore->create(cpputils::Data(100))->key();
+  auto key3 = blockStore->create(cpputils::Data(100))->key();
+  blockStore->load(key3).value()->write("data", 0, 4);
+  blockStore->removeMany(std::vector<blockstore::Key>{key1, key3});
+  EXPECT_EQ(1u, blockStore->numBlocks());
+  EXPECT_EQ(boost::none, blockStore->load(key1));
+  EXPECT_NE(boost::none, blockStore->load(key2));
+  EXPECT_EQ(boost::none, blockStore->load(key3));
+}
+
 #include "BlockStoreTest_Size.h"
 #include "BlockStoreTest_Data.h"
 
@@ -218,7 +307,14 @@ REGISTER_TYPED_TEST_CASE_P(BlockStoreTest,
     Resize_Smaller,
     Resize_Smaller_BlockIsStillUsable,
     Resize_Smaller_ToZero,
-    Resize_Smaller_ToZero_BlockIsStillUsable
+    Resize_Smaller_ToZero_BlockIsStillUsable,
+    LoadMany_ReturnsBlocksInOrderOfKeys,
+    LoadMany_Empty,
+    StoreMany_CreatesAndOverwritesBlocks,
+    RemoveMany_RemovesBlocks,
+    RemoveByKey_RemovesBlock,
+    RemoveByKey_RemovesModifiedBlock,
+    RemoveManyByKey_RemovesBlocks
 );
 
 
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "cpp-utils/crypto/symmetric/ChaCha20Poly1305.h"
+#include "cpp-utils/data/Data.h"
+#include "testutils/HexData.h"
+#include <cstring>
+
+using namespace cpputils;
+using std::string;
+
+// Test vectors from RFC 8439 and draft-irtf-cfrg-xchacha, and further messages checked against OpenSSL
+class ChaCha20Poly1305Test: public ::testing::Test {
+public:
+  const string SUNSCREEN = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+
+  static Data FromString(const string &str) {
+    Data result(str.size());
+    std::memcpy(result.data(), str.c_str(), str.size());
+    return result;
+  }
+
+  // Bytes counting up from zero. 1000 bytes go through all code paths of the implementation.
+  static Data Counting(size_t size) {
+    Data result(size);
+    for (size_t i = 0; i < size; ++i) {
+      ((uint8_t*)result.data())[i] = static_cast<uint8_t>(i);
+    }
+    return result;
+  }
+
+  // Checks encryption and decryption with ChaCha20Poly1305::encrypt/decrypt (nonce of 12 bytes)
+  // or ChaCha20Poly1305::xencrypt/xdecrypt (nonce of 24 bytes)
+  void EXPECT_ENCRYPTS(const string &key, const string &nonce, const string &header, const Data &message, const string &expectedCiphertext, const string &expectedTag) {
+    Data keyData = HexData(key);
+    Data nonceData = HexData(nonce);
+    Data headerData = HexData(header);
+    bool extended = nonceData.size() == ChaCha20Poly1305::XNONCE_SIZE;
+    auto encrypt = extended ? &ChaCha20Poly1305::xencrypt : &ChaCha20Poly1305::encrypt;
+    auto decrypt = extended ? &ChaCha20Poly1305::xdecrypt : &ChaCha20Poly1305::decrypt;
+
+    Data ciphertext(message.size());
+    Data tag(ChaCha20Poly1305::TAG_SIZE);
+    encrypt((const uint8_t*)keyData.data(), (const uint8_t*)nonceData.data(), (const uint8_t*)headerData.data(), headerData.size(),
+            (const uint8_t*)message.data(), message.size(), (uint8_t*)ciphertext.data(), (uint8_t*)tag.data());
+    if (expectedCiphertext != "") {
+      EXPECT_EQ(HexData(expectedCiphertext), ciphertext);
+    }
+    EXPECT_EQ(HexData(expectedTag), tag);
+
+    Data decrypted(message.size());
+    EXPECT_TRUE(decrypt((const uint8_t*)keyData.data(), (const uint8_t*)nonceData.data(), (const uint8_t*)headerData.data(), headerData.size(),
+                        (const uint8_t*)ciphertext.data(), ciphertext.size(), (const uint8_t*)tag.data(), (uint8_t*)decrypted.data()));
+    EXPECT_EQ(message, decrypted);
+
+    ((uint8_t*)tag.data())[0] ^= 1;
+    EXPECT_FALSE(decrypt((const uint8_t*)keyData.data(), (const uint8_t*)nonceData.data(), (const uint8_t*)headerData.data(), headerData.size(),
+                         (const uint8_t*)ciphertext.data(), ciphertext.size(), (const uint8_t*)tag.data(), (uint8_t*)decrypted.data()));
+  }
+};
+
+TEST_F(ChaCha20Poly1305Test, RFC8439) {
+  EXPECT_ENCRYPTS("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f", "070000004041424344454647", "50515253c0c1c2c3c4c5c6c7",
+                  FromString(SUNSCREEN),
+                  "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d63dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+                  "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc3ff4def08e4b7a9de576d26586cec64b6116",
+                  "1ae10b594f09e26a7e902ecbd0600691");
+}
+
+TEST_F(ChaCha20Poly1305Test, LongMessage) {
+  EXPECT_ENCRYPTS("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", "000000000001020304050607", "", Counting(1000),
+                  "", "b8db8a82ccee7b7670979a0b35112799");
+}
+
+TEST_F(ChaCha20Poly1305Test, EmptyMessage) {
+  EXPECT_ENCRYPTS("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f", "070000004041424344454647", "50515253c0c1c2c3c4c5c6c7",
+                  Data(0), "", "e622e5647a38d967a7ecbcb46c7f675c");
+}
+
+TEST_F(ChaCha20Poly1305Test, HChaCha20) {
+  Data key = HexData("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+  Data nonce = HexData("000000090000004a0000000031415927");
+  Data subkey(32);
+  ChaCha20Poly1305::hchacha20((const uint8_t*)key.data(), (const uint8_t*)nonce.data(), (uint8_t*)subkey.data());
+  EXPECT_EQ(HexData("82413b4227b27bfed30e42508a877d73a0f9e4d58a74a853c12ec41326d3ecdc"), subkey);
+}
+
+TEST_F(ChaCha20Poly1305Test, XChaCha20Poly1305) {
+  EXPECT_ENCRYPTS("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f", "404142434445464748494a4b4c4d4e4f5051525354555657",
+                  "50515253c0c1c2c3c4c5c6c7", FromString(SUNSCREEN),
+                  "bd6d179d3e83d43b9576579493c0e939572a1700252bfaccbed2902c21396cbb731c7f1b0b4aa6440bf3a82f4eda7e39ae64c6708c54c216cb96b72e1213b452"
+                  "2f8c9ba40db5d945b11b69b982c1bb9e3f3fac2bc369488f76b2383565d3fff921f9664c97637da9768812f615c68b13b52e",
+                  "c0875924c1c7987947deafd8780acf49");
+}
@@ -6,6 +6,7 @@
 #include "cpp-utils/data/DataFixture.h"
 #include "cpp-utils/data/Data.h"
 #include <boost/optional/optional_io.hpp>
+#include <thread>
 
 using namespace cpputils;
 using std::string;
@@ -123,6 +124,45 @@ TYPED_TEST_P(CipherTest, TryDecryptDataThatIsMuchTooSmall_1) {
   this->ExpectDoesntDecrypt(tooSmallCiphertext);
 }
 
+TYPED_TEST_P(CipherTest, EncryptIntoBufferThenDecryptIntoBuffer) {
+  for (auto size: SIZES) {
+    Data plaintext = this->CreateData(size);
+    Data ciphertext(TypeParam::ciphertextSize(size));
+    TypeParam::encrypt((byte*)plaintext.data(), plaintext.size(), (byte*)ciphertext.data(), this->encKey);
+    Data decrypted(size);
+    EXPECT_TRUE(TypeParam::decrypt((byte*)ciphertext.data(), ciphertext.size(), (byte*)decrypted.data(), this->encKey));
+    EXPECT_EQ(plaintext, decrypted);
+  }
+}
+
+TYPED_TEST_P(CipherTest, DecryptBufferEncryptedWithDataVersion) {
+  Data plaintext = this->CreateData(1024);
+  Data ciphertext = this->Encrypt(plaintext);
+  Data decrypted(plaintext.size());
+  EXPECT_TRUE(TypeParam::decrypt((byte*)ciphertext.data(), ciphertext.size(), (byte*)decrypted.data(), this->encKey));
+  EXPECT_EQ(plaintext, decrypted);
+}
+
+TYPED_TEST_P(CipherTest, EncryptThenDecrypt_AlternatingKeys) {
+  // Each thread keeps the key it used last, so switching keys must not mix them up
+  auto otherKey = this->createKeyFixture(1);
+  Data plaintext = this->CreateData(1024);
+  Data ciphertext1 = this->Encrypt(plaintext);
+  Data ciphertext2 = TypeParam::encrypt((byte*)plaintext.data(), plaintext.size(), otherKey);
+  EXPECT_EQ(plaintext, this->Decrypt(ciphertext1));
+  EXPECT_EQ(plaintext, TypeParam::decrypt((byte*)ciphertext2.data(), ciphertext2.size(), otherKey).value());
+  EXPECT_EQ(plaintext, this->Decrypt(ciphertext1));
+}
+
+TYPED_TEST_P(CipherTest, EncryptAndDecryptOnDifferentThreads) {
+  Data plaintext = this->CreateData(1024);
+  Data ciphertext(0);
+  std::thread([this, &plaintext, &ciphertext] {
+    ciphertext = this->Encrypt(plaintext);
+  }).join();
+  EXPECT_EQ(plaintext, this->Decrypt(ciphertext));
+}
+
 REGISTER_TYPED_TEST_CASE_P(CipherTest,
     Size,
     EncryptThenDecrypt_Zeroes,
@@ -132,7 +172,11 @@ REGISTER_TYPED_TEST_CASE_P(CipherTest,
     EncryptedSize,
     TryDecryptDataThatIsTooSmall,
     TryDecryptDataThatIsMuchTooSmall_0,
-    TryDecryptDataThatIsMuchTooSmall_1
+    TryDecryptDataThatIsMuchTooSmall_1,
+    EncryptIntoBufferThenDecryptIntoBuffer,
+    DecryptBufferEncryptedWithDataVersion,
+    EncryptThenDecrypt_AlternatingKeys,
+    EncryptAndDecryptOnDifferentThreads
 );
 
 template<class Cipher>
@@ -194,6 +238,13 @@ TYPED_TEST_P(AuthenticatedCipherTest, ModifyMiddleByte_Data) {
   this->ExpectDoesntDecrypt(ciphertext);
 }
 
+TYPED_TEST_P(AuthenticatedCipherTest, ModifyMiddleByte_DecryptIntoBuffer) {
+  Data ciphertext = this->Encrypt(this->plaintext2);
+  ((byte*)ciphertext.data())[ciphertext.size()/2] = ((byte*)ciphertext.data())[ciphertext.size()/2] + 1;
+  Data decrypted(this->plaintext2.size());
+  EXPECT_FALSE(TypeParam::decrypt((byte*)ciphertext.data(), ciphertext.size(), (byte*)decrypted.data(), this->encKey));
+}
+
 TYPED_TEST_P(AuthenticatedCipherTest, TryDecryptZeroesData) {
   this->ExpectDoesntDecrypt(this->zeroes2);
 }
@@ -211,6 +262,7 @@ REGISTER_TYPED_TEST_CASE_P(AuthenticatedCipherTest,
   ModifyLastByte_Data,
   ModifyMiddleByte_Zeroes,
   ModifyMiddleByte_Data,
+  ModifyMiddleByte_DecryptIntoBuffer,
   TryDecryptZeroesData,
   TryDecryptRandomData
 );
@@ -226,6 +278,9 @@ INSTANTIATE_TYPED_TEST_CASE_P(AES128_CFB, CipherTest, AES128_CFB); //CFB mode is
 INSTANTIATE_TYPED_TEST_CASE_P(AES128_GCM, CipherTest, AES128_GCM);
 INSTANTIATE_TYPED_TEST_CASE_P(AES128_GCM, AuthenticatedCipherTest, AES128_GCM);
 
+INSTANTIATE_TYPED_TEST_CASE_P(XChaCha20Poly1305, CipherTest, XChaCha20Poly1305);
+INSTANTIATE_TYPED_TEST_CASE_P(XChaCha20Poly1305, AuthenticatedCipherTest, XChaCha20Poly1305);
+
 INSTANTIATE_TYPED_TEST_CASE_P(Twofish256_CFB, CipherTest, Twofish256_CFB); //CFB mode is not authenticated
 INSTANTIATE_TYPED_TEST_CASE_P(Twofish256_GCM, CipherTest, Twofish256_GCM);
 INSTANTIATE_TYPED_TEST_CASE_P(Twofish256_GCM, AuthenticatedCipherTest, Twofish256_GCM);
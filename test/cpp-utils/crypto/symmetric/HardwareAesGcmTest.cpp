@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "cpp-utils/crypto/symmetric/HardwareAesGcm.h"
+#include "cpp-utils/data/Data.h"
+#include "testutils/HexData.h"
+
+using namespace cpputils;
+using std::string;
+
+// Test vectors from "The Galois/Counter Mode of Operation (GCM)" by McGrew and Viega, and messages with the
+// 16 byte IVs GCM_Cipher uses, checked against OpenSSL. The tests don't do anything on CPUs without AES-NI.
+class HardwareAesGcmTest: public ::testing::Test {
+public:
+  void EXPECT_ENCRYPTS(const string &key, const string &iv, const string &header, const Data &message, const string &expectedCiphertext, const string &expectedTag) {
+    if (!HardwareAesGcm::isSupported()) {
+      return;
+    }
+    Data keyData = HexData(key);
+    Data ivData = HexData(iv);
+    Data headerData = HexData(header);
+    HardwareAesGcm gcm;
+    gcm.SetKeyWithIV((const uint8_t*)keyData.data(), keyData.size(), (const uint8_t*)ivData.data(), ivData.size());
+
+    Data ciphertext(message.size());
+    Data tag(16);
+    gcm.EncryptAndAuthenticate((uint8_t*)ciphertext.data(), (uint8_t*)tag.data(), tag.size(), (const uint8_t*)ivData.data(), ivData.size(),
+                               (const uint8_t*)headerData.data(), headerData.size(), (const uint8_t*)message.data(), message.size());
+    if (expectedCiphertext != "") {
+      EXPECT_EQ(HexData(expectedCiphertext), ciphertext);
+    }
+    EXPECT_EQ(HexData(expectedTag), tag);
+
+    Data decrypted(message.size());
+    EXPECT_TRUE(gcm.DecryptAndVerify((uint8_t*)decrypted.data(), (const uint8_t*)tag.data(), tag.size(), (const uint8_t*)ivData.data(), ivData.size(),
+                                     (const uint8_t*)headerData.data(), headerData.size(), (const uint8_t*)ciphertext.data(), ciphertext.size()));
+    EXPECT_EQ(message, decrypted);
+
+    ((uint8_t*)tag.data())[0] ^= 1;
+    EXPECT_FALSE(gcm.DecryptAndVerify((uint8_t*)decrypted.data(), (const uint8_t*)tag.data(), tag.size(), (const uint8_t*)ivData.data(), ivData.size(),
+                                      (const uint8_t*)headerData.data(), headerData.size(), (const uint8_t*)ciphertext.data(), ciphertext.size()));
+  }
+
+  // Bytes counting up from zero. 1000 bytes go through all code paths of the implementation.
+  static Data Counting(size_t size) {
+    Data result(size);
+    for (size_t i = 0; i < size; ++i) {
+      ((uint8_t*)result.data())[i] = static_cast<uint8_t>(i);
+    }
+    return result;
+  }
+};
+
+TEST_F(HardwareAesGcmTest, AES128_ZeroBlock) {
+  EXPECT_ENCRYPTS("00000000000000000000000000000000", "000000000000000000000000", "", HexData("00000000000000000000000000000000"),
+                  "0388dace60b6a392f328c2b971b2fe78", "ab6e47d42cec13bdf53a67b21257bddf");
+}
+
+TEST_F(HardwareAesGcmTest, AES256_ZeroBlock) {
+  EXPECT_ENCRYPTS("0000000000000000000000000000000000000000000000000000000000000000", "000000000000000000000000", "", HexData("00000000000000000000000000000000"),
+                  "cea7403d4d606b6e074ec5d3baf39d18", "d0d1c8a799996bf0265b98b5d48ab919");
+}
+
+TEST_F(HardwareAesGcmTest, AES128_LongIVAndHeader) {
+  EXPECT_ENCRYPTS("feffe9928665731c6d6a8f9467308308",
+                  "9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b",
+                  "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+                  HexData("d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39"),
+                  "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca701e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+                  "619cc5aefffe0bfa462af43c1699d050");
+}
+
+TEST_F(HardwareAesGcmTest, AES256_16ByteIV_PartialBlock) {
+  EXPECT_ENCRYPTS("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", "", Counting(33),
+                  "b8601e2c9585e8c0a0ec59ce0123b4a562f552a8ecb5e785b18d6d6346c245c7ec", "abf8808f6115c749823850ece884fcdd");
+}
+
+TEST_F(HardwareAesGcmTest, AES256_16ByteIV_LongMessage) {
+  EXPECT_ENCRYPTS("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", "", Counting(1000),
+                  "", "9a6a62ae62c6616b90cf488c41f2ba6a");
+}
+
+TEST_F(HardwareAesGcmTest, AES128_16ByteIV_LongMessage) {
+  EXPECT_ENCRYPTS("000102030405060708090a0b0c0d0e0f", "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", "", Counting(1000),
+                  "", "d598a20f4c394153f89e518cc593465f");
+}
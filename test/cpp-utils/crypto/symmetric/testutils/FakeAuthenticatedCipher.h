@@ -47,41 +47,53 @@ namespace cpputils {
           return ciphertextBlockSize - 5;
         }
 
-        static Data encrypt(const byte *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey) {
-          Data result(ciphertextSize(plaintextSize));
-
+        static void encrypt(const byte *plaintext, unsigned int plaintextSize, byte *ciphertext, const EncryptionKey &encKey) {
           //Add a random IV
           uint8_t iv = rand();
-          std::memcpy(result.data(), &iv, 1);
+          std::memcpy(ciphertext, &iv, 1);
 
           //Use caesar chiffre on plaintext
-          _caesar((byte *) result.data() + 1, plaintext, plaintextSize, encKey.value + iv);
+          _caesar(ciphertext + 1, plaintext, plaintextSize, encKey.value + iv);
 
           //Add parity information
-          int32_t parity = _parity((byte *) result.data(), plaintextSize + 1);
-          std::memcpy((byte *) result.data() + plaintextSize + 1, &parity, 4);
-
-          return result;
+          int32_t parity = _parity(ciphertext, plaintextSize + 1);
+          std::memcpy(ciphertext + plaintextSize + 1, &parity, 4);
         }
 
-        static boost::optional <Data> decrypt(const byte *ciphertext, unsigned int ciphertextSize,
-                                              const EncryptionKey &encKey) {
+        static bool decrypt(const byte *ciphertext, unsigned int ciphertextSize, byte *plaintext, const EncryptionKey &encKey) {
           //We need at least 5 bytes (iv + parity)
           if (ciphertextSize < 5) {
-            return boost::none;
+            return false;
           }
 
           //Check parity
           int32_t expectedParity = _parity(ciphertext, plaintextSize(ciphertextSize) + 1);
           int32_t actualParity = *(int32_t * )(ciphertext + plaintextSize(ciphertextSize) + 1);
           if (expectedParity != actualParity) {
-            return boost::none;
+            return false;
           }
 
           //Decrypt caesar chiffre from ciphertext
           int32_t iv = *(int32_t *) ciphertext;
+          _caesar(plaintext, ciphertext + 1, plaintextSize(ciphertextSize), -(encKey.value + iv));
+          return true;
+        }
+
+        static Data encrypt(const byte *plaintext, unsigned int plaintextSize, const EncryptionKey &encKey) {
+          Data result(ciphertextSize(plaintextSize));
+          encrypt(plaintext, plaintextSize, (byte *) result.data(), encKey);
+          return result;
+        }
+
+        static boost::optional <Data> decrypt(const byte *ciphertext, unsigned int ciphertextSize,
+                                              const EncryptionKey &encKey) {
+          if (ciphertextSize < 5) {
+            return boost::none;
+          }
           Data result(plaintextSize(ciphertextSize));
-          _caesar((byte *) result.data(), ciphertext + 1, plaintextSize(ciphertextSize), -(encKey.value + iv));
+          if (!decrypt(ciphertext, ciphertextSize, (byte *) result.data(), encKey)) {
+            return boost::none;
+          }
           return std::move(result);
         }
 
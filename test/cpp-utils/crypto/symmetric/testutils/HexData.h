@@ -0,0 +1,21 @@
+#pragma once
+#ifndef MESSMER_CPPUTILS_TEST_CRYPTO_SYMMETRIC_TESTUTILS_HEXDATA_H_
+#define MESSMER_CPPUTILS_TEST_CRYPTO_SYMMETRIC_TESTUTILS_HEXDATA_H_
+
+#include "cpp-utils/data/Data.h"
+#include <string>
+
+namespace cpputils {
+
+    // Parses the hex strings test vectors are given in
+    inline Data HexData(const std::string &hex) {
+        Data result(hex.size() / 2);
+        for (size_t i = 0; i < result.size(); ++i) {
+            static_cast<uint8_t*>(result.data())[i] = static_cast<uint8_t>(std::stoul(hex.substr(2 * i, 2), nullptr, 16));
+        }
+        return result;
+    }
+
+}
+
+#endif
@@ -153,6 +153,54 @@ TEST_F(DataTest, MoveAssignment) {
   EXPECT_EQ(0u, original.size());
 }
 
+TEST_F(DataTest, MoveKeepsHeadroom) {
+  Data original(1024, 16);
+  Data moved(std::move(original));
+  EXPECT_EQ(16u, moved.headroom());
+  EXPECT_EQ(0u, original.headroom());
+}
+
+TEST_F(DataTest, CopyKeepsHeadroom) {
+  Data original(1024, 16);
+  EXPECT_EQ(16u, original.copy().headroom());
+}
+
+TEST_F(DataTest, GrowFrontUsesHeadroom) {
+  Data data(1024, 16);
+  std::memcpy(data.data(), DataFixture::generate(1024).data(), 1024);
+  const void *begin = data.data();
+  data.growFront(10);
+  EXPECT_EQ(1034u, data.size());
+  EXPECT_EQ(6u, data.headroom());
+  EXPECT_EQ((const uint8_t*)begin - 10, data.data());
+  EXPECT_EQ(0, std::memcmp(DataFixture::generate(1024).data(), data.dataOffset(10), 1024));
+}
+
+TEST_F(DataTest, GrowFrontWithoutEnoughHeadroom) {
+  Data data = DataFixture::generate(1024);
+  data.growFront(10);
+  EXPECT_EQ(1034u, data.size());
+  EXPECT_EQ(0, std::memcmp(DataFixture::generate(1024).data(), data.dataOffset(10), 1024));
+}
+
+TEST_F(DataTest, ShrinkFront) {
+  Data data = DataFixture::generate(1024);
+  const void *begin = data.data();
+  data.shrinkFront(10);
+  EXPECT_EQ(1014u, data.size());
+  EXPECT_EQ(10u, data.headroom());
+  EXPECT_EQ((const uint8_t*)begin + 10, data.data());
+  EXPECT_EQ(0, std::memcmp(DataFixture::generate(1024).dataOffset(10), data.data(), 1014));
+}
+
+TEST_F(DataTest, GrowFrontAfterShrinkFront) {
+  Data data = DataFixture::generate(1024);
+  const void *begin = data.data();
+  data.shrinkFront(10).growFront(10);
+  EXPECT_EQ(begin, data.data());
+  EXPECT_EQ(DataFixture::generate(1024), data);
+}
+
 TEST_F(DataTest, Equality) {
   Data data1 = DataFixture::generate(1024);
   Data data2 = DataFixture::generate(1024);
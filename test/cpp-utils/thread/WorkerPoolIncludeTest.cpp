@@ -0,0 +1,3 @@
+#include "cpp-utils/thread/WorkerPool.h"
+
+// Test the header can be included without needing additional dependencies
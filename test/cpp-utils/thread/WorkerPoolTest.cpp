@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include "cpp-utils/thread/WorkerPool.h"
+#include "cpp-utils/lock/ConditionBarrier.h"
+#include <atomic>
+#include <set>
+#include <mutex>
+#include <thread>
+
+using cpputils::WorkerPool;
+using cpputils::ConditionBarrier;
+using std::future;
+using std::vector;
+
+class WorkerPoolTest: public ::testing::Test {
+};
+
+TEST_F(WorkerPoolTest, RunsTask) {
+  WorkerPool pool(2, 10);
+  std::atomic<bool> called(false);
+  pool.schedule([&called] {
+    called = true;
+  }).wait();
+  EXPECT_TRUE(called);
+}
+
+TEST_F(WorkerPoolTest, RunsManyTasks) {
+  WorkerPool pool(4, 2);
+  std::atomic<int> counter(0);
+  vector<future<void>> waitHandles;
+  for (int i = 0; i < 1000; ++i) {
+    waitHandles.push_back(pool.schedule([&counter] {
+      ++counter;
+    }));
+  }
+  for (auto &waitHandle : waitHandles) {
+    waitHandle.wait();
+  }
+  EXPECT_EQ(1000, counter);
+}
+
+TEST_F(WorkerPoolTest, PassesExceptionsToFuture) {
+  WorkerPool pool(1, 10);
+  auto waitHandle = pool.schedule([] {
+    throw std::runtime_error("error");
+  });
+  EXPECT_THROW(waitHandle.get(), std::runtime_error);
+  // The worker is still running
+  pool.schedule([] {}).get();
+}
+
+TEST_F(WorkerPoolTest, RunsTasksInParallel) {
+  WorkerPool pool(2, 10);
+  ConditionBarrier firstTaskStarted;
+  ConditionBarrier secondTaskFinished;
+  auto first = pool.schedule([&] {
+    firstTaskStarted.release();
+    secondTaskFinished.wait();
+  });
+  firstTaskStarted.wait();
+  pool.schedule([] {}).wait();
+  secondTaskFinished.release();
+  first.wait();
+}
+
+TEST_F(WorkerPoolTest, RunOnAllWorkers) {
+  WorkerPool pool(4, 1);
+  std::mutex mutex;
+  std::multiset<uint32_t> calledWith;
+  pool.runOnAllWorkers([&] (uint32_t workerIndex) {
+    std::unique_lock<std::mutex> lock(mutex);
+    calledWith.insert(workerIndex);
+  });
+  EXPECT_EQ((std::multiset<uint32_t>{0, 1, 2, 3}), calledWith);
+}
+
+TEST_F(WorkerPoolTest, ParallelFor_RunsEachIndexOnce) {
+  WorkerPool pool(4, 1);
+  vector<std::atomic<int>> calls(1000);
+  pool.parallelFor(calls.size(), [&calls] (size_t index) {
+    ++calls[index];
+  });
+  for (const auto &numCalls : calls) {
+    EXPECT_EQ(1, numCalls);
+  }
+}
+
+TEST_F(WorkerPoolTest, ParallelFor_FewerTasksThanWorkers) {
+  WorkerPool pool(4, 1);
+  std::atomic<int> counter(0);
+  pool.parallelFor(2, [&counter] (size_t) {
+    ++counter;
+  });
+  EXPECT_EQ(2, counter);
+  pool.parallelFor(0, [&counter] (size_t) {
+    ++counter;
+  });
+  EXPECT_EQ(2, counter);
+}
+
+TEST_F(WorkerPoolTest, ParallelFor_RethrowsWhenNoTaskIsRunningAnymore) {
+  WorkerPool pool(4, 1);
+  std::atomic<int> counter(0);
+  EXPECT_THROW(pool.parallelFor(100, [&counter] (size_t index) {
+    if (index == 0) {
+      throw std::runtime_error("error");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ++counter;
+  }), std::runtime_error);
+  int counterAfterReturning = counter;
+  EXPECT_LT(0, counterAfterReturning);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(counterAfterReturning, counter);
+}
+
+TEST_F(WorkerPoolTest, Statistics_Empty) {
+  WorkerPool pool(2, 10);
+  auto statistics = pool.statistics();
+  EXPECT_EQ(0u, statistics.queueDepth);
+  EXPECT_EQ(0u, statistics.numFinishedTasks);
+  EXPECT_EQ(0, statistics.averageLatencySec);
+  EXPECT_EQ(0, statistics.maxLatencySec);
+}
+
+TEST_F(WorkerPoolTest, Statistics_QueueDepth) {
+  WorkerPool pool(1, 10);
+  ConditionBarrier taskStarted;
+  ConditionBarrier release;
+  auto blocking = pool.schedule([&] {
+    taskStarted.release();
+    release.wait();
+  });
+  taskStarted.wait();
+  auto queued1 = pool.schedule([] {});
+  auto queued2 = pool.schedule([] {});
+  EXPECT_EQ(2u, pool.statistics().queueDepth);
+  release.release();
+  queued2.wait();
+  EXPECT_EQ(0u, pool.statistics().queueDepth);
+}
+
+TEST_F(WorkerPoolTest, Statistics_Latency) {
+  WorkerPool pool(1, 10);
+  pool.schedule([] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }).wait();
+  pool.schedule([] {}).wait();
+  // Statistics are updated after the future is ready, so wait for the worker to pick up another task
+  pool.schedule([] {}).wait();
+  auto statistics = pool.statistics();
+  EXPECT_LE(2u, statistics.numFinishedTasks);
+  EXPECT_LE(0.05, statistics.maxLatencySec);
+  EXPECT_LT(0, statistics.averageLatencySec);
+}
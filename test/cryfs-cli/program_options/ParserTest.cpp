@@ -146,6 +146,45 @@ TEST_F(ProgramOptionsParserTest, BlocksizeNotGiven) {
     EXPECT_EQ(none, options.blocksizeBytes());
 }
 
+TEST_F(ProgramOptionsParserTest, CacheSizeGiven) {
+    ProgramOptions options = parse({"./myExecutable", "/home/user/baseDir", "--cache-size", "4294967296", "/home/user/mountDir"});
+    EXPECT_EQ(4294967296u, options.cacheSizeBytes().value());
+}
+
+TEST_F(ProgramOptionsParserTest, CacheSizeNotGiven) {
+    ProgramOptions options = parse({"./myExecutable", "/home/user/baseDir", "/home/user/mountDir"});
+    EXPECT_EQ(none, options.cacheSizeBytes());
+}
+
+TEST_F(ProgramOptionsParserTest, LowlevelFuseGiven) {
+    ProgramOptions options = parse({"./myExecutable", "/home/user/baseDir", "--fuse-lowlevel", "/home/user/mountDir"});
+    EXPECT_TRUE(options.lowlevelFuse());
+}
+
+TEST_F(ProgramOptionsParserTest, LowlevelFuseNotGiven) {
+    ProgramOptions options = parse({"./myExecutable", "/home/user/baseDir", "/home/user/mountDir"});
+    EXPECT_FALSE(options.lowlevelFuse());
+}
+
+TEST_F(ProgramOptionsParserTest, TimeoutsGiven) {
+    ProgramOptions options = parse({"./myExecutable", "/home/user/baseDir", "--fuse-lowlevel", "--entry-timeout", "10.5", "--attr-timeout", "2", "/home/user/mountDir"});
+    EXPECT_EQ(10.5, options.entryTimeoutSeconds().value());
+    EXPECT_EQ(2.0, options.attrTimeoutSeconds().value());
+}
+
+TEST_F(ProgramOptionsParserTest, TimeoutsNotGiven) {
+    ProgramOptions options = parse({"./myExecutable", "/home/user/baseDir", "--fuse-lowlevel", "/home/user/mountDir"});
+    EXPECT_EQ(none, options.entryTimeoutSeconds());
+    EXPECT_EQ(none, options.attrTimeoutSeconds());
+}
+
+TEST_F(ProgramOptionsParserTest, TimeoutsWithoutLowlevelFuse) {
+    EXPECT_DEATH(
+        parse({"./myExecutable", "/home/user/baseDir", "--entry-timeout", "10", "/home/user/mountDir"}),
+        "can only be used with --fuse-lowlevel"
+    );
+}
+
 TEST_F(ProgramOptionsParserTest, FuseOptionGiven) {
     ProgramOptions options = parse({"./myExecutable", "/home/user/baseDir", "/home/user/mountDir", "--", "-f"});
     EXPECT_EQ("/home/user/baseDir", options.baseDir());
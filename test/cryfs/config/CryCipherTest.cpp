@@ -78,6 +78,7 @@ public:
 TEST_F(CryCipherTest, FindsCorrectCipher) {
   EXPECT_FINDS_CORRECT_CIPHERS({
     "aes-256-gcm", "aes-256-cfb", "aes-256-gcm", "aes-256-cfb",
+    "xchacha20-poly1305",
     "twofish-256-gcm", "twofish-256-cfb", "twofish-256-gcm", "twofish-256-cfb",
     "serpent-256-gcm", "serpent-256-cfb", "serpent-256-gcm", "serpent-256-cfb",
     "cast-256-gcm", "cast-256-cfb",
@@ -90,6 +91,7 @@ TEST_F(CryCipherTest, CreatesCorrectEncryptedBlockStore) {
     EXPECT_CREATES_CORRECT_ENCRYPTED_BLOCKSTORE<AES256_CFB>("aes-256-cfb");
     EXPECT_CREATES_CORRECT_ENCRYPTED_BLOCKSTORE<AES128_GCM>("aes-128-gcm");
     EXPECT_CREATES_CORRECT_ENCRYPTED_BLOCKSTORE<AES128_CFB>("aes-128-cfb");
+    EXPECT_CREATES_CORRECT_ENCRYPTED_BLOCKSTORE<XChaCha20Poly1305>("xchacha20-poly1305");
     EXPECT_CREATES_CORRECT_ENCRYPTED_BLOCKSTORE<Twofish256_GCM>("twofish-256-gcm");
     EXPECT_CREATES_CORRECT_ENCRYPTED_BLOCKSTORE<Twofish256_CFB>("twofish-256-cfb");
     EXPECT_CREATES_CORRECT_ENCRYPTED_BLOCKSTORE<Twofish128_GCM>("twofish-128-gcm");
@@ -3,6 +3,7 @@
 #include <cryfs/filesystem/CryDir.h>
 #include <cryfs/filesystem/CryFile.h>
 #include <cryfs/filesystem/CryOpenFile.h>
+#include <fspp/fuse/FuseErrnoException.h>
 
 using cpputils::unique_ref;
 using cpputils::dynamic_pointer_move;
@@ -40,3 +41,46 @@ TEST_F(CryNodeTest, Rename_Overwrite_DoesntLeaveBlocksOver) {
     node->rename("/newexistingname");
     EXPECT_EQ(2u, device().numBlocks()); // Only the blocks of one file are left
 }
+
+TEST_F(CryNodeTest, Rename_OldPathCantBeLoadedAnymore) {
+    auto node = CreateFile("/oldname");
+    EXPECT_NE(boost::none, device().Load("/oldname"));
+    node->rename("/newname");
+    EXPECT_EQ(boost::none, device().Load("/oldname"));
+    EXPECT_NE(boost::none, device().Load("/newname"));
+}
+
+TEST_F(CryNodeTest, Rename_ChildrenOfDirAreLoadedFromNewPath) {
+    device().LoadDir("/").value()->createDir("olddir", MODE_PUBLIC, 0, 0);
+    CreateFile("/olddir/file");
+    EXPECT_NE(boost::none, device().Load("/olddir/file"));
+    device().Load("/olddir").value()->rename("/newdir");
+    EXPECT_THROW(device().Load("/olddir/file"), fspp::fuse::FuseErrnoException);
+    EXPECT_NE(boost::none, device().Load("/newdir/file"));
+}
+
+TEST_F(CryNodeTest, Rename_Overwrite_LoadsMovedNodeFromTargetPath) {
+    device().LoadDir("/").value()->createDir("source", MODE_PUBLIC, 0, 0);
+    device().LoadDir("/").value()->createDir("target", MODE_PUBLIC, 0, 0);
+    CreateFile("/source/file");
+    EXPECT_NE(boost::none, device().Load("/target"));
+    device().Load("/source").value()->rename("/target");
+    EXPECT_NE(boost::none, device().Load("/target/file"));
+}
+
+TEST_F(CryNodeTest, Remove_PathCantBeLoadedAnymore) {
+    CreateFile("/file");
+    EXPECT_NE(boost::none, device().Load("/file"));
+    device().Load("/file").value()->remove();
+    EXPECT_EQ(boost::none, device().Load("/file"));
+}
+
+TEST_F(CryNodeTest, Remove_Dir_ChildrenCantBeLoadedAnymore) {
+    device().LoadDir("/").value()->createDir("dir", MODE_PUBLIC, 0, 0);
+    device().LoadDir("/dir").value()->createDir("subdir", MODE_PUBLIC, 0, 0);
+    EXPECT_NE(boost::none, device().Load("/dir/subdir"));
+    device().Load("/dir/subdir").value()->remove();
+    device().Load("/dir").value()->remove();
+    EXPECT_EQ(boost::none, device().Load("/dir"));
+    EXPECT_THROW(device().Load("/dir/subdir"), fspp::fuse::FuseErrnoException);
+}
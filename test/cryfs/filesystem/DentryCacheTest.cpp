@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <cryfs/filesystem/DentryCache.h>
+#include <cpp-utils/data/DataFixture.h>
+
+using blockstore::Key;
+using boost::none;
+using cpputils::DataFixture;
+using cryfs::DentryCache;
+using fspp::Dir;
+
+class DentryCacheTest : public ::testing::Test {
+public:
+    DentryCacheTest(): rootKey(CreateKey(0)), cache(100) {}
+
+    static Key CreateKey(int seed) {
+        return DataFixture::generateFixedSize<Key::BINARY_LENGTH>(seed);
+    }
+
+    void Insert(const char *path, int keySeed, int parentKeySeed, Dir::EntryType type = Dir::EntryType::DIR) {
+        cache.insert(path, DentryCache::Entry{CreateKey(keySeed), CreateKey(parentKeySeed), type}, cache.generation());
+    }
+
+    bool IsCached(const char *path) {
+        return cache.lookup(path) != none;
+    }
+
+    Key rootKey;
+    DentryCache cache;
+};
+
+TEST_F(DentryCacheTest, EmptyCacheDoesntFindPath) {
+    EXPECT_EQ(none, cache.lookup("/dir"));
+}
+
+TEST_F(DentryCacheTest, FindsInsertedPath) {
+    Insert("/file", 1, 0, Dir::EntryType::FILE);
+    auto found = cache.lookup("/file");
+    ASSERT_NE(none, found);
+    EXPECT_EQ(CreateKey(1), found->key);
+    EXPECT_EQ(rootKey, found->parentKey);
+    EXPECT_EQ(Dir::EntryType::FILE, found->type);
+}
+
+TEST_F(DentryCacheTest, FindsNestedPath) {
+    Insert("/dir", 1, 0);
+    Insert("/dir/subdir", 2, 1);
+    Insert("/dir/subdir/file", 3, 2, Dir::EntryType::FILE);
+    EXPECT_EQ(CreateKey(3), cache.lookup("/dir/subdir/file")->key);
+}
+
+TEST_F(DentryCacheTest, DoesntInsertPathWithoutCachedParent) {
+    Insert("/dir/subdir", 2, 1);
+    EXPECT_FALSE(IsCached("/dir/subdir"));
+}
+
+TEST_F(DentryCacheTest, DoesntInsertPathWithDifferentParent) {
+    Insert("/dir", 1, 0);
+    Insert("/dir/subdir", 2, 5);
+    EXPECT_FALSE(IsCached("/dir/subdir"));
+}
+
+TEST_F(DentryCacheTest, DoesntInsertIfInvalidatedSinceGeneration) {
+    uint64_t generation = cache.generation();
+    cache.invalidate(CreateKey(10));
+    cache.insert("/file", DentryCache::Entry{CreateKey(1), rootKey, Dir::EntryType::FILE}, generation);
+    EXPECT_FALSE(IsCached("/file"));
+}
+
+TEST_F(DentryCacheTest, InvalidateRemovesPathAndDescendants) {
+    Insert("/dir", 1, 0);
+    Insert("/dir/subdir", 2, 1);
+    Insert("/dir/subdir/file", 3, 2, Dir::EntryType::FILE);
+    Insert("/dir-2", 4, 0);
+    Insert("/dir-2/file", 5, 4, Dir::EntryType::FILE);
+    Insert("/dir.txt", 6, 0, Dir::EntryType::FILE);
+    cache.invalidate(CreateKey(1));
+    EXPECT_FALSE(IsCached("/dir"));
+    EXPECT_FALSE(IsCached("/dir/subdir"));
+    EXPECT_FALSE(IsCached("/dir/subdir/file"));
+    EXPECT_TRUE(IsCached("/dir-2"));
+    EXPECT_TRUE(IsCached("/dir-2/file"));
+    EXPECT_TRUE(IsCached("/dir.txt"));
+    EXPECT_EQ(3u, cache.size());
+}
+
+TEST_F(DentryCacheTest, InvalidateSubdirKeepsParent) {
+    Insert("/dir", 1, 0);
+    Insert("/dir/subdir", 2, 1);
+    Insert("/dir/subdir/file", 3, 2, Dir::EntryType::FILE);
+    cache.invalidate(CreateKey(2));
+    EXPECT_TRUE(IsCached("/dir"));
+    EXPECT_FALSE(IsCached("/dir/subdir"));
+    EXPECT_FALSE(IsCached("/dir/subdir/file"));
+}
+
+TEST_F(DentryCacheTest, InvalidateUncachedKeyDoesNothing) {
+    Insert("/dir", 1, 0);
+    cache.invalidate(CreateKey(10));
+    EXPECT_TRUE(IsCached("/dir"));
+}
+
+TEST_F(DentryCacheTest, InsertingKeyAtNewPathRemovesOldPath) {
+    Insert("/dir", 1, 0);
+    Insert("/dir/file", 2, 1, Dir::EntryType::FILE);
+    Insert("/dir2", 1, 0);
+    EXPECT_FALSE(IsCached("/dir"));
+    EXPECT_FALSE(IsCached("/dir/file"));
+    EXPECT_TRUE(IsCached("/dir2"));
+}
+
+TEST_F(DentryCacheTest, InsertingOtherKeyAtPathReplacesIt) {
+    Insert("/file", 1, 0, Dir::EntryType::FILE);
+    Insert("/file", 2, 0, Dir::EntryType::DIR);
+    EXPECT_EQ(CreateKey(2), cache.lookup("/file")->key);
+    cache.invalidate(CreateKey(1));
+    EXPECT_TRUE(IsCached("/file"));
+}
+
+TEST_F(DentryCacheTest, DropsLeastRecentlyUsedPaths) {
+    DentryCache smallCache(3);
+    auto insert = [&smallCache] (const char *path, int keySeed, int parentKeySeed) {
+        smallCache.insert(path, DentryCache::Entry{CreateKey(keySeed), CreateKey(parentKeySeed), Dir::EntryType::FILE}, smallCache.generation());
+    };
+    insert("/a", 1, 0);
+    insert("/b", 2, 0);
+    insert("/c", 3, 0);
+    smallCache.lookup("/a");
+    insert("/d", 4, 0);
+    EXPECT_EQ(3u, smallCache.size());
+    EXPECT_NE(none, smallCache.lookup("/a"));
+    EXPECT_EQ(none, smallCache.lookup("/b"));
+    EXPECT_NE(none, smallCache.lookup("/c"));
+    EXPECT_NE(none, smallCache.lookup("/d"));
+}
+
+TEST_F(DentryCacheTest, KeepsAncestorsOfRecentlyUsedPaths) {
+    DentryCache smallCache(3);
+    auto insert = [&smallCache] (const char *path, int keySeed, int parentKeySeed) {
+        smallCache.insert(path, DentryCache::Entry{CreateKey(keySeed), CreateKey(parentKeySeed), Dir::EntryType::DIR}, smallCache.generation());
+    };
+    insert("/dir", 1, 0);
+    insert("/dir/subdir", 2, 1);
+    insert("/other", 3, 0);
+    smallCache.lookup("/dir/subdir");
+    insert("/other2", 4, 0);
+    EXPECT_NE(none, smallCache.lookup("/dir"));
+    EXPECT_NE(none, smallCache.lookup("/dir/subdir"));
+    EXPECT_EQ(none, smallCache.lookup("/other"));
+}
+
+TEST_F(DentryCacheTest, DisabledCacheDoesntCacheAnything) {
+    DentryCache disabled(0);
+    disabled.insert("/file", DentryCache::Entry{CreateKey(1), rootKey, Dir::EntryType::FILE}, disabled.generation());
+    EXPECT_EQ(none, disabled.lookup("/file"));
+    EXPECT_EQ(0u, disabled.size());
+}
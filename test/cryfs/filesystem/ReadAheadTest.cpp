@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <cryfs/filesystem/ReadAhead.h>
+#include <cpp-utils/pointer/unique_ref.h>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <thread>
+#include <chrono>
+
+using cpputils::unique_ref;
+using cpputils::make_unique_ref;
+using cpputils::WorkerPool;
+using std::vector;
+using std::pair;
+using cryfs::ReadAhead;
+
+class ReadAheadTest : public ::testing::Test {
+public:
+    static constexpr uint64_t MAX_WINDOW_SIZE = 1024 * 1024;
+
+    ReadAheadTest(): workers(1, 1), prefetchesMutex(), prefetches() {}
+
+    unique_ref<ReadAhead> CreateReadAhead(uint64_t maxWindowSize = MAX_WINDOW_SIZE) {
+        return make_unique_ref<ReadAhead>(&workers, [this] (uint64_t offset, uint64_t count) {
+            std::lock_guard<std::mutex> lock(prefetchesMutex);
+            prefetches.emplace_back(offset, count);
+        }, maxWindowSize);
+    }
+
+    void WaitForNumPrefetches(size_t num) {
+        for (int i = 0; i < 1000; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(prefetchesMutex);
+                if (prefetches.size() >= num) {
+                    return;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        FAIL() << "Prefetch didn't run";
+    }
+
+    // Destructing the ReadAhead waits for its prefetch
+    vector<pair<uint64_t, uint64_t>> PrefetchesAfterDestructing(unique_ref<ReadAhead> readAhead) {
+        cpputils::destruct(std::move(readAhead));
+        std::lock_guard<std::mutex> lock(prefetchesMutex);
+        return prefetches;
+    }
+
+    WorkerPool workers;
+    std::mutex prefetchesMutex;
+    vector<pair<uint64_t, uint64_t>> prefetches;
+};
+constexpr uint64_t ReadAheadTest::MAX_WINDOW_SIZE;
+
+TEST_F(ReadAheadTest, FirstReadAtBeginningOfFile_PrefetchesTwiceTheReadSize) {
+    auto readAhead = CreateReadAhead();
+    readAhead->onRead(0, 4096);
+    EXPECT_EQ(8192u, readAhead->windowSize());
+    EXPECT_EQ((vector<pair<uint64_t, uint64_t>>{{4096, 8192}}), PrefetchesAfterDestructing(std::move(readAhead)));
+}
+
+TEST_F(ReadAheadTest, FirstReadInMiddleOfFile_DoesntPrefetch) {
+    auto readAhead = CreateReadAhead();
+    readAhead->onRead(10000, 4096);
+    EXPECT_EQ(0u, readAhead->windowSize());
+    EXPECT_EQ((vector<pair<uint64_t, uint64_t>>{}), PrefetchesAfterDestructing(std::move(readAhead)));
+}
+
+TEST_F(ReadAheadTest, SequentialReads_WindowGrowsUpToMaximum) {
+    auto readAhead = CreateReadAhead();
+    uint64_t offset = 0;
+    uint64_t expectedWindowSize = 8192;
+    while (expectedWindowSize < MAX_WINDOW_SIZE) {
+        readAhead->onRead(offset, 4096);
+        offset += 4096;
+        EXPECT_EQ(expectedWindowSize, readAhead->windowSize());
+        expectedWindowSize *= 2;
+    }
+    readAhead->onRead(offset, 4096);
+    EXPECT_EQ(MAX_WINDOW_SIZE, readAhead->windowSize());
+}
+
+TEST_F(ReadAheadTest, NonSequentialRead_ResetsWindow) {
+    auto readAhead = CreateReadAhead();
+    readAhead->onRead(0, 4096);
+    readAhead->onRead(4096, 4096);
+    EXPECT_LT(0u, readAhead->windowSize());
+    readAhead->onRead(100000, 4096);
+    EXPECT_EQ(0u, readAhead->windowSize());
+    // Reading sequentially from there on starts a new window
+    readAhead->onRead(104096, 4096);
+    EXPECT_EQ(8192u, readAhead->windowSize());
+}
+
+TEST_F(ReadAheadTest, PrefetchesAgainWhenHalfOfPrefetchedDataIsRead) {
+    auto readAhead = CreateReadAhead(16384);
+    readAhead->onRead(0, 4096);
+    WaitForNumPrefetches(1);
+    readAhead->onRead(4096, 4096);
+    WaitForNumPrefetches(2);
+    // More than half of the window is prefetched after these reads
+    readAhead->onRead(8192, 4096);
+    readAhead->onRead(12288, 4096);
+    readAhead->onRead(16384, 4096);
+    // Each prefetch continues where the last one stopped
+    EXPECT_EQ((vector<pair<uint64_t, uint64_t>>{{4096, 8192}, {12288, 12288}, {24576, 12288}}), PrefetchesAfterDestructing(std::move(readAhead)));
+}
+
+TEST_F(ReadAheadTest, MaxWindowSizeZero_DoesntPrefetch) {
+    auto readAhead = CreateReadAhead(0);
+    readAhead->onRead(0, 4096);
+    readAhead->onRead(4096, 4096);
+    EXPECT_EQ((vector<pair<uint64_t, uint64_t>>{}), PrefetchesAfterDestructing(std::move(readAhead)));
+}
+
+TEST_F(ReadAheadTest, FailingPrefetchDoesntAffectReads) {
+    auto readAhead = make_unique_ref<ReadAhead>(&workers, [] (uint64_t, uint64_t) {
+        throw std::runtime_error("Couldn't load block");
+    }, MAX_WINDOW_SIZE);
+    readAhead->onRead(0, 4096);
+    readAhead->onRead(4096, 4096);
+    EXPECT_NO_THROW(cpputils::destruct(std::move(readAhead)));
+}
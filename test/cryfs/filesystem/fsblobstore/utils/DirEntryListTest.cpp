@@ -0,0 +1,285 @@
+#include <gtest/gtest.h>
+#include <cryfs/filesystem/fsblobstore/utils/DirEntryList.h>
+#include <cpp-utils/data/DataFixture.h>
+#include <fspp/fuse/FuseErrnoException.h>
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+using blockstore::Key;
+using boost::none;
+using cpputils::Data;
+using cpputils::DataFixture;
+using cryfs::fsblobstore::DirEntry;
+using cryfs::fsblobstore::DirEntryList;
+using fspp::Dir;
+using fspp::fuse::FuseErrnoException;
+using std::string;
+
+class DirEntryListTest : public ::testing::Test {
+public:
+    static Key CreateKey(int seed) {
+        return DataFixture::generateFixedSize<Key::BINARY_LENGTH>(seed);
+    }
+
+    void Add(const string &name, int keySeed, Dir::EntryType type = Dir::EntryType::FILE) {
+        list.add(name, CreateKey(keySeed), type, S_IFREG | S_IRUSR, 0, 0, timespec{0, 0}, timespec{0, 0});
+    }
+
+    void AddOrOverwrite(const string &name, int keySeed, Dir::EntryType type = Dir::EntryType::FILE) {
+        list.addOrOverwrite(name, CreateKey(keySeed), type, S_IFREG | S_IRUSR, 0, 0, timespec{0, 0}, timespec{0, 0}, [] (const Key &) {});
+    }
+
+    void Rename(int keySeed, const string &name) {
+        list.rename(CreateKey(keySeed), name, [] (const Key &) {});
+    }
+
+    void ExpectHasEntry(const string &name, int keySeed) {
+        auto found = list.get(name);
+        ASSERT_NE(none, found);
+        EXPECT_EQ(name, found->name());
+        EXPECT_EQ(CreateKey(keySeed), found->key());
+    }
+
+    void ExpectLoadsAllFiles(const Data &serialized, int numFiles) {
+        DirEntryList loaded;
+        loaded.deserializeFrom(serialized.data(), serialized.size());
+        EXPECT_EQ(static_cast<size_t>(numFiles), loaded.size());
+        for (int i = 0; i < numFiles; ++i) {
+            EXPECT_EQ(CreateKey(i), loaded.get("file" + std::to_string(i))->key());
+        }
+    }
+
+    // Writes the changes of the list to disk like DirBlob does and returns the number of bytes written
+    uint64_t WriteChanges() {
+        Data resized(list.serializedSize());
+        resized.FillWithZeroes();
+        std::memcpy(resized.data(), disk.data(), std::min(disk.size(), resized.size()));
+        disk = std::move(resized);
+        uint64_t written = 0;
+        list.serializeChanges([this, &written] (uint64_t offset, const Data &data) {
+            std::memcpy(disk.dataOffset(offset), data.data(), data.size());
+            written += data.size();
+        });
+        return written;
+    }
+
+    DirEntryList list;
+    // The serialized list, as DirBlob stores it in its blob
+    Data disk = Data(0);
+};
+
+TEST_F(DirEntryListTest, FindsAddedEntriesByName) {
+    for (int i = 0; i < 1000; ++i) {
+        Add("file" + std::to_string(i), i);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        ExpectHasEntry("file" + std::to_string(i), i);
+    }
+    EXPECT_EQ(none, list.get("file1000"));
+}
+
+TEST_F(DirEntryListTest, AddingExistingNameThrows) {
+    Add("file", 1);
+    try {
+        Add("file", 2);
+        EXPECT_TRUE(false); // Expect it throws
+    } catch (const FuseErrnoException &e) {
+        EXPECT_EQ(EEXIST, e.getErrno());
+    }
+}
+
+TEST_F(DirEntryListTest, DoesntFindRemovedEntryByName) {
+    Add("file1", 1);
+    Add("file2", 2);
+    Add("file3", 3);
+    list.remove("file2");
+    EXPECT_EQ(none, list.get("file2"));
+    ExpectHasEntry("file1", 1);
+    ExpectHasEntry("file3", 3);
+    Add("file2", 4);
+    ExpectHasEntry("file2", 4);
+}
+
+TEST_F(DirEntryListTest, DoesntFindEntryRemovedByKey) {
+    Add("file1", 1);
+    Add("file2", 2);
+    list.remove(CreateKey(2));
+    EXPECT_EQ(none, list.get("file2"));
+    ExpectHasEntry("file1", 1);
+}
+
+TEST_F(DirEntryListTest, FindsRenamedEntryByNewName) {
+    Add("oldname", 1);
+    Rename(1, "newname");
+    EXPECT_EQ(none, list.get("oldname"));
+    ExpectHasEntry("newname", 1);
+    Add("oldname", 2);
+    ExpectHasEntry("oldname", 2);
+}
+
+TEST_F(DirEntryListTest, RenameOverwritesEntryWithSameName) {
+    Add("file1", 1);
+    Add("file2", 2);
+    Rename(1, "file2");
+    EXPECT_EQ(none, list.get("file1"));
+    ExpectHasEntry("file2", 1);
+    EXPECT_EQ(1u, list.size());
+}
+
+TEST_F(DirEntryListTest, FindsOverwrittenEntryByName) {
+    Add("file", 1);
+    AddOrOverwrite("file", 2);
+    ExpectHasEntry("file", 2);
+    EXPECT_EQ(1u, list.size());
+    list.remove("file");
+    EXPECT_EQ(none, list.get("file"));
+}
+
+TEST_F(DirEntryListTest, FindsEntriesByNameAfterDeserializing) {
+    for (int i = 0; i < 100; ++i) {
+        Add("file" + std::to_string(i), i);
+    }
+    Data serialized = list.serialize();
+    DirEntryList loaded;
+    loaded.deserializeFrom(serialized.data(), serialized.size());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(CreateKey(i), loaded.get("file" + std::to_string(i))->key());
+    }
+    EXPECT_EQ(none, loaded.get("file100"));
+}
+
+TEST_F(DirEntryListTest, DeserializingReplacesEntries) {
+    Add("file1", 1);
+    Data serialized = list.serialize();
+    Add("file2", 2);
+    list.deserializeFrom(serialized.data(), serialized.size());
+    ExpectHasEntry("file1", 1);
+    EXPECT_EQ(none, list.get("file2"));
+}
+
+TEST_F(DirEntryListTest, IteratesAllEntries) {
+    for (int i = 0; i < 1000; ++i) {
+        Add("file" + std::to_string(i), i);
+    }
+    std::set<string> names;
+    for (const auto &entry : list) {
+        names.insert(entry.name());
+    }
+    EXPECT_EQ(1000u, names.size());
+}
+
+TEST_F(DirEntryListTest, SmallDirectoryIsStoredInFlatFormat) {
+    Add("file1", 1);
+    Add("file2", 2);
+    EXPECT_EQ(list.get("file1")->serializedSize() + list.get("file2")->serializedSize(), list.serializedSize());
+    EXPECT_EQ(list.serializedSize(), list.serialize().size());
+}
+
+TEST_F(DirEntryListTest, LargeDirectoryIsStoredInPages) {
+    for (int i = 0; i < 1000; ++i) {
+        Add("file" + std::to_string(i), i);
+    }
+    // A header of 5 bytes and full pages
+    EXPECT_EQ(5u, list.serializedSize() % DirEntryList::PAGE_SIZE);
+    EXPECT_EQ(list.serializedSize(), list.serialize().size());
+    ExpectLoadsAllFiles(list.serialize(), 1000);
+}
+
+TEST_F(DirEntryListTest, LoadsDirectoryInFlatFormat) {
+    // Older versions stored directories of all sizes in the flat format
+    std::vector<DirEntry> entries;
+    for (int i = 0; i < 1000; ++i) {
+        entries.emplace_back(Dir::EntryType::FILE, "file" + std::to_string(i), CreateKey(i), S_IFREG | S_IRUSR, 0, 0, timespec{0, 0}, timespec{0, 0}, timespec{0, 0});
+    }
+    std::sort(entries.begin(), entries.end(), [] (const DirEntry &lhs, const DirEntry &rhs) {
+        return std::less<Key>()(lhs.key(), rhs.key());
+    });
+    size_t size = 0;
+    for (const auto &entry : entries) {
+        size += entry.serializedSize();
+    }
+    Data flat(size);
+    size_t offset = 0;
+    for (const auto &entry : entries) {
+        entry.serialize(static_cast<uint8_t*>(flat.dataOffset(offset)));
+        offset += entry.serializedSize();
+    }
+
+    list.deserializeFrom(flat.data(), flat.size());
+    EXPECT_EQ(flat, list.serialize());
+    ExpectLoadsAllFiles(flat, 1000);
+
+    // It is converted to pages on the first change
+    Rename(5, "renamed");
+    WriteChanges();
+    EXPECT_NE(flat.size(), disk.size());
+    EXPECT_EQ(list.serialize(), disk);
+    DirEntryList loaded;
+    loaded.deserializeFrom(disk.data(), disk.size());
+    EXPECT_EQ(1000u, loaded.size());
+    EXPECT_EQ(CreateKey(5), loaded.get("renamed")->key());
+}
+
+TEST_F(DirEntryListTest, ChangingEntryOfLargeDirectoryOnlyWritesItsPage) {
+    for (int i = 0; i < 1000; ++i) {
+        Add("file" + std::to_string(i), i);
+    }
+    WriteChanges();
+    list.setMode(CreateKey(10), S_IFREG | S_IRWXU);
+    EXPECT_EQ(DirEntryList::PAGE_SIZE, WriteChanges());
+    EXPECT_EQ(list.serialize(), disk);
+}
+
+TEST_F(DirEntryListTest, AddingAndRemovingEntriesOfLargeDirectoryOnlyWritesTheirPages) {
+    for (int i = 0; i < 1000; ++i) {
+        Add("file" + std::to_string(i), i);
+    }
+    WriteChanges();
+    for (int i = 1000; i < 1100; ++i) {
+        Add("file" + std::to_string(i), i);
+        // The page of the new entry and, if it was full, the page it was split into
+        EXPECT_GE(2u * DirEntryList::PAGE_SIZE, WriteChanges());
+    }
+    list.remove("file5");
+    EXPECT_EQ(DirEntryList::PAGE_SIZE, WriteChanges());
+    list.remove(CreateKey(6));
+    EXPECT_EQ(DirEntryList::PAGE_SIZE, WriteChanges());
+    Rename(7, "renamed");
+    EXPECT_GE(2u * DirEntryList::PAGE_SIZE, WriteChanges());
+    EXPECT_EQ(list.serialize(), disk);
+
+    DirEntryList loaded;
+    loaded.deserializeFrom(disk.data(), disk.size());
+    EXPECT_EQ(1098u, loaded.size());
+    EXPECT_EQ(none, loaded.get("file5"));
+    EXPECT_EQ(none, loaded.get("file6"));
+    EXPECT_EQ(CreateKey(7), loaded.get("renamed")->key());
+    EXPECT_EQ(CreateKey(1099), loaded.get("file1099")->key());
+}
+
+TEST_F(DirEntryListTest, FindsEntriesOfLargeDirectoryAfterChangesAndReloading) {
+    for (int i = 0; i < 1000; ++i) {
+        Add("file" + std::to_string(i), i);
+    }
+    WriteChanges();
+    list.deserializeFrom(disk.data(), disk.size());
+    Add("file1000", 1000);
+    AddOrOverwrite("file3", 1003);
+    WriteChanges();
+    list.deserializeFrom(disk.data(), disk.size());
+    EXPECT_EQ(1001u, list.size());
+    ExpectHasEntry("file3", 1003);
+    ExpectHasEntry("file1000", 1000);
+    ExpectHasEntry("file999", 999);
+}
+
+TEST_F(DirEntryListTest, AddingEntryWithTooLongNameThrows) {
+    try {
+        Add(string(DirEntryList::PAGE_SIZE, 'a'), 1);
+        EXPECT_TRUE(false); // Expect it throws
+    } catch (const FuseErrnoException &e) {
+        EXPECT_EQ(ENAMETOOLONG, e.getErrno());
+    }
+    EXPECT_EQ(0u, list.size());
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <cryfs/filesystem/fsblobstore/utils/DirEntryNameIndex.h>
+#include <cpp-utils/data/DataFixture.h>
+#include <map>
+
+using blockstore::Key;
+using boost::none;
+using cpputils::DataFixture;
+using cryfs::fsblobstore::DirEntryNameIndex;
+using std::string;
+using std::map;
+
+class DirEntryNameIndexTest : public ::testing::Test {
+public:
+    static Key CreateKey(int seed) {
+        return DataFixture::generateFixedSize<Key::BINARY_LENGTH>(seed);
+    }
+
+    void Add(const string &name, int keySeed) {
+        index.add(name, CreateKey(keySeed));
+        names[CreateKey(keySeed)] = name;
+    }
+
+    void Remove(const string &name, int keySeed) {
+        index.remove(name, CreateKey(keySeed));
+        names.erase(CreateKey(keySeed));
+    }
+
+    boost::optional<Key> Find(const string &name) {
+        return index.find(name, [this, &name] (const Key &key) {
+            auto found = names.find(key);
+            return found != names.end() && found->second == name;
+        });
+    }
+
+    DirEntryNameIndex index;
+    // The names the index would get from the directory entries
+    map<Key, string> names;
+};
+
+TEST_F(DirEntryNameIndexTest, EmptyIndexDoesntFindName) {
+    EXPECT_EQ(none, Find("name"));
+}
+
+TEST_F(DirEntryNameIndexTest, FindsAddedName) {
+    Add("name", 1);
+    EXPECT_EQ(CreateKey(1), Find("name").value());
+    EXPECT_EQ(none, Find("othername"));
+}
+
+TEST_F(DirEntryNameIndexTest, DoesntFindRemovedName) {
+    Add("name", 1);
+    Remove("name", 1);
+    EXPECT_EQ(none, Find("name"));
+    EXPECT_EQ(0u, index.size());
+}
+
+TEST_F(DirEntryNameIndexTest, ClearRemovesAllNames) {
+    Add("name1", 1);
+    Add("name2", 2);
+    index.clear();
+    EXPECT_EQ(none, Find("name1"));
+    EXPECT_EQ(none, Find("name2"));
+    EXPECT_EQ(0u, index.size());
+}
+
+TEST_F(DirEntryNameIndexTest, AsksCallerToCompareNames) {
+    Add("name", 1);
+    EXPECT_EQ(none, index.find("name", [] (const Key &) {return false;}));
+}
+
+TEST_F(DirEntryNameIndexTest, FindsRemainingNamesWhenRemovingManyNames) {
+    // Grows the table several times and removes names from the middle of probe sequences
+    for (int i = 0; i < 10000; ++i) {
+        Add("name" + std::to_string(i), i);
+    }
+    for (int i = 0; i < 10000; i += 3) {
+        Remove("name" + std::to_string(i), i);
+    }
+    EXPECT_EQ(10000u - 3334u, index.size());
+    for (int i = 0; i < 10000; ++i) {
+        if (i % 3 == 0) {
+            EXPECT_EQ(none, Find("name" + std::to_string(i)));
+        } else {
+            EXPECT_EQ(CreateKey(i), Find("name" + std::to_string(i)).value());
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <cryfs/filesystem/parallelaccessfsblobstore/LstatSizeCache.h>
+#include <cpp-utils/data/DataFixture.h>
+
+using blockstore::Key;
+using cpputils::DataFixture;
+using cryfs::parallelaccessfsblobstore::LstatSizeCache;
+
+class LstatSizeCacheTest : public ::testing::Test {
+public:
+    LstatSizeCacheTest(): cache(100), numComputations(0) {}
+
+    static Key CreateKey(int seed) {
+        return DataFixture::generateFixedSize<Key::BINARY_LENGTH>(seed);
+    }
+
+    off_t Get(int keySeed, off_t actualSize) {
+        return cache.getOrCompute(CreateKey(keySeed), [this, actualSize] {
+            ++numComputations;
+            return actualSize;
+        });
+    }
+
+    LstatSizeCache cache;
+    int numComputations;
+};
+
+TEST_F(LstatSizeCacheTest, ComputesSizeOnFirstAccess) {
+    EXPECT_EQ(1024, Get(1, 1024));
+    EXPECT_EQ(1, numComputations);
+}
+
+TEST_F(LstatSizeCacheTest, ReturnsCachedSizeOnSecondAccess) {
+    Get(1, 1024);
+    EXPECT_EQ(1024, Get(1, 2048));
+    EXPECT_EQ(1, numComputations);
+}
+
+TEST_F(LstatSizeCacheTest, CachesSizesPerKey) {
+    Get(1, 1024);
+    EXPECT_EQ(2048, Get(2, 2048));
+    EXPECT_EQ(1024, Get(1, 0));
+    EXPECT_EQ(2048, Get(2, 0));
+    EXPECT_EQ(2, numComputations);
+}
+
+TEST_F(LstatSizeCacheTest, ComputesSizeAgainAfterInvalidate) {
+    Get(1, 1024);
+    cache.invalidate(CreateKey(1));
+    EXPECT_EQ(2048, Get(1, 2048));
+    EXPECT_EQ(2, numComputations);
+}
+
+TEST_F(LstatSizeCacheTest, InvalidateDoesntAffectOtherKeys) {
+    Get(1, 1024);
+    Get(2, 2048);
+    cache.invalidate(CreateKey(1));
+    EXPECT_EQ(2048, Get(2, 0));
+    EXPECT_EQ(1, cache.size());
+}
+
+TEST_F(LstatSizeCacheTest, InvalidateNonexistingKey) {
+    cache.invalidate(CreateKey(1));
+    EXPECT_EQ(0, cache.size());
+}
+
+TEST_F(LstatSizeCacheTest, DoesntCacheSizeInvalidatedWhileComputing) {
+    cache.getOrCompute(CreateKey(1), [this] {
+        // The blob is changed while its size is computed
+        cache.invalidate(CreateKey(1));
+        return 1024;
+    });
+    EXPECT_EQ(2048, Get(1, 2048));
+}
+
+TEST_F(LstatSizeCacheTest, DoesntCacheSizeInvalidatedAndComputedAgainWhileComputing) {
+    cache.getOrCompute(CreateKey(1), [this] {
+        cache.invalidate(CreateKey(1));
+        Get(1, 2048);
+        return 1024;
+    });
+    EXPECT_EQ(2048, Get(1, 0));
+}
+
+TEST_F(LstatSizeCacheTest, ComputesAgainIfComputationFailed) {
+    EXPECT_ANY_THROW(
+        cache.getOrCompute(CreateKey(1), [] () -> off_t {
+            throw std::runtime_error("Blob not loadable");
+        })
+    );
+    EXPECT_EQ(1024, Get(1, 1024));
+    EXPECT_EQ(1024, Get(1, 0));
+}
+
+TEST_F(LstatSizeCacheTest, DropsLeastRecentlyUsedSizes) {
+    for (int i = 0; i < 100; ++i) {
+        Get(i, i);
+    }
+    Get(0, 0);
+    Get(100, 100);
+    EXPECT_EQ(100, cache.size());
+    EXPECT_EQ(0, Get(0, 1000));
+    EXPECT_EQ(1000, Get(1, 1000));
+}
+
+TEST_F(LstatSizeCacheTest, DisabledCacheAlwaysComputes) {
+    LstatSizeCache disabled(0);
+    disabled.getOrCompute(CreateKey(1), [] {return 1024;});
+    EXPECT_EQ(2048, disabled.getOrCompute(CreateKey(1), [] {return 2048;}));
+    EXPECT_EQ(0, disabled.size());
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include "fspp/impl/InodeTable.h"
+#include "fspp/fuse/FuseErrnoException.h"
+#include <cpp-utils/data/DataFixture.h>
+
+using std::vector;
+using fspp::InodeTable;
+using fspp::Device;
+
+class InodeTableTest: public ::testing::Test {
+public:
+  InodeTableTest(): table() {}
+
+  static Device::NodeId Id(int seed) {
+    return cpputils::DataFixture::generateFixedSize<16>(seed);
+  }
+
+  InodeTable table;
+};
+
+TEST_F(InodeTableTest, InitiallyOnlyRoot) {
+  EXPECT_EQ(1u, table.size());
+  EXPECT_EQ(vector<Device::NodeId>({}), table.ids(InodeTable::ROOT_INODE));
+  EXPECT_EQ("/", table.path(InodeTable::ROOT_INODE));
+}
+
+TEST_F(InodeTableTest, LookupInRoot) {
+  auto inode = table.lookup(InodeTable::ROOT_INODE, "myfile", Id(1));
+  EXPECT_NE(InodeTable::ROOT_INODE, inode);
+  EXPECT_EQ(vector<Device::NodeId>({Id(1)}), table.ids(inode));
+  EXPECT_EQ("/myfile", table.path(inode));
+}
+
+TEST_F(InodeTableTest, LookupNested) {
+  auto dir = table.lookup(InodeTable::ROOT_INODE, "mydir", Id(1));
+  auto subdir = table.lookup(dir, "mysubdir", Id(2));
+  auto file = table.lookup(subdir, "myfile", Id(3));
+  EXPECT_EQ(vector<Device::NodeId>({Id(1), Id(2), Id(3)}), table.ids(file));
+  EXPECT_EQ("/mydir/mysubdir/myfile", table.path(file));
+}
+
+TEST_F(InodeTableTest, LookupDifferentNodes) {
+  auto inode1 = table.lookup(InodeTable::ROOT_INODE, "myfile1", Id(1));
+  auto inode2 = table.lookup(InodeTable::ROOT_INODE, "myfile2", Id(2));
+  EXPECT_NE(inode1, inode2);
+  EXPECT_EQ(3u, table.size());
+}
+
+TEST_F(InodeTableTest, LookupSameNodeTwice) {
+  auto inode1 = table.lookup(InodeTable::ROOT_INODE, "myfile", Id(1));
+  auto inode2 = table.lookup(InodeTable::ROOT_INODE, "myfile", Id(1));
+  EXPECT_EQ(inode1, inode2);
+  EXPECT_EQ(2u, table.size());
+}
+
+TEST_F(InodeTableTest, LookupSameNodeAtOtherPositionMovesIt) {
+  auto dir = table.lookup(InodeTable::ROOT_INODE, "mydir", Id(1));
+  auto inode = table.lookup(InodeTable::ROOT_INODE, "myfile", Id(2));
+  EXPECT_EQ(inode, table.lookup(dir, "myrenamedfile", Id(2)));
+  EXPECT_EQ(vector<Device::NodeId>({Id(1), Id(2)}), table.ids(inode));
+  EXPECT_EQ("/mydir/myrenamedfile", table.path(inode));
+}
+
+TEST_F(InodeTableTest, UnknownInode) {
+  EXPECT_THROW(table.ids(1000), fspp::fuse::FuseErrnoException);
+  EXPECT_THROW(table.path(1000), fspp::fuse::FuseErrnoException);
+}
+
+TEST_F(InodeTableTest, ForgetRemovesInode) {
+  auto inode = table.lookup(InodeTable::ROOT_INODE, "myfile", Id(1));
+  table.forget(inode, 1);
+  EXPECT_EQ(1u, table.size());
+  EXPECT_THROW(table.ids(inode), fspp::fuse::FuseErrnoException);
+}
+
+TEST_F(InodeTableTest, ForgetOnlySomeLookupsKeepsInode) {
+  auto inode = table.lookup(InodeTable::ROOT_INODE, "myfile", Id(1));
+  table.lookup(InodeTable::ROOT_INODE, "myfile", Id(1));
+  table.lookup(InodeTable::ROOT_INODE, "myfile", Id(1));
+  table.forget(inode, 2);
+  EXPECT_EQ(vector<Device::NodeId>({Id(1)}), table.ids(inode));
+  table.forget(inode, 1);
+  EXPECT_THROW(table.ids(inode), fspp::fuse::FuseErrnoException);
+}
+
+TEST_F(InodeTableTest, ForgetRootIsIgnored) {
+  table.forget(InodeTable::ROOT_INODE, 1);
+  EXPECT_EQ(1u, table.size());
+  EXPECT_EQ("/", table.path(InodeTable::ROOT_INODE));
+}
+
+TEST_F(InodeTableTest, ForgottenInodeGetsNewNumber) {
+  auto inode = table.lookup(InodeTable::ROOT_INODE, "myfile", Id(1));
+  table.forget(inode, 1);
+  EXPECT_NE(inode, table.lookup(InodeTable::ROOT_INODE, "myfile", Id(1)));
+}
+
+TEST_F(InodeTableTest, ForgottenDirStaysWhileChildrenAreKnown) {
+  auto dir = table.lookup(InodeTable::ROOT_INODE, "mydir", Id(1));
+  auto file = table.lookup(dir, "myfile", Id(2));
+  table.forget(dir, 1);
+  EXPECT_EQ(vector<Device::NodeId>({Id(1), Id(2)}), table.ids(file));
+  EXPECT_EQ(3u, table.size());
+  table.forget(file, 1);
+  EXPECT_EQ(1u, table.size());
+}
+
+TEST_F(InodeTableTest, Rename) {
+  auto dir = table.lookup(InodeTable::ROOT_INODE, "mydir", Id(1));
+  auto file = table.lookup(InodeTable::ROOT_INODE, "myfile", Id(2));
+  table.rename(Id(2), dir, "myrenamedfile");
+  EXPECT_EQ(vector<Device::NodeId>({Id(1), Id(2)}), table.ids(file));
+  EXPECT_EQ("/mydir/myrenamedfile", table.path(file));
+}
+
+TEST_F(InodeTableTest, RenameDirMovesChildren) {
+  auto dir = table.lookup(InodeTable::ROOT_INODE, "mydir", Id(1));
+  auto targetDir = table.lookup(InodeTable::ROOT_INODE, "mytargetdir", Id(2));
+  auto file = table.lookup(dir, "myfile", Id(3));
+  table.rename(Id(1), targetDir, "mydir");
+  EXPECT_EQ(vector<Device::NodeId>({Id(2), Id(1), Id(3)}), table.ids(file));
+  EXPECT_EQ("/mytargetdir/mydir/myfile", table.path(file));
+}
+
+TEST_F(InodeTableTest, RenameUnknownNode) {
+  auto dir = table.lookup(InodeTable::ROOT_INODE, "mydir", Id(1));
+  table.rename(Id(2), dir, "myfile");
+  EXPECT_EQ(2u, table.size());
+}
+
+TEST_F(InodeTableTest, RenameRemovesForgottenOldParent) {
+  auto dir = table.lookup(InodeTable::ROOT_INODE, "mydir", Id(1));
+  table.lookup(dir, "myfile", Id(2));
+  table.forget(dir, 1);
+  table.rename(Id(2), InodeTable::ROOT_INODE, "myfile");
+  EXPECT_EQ(2u, table.size());
+  EXPECT_THROW(table.ids(dir), fspp::fuse::FuseErrnoException);
+}